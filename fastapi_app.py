@@ -15,6 +15,9 @@ from langchain.chains import LLMChain
 from langchain_community.chat_message_histories import RedisChatMessageHistory
 from langchain.memory import ConversationBufferMemory
 from aip import AipSpeech
+from rtp_audio import UdpAudioServer
+import hello_protocol
+import time
 
 # --- 1. 初始化所有客户端和服务 (无变化) ---
 # 百度语音 API
@@ -87,6 +90,15 @@ app = FastAPI()
 # LED控制器连接（用于转发说话状态）
 led_controller_connection: Optional[WebSocket] = None
 
+# UDP音频通道（设备发 udp_offer 后启用），默认与HTTP使用相同的端口号
+UDP_AUDIO_PORT = int(os.getenv("UDP_AUDIO_PORT", "8000"))
+udp_server = UdpAudioServer()
+
+
+@app.on_event("startup")
+async def start_udp_server():
+    await udp_server.start(UDP_AUDIO_PORT)
+
 # --- 2. 使用 Pydantic 定义请求体模型 ---
 class ChatRequest(BaseModel):
     user_input: str
@@ -132,9 +144,15 @@ async def websocket_endpoint(websocket: WebSocket, client_id: str):
     # 为每个连接维护一个独立的状态
     client_state = {
         "is_recording": False,
-        "audio_buffer": bytearray()
+        "audio_buffer": bytearray(),
+        "config": dict(hello_protocol.LEGACY),
+        "udp_session": None
     }
 
+    def on_udp_audio(chunk: bytes):
+        if client_state["is_recording"]:
+            client_state["audio_buffer"].extend(chunk)
+
     try:
         while True:
             message = await websocket.receive()
@@ -157,7 +175,25 @@ async def websocket_endpoint(websocket: WebSocket, client_id: str):
                 data = json.loads(text)
                 event = data.get("event")
 
-                if event == "wake_word_detected":
+                if event == "hello":
+                    features = [hello_protocol.FEATURE_HEARTBEAT_RTT, hello_protocol.FEATURE_UDP_AUDIO]
+                    client_state["config"], ack = hello_protocol.answer_hello(data, features, 1024)
+                    await websocket.send_text(json.dumps(ack, separators=(",", ":")))
+                    print(f"[{client_ip}] 握手: {hello_protocol.describe(client_state['config'])}")
+
+                elif event == "udp_offer":
+                    udp_server.close_session(client_state["udp_session"])
+                    session, answer = udp_server.answer(data, client_ip, on_udp_audio)
+                    client_state["udp_session"] = session
+                    await websocket.send_text(json.dumps(answer, separators=(",", ":")))
+                    print(f"[{client_ip}] UDP音频通道已建立 (设备端口 {data['port']})")
+
+                elif event == "memory_pressure":
+                    # 设备内存紧张时逐级关掉可选功能（卸载模型、关降噪、缩小播放缓冲区），恢复时也会上报
+                    print(f"[{client_ip}] 设备内存级别: {data.get('name')} (原因 {data.get('reason')}), "
+                          f"内部 {data.get('internal')}, DMA {data.get('dma')}, PSRAM {data.get('psram')}")
+
+                elif event == "wake_word_detected":
                     print(f"[{client_ip}] 检测到唤醒词！")
 
                 elif event == "recording_started":
@@ -167,6 +203,14 @@ async def websocket_endpoint(websocket: WebSocket, client_id: str):
 
                 elif event == "recording_ended":
                     print(f"[{client_ip}] 录音结束")
+                    # 设备统计的本轮上行音频质量（电平、削波、信噪比、丢帧、结束原因），与识别结果对照
+                    audio_quality = data.get("audio")
+                    if audio_quality is not None:
+                        print(f"  - 上行音频质量: {audio_quality}")
+                    if data.get("mem") is not None:
+                        print(f"  - 设备内存: {data['mem']}")
+                    if client_state["udp_session"] is not None:
+                        print(f"  - UDP上行统计: {client_state['udp_session'].flush_uplink()}")
                     client_state["is_recording"] = False
                     
                     if not client_state["audio_buffer"]:
@@ -179,7 +223,7 @@ async def websocket_endpoint(websocket: WebSocket, client_id: str):
                     # 1. ASR
                     user_text = await asyncio.to_thread(transcribe_audio_stream, bytes(client_state['audio_buffer']))
                     if not user_text:
-                        print("  - ASR 失败，对话中止。")
+                        print(f"  - ASR 失败，对话中止。上行音频质量: {audio_quality}")
                         continue
                     print(f"  -  用户说 (ASR): '{user_text}'")
 
@@ -198,14 +242,25 @@ async def websocket_endpoint(websocket: WebSocket, client_id: str):
                     
                     # 4. 【新策略】分块发送音频回 ESP32 (Burst and Yield)
                     print(f"  -  开始流式发送 {len(response_audio_bytes)} 字节的回复音频...")
-                    CHUNK_SIZE = 1024  # 每次发送的数据块大小
+                    CHUNK_SIZE = min(1024, client_state["config"]["max_frame"])  # 每次发送的数据块大小
                     BURST_SIZE = 8     # 定义一次“爆发”发送多少个数据块 (8 * 1024 = 8KB)
                     burst_count = 0
 
+                    if client_state["udp_session"] is not None:
+                        # UDP通道：按20ms一帧发送，最后一包带marker
+                        await client_state["udp_session"].send_stream(response_audio_bytes, client_state["config"])
+                        response_audio_bytes = b""
+
+                    send_start = time.monotonic()
                     for i in range(0, len(response_audio_bytes), CHUNK_SIZE):
                         chunk = response_audio_bytes[i:i + CHUNK_SIZE]
                         
                         try:
+                            # 不超过设备播放缓冲区的容量（握手时上报）
+                            delay = hello_protocol.ring_headroom_delay(
+                                client_state["config"], i, time.monotonic() - send_start)
+                            if delay > 0:
+                                await asyncio.sleep(delay)
                             await websocket.send_bytes(chunk)
                             burst_count += 1
                             
@@ -249,6 +304,7 @@ async def websocket_endpoint(websocket: WebSocket, client_id: str):
     except Exception as e:
         print(f" [{client_ip}] 连接出现未知错误: {e}")
     finally:
+        udp_server.close_session(client_state["udp_session"])
         # 无论如何，确保连接被关闭（如果它仍然打开）
         # 检查状态以避免在已经关闭的连接上再次关闭
         if websocket.client_state != WebSocketState.DISCONNECTED:
@@ -0,0 +1,73 @@
+"""
+连接握手 - 服务器端公共模块（与设备端 hello_handshake.h 保持一致）
+
+设备连接后先发 hello 声明能力，服务器用 answer_hello() 选出本次连接的配置
+并回 hello_ack。没有发 hello 的旧设备按 LEGACY 配置处理。
+"""
+
+PROTOCOL_VERSION = 1
+CODEC = "pcm_s16le"
+SAMPLE_RATE = 16000
+
+# 可选特性
+FEATURE_UDP_AUDIO = "udp_audio"          # UDP音频通道（见 rtp_audio.py）
+FEATURE_HEARTBEAT_RTT = "heartbeat_rtt"  # 心跳ping带时间戳，pong原样回送（WebSocket库自动完成）
+
+# 旧设备：不握手，按16kHz PCM、8KB帧处理，不启用可选特性
+LEGACY = {
+    "version": 0,
+    "codec": CODEC,
+    "sample_rate_up": SAMPLE_RATE,
+    "sample_rate_down": SAMPLE_RATE,
+    "max_frame": 8192,
+    "ring_bytes": 0,
+    "features": [],
+}
+
+
+def answer_hello(hello: dict, server_features, max_frame: int):
+    """
+    根据设备的 hello 选出本次连接的配置。
+
+    返回 (配置, hello_ack消息)；设备不支持本服务器的编码或采样率时返回 (LEGACY, error消息)。
+    消息要用紧凑格式发送：json.dumps(msg, separators=(",", ":"))，设备端按 "key":value 查找字段。
+    """
+    if CODEC not in hello.get("codecs", []) or SAMPLE_RATE not in hello.get("sample_rates", []):
+        return dict(LEGACY), {"event": "error", "message": "unsupported audio format"}
+
+    device_features = set(hello.get("features", []))
+    config = {
+        "version": min(int(hello.get("version", 1)), PROTOCOL_VERSION),
+        "codec": CODEC,
+        "sample_rate_up": SAMPLE_RATE,
+        "sample_rate_down": SAMPLE_RATE,
+        "max_frame": min(int(hello.get("max_frame", max_frame)), max_frame),
+        "ring_bytes": int(hello.get("ring_bytes", 0)),
+        "features": sorted(device_features & set(server_features)),
+    }
+    ack = {"event": "hello_ack"}
+    ack.update({k: v for k, v in config.items() if k != "ring_bytes"})
+    return config, ack
+
+
+def describe(config: dict) -> str:
+    """打印用的一行摘要"""
+    return (f"协议v{config['version']}, {config['sample_rate_down']}Hz, "
+            f"单帧 {config['max_frame']} 字节, 播放缓冲 {config['ring_bytes']} 字节, "
+            f"特性 {config['features'] or '无'}")
+
+
+def ring_headroom_delay(config: dict, sent_bytes: int, elapsed_s: float) -> float:
+    """
+    下行突发发送时，按设备播放缓冲区容量计算需要等待的时间（秒）。
+
+    设备边收边播，缓冲区中最多积压 sent - 已播放 字节；超过容量的3/4就等一等，
+    避免设备端缓冲区满而丢音频。旧设备没有上报容量，不做限制。
+    """
+    ring_bytes = config.get("ring_bytes", 0)
+    if ring_bytes <= 0:
+        return 0.0
+    bytes_per_second = config["sample_rate_down"] * 2
+    backlog = sent_bytes - elapsed_s * bytes_per_second
+    excess = backlog - ring_bytes * 3 // 4
+    return excess / bytes_per_second if excess > 0 else 0.0
@@ -6,9 +6,14 @@ ESP32音频回环服务器 - 固定WAV文件回复版
 import os
 import json
 import asyncio
+import argparse
 import wave  # <-- 1. 引入wave库来处理.wav文件
 from fastapi import FastAPI, WebSocket, WebSocketDisconnect
+from fastapi.responses import PlainTextResponse
 import socket
+import time
+from rtp_audio import UdpAudioServer
+import hello_protocol
 
 app = FastAPI(title="ESP32音频回环服务器", version="1.0")
 
@@ -16,6 +21,32 @@ app = FastAPI(title="ESP32音频回环服务器", version="1.0")
 REPLY_WAV_FILE = "audio_record_20251111_095832.wav"
 REPLY_AUDIO_DATA = None  # 用于在启动时加载音频数据
 
+# 注入的处理延迟（毫秒），用于在本机模拟远近不同的多个服务器节点
+INJECTED_LATENCY_MS = 0
+
+# UDP音频通道（设备发 udp_offer 后启用），与HTTP使用相同的端口号
+udp_server = UdpAudioServer()
+UDP_PORT = None
+
+
+@app.on_event("startup")
+async def start_udp_server():
+    if UDP_PORT:
+        await udp_server.start(UDP_PORT)
+
+
+async def inject_latency():
+    """模拟网络/处理延迟"""
+    if INJECTED_LATENCY_MS > 0:
+        await asyncio.sleep(INJECTED_LATENCY_MS / 1000.0)
+
+
+@app.get("/health")
+async def health():
+    """设备测速接口：设备以请求到首字节的时间作为该节点的RTT"""
+    await inject_latency()
+    return PlainTextResponse("ok")
+
 def load_wav_audio(filepath: str):
     """从WAV文件中加载音频数据，并检查格式是否兼容ESP32"""
     try:
@@ -49,6 +80,35 @@ def load_wav_audio(filepath: str):
         print(f"加载WAV文件失败: {e}")
         return None
 
+@app.websocket("/ws/bench")
+async def bench_endpoint(websocket: WebSocket):
+    """
+    传输基准测试端点（CONFIG_WS_TRANSPORT_BENCH）：丢弃二进制数据只计数，
+    收到 bench_done 后回报字节数和从第一个字节起的耗时。必须在 /ws/{client_id} 之前注册。
+    """
+    await websocket.accept()
+    total = 0
+    first = None
+    try:
+        while True:
+            message = await websocket.receive()
+            if message.get("bytes"):
+                if first is None:
+                    first = time.monotonic()
+                total += len(message["bytes"])
+            elif message.get("text") and "bench_done" in message["text"]:
+                elapsed_ms = int((time.monotonic() - first) * 1000) if first else 0
+                print(f"[bench] 收到 {total} 字节，用时 {elapsed_ms} ms")
+                await websocket.send_text(json.dumps({"event": "bench_result", "bytes": total, "ms": elapsed_ms},
+                                                     separators=(",", ":")))
+                total = 0
+                first = None
+            elif message.get("type") == "websocket.disconnect":
+                break
+    except WebSocketDisconnect:
+        pass
+
+
 @app.websocket("/ws/{client_id}")
 async def websocket_endpoint(websocket: WebSocket, client_id: str):
     """
@@ -62,9 +122,15 @@ async def websocket_endpoint(websocket: WebSocket, client_id: str):
     client_state = {
         "is_recording": False,
         "audio_buffer": bytearray(),
-        "conversation_count": 0
+        "conversation_count": 0,
+        "config": dict(hello_protocol.LEGACY),
+        "udp_session": None
     }
 
+    def on_udp_audio(chunk: bytes):
+        if client_state["is_recording"]:
+            client_state["audio_buffer"].extend(chunk)
+
     try:
         while True:
             # 接收消息
@@ -72,16 +138,34 @@ async def websocket_endpoint(websocket: WebSocket, client_id: str):
 
             # 处理文本消息 (JSON事件)
             if "text" in message:
+                await inject_latency()
                 data = json.loads(message["text"])
                 event = data.get("event")
 
-                if event == "recording_started":
+                if event == "hello":
+                    features = [hello_protocol.FEATURE_HEARTBEAT_RTT]
+                    if udp_server.transport is not None:
+                        features.append(hello_protocol.FEATURE_UDP_AUDIO)
+                    client_state["config"], ack = hello_protocol.answer_hello(data, features, 3200)
+                    await websocket.send_text(json.dumps(ack, separators=(",", ":")))
+                    print(f"[{client_ip}] 握手: {hello_protocol.describe(client_state['config'])}")
+
+                elif event == "udp_offer" and udp_server.transport is not None:
+                    udp_server.close_session(client_state["udp_session"])
+                    session, answer = udp_server.answer(data, client_ip, on_udp_audio)
+                    client_state["udp_session"] = session
+                    await websocket.send_text(json.dumps(answer, separators=(",", ":")))
+                    print(f"[{client_ip}] UDP音频通道已建立 (设备端口 {data['port']})")
+
+                elif event == "recording_started":
                     print(f"[{client_ip}] 开始录音...")
                     client_state["is_recording"] = True
                     client_state["audio_buffer"].clear()
 
                 elif event == "recording_ended":
                     print(f"[{client_ip}] 录音结束")
+                    if client_state["udp_session"] is not None:
+                        print(f"  - UDP上行统计: {client_state['udp_session'].flush_uplink()}")
                     client_state["is_recording"] = False
                     client_state["conversation_count"] += 1
 
@@ -92,7 +176,8 @@ async def websocket_endpoint(websocket: WebSocket, client_id: str):
                     # 直接使用预加载的WAV音频数据
                     if REPLY_AUDIO_DATA:
                         print(f"  - 返回固定WAV音频: {REPLY_WAV_FILE} ({len(REPLY_AUDIO_DATA)} 字节)")
-                        await send_audio_stream(websocket, REPLY_AUDIO_DATA)
+                        await send_audio_stream(websocket, REPLY_AUDIO_DATA, client_state["config"],
+                                                client_state["udp_session"])
                     else:
                         print("警告：回复音频未加载，无法发送回复。")
 
@@ -110,30 +195,37 @@ async def websocket_endpoint(websocket: WebSocket, client_id: str):
         print(f"[{client_ip}] 连接错误: {e}")
         if websocket.client_state != "DISCONNECTED":
             await websocket.close()
+    finally:
+        udp_server.close_session(client_state["udp_session"])
 
-async def send_audio_stream(websocket: WebSocket, audio_data: bytes):
+async def send_audio_stream(websocket: WebSocket, audio_data: bytes, config: dict, udp_session=None):
     """
-    流式发送音频数据到ESP32
+    流式发送音频数据到ESP32（协商了UDP通道时走UDP）
     """
-    CHUNK_SIZE = 3200  # 每次发送3200字节（200ms的音频）
+    CHUNK_SIZE = min(3200, config["max_frame"])  # 每次最多发送3200字节（200ms的音频）
     
     sent_bytes = 0
-    for i in range(0, len(audio_data), CHUNK_SIZE):
-        chunk = audio_data[i:i + CHUNK_SIZE]
-        try:
-            await websocket.send_bytes(chunk)
-            sent_bytes += len(chunk)
-            await asyncio.sleep(0.01)  # 短暂延时，模拟真实网络情况
-        except Exception as e:
-            print(f"发送音频失败: {e}")
-            break
-
-    # 发送ping包作为结束标志
+    if udp_session is not None:
+        await udp_session.send_stream(audio_data, config)
+        sent_bytes = len(audio_data)
+    else:
+        for i in range(0, len(audio_data), CHUNK_SIZE):
+            chunk = audio_data[i:i + CHUNK_SIZE]
+            try:
+                await websocket.send_bytes(chunk)
+                sent_bytes += len(chunk)
+                await asyncio.sleep(0.01)  # 短暂延时，模拟真实网络情况
+            except Exception as e:
+                print(f"发送音频失败: {e}")
+                break
+
+    # 结束标志：与 fastapi_app.py 相同，发 response_finished 事件
+    # （原来的 websocket.ping() 在Starlette中不存在，设备收不到结束信号）
     try:
-        await websocket.ping()
+        await websocket.send_text(json.dumps({"event": "response_finished"}))
         print(f"音频流发送完成: {sent_bytes}/{len(audio_data)} 字节")
-    except:
-        pass
+    except Exception as e:
+        print(f"发送结束标志失败: {e}")
 
 def get_local_ip():
     """获取本机IP地址"""
@@ -149,7 +241,15 @@ def get_local_ip():
 if __name__ == "__main__":
     import uvicorn
 
-    PORT = 8000
+    parser = argparse.ArgumentParser(description="ESP32音频回环服务器")
+    parser.add_argument("--port", type=int, default=8000, help="监听端口")
+    parser.add_argument("--latency-ms", type=int, default=0,
+                        help="注入的处理延迟（毫秒），用于测试多节点测速和故障切换")
+    args = parser.parse_args()
+
+    PORT = args.port
+    INJECTED_LATENCY_MS = args.latency_ms
+    UDP_PORT = PORT
     local_ip = get_local_ip()
 
     print("=" * 60)
@@ -157,6 +257,7 @@ if __name__ == "__main__":
     print("=" * 60)
     print(f"服务器地址: http://{local_ip}:{PORT}")
     print(f"WebSocket地址: ws://{local_ip}:{PORT}/ws/esp32")
+    print(f"注入延迟: {INJECTED_LATENCY_MS} ms")
     print("=" * 60)
     
     # --- 4. 在服务器启动时加载WAV文件 ---
@@ -0,0 +1,188 @@
+/**
+ * @file async_copy.cc
+ * @brief 🚚 异步内存拷贝实现
+ */
+
+#include "async_copy.h"
+#include <string.h>
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "esp_attr.h"
+#include "esp_memory_utils.h"
+
+#if CONFIG_AUDIO_ASYNC_COPY
+#include "esp_async_memcpy.h"
+#include "esp_cache.h"
+#include "esp_idf_version.h"
+#endif
+
+static const char *TAG = "AsyncCopy";
+
+#if CONFIG_AUDIO_ASYNC_COPY
+struct AsyncCopy::IsrHandler {
+    /**
+     * @brief GDMA完成中断：唤醒等待的任务，再调用栅栏的完成回调
+     */
+    static bool IRAM_ATTR on_done(async_memcpy_handle_t handle, async_memcpy_event_t* event, void* arg)
+    {
+        Fence* fence = (Fence*)arg;
+        BaseType_t high_task_wakeup = pdFALSE;
+        xSemaphoreGiveFromISR(fence->done_, &high_task_wakeup);
+        if (fence->callback_ != nullptr) {
+            fence->callback_(fence->callback_arg_);
+        }
+        return high_task_wakeup == pdTRUE;
+    }
+};
+#endif
+
+AsyncCopy::Fence::Fence(DoneCallback callback, void* arg)
+    : done_(xSemaphoreCreateCounting(AsyncCopy::BACKLOG, 0))
+    , outstanding_(0)
+    , callback_(callback)
+    , callback_arg_(arg)
+{
+}
+
+AsyncCopy::Fence::~Fence()
+{
+    if (done_ != nullptr) {
+        vSemaphoreDelete(done_);
+    }
+}
+
+AsyncCopy::AsyncCopy(size_t threshold)
+    : threshold_(threshold)
+    , handle_(nullptr)
+    , dma_copies_(0)
+    , cpu_copies_(0)
+    , cpu_fallbacks_(0)
+    , dma_bytes_(0)
+    , cpu_bytes_(0)
+    , dma_failed_(false)
+{
+}
+
+AsyncCopy::~AsyncCopy()
+{
+#if CONFIG_AUDIO_ASYNC_COPY
+    if (handle_ != nullptr) {
+        esp_async_memcpy_uninstall(handle_);
+        handle_ = nullptr;
+    }
+#endif
+}
+
+esp_err_t AsyncCopy::init()
+{
+#if CONFIG_AUDIO_ASYNC_COPY
+    if (handle_ != nullptr) {
+        return ESP_OK;
+    }
+    async_memcpy_config_t config = ASYNC_MEMCPY_DEFAULT_CONFIG();
+    config.backlog = BACKLOG;
+#if ESP_IDF_VERSION < ESP_IDF_VERSION_VAL(5, 4, 0)
+    config.psram_trans_align = PSRAM_ALIGN;
+#endif
+    async_memcpy_handle_t handle = nullptr;
+    esp_err_t ret = esp_async_memcpy_install(&config, &handle);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "GDMA拷贝驱动安装失败: %s，全部使用CPU拷贝", esp_err_to_name(ret));
+        return ret;
+    }
+    handle_ = handle;
+    ESP_LOGI(TAG, "✓ GDMA异步拷贝已启用，阈值 %zu 字节", threshold_);
+    return ESP_OK;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+bool AsyncCopy::canOffload(const void* dst, const void* src, size_t n) const
+{
+    if (handle_ == nullptr || n < threshold_ || dma_failed_) {
+        return false;
+    }
+    bool dst_ext = esp_ptr_external_ram(dst);
+    bool src_ext = esp_ptr_external_ram(src);
+    if ((!dst_ext && !esp_ptr_dma_capable(dst)) || (!src_ext && !esp_ptr_dma_capable(src))) {
+        return false;
+    }
+    size_t align = (dst_ext || src_ext) ? PSRAM_ALIGN : SRAM_ALIGN;
+    return ((uintptr_t)dst % align) == 0 && ((uintptr_t)src % align) == 0 && (n % align) == 0;
+}
+
+void AsyncCopy::cpuCopy(void* dst, const void* src, size_t n, bool fallback)
+{
+    memcpy(dst, src, n);
+    cpu_copies_++;
+    cpu_bytes_ += n;
+    if (fallback) {
+        cpu_fallbacks_++;
+    }
+}
+
+bool AsyncCopy::submit(Fence& fence, void* dst, const void* src, size_t n)
+{
+    if (!canOffload(dst, src, n) || fence.done_ == nullptr) {
+        cpuCopy(dst, src, n, handle_ != nullptr && n >= threshold_);
+        return false;
+    }
+
+#if CONFIG_AUDIO_ASYNC_COPY
+    // DMA直接读写PSRAM，绕过cache：源数据先写回，目标区域的脏行先写回并失效，
+    // 避免DMA完成后被cache里的旧行覆盖或读到旧数据
+    if (esp_ptr_external_ram(src)) {
+        esp_cache_msync((void*)src, n, ESP_CACHE_MSYNC_FLAG_DIR_C2M);
+    }
+    if (esp_ptr_external_ram(dst)) {
+        esp_cache_msync(dst, n, ESP_CACHE_MSYNC_FLAG_DIR_C2M | ESP_CACHE_MSYNC_FLAG_INVALIDATE);
+    }
+
+    esp_err_t ret = esp_async_memcpy(handle_, dst, (void*)src, n, IsrHandler::on_done, &fence);
+    if (ret != ESP_OK) {
+        // 在途拷贝已达 BACKLOG 等情况，直接用CPU完成
+        cpuCopy(dst, src, n, true);
+        return false;
+    }
+    fence.outstanding_++;
+    dma_copies_++;
+    dma_bytes_ += n;
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool AsyncCopy::wait(Fence& fence, TickType_t timeout)
+{
+    while (fence.outstanding_ > 0) {
+        if (xSemaphoreTake(fence.done_, timeout) != pdTRUE) {
+            // GDMA卡住了：之后全部走CPU，不再有新的DMA完成信号，迟到的信号也就不会被误当成下一次的完成
+            ESP_LOGE(TAG, "等待GDMA拷贝完成超时，仍有 %lu 个未完成，停用GDMA", (unsigned long)fence.outstanding_);
+            fence.outstanding_ = 0;
+            dma_failed_ = true;
+            return false;
+        }
+        fence.outstanding_--;
+    }
+    return true;
+}
+
+void AsyncCopy::copy(Fence& fence, void* dst, const void* src, size_t n)
+{
+    if (submit(fence, dst, src, n) && !wait(fence)) {
+        cpuCopy(dst, src, n, true);
+    }
+}
+
+AsyncCopy::Stats AsyncCopy::getStats() const
+{
+    Stats stats;
+    stats.dma_copies = dma_copies_.load();
+    stats.cpu_copies = cpu_copies_.load();
+    stats.cpu_fallbacks = cpu_fallbacks_.load();
+    stats.dma_bytes = dma_bytes_.load();
+    stats.cpu_bytes = cpu_bytes_.load();
+    return stats;
+}
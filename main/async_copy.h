@@ -0,0 +1,148 @@
+/**
+ * @file async_copy.h
+ * @brief 🚚 异步内存拷贝 - 用GDMA搬运大块音频数据
+ *
+ * 录音缓冲区和播放环形缓冲区都在PSRAM里，CPU拷贝PSRAM要一直等cache行填充，
+ * 几KB的拷贝就要占用几十微秒，而这段时间本可以留给同一个核上的唤醒词检测。
+ * 这里把 esp_async_memcpy（GDMA）包装成一个简单的服务：
+ *
+ * - 大于阈值、地址和长度满足DMA要求的拷贝交给GDMA，调用方可以先去做别的事
+ * - 小块、未对齐、不可DMA的内存自动回退到CPU memcpy，调用方不需要区分
+ * - 每个调用方持有自己的 Fence，wait() 只等自己提交的拷贝，多个任务互不干扰
+ *
+ * 对齐要求：涉及PSRAM时，源、目标地址和长度都要按cache行（64字节）对齐，
+ * 否则DMA前后的cache回写/失效会波及相邻数据；内部RAM只要求4字节对齐。
+ *
+ * 目前音频路径没有使用：播放环形缓冲区的读写都要拷完才能移动指针，提交后只能原地等待。
+ * 接入新的路径之前先用 async_copy_bench（CONFIG_AUDIO_ASYNC_COPY_BENCH）在目标板上测出收益。
+ */
+
+#ifndef ASYNC_COPY_H
+#define ASYNC_COPY_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+struct async_memcpy_context_t;
+
+class AsyncCopy {
+public:
+    /**
+     * @brief 单次DMA拷贝完成回调（在中断上下文中执行，必须简短）
+     */
+    using DoneCallback = void (*)(void* arg);
+
+    /**
+     * @brief 一组拷贝的完成栅栏，由提交拷贝的任务独占使用
+     */
+    class Fence {
+    public:
+        explicit Fence(DoneCallback callback = nullptr, void* arg = nullptr);
+        ~Fence();
+
+        /**
+         * @brief 是否还有已提交但未等待的DMA拷贝
+         */
+        bool pending() const { return outstanding_ > 0; }
+
+    private:
+        friend class AsyncCopy;
+        SemaphoreHandle_t done_;
+        uint32_t outstanding_;
+        DoneCallback callback_;
+        void* callback_arg_;
+    };
+
+    /**
+     * @brief 拷贝统计
+     */
+    struct Stats {
+        uint32_t dma_copies;        // 交给GDMA的次数
+        uint32_t cpu_copies;        // CPU拷贝的次数（小块、不满足对齐、DMA队列满）
+        uint32_t cpu_fallbacks;     // 超过阈值但因对齐/内存类型/队列满退回CPU的次数
+        uint64_t dma_bytes;
+        uint64_t cpu_bytes;
+    };
+
+    /**
+     * @param threshold 达到这个字节数才考虑用DMA（更小的拷贝CPU更快）
+     */
+    explicit AsyncCopy(size_t threshold = DEFAULT_THRESHOLD);
+    ~AsyncCopy();
+
+    /**
+     * @brief 安装GDMA拷贝驱动
+     *
+     * 失败（或 CONFIG_AUDIO_ASYNC_COPY 关闭）时所有拷贝都走CPU，功能不受影响。
+     *
+     * @return ESP_OK=GDMA可用，其它=只用CPU
+     */
+    esp_err_t init();
+
+    /**
+     * @brief GDMA是否可用
+     */
+    bool isAvailable() const { return handle_ != nullptr; }
+
+    /**
+     * @brief 这次拷贝能否交给GDMA（阈值、内存类型、对齐）
+     */
+    bool canOffload(const void* dst, const void* src, size_t n) const;
+
+    /**
+     * @brief 提交一次拷贝
+     *
+     * 走CPU时返回前就已拷贝完成；走DMA时在 wait(fence) 返回前，
+     * src 不能修改、dst 不能读取。
+     *
+     * @return true=已交给GDMA，false=已由CPU完成
+     */
+    bool submit(Fence& fence, void* dst, const void* src, size_t n);
+
+    /**
+     * @brief 等待该栅栏上所有已提交的DMA拷贝完成
+     *
+     * 超时说明GDMA异常：栅栏清零，之后所有拷贝都走CPU。调用方要用CPU重新拷一遍
+     * 这个栅栏上的数据（目标区域不一定已经写完）。
+     *
+     * @return true=全部完成，false=超时（GDMA异常）
+     */
+    bool wait(Fence& fence, TickType_t timeout = pdMS_TO_TICKS(WAIT_TIMEOUT_MS));
+
+    /**
+     * @brief 同步拷贝：submit + wait，等待期间本任务让出CPU
+     */
+    void copy(Fence& fence, void* dst, const void* src, size_t n);
+
+    /**
+     * @brief 获取统计快照
+     */
+    Stats getStats() const;
+
+    static constexpr size_t DEFAULT_THRESHOLD = 1024;
+    static constexpr size_t PSRAM_ALIGN = 64;      // ESP32-S3 数据cache行
+    static constexpr size_t SRAM_ALIGN = 4;
+
+private:
+    struct IsrHandler;              // GDMA完成中断回调（定义在 .cc，依赖驱动头文件）
+    void cpuCopy(void* dst, const void* src, size_t n, bool fallback);
+
+    size_t threshold_;
+    async_memcpy_context_t* handle_;
+
+    std::atomic<uint32_t> dma_copies_;
+    std::atomic<uint32_t> cpu_copies_;
+    std::atomic<uint32_t> cpu_fallbacks_;
+    std::atomic<uint64_t> dma_bytes_;
+    std::atomic<uint64_t> cpu_bytes_;
+    std::atomic<bool> dma_failed_;      // 等待超时过一次，不再使用GDMA
+
+    static constexpr uint32_t BACKLOG = 8;          // 同时在途的拷贝数
+    static constexpr uint32_t WAIT_TIMEOUT_MS = 100;
+};
+
+#endif // ASYNC_COPY_H
@@ -0,0 +1,154 @@
+/**
+ * @file async_copy_bench.cc
+ * @brief 📊 异步拷贝基准测试实现
+ */
+
+#include "async_copy_bench.h"
+#include "async_copy.h"
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include <string.h>
+
+static const char *TAG = "CopyBench";
+
+static constexpr int BENCH_CORE = 0;                    // 主循环（唤醒词检测）所在的核
+static constexpr int64_t RUN_US = 1000 * 1000;          // 每种模式运行1秒
+static constexpr size_t PLAYER_CHUNK = 3200;            // 与默认播放块 STREAMING_CHUNK_MAX 相同
+static constexpr size_t RECORD_CHUNK = 1024;            // 一帧麦克风数据（512样本）
+static constexpr size_t PSRAM_BYTES = 64 * 1024;
+
+struct BenchContext {
+    AsyncCopy* copier;          // 空表示不拷贝（基线）
+    uint8_t* psram;
+    uint8_t* sram_play;
+    uint8_t* sram_record;
+    volatile bool running;
+    volatile uint32_t spins;    // 计数任务的循环次数
+    uint64_t copied_bytes;
+    SemaphoreHandle_t done;
+};
+
+/**
+ * @brief 低优先级计数任务，代表同一个核上的唤醒词检测
+ */
+static void spin_task(void* arg)
+{
+    BenchContext* ctx = (BenchContext*)arg;
+    while (ctx->running) {
+        ctx->spins++;
+    }
+    xSemaphoreGive(ctx->done);
+    vTaskDelete(NULL);
+}
+
+/**
+ * @brief 高优先级拷贝任务，交替模拟播放取数和录音追加
+ */
+static void copy_task(void* arg)
+{
+    BenchContext* ctx = (BenchContext*)arg;
+    AsyncCopy::Fence fence;
+    size_t play_pos = 0;
+    size_t record_pos = 0;
+    int64_t end = esp_timer_get_time() + RUN_US;
+
+    while (esp_timer_get_time() < end) {
+        if (ctx->copier == nullptr) {
+            vTaskDelay(pdMS_TO_TICKS(10));
+            continue;
+        }
+        ctx->copier->copy(fence, ctx->sram_play, ctx->psram + play_pos, PLAYER_CHUNK);
+        ctx->copier->copy(fence, ctx->psram + record_pos, ctx->sram_record, RECORD_CHUNK);
+        play_pos = (play_pos + PLAYER_CHUNK) % (PSRAM_BYTES - PLAYER_CHUNK);
+        record_pos = (record_pos + RECORD_CHUNK) % (PSRAM_BYTES / 2);
+        ctx->copied_bytes += PLAYER_CHUNK + RECORD_CHUNK;
+    }
+    ctx->running = false;
+    xSemaphoreGive(ctx->done);
+    vTaskDelete(NULL);
+}
+
+/**
+ * @brief 运行一种模式，返回计数任务的循环次数
+ */
+static uint32_t run_mode(BenchContext* ctx, AsyncCopy* copier)
+{
+    ctx->copier = copier;
+    ctx->running = true;
+    ctx->spins = 0;
+    ctx->copied_bytes = 0;
+    xTaskCreatePinnedToCore(spin_task, "bench_spin", 2048, ctx, 2, NULL, BENCH_CORE);
+    xTaskCreatePinnedToCore(copy_task, "bench_copy", 3072, ctx, 6, NULL, BENCH_CORE);
+    xSemaphoreTake(ctx->done, portMAX_DELAY);
+    xSemaphoreTake(ctx->done, portMAX_DELAY);
+    return ctx->spins;
+}
+
+void async_copy_bench_run(void)
+{
+    BenchContext ctx = {};
+    ctx.psram = (uint8_t*)heap_caps_aligned_alloc(AsyncCopy::PSRAM_ALIGN, PSRAM_BYTES, MALLOC_CAP_SPIRAM);
+    ctx.sram_play = (uint8_t*)heap_caps_aligned_alloc(AsyncCopy::PSRAM_ALIGN, PLAYER_CHUNK,
+                                                      MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    ctx.sram_record = (uint8_t*)heap_caps_aligned_alloc(AsyncCopy::PSRAM_ALIGN, RECORD_CHUNK,
+                                                        MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    ctx.done = xSemaphoreCreateCounting(2, 0);
+
+    // 阈值设为无穷大就是纯CPU拷贝
+    AsyncCopy cpu_copier(SIZE_MAX);
+    AsyncCopy dma_copier(RECORD_CHUNK);
+
+    if (ctx.psram == nullptr || ctx.sram_play == nullptr || ctx.sram_record == nullptr || ctx.done == nullptr) {
+        ESP_LOGW(TAG, "基准测试缓冲区分配失败");
+    } else if (dma_copier.init() != ESP_OK) {
+        ESP_LOGW(TAG, "GDMA不可用，跳过异步拷贝基准测试");
+    } else {
+        for (size_t i = 0; i < PSRAM_BYTES; i++) {
+            ctx.psram[i] = (uint8_t)(i * 7);
+        }
+        memset(ctx.sram_record, 0x5A, RECORD_CHUNK);
+
+        ESP_LOGI(TAG, "========== 异步拷贝基准测试 ==========");
+        uint32_t baseline = run_mode(&ctx, nullptr);
+        uint32_t with_cpu = run_mode(&ctx, &cpu_copier);
+        uint64_t cpu_bytes = ctx.copied_bytes;
+        uint32_t with_dma = run_mode(&ctx, &dma_copier);
+        uint64_t dma_bytes = ctx.copied_bytes;
+
+        // 最后一次播放取数的结果应与源数据一致
+        AsyncCopy::Fence fence;
+        dma_copier.copy(fence, ctx.sram_play, ctx.psram, PLAYER_CHUNK);
+        bool match = memcmp(ctx.sram_play, ctx.psram, PLAYER_CHUNK) == 0;
+
+        // 计数任务的循环次数折算成CPU周期（基线≈整核）
+        const double core_cycles = (double)CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ * 1e6 * (RUN_US / 1e6);
+        double cpu_share = baseline ? (double)with_cpu / baseline : 0;
+        double dma_share = baseline ? (double)with_dma / baseline : 0;
+        double cpu_mb = cpu_bytes / (1024.0 * 1024.0);
+        double dma_mb = dma_bytes / (1024.0 * 1024.0);
+
+        ESP_LOGI(TAG, "CPU拷贝:  %.1f MB/s，同核任务剩余 %.1f%% CPU", cpu_mb, cpu_share * 100);
+        ESP_LOGI(TAG, "GDMA拷贝: %.1f MB/s，同核任务剩余 %.1f%% CPU%s", dma_mb, dma_share * 100,
+                 match ? "" : " [数据不一致!]");
+        if (cpu_mb > 0 && dma_mb > 0) {
+            // 每搬1MB占用同核任务的CPU周期，两种方式之差就是GDMA省出来的
+            double cpu_cost = (1.0 - cpu_share) * core_cycles / cpu_mb;
+            double dma_cost = (1.0 - dma_share) * core_cycles / dma_mb;
+            double freed = cpu_cost - dma_cost;
+            ESP_LOGI(TAG, "每搬运1MB音频，GDMA为同核任务多留出约 %.0f 万个CPU周期", freed / 1e4);
+        }
+        ESP_LOGI(TAG, "======================================");
+    }
+
+    heap_caps_free(ctx.psram);
+    heap_caps_free(ctx.sram_play);
+    heap_caps_free(ctx.sram_record);
+    if (ctx.done != nullptr) {
+        vSemaphoreDelete(ctx.done);
+    }
+}
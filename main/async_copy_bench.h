@@ -0,0 +1,19 @@
+/**
+ * @file async_copy_bench.h
+ * @brief 📊 异步拷贝基准测试 - GDMA搬运能给同核任务省出多少CPU
+ *
+ * 启动时运行（CONFIG_AUDIO_ASYNC_COPY_BENCH）。在主循环所在的核上放一个
+ * 低优先级的计数任务代替唤醒词检测，一个高优先级任务按音频路径的模式
+ * 连续拷贝（环形缓冲区→播放缓冲区 3200 字节、麦克风帧→录音缓冲区 1024 字节），
+ * 分别用CPU和GDMA，比较计数任务拿到的CPU时间和拷贝吞吐。
+ */
+
+#ifndef ASYNC_COPY_BENCH_H
+#define ASYNC_COPY_BENCH_H
+
+/**
+ * @brief 运行基准测试并打印结果（阻塞，约3秒）
+ */
+void async_copy_bench_run(void);
+
+#endif // ASYNC_COPY_BENCH_H
@@ -0,0 +1,138 @@
+/**
+ * @file audio_frame_pool.cc
+ * @brief 🧊 音频帧池实现
+ */
+
+#include "audio_frame_pool.h"
+#include <new>
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+
+static const char *TAG = "FramePool";
+
+uint32_t AudioFrame::caps() const
+{
+    return pool_->caps();
+}
+
+void AudioFrame::release()
+{
+    // acq_rel：前面对数据的写入在帧被别人重新取走之前可见
+    if (refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        pool_->recycle(this);
+    }
+}
+
+AudioFramePool::AudioFramePool(const char* name, size_t block_size, size_t block_count, uint32_t caps)
+    : name_(name)
+    , block_size_((block_size + ALIGN - 1) & ~(ALIGN - 1))
+    , block_count_(block_count)
+    , caps_(caps)
+    , storage_(nullptr)
+    , frames_(nullptr)
+    , free_list_(nullptr)
+    , next_sequence_(0)
+    , in_use_(0)
+    , peak_in_use_(0)
+    , acquired_(0)
+    , exhausted_(0)
+{
+    portMUX_INITIALIZE(&lock_);
+}
+
+AudioFramePool::~AudioFramePool()
+{
+    if (in_use_ > 0) {
+        ESP_LOGW(TAG, "[%s] 销毁时仍有 %zu 帧未释放", name_, in_use_);
+    }
+    heap_caps_free(storage_);
+    heap_caps_free(frames_);
+}
+
+esp_err_t AudioFramePool::init()
+{
+    if (storage_ != nullptr) {
+        return ESP_OK;
+    }
+    storage_ = (uint8_t*)heap_caps_aligned_alloc(ALIGN, block_size_ * block_count_, caps_);
+    // 帧头总在内部RAM，引用计数操作不经过PSRAM
+    frames_ = (AudioFrame*)heap_caps_malloc(sizeof(AudioFrame) * block_count_, MALLOC_CAP_INTERNAL);
+    if (storage_ == nullptr || frames_ == nullptr) {
+        ESP_LOGE(TAG, "[%s] 帧池分配失败: %zu x %zu 字节", name_, block_count_, block_size_);
+        heap_caps_free(storage_);
+        heap_caps_free(frames_);
+        storage_ = nullptr;
+        frames_ = nullptr;
+        return ESP_ERR_NO_MEM;
+    }
+
+    free_list_ = nullptr;
+    for (size_t i = block_count_; i > 0; i--) {
+        AudioFrame* frame = new (&frames_[i - 1]) AudioFrame();
+        frame->data = storage_ + (i - 1) * block_size_;
+        frame->capacity = block_size_;
+        frame->length = 0;
+        frame->sequence = 0;
+        frame->pool_ = this;
+        frame->refs_.store(0);
+        frame->next_free_ = free_list_;
+        free_list_ = frame;
+    }
+    ESP_LOGI(TAG, "✓ [%s] 帧池就绪: %zu 帧 x %zu 字节 (caps=0x%lx)",
+             name_, block_count_, block_size_, (unsigned long)caps_);
+    return ESP_OK;
+}
+
+AudioFrame* AudioFramePool::acquire()
+{
+    portENTER_CRITICAL_SAFE(&lock_);
+    AudioFrame* frame = free_list_;
+    if (frame != nullptr) {
+        free_list_ = frame->next_free_;
+        frame->sequence = next_sequence_++;
+        in_use_++;
+        if (in_use_ > peak_in_use_) {
+            peak_in_use_ = in_use_;
+        }
+        acquired_++;
+    } else {
+        exhausted_++;
+    }
+    portEXIT_CRITICAL_SAFE(&lock_);
+
+    if (frame != nullptr) {
+        frame->next_free_ = nullptr;
+        frame->length = 0;
+        frame->refs_.store(1, std::memory_order_relaxed);
+    }
+    return frame;
+}
+
+void AudioFramePool::recycle(AudioFrame* frame)
+{
+    portENTER_CRITICAL_SAFE(&lock_);
+    frame->next_free_ = free_list_;
+    free_list_ = frame;
+    in_use_--;
+    portEXIT_CRITICAL_SAFE(&lock_);
+}
+
+bool AudioFramePool::owns(const void* ptr) const
+{
+    const uint8_t* p = (const uint8_t*)ptr;
+    return storage_ != nullptr && p >= storage_ && p < storage_ + block_size_ * block_count_;
+}
+
+AudioFramePool::Stats AudioFramePool::getStats() const
+{
+    Stats stats;
+    portENTER_CRITICAL_SAFE(&lock_);
+    stats.block_count = block_count_;
+    stats.block_size = block_size_;
+    stats.in_use = in_use_;
+    stats.peak_in_use = peak_in_use_;
+    stats.acquired = acquired_;
+    stats.exhausted = exhausted_;
+    portEXIT_CRITICAL_SAFE(&lock_);
+    return stats;
+}
@@ -0,0 +1,179 @@
+/**
+ * @file audio_frame_pool.h
+ * @brief 🧊 音频帧池 - 固定大小、cache行对齐、带引用计数的音频缓冲区
+ *
+ * 采集、编码、网络、播放各个环节原来各自 malloc 自己的缓冲区，
+ * 地址对齐随意，交给I2S/GDMA时驱动可能要额外回写/失效cache甚至用bounce buffer。
+ * 帧池一次分配一整块内存，切成固定大小的块：
+ *
+ * - 每块按cache行（64字节）对齐，大小向上取整到cache行，DMA可以直接使用
+ * - 池在创建时指定内存能力（MALLOC_CAP_DMA / MALLOC_CAP_SPIRAM ...），帧带着这个标签
+ * - 帧带引用计数，各环节传递帧句柄而不是拷贝数据，最后一个使用者释放时自动回到池里
+ * - 取帧/还帧只是一次很短的临界区链表操作，没有堆分配
+ */
+
+#ifndef AUDIO_FRAME_POOL_H
+#define AUDIO_FRAME_POOL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+class AudioFramePool;
+
+/**
+ * @brief 池中的一帧音频数据
+ */
+struct AudioFrame {
+    uint8_t* data;              // 数据区（cache行对齐）
+    size_t capacity;            // 数据区大小（字节）
+    size_t length;              // 有效数据（字节）
+    uint32_t sequence;          // 取帧时由池分配的递增序号
+
+    int16_t* samples() { return (int16_t*)data; }
+    const int16_t* samples() const { return (const int16_t*)data; }
+    size_t sampleCount() const { return length / sizeof(int16_t); }
+
+    /**
+     * @brief 帧所在内存的能力标签（MALLOC_CAP_*）
+     */
+    uint32_t caps() const;
+
+    /**
+     * @brief 增加一个引用
+     */
+    void retain() { refs_.fetch_add(1, std::memory_order_relaxed); }
+
+    /**
+     * @brief 释放一个引用，最后一个引用释放时帧回到池里
+     */
+    void release();
+
+    uint32_t refCount() const { return refs_.load(std::memory_order_relaxed); }
+
+private:
+    friend class AudioFramePool;
+    AudioFramePool* pool_;
+    AudioFrame* next_free_;
+    std::atomic<uint32_t> refs_;
+};
+
+/**
+ * @brief 帧句柄：拷贝即增加引用，析构即释放引用
+ */
+class AudioFrameRef {
+public:
+    AudioFrameRef() : frame_(nullptr) {}
+
+    /**
+     * @brief 接管一个已持有的引用（例如 AudioFramePool::acquire() 的返回值）
+     */
+    static AudioFrameRef adopt(AudioFrame* frame) { return AudioFrameRef(frame); }
+
+    AudioFrameRef(const AudioFrameRef& other) : frame_(other.frame_) {
+        if (frame_ != nullptr) frame_->retain();
+    }
+    AudioFrameRef(AudioFrameRef&& other) noexcept : frame_(other.frame_) { other.frame_ = nullptr; }
+    AudioFrameRef& operator=(AudioFrameRef other) noexcept {
+        AudioFrame* tmp = frame_;
+        frame_ = other.frame_;
+        other.frame_ = tmp;
+        return *this;
+    }
+    ~AudioFrameRef() { reset(); }
+
+    void reset() {
+        if (frame_ != nullptr) {
+            frame_->release();
+            frame_ = nullptr;
+        }
+    }
+
+    AudioFrame* get() const { return frame_; }
+    AudioFrame* operator->() const { return frame_; }
+    explicit operator bool() const { return frame_ != nullptr; }
+
+private:
+    explicit AudioFrameRef(AudioFrame* frame) : frame_(frame) {}
+    AudioFrame* frame_;
+};
+
+class AudioFramePool {
+public:
+    /**
+     * @brief 帧池统计
+     */
+    struct Stats {
+        size_t block_count;         // 总帧数
+        size_t block_size;          // 每帧字节数（已按cache行取整）
+        size_t in_use;              // 当前被引用的帧数
+        size_t peak_in_use;         // 历史最高
+        uint32_t acquired;          // 累计取帧次数
+        uint32_t exhausted;         // 池空导致取帧失败的次数
+    };
+
+    /**
+     * @param name 池名称（日志用）
+     * @param block_size 每帧最少字节数，会向上取整到cache行
+     * @param block_count 帧数
+     * @param caps 内存能力，例如 MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL
+     */
+    AudioFramePool(const char* name, size_t block_size, size_t block_count, uint32_t caps);
+    ~AudioFramePool();
+
+    /**
+     * @brief 分配帧存储
+     *
+     * @return ESP_OK=成功，ESP_ERR_NO_MEM=内存不足
+     */
+    esp_err_t init();
+
+    /**
+     * @brief 取一帧（引用计数为1，length为0）
+     *
+     * @return 帧指针，池空时返回 nullptr
+     */
+    AudioFrame* acquire();
+
+    /**
+     * @brief 取一帧并包装成句柄
+     */
+    AudioFrameRef acquireRef() { return AudioFrameRef::adopt(acquire()); }
+
+    uint32_t caps() const { return caps_; }
+    size_t blockSize() const { return block_size_; }
+
+    /**
+     * @brief 指针是否落在本池的存储区内
+     */
+    bool owns(const void* ptr) const;
+
+    /**
+     * @brief 获取统计快照
+     */
+    Stats getStats() const;
+
+    static constexpr size_t ALIGN = 64;         // ESP32-S3 数据cache行
+
+private:
+    friend struct AudioFrame;
+    void recycle(AudioFrame* frame);
+
+    const char* name_;
+    size_t block_size_;
+    size_t block_count_;
+    uint32_t caps_;
+    uint8_t* storage_;
+    AudioFrame* frames_;
+    AudioFrame* free_list_;
+    mutable portMUX_TYPE lock_;
+    uint32_t next_sequence_;
+    size_t in_use_;
+    size_t peak_in_use_;
+    uint32_t acquired_;
+    uint32_t exhausted_;
+};
+
+#endif // AUDIO_FRAME_POOL_H
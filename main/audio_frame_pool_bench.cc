@@ -0,0 +1,181 @@
+/**
+ * @file audio_frame_pool_bench.cc
+ * @brief 📊 帧池基准测试实现
+ */
+
+#include "audio_frame_pool_bench.h"
+#include "audio_frame_pool.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_cpu.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include <string.h>
+#include <stdlib.h>
+
+static const char *TAG = "PoolBench";
+
+static constexpr size_t FRAME_BYTES = 1024;             // 一帧麦克风数据（512样本）
+static constexpr size_t POOL_FRAMES = 16;
+static constexpr int LATENCY_ROUNDS = 2000;
+static constexpr int64_t THROUGHPUT_US = 500 * 1000;    // 每种传递方式运行0.5秒
+static constexpr UBaseType_t QUEUE_DEPTH = 8;
+
+struct LatencyResult {
+    uint32_t avg_cycles;
+    uint32_t max_cycles;
+};
+
+/**
+ * @brief 测一种“分配+释放”的CPU周期
+ */
+template <typename Alloc, typename Free>
+static LatencyResult measure(Alloc alloc, Free release)
+{
+    uint64_t total = 0;
+    uint32_t worst = 0;
+    for (int i = 0; i < LATENCY_ROUNDS; i++) {
+        uint32_t start = esp_cpu_get_cycle_count();
+        void* p = alloc();
+        release(p);
+        uint32_t cycles = esp_cpu_get_cycle_count() - start;
+        total += cycles;
+        if (cycles > worst) {
+            worst = cycles;
+        }
+    }
+    return { (uint32_t)(total / LATENCY_ROUNDS), worst };
+}
+
+struct ThroughputContext {
+    QueueHandle_t queue;
+    bool by_handle;
+    volatile bool running;
+    uint32_t frames;
+    SemaphoreHandle_t done;
+};
+
+/**
+ * @brief 消费者：取出一帧，读一下数据，释放
+ */
+static void consumer_task(void* arg)
+{
+    ThroughputContext* ctx = (ThroughputContext*)arg;
+    uint8_t item[FRAME_BYTES];
+    volatile uint32_t sink = 0;
+    while (true) {
+        if (ctx->by_handle) {
+            AudioFrame* frame = nullptr;
+            if (xQueueReceive(ctx->queue, &frame, pdMS_TO_TICKS(20)) != pdTRUE) {
+                if (!ctx->running) break;
+                continue;
+            }
+            if (frame == nullptr) break;
+            sink += frame->data[0];
+            frame->release();
+        } else {
+            if (xQueueReceive(ctx->queue, item, pdMS_TO_TICKS(20)) != pdTRUE) {
+                if (!ctx->running) break;
+                continue;
+            }
+            sink += item[0];
+        }
+        ctx->frames++;
+    }
+    xSemaphoreGive(ctx->done);
+    vTaskDelete(NULL);
+}
+
+/**
+ * @brief 在当前任务里生产帧，消费者放在另一个核上
+ *
+ * @return 每秒传递的帧数
+ */
+static double run_throughput(AudioFramePool* pool, bool by_handle, uint8_t* scratch)
+{
+    ThroughputContext ctx = {};
+    ctx.by_handle = by_handle;
+    ctx.running = true;
+    ctx.queue = xQueueCreate(QUEUE_DEPTH, by_handle ? sizeof(AudioFrame*) : FRAME_BYTES);
+    ctx.done = xSemaphoreCreateBinary();
+    if (ctx.queue == nullptr || ctx.done == nullptr) {
+        if (ctx.queue) vQueueDelete(ctx.queue);
+        if (ctx.done) vSemaphoreDelete(ctx.done);
+        return 0;
+    }
+    xTaskCreatePinnedToCore(consumer_task, "pool_consumer", 2048 + FRAME_BYTES, &ctx, 5, NULL, 1);
+
+    int64_t start = esp_timer_get_time();
+    int64_t end = start + THROUGHPUT_US;
+    while (esp_timer_get_time() < end) {
+        if (by_handle) {
+            AudioFrame* frame = pool->acquire();
+            if (frame == nullptr) {
+                vTaskDelay(1);
+                continue;
+            }
+            frame->data[0] = 1;
+            frame->length = FRAME_BYTES;
+            if (xQueueSend(ctx.queue, &frame, pdMS_TO_TICKS(20)) != pdTRUE) {
+                frame->release();
+            }
+        } else {
+            scratch[0] = 1;
+            xQueueSend(ctx.queue, scratch, pdMS_TO_TICKS(20));
+        }
+    }
+    ctx.running = false;
+    xSemaphoreTake(ctx.done, portMAX_DELAY);
+    int64_t elapsed = esp_timer_get_time() - start;
+
+    // 消费者退出时可能还有帧留在队列里
+    AudioFrame* leftover = nullptr;
+    while (by_handle && xQueueReceive(ctx.queue, &leftover, 0) == pdTRUE) {
+        leftover->release();
+    }
+    vQueueDelete(ctx.queue);
+    vSemaphoreDelete(ctx.done);
+    return ctx.frames / (elapsed / 1e6);
+}
+
+void audio_frame_pool_bench_run(void)
+{
+    AudioFramePool pool("bench", FRAME_BYTES, POOL_FRAMES, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    uint8_t* scratch = (uint8_t*)malloc(FRAME_BYTES);
+    if (pool.init() != ESP_OK || scratch == nullptr) {
+        ESP_LOGW(TAG, "帧池基准测试内存不足");
+        free(scratch);
+        return;
+    }
+    memset(scratch, 0, FRAME_BYTES);
+
+    ESP_LOGI(TAG, "========== 帧池基准测试 ==========");
+    LatencyResult pool_lat = measure([&]() -> void* { return pool.acquire(); },
+                                     [](void* p) { if (p) ((AudioFrame*)p)->release(); });
+    LatencyResult malloc_lat = measure([]() -> void* { return malloc(FRAME_BYTES); },
+                                       [](void* p) { free(p); });
+    LatencyResult aligned_lat = measure([]() -> void* {
+        return heap_caps_aligned_alloc(AudioFramePool::ALIGN, FRAME_BYTES, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    }, [](void* p) { heap_caps_free(p); });
+
+    ESP_LOGI(TAG, "取帧+还帧:            平均 %lu 周期，最坏 %lu 周期",
+             (unsigned long)pool_lat.avg_cycles, (unsigned long)pool_lat.max_cycles);
+    ESP_LOGI(TAG, "malloc+free:          平均 %lu 周期，最坏 %lu 周期",
+             (unsigned long)malloc_lat.avg_cycles, (unsigned long)malloc_lat.max_cycles);
+    ESP_LOGI(TAG, "对齐DMA分配+释放:     平均 %lu 周期，最坏 %lu 周期",
+             (unsigned long)aligned_lat.avg_cycles, (unsigned long)aligned_lat.max_cycles);
+
+    double by_copy = run_throughput(&pool, false, scratch);
+    double by_handle = run_throughput(&pool, true, scratch);
+    ESP_LOGI(TAG, "跨核传递 %zu 字节帧: 队列拷贝 %.0f 帧/秒，帧句柄 %.0f 帧/秒",
+             FRAME_BYTES, by_copy, by_handle);
+
+    AudioFramePool::Stats stats = pool.getStats();
+    ESP_LOGI(TAG, "帧池: 峰值占用 %zu/%zu，池空 %lu 次", stats.peak_in_use, stats.block_count,
+             (unsigned long)stats.exhausted);
+    ESP_LOGI(TAG, "==================================");
+    free(scratch);
+}
@@ -0,0 +1,18 @@
+/**
+ * @file audio_frame_pool_bench.h
+ * @brief 📊 帧池基准测试 - 取帧延迟和按句柄传递的吞吐
+ *
+ * 启动时运行（CONFIG_AUDIO_FRAME_POOL_BENCH）：
+ * - 延迟：取帧+还帧 vs malloc/free vs heap_caps_aligned_alloc/free，平均和最坏CPU周期
+ * - 吞吐：生产者→消费者跨核传递一帧音频，传句柄（帧池）vs 传数据（队列拷贝）
+ */
+
+#ifndef AUDIO_FRAME_POOL_BENCH_H
+#define AUDIO_FRAME_POOL_BENCH_H
+
+/**
+ * @brief 运行基准测试并打印结果（阻塞，约2秒）
+ */
+void audio_frame_pool_bench_run(void);
+
+#endif // AUDIO_FRAME_POOL_BENCH_H
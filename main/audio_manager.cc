@@ -13,77 +13,77 @@ extern "C" {
 #include "esp_heap_caps.h"
 }
 
+#include <utility>
 #include "audio_manager.h"
 
+#ifdef CONFIG_AUDIO_PLAYBACK_VOLUME
+#define PLAYBACK_VOLUME CONFIG_AUDIO_PLAYBACK_VOLUME
+#else
+#define PLAYBACK_VOLUME 100
+#endif
+
 const char* AudioManager::TAG = "AudioManager";
 
 AudioManager::AudioManager(uint32_t sample_rate, uint32_t recording_duration_sec, uint32_t response_duration_sec)
     : sample_rate(sample_rate)
     , recording_duration_sec(recording_duration_sec)
     , response_duration_sec(response_duration_sec)
-    , recording_buffer(nullptr)
     , recording_buffer_size(0)
     , recording_length(0)
     , is_recording(false)
+    , history_head(0)
+    , history_count(0)
     , response_buffer(nullptr)
     , response_buffer_size(0)
     , response_length(0)
     , response_played(false)
     , is_streaming(false)
+    , streaming_lock(xSemaphoreCreateMutex())
+    , ring_writer_active(false)
+    , streaming_generation(0)
+    , ring_writer_generation(0)
     , streaming_buffer(nullptr)
     , streaming_buffer_size(STREAMING_BUFFER_SIZE)
     , streaming_write_pos(0)
     , streaming_read_pos(0)
+    , streaming_chunk_size(STREAMING_CHUNK_MAX)
+    , player_deadline(nullptr)
     , aec_reference_queue(nullptr)
     , is_finishing(false) // 初始化
 {
     // 🧮 计算所需缓冲区大小
-    recording_buffer_size = sample_rate * recording_duration_sec;  // 录音缓冲区（样本数）
+    recording_buffer_size = sample_rate * recording_duration_sec;  // 录音时长上限（样本数）
     response_buffer_size = sample_rate * response_duration_sec * sizeof(int16_t);  // 响应缓冲区（字节数）
+    setPlaybackVolume(PLAYBACK_VOLUME);
 }
 
 AudioManager::~AudioManager() {
     deinit();
+    vSemaphoreDelete(streaming_lock);
 }
 
 esp_err_t AudioManager::init() {
     ESP_LOGI(TAG, "初始化音频管理器...");
     
-    // 分配录音缓冲区
-    recording_buffer = (int16_t*)malloc(recording_buffer_size * sizeof(int16_t));
-    if (recording_buffer == nullptr) {
-        ESP_LOGE(TAG, "录音缓冲区分配失败，需要 %zu 字节", 
-                 recording_buffer_size * sizeof(int16_t));
-        return ESP_ERR_NO_MEM;
-    }
-    ESP_LOGI(TAG, "✓ 录音缓冲区分配成功，大小: %zu 字节 (%lu 秒)", 
-             recording_buffer_size * sizeof(int16_t), (unsigned long)recording_duration_sec);
-    
     // 分配响应缓冲区
     response_buffer = (int16_t*)calloc(response_buffer_size / sizeof(int16_t), sizeof(int16_t));
     if (response_buffer == nullptr) {
         ESP_LOGE(TAG, "响应缓冲区分配失败，需要 %zu 字节", response_buffer_size);
-        free(recording_buffer);
-        recording_buffer = nullptr;
         return ESP_ERR_NO_MEM;
     }
     ESP_LOGI(TAG, "✓ 响应缓冲区分配成功，大小: %zu 字节 (%lu 秒)", 
              response_buffer_size, (unsigned long)response_duration_sec);
     
-    // 分配流式播放缓冲区
-    // 强制使用 PSRAM (外部内存)
-    streaming_buffer = (uint8_t*)heap_caps_malloc(streaming_buffer_size, MALLOC_CAP_SPIRAM);
-    
-    // 如果板子没有 PSRAM 或者分配失败，回退到内部 RAM (但大小可能不够)
+    // 分配流式播放缓冲区；整块分配不到时退回最小值，少缓冲一些也比启动失败强
+    streaming_buffer = allocStreamingBuffer(streaming_buffer_size);
     if (streaming_buffer == nullptr) {
-        ESP_LOGW(TAG, "PSRAM分配失败，尝试使用内部SRAM...");
-        streaming_buffer = (uint8_t*)malloc(streaming_buffer_size);
+        ESP_LOGW(TAG, "流式播放缓冲区 %zu 字节分配失败，退回 %zu 字节", streaming_buffer_size, STREAMING_BUFFER_MIN);
+        streaming_buffer_size = STREAMING_BUFFER_MIN;
+        streaming_buffer = allocStreamingBuffer(streaming_buffer_size);
     }
     if (streaming_buffer == nullptr) {
         ESP_LOGE(TAG, "流式播放缓冲区分配失败，需要 %zu 字节", streaming_buffer_size);
-        free(recording_buffer);
         free(response_buffer);
-        recording_buffer = nullptr;
         response_buffer = nullptr;
         return ESP_ERR_NO_MEM;
     }
@@ -94,16 +94,63 @@ esp_err_t AudioManager::init() {
     return ESP_OK;
 }
 
+uint8_t* AudioManager::allocStreamingBuffer(size_t size) {
+    // 优先 PSRAM (外部内存)
+    uint8_t* buf = (uint8_t*)heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
+    // 如果板子没有 PSRAM 或者分配失败，回退到内部 RAM
+    if (buf == nullptr) {
+        ESP_LOGW(TAG, "PSRAM分配失败，尝试使用内部SRAM...");
+        buf = (uint8_t*)malloc(size);
+    }
+    return buf;
+}
+
+esp_err_t AudioManager::setStreamingBufferSize(size_t size) {
+    // 网络任务随时可能开始播放（比如服务器主动推送的天气播报）：
+    // 检查和重新分配都在锁里，写入方拿到锁时看到的要么是旧缓冲区要么是新的
+    xSemaphoreTake(streaming_lock, portMAX_DELAY);
+    esp_err_t ret = resizeStreamingLocked(size);
+    xSemaphoreGive(streaming_lock);
+    return ret;
+}
+
+esp_err_t AudioManager::resizeStreamingLocked(size_t size) {
+    if (is_streaming || ring_writer_active) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (size > STREAMING_BUFFER_SIZE) size = STREAMING_BUFFER_SIZE;
+    if (size < STREAMING_BUFFER_MIN) size = STREAMING_BUFFER_MIN;
+    if (streaming_buffer != nullptr && size == streaming_buffer_size) {
+        return ESP_OK;
+    }
+
+    size_t old_size = streaming_buffer_size;
+    heap_caps_free(streaming_buffer);
+    streaming_buffer = allocStreamingBuffer(size);
+    if (streaming_buffer == nullptr && size > STREAMING_BUFFER_MIN) {
+        size = STREAMING_BUFFER_MIN;
+        streaming_buffer = allocStreamingBuffer(size);
+    }
+    streaming_write_pos = 0;
+    streaming_read_pos = 0;
+    streaming_generation++;
+    if (streaming_buffer == nullptr) {
+        streaming_buffer_size = 0;
+        ESP_LOGE(TAG, "流式播放缓冲区重新分配失败");
+        return ESP_ERR_NO_MEM;
+    }
+    streaming_buffer_size = size;
+    ESP_LOGI(TAG, "流式播放缓冲区: %zu -> %zu 字节", old_size, size);
+    return ESP_OK;
+}
+
 void AudioManager::deinit() {
     if (player_task_handle != nullptr) {
         vTaskDelete(player_task_handle);
         player_task_handle = nullptr;
     }
 
-    if (recording_buffer != nullptr) {
-        free(recording_buffer);
-        recording_buffer = nullptr;
-    }
+    clearRecordingHistory();
     
     if (response_buffer != nullptr) {
         free(response_buffer);
@@ -120,6 +167,7 @@ void AudioManager::deinit() {
 // 🎙️ ========== 录音功能实现 ==========
 
 void AudioManager::startRecording() {
+    clearRecordingHistory();
     is_recording = true;
     recording_length = 0;
     ESP_LOGI(TAG, "开始录音...");
@@ -127,34 +175,68 @@ void AudioManager::startRecording() {
 
 void AudioManager::stopRecording() {
     is_recording = false;
+    clearRecordingHistory();    // 历史只用于开始说话时的补发，及时把帧还给帧池
     ESP_LOGI(TAG, "停止录音，当前长度: %zu 样本 (%.2f 秒)", 
              recording_length, getRecordingDuration());
 }
 
-bool AudioManager::addRecordingData(const int16_t* data, size_t samples) {
-    if (!is_recording || recording_buffer == nullptr) {
+bool AudioManager::addRecordingFrame(AudioFrame* frame, bool keep_history) {
+    if (!is_recording || frame == nullptr) {
         return false;
     }
     
-    // 📏 检查缓冲区是否还有空间
+    // 📏 检查是否超过录音时长上限
+    size_t samples = frame->sampleCount();
     if (recording_length + samples > recording_buffer_size) {
-        ESP_LOGW(TAG, "录音缓冲区已满（超过10秒上限）");
+        ESP_LOGW(TAG, "录音已达上限（超过10秒）");
         return false;
     }
     
-    // 💾 将新的音频数据追加到缓冲区末尾
-    memcpy(&recording_buffer[recording_length], data, samples * sizeof(int16_t));
+    // 💾 只记引用不拷贝数据；历史满了覆盖最旧的一帧
+    if (keep_history) {
+        frame->retain();
+        size_t slot = (history_head + history_count) % RECORDING_HISTORY_FRAMES;
+        if (history_count == RECORDING_HISTORY_FRAMES) {
+            history_head = (history_head + 1) % RECORDING_HISTORY_FRAMES;
+        } else {
+            history_count++;
+        }
+        recording_history[slot] = AudioFrameRef::adopt(frame);
+    }
     recording_length += samples;
     
     return true;
 }
 
-const int16_t* AudioManager::getRecordingBuffer(size_t& length) const {
-    length = recording_length;
-    return recording_buffer;
+size_t AudioManager::takeRecentFrames(size_t max_samples, AudioFrameRef* out, size_t max_frames) {
+    // 从最新的一帧往前数，直到覆盖 max_samples
+    size_t take = 0;
+    size_t samples = 0;
+    while (take < history_count && take < max_frames && samples < max_samples) {
+        size_t slot = (history_head + history_count - 1 - take) % RECORDING_HISTORY_FRAMES;
+        samples += recording_history[slot]->sampleCount();
+        take++;
+    }
+
+    size_t first = history_count - take;
+    for (size_t i = 0; i < take; i++) {
+        size_t slot = (history_head + first + i) % RECORDING_HISTORY_FRAMES;
+        out[i] = std::move(recording_history[slot]);
+    }
+    clearRecordingHistory();
+    return take;
+}
+
+void AudioManager::clearRecordingHistory() {
+    for (size_t i = 0; i < RECORDING_HISTORY_FRAMES; i++) {
+        recording_history[i].reset();
+    }
+    history_head = 0;
+    history_count = 0;
 }
 
 void AudioManager::clearRecordingBuffer() {
+    clearRecordingHistory();
     recording_length = 0;
 }
 
@@ -241,17 +323,29 @@ esp_err_t AudioManager::playAudio(const uint8_t* audio_data, size_t data_len, co
 
 void AudioManager::startStreamingPlayback() {
     ESP_LOGI(TAG, "开始流式音频播放");
+    xSemaphoreTake(streaming_lock, portMAX_DELAY);
     is_streaming = true;
     streaming_write_pos = 0;
     streaming_read_pos = 0;
+    // 网络层可能正收到一半（直接写入还没提交），那段数据属于上一段音频，提交时按代数丢弃
+    streaming_generation++;
     
     // 清空缓冲区
     if (streaming_buffer) {
         memset(streaming_buffer, 0, streaming_buffer_size);
     }
+    xSemaphoreGive(streaming_lock);
 }
 
 bool AudioManager::addStreamingAudioChunk(const uint8_t* data, size_t size) {
+    // 持锁拷贝：播放任务收尾后 is_streaming 会变成 false，锁保证拷贝途中缓冲区不被重新分配
+    xSemaphoreTake(streaming_lock, portMAX_DELAY);
+    bool ok = writeStreamingLocked(data, size);
+    xSemaphoreGive(streaming_lock);
+    return ok;
+}
+
+bool AudioManager::writeStreamingLocked(const uint8_t* data, size_t size) {
     if (!is_streaming || !streaming_buffer || !data) {
         return false;
     }
@@ -272,6 +366,7 @@ bool AudioManager::addStreamingAudioChunk(const uint8_t* data, size_t size) {
     }
     
     // 📝 将数据写入环形缓冲区
+    // 用CPU拷贝：拷完才能移动写指针，交给GDMA也只能在锁里原地等它，省不出时间
     size_t bytes_to_end = streaming_buffer_size - streaming_write_pos;
     if (size <= bytes_to_end) {
         // 简单情况：数据不跨越缓冲区末尾
@@ -295,6 +390,52 @@ bool AudioManager::addStreamingAudioChunk(const uint8_t* data, size_t size) {
     return true;
 }
 
+uint8_t* AudioManager::acquireStreamingWrite(size_t want, size_t* granted) {
+    *granted = 0;
+    xSemaphoreTake(streaming_lock, portMAX_DELAY);
+    if (!is_streaming || !streaming_buffer) {
+        xSemaphoreGive(streaming_lock);
+        return nullptr;
+    }
+
+    // 与 addStreamingAudioChunk 相同，保留1字节区分满和空
+    size_t available_space;
+    if (streaming_write_pos >= streaming_read_pos) {
+        available_space = streaming_buffer_size - (streaming_write_pos - streaming_read_pos) - 1;
+    } else {
+        available_space = streaming_read_pos - streaming_write_pos - 1;
+    }
+    size_t bytes_to_end = streaming_buffer_size - streaming_write_pos;
+    size_t n = want;
+    if (n > available_space) n = available_space;
+    if (n > bytes_to_end) n = bytes_to_end;
+    if (n == 0) {
+        xSemaphoreGive(streaming_lock);
+        return nullptr;
+    }
+    *granted = n;
+    // 网络层收数据期间不持锁（recv可能阻塞），只标记有写入方在用这段缓冲区
+    ring_writer_active = true;
+    ring_writer_generation = streaming_generation;
+    uint8_t* dst = streaming_buffer + streaming_write_pos;
+    xSemaphoreGive(streaming_lock);
+    return dst;
+}
+
+void AudioManager::commitStreamingWrite(size_t size) {
+    xSemaphoreTake(streaming_lock, portMAX_DELAY);
+    if (ring_writer_generation != streaming_generation) {
+        ESP_LOGD(TAG, "流式播放已重新开始，丢弃旧的直接写入: %zu 字节", size);
+    } else {
+        streaming_write_pos += size;
+        if (streaming_write_pos >= streaming_buffer_size) {
+            streaming_write_pos = 0;
+        }
+    }
+    ring_writer_active = false;
+    xSemaphoreGive(streaming_lock);
+}
+
 void AudioManager::finishStreamingPlayback() {
     if (!is_streaming) {
         return;
@@ -307,23 +448,25 @@ void AudioManager::finishStreamingPlayback() {
 void AudioManager::player_task(void* pvParameters) {
     AudioManager* manager = (AudioManager*)pvParameters;
     // 在堆上分配临时缓冲区，而不是在栈上
-    uint8_t* temp_buffer = (uint8_t*)malloc(STREAMING_CHUNK_SIZE);
+    uint8_t* temp_buffer = (uint8_t*)malloc(STREAMING_CHUNK_MAX);
     if (temp_buffer == nullptr) {
         ESP_LOGE(TAG, "播放任务临时缓冲区分配失败！任务退出。");
         vTaskDelete(NULL);
         return;
     }
     while (1) {
+        DeadlineLoop* deadline = manager->player_deadline;
+        const size_t chunk_size = manager->streaming_chunk_size;
         // 检查是否在流式播放模式
         if (!manager->is_streaming) {
+            if (deadline != nullptr) deadline->skip();
             vTaskDelay(pdMS_TO_TICKS(100));
             continue;
         }
 
         // 检查缓冲区数据量
-        // 注意：这里需要处理一下线程安全，或者简单点，直接读取
-        // 因为是单生产者(Net)-单消费者(Audio)，简单的读写指针操作通常是安全的，
-        // 但为了严谨，最好加个互斥锁。不过为了演示，我们先用简单逻辑：
+        // 按整块读取不加锁：单生产者(Net)-单消费者(Audio)，读指针只有本任务写；
+        // 收尾时要同时重置读写位置，那一步持锁（见下面的 is_finishing 分支）
         
         size_t available_data;
         if (manager->streaming_write_pos >= manager->streaming_read_pos) {
@@ -332,16 +475,16 @@ void AudioManager::player_task(void* pvParameters) {
             available_data = manager->streaming_buffer_size - manager->streaming_read_pos + manager->streaming_write_pos;
         }
 
-        if (available_data >= STREAMING_CHUNK_SIZE) {
+        if (available_data >= chunk_size) {
             // 从环形缓冲区读取数据
             size_t bytes_to_end = manager->streaming_buffer_size - manager->streaming_read_pos;
-            if (STREAMING_CHUNK_SIZE <= bytes_to_end) {
-                memcpy(temp_buffer, manager->streaming_buffer + manager->streaming_read_pos, STREAMING_CHUNK_SIZE);
-                manager->streaming_read_pos += STREAMING_CHUNK_SIZE;
+            if (chunk_size <= bytes_to_end) {
+                memcpy(temp_buffer, manager->streaming_buffer + manager->streaming_read_pos, chunk_size);
+                manager->streaming_read_pos += chunk_size;
             } else {
                 memcpy(temp_buffer, manager->streaming_buffer + manager->streaming_read_pos, bytes_to_end);
-                memcpy(temp_buffer + bytes_to_end, manager->streaming_buffer, STREAMING_CHUNK_SIZE - bytes_to_end);
-                manager->streaming_read_pos = STREAMING_CHUNK_SIZE - bytes_to_end;
+                memcpy(temp_buffer + bytes_to_end, manager->streaming_buffer, chunk_size - bytes_to_end);
+                manager->streaming_read_pos = chunk_size - bytes_to_end;
             }
 
             // 环形回绕
@@ -349,59 +492,113 @@ void AudioManager::player_task(void* pvParameters) {
                 manager->streaming_read_pos = 0;
             }
 
+            manager->processPlayback(temp_buffer, chunk_size);
+
             // 播放！(这里是阻塞的，但因为在独立任务里，不会卡住网络接收)
             // 播放 (这里阻塞是没问题的，因为是在独立任务里)
-            esp_err_t ret = bsp_play_audio_stream(temp_buffer, STREAMING_CHUNK_SIZE);
+            // 从上一次写完到这里是本块的处理时间（含等数据）；写I2S阻塞到DMA有空位为止
+            if (deadline != nullptr) deadline->waitStart();
+            esp_err_t ret = bsp_play_audio_stream(temp_buffer, chunk_size);
+            if (deadline != nullptr) deadline->stamp();
             if (ret != ESP_OK) {
                 ESP_LOGE(TAG, "流式播放I2S写入失败: %s", esp_err_to_name(ret));
             }
             // 发送 AEC 参考信号
             int16_t* audio_samples = (int16_t*)temp_buffer;
-            size_t sample_count = STREAMING_CHUNK_SIZE / sizeof(int16_t);
+            size_t sample_count = chunk_size / sizeof(int16_t);
             manager->sendAECReference(audio_samples, sample_count);
             
-        } else if (manager->is_finishing && available_data > 0) {
-            // --- 收尾阶段：播放剩余的不足一个块的数据 ---
-            ESP_LOGI(TAG, "任务处理剩余尾巴: %zu 字节", available_data);
+        } else if (manager->is_finishing) {
+            // --- 收尾阶段：播放剩余的不足一个块的数据，然后重置 ---
+            // 重置读写位置要持锁；网络层还有没提交的直接写入时不能重置，等它提交
+            xSemaphoreTake(manager->streaming_lock, portMAX_DELAY);
+            if (manager->ring_writer_active) {
+                xSemaphoreGive(manager->streaming_lock);
+                vTaskDelay(1);
+                continue;
+            }
+            size_t write_pos = manager->streaming_write_pos;
+            size_t read_pos = manager->streaming_read_pos;
+            size_t tail = write_pos >= read_pos ? write_pos - read_pos
+                                                : manager->streaming_buffer_size - read_pos + write_pos;
+            if (tail >= chunk_size) {
+                // 判断之后又写进来了数据，先按整块播放
+                xSemaphoreGive(manager->streaming_lock);
+                continue;
+            }
 
             // 这里可以用 temp_buffer 复用，不用再 malloc temp_chunk 了，省内存
-            // 读取剩余数据
-            if (manager->streaming_write_pos >= manager->streaming_read_pos) {
-                memcpy(temp_buffer, manager->streaming_buffer + manager->streaming_read_pos, available_data);
+            if (write_pos >= read_pos) {
+                memcpy(temp_buffer, manager->streaming_buffer + read_pos, tail);
             } else {
-                size_t bytes_to_end = manager->streaming_buffer_size - manager->streaming_read_pos;
-                memcpy(temp_buffer, manager->streaming_buffer + manager->streaming_read_pos, bytes_to_end);
-                memcpy(temp_buffer + bytes_to_end, manager->streaming_buffer, available_data - bytes_to_end);
+                size_t bytes_to_end = manager->streaming_buffer_size - read_pos;
+                memcpy(temp_buffer, manager->streaming_buffer + read_pos, bytes_to_end);
+                memcpy(temp_buffer + bytes_to_end, manager->streaming_buffer, tail - bytes_to_end);
             }
-
-            bsp_play_audio_stream(temp_buffer, available_data);
-            
-            // 播放完毕，重置状态
             manager->streaming_read_pos = 0;
             manager->streaming_write_pos = 0;
+            manager->streaming_generation++;
             manager->is_finishing = false;
             manager->is_streaming = false; // 任务自己宣布下班
-            
+            xSemaphoreGive(manager->streaming_lock);
+
+            if (tail > 0) {
+                ESP_LOGI(TAG, "任务处理剩余尾巴: %zu 字节", tail);
+                manager->processPlayback(temp_buffer, tail);
+                bsp_play_audio_stream(temp_buffer, tail);
+            }
+            if (deadline != nullptr) deadline->skip();
+
             // 停止 I2S 输出以防噪音
             bsp_audio_stop();
-            ESP_LOGI(TAG, "流式播放自然结束");
+            if (tail > 0) {
+                ESP_LOGI(TAG, "流式播放自然结束");
+            } else {
+                ESP_LOGI(TAG, "流式播放自然结束 (无剩余数据)");
+            }
 
-        } else if (manager->is_finishing && available_data == 0) {
-            // --- 收尾阶段：没有数据了 ---
-            manager->is_finishing = false;
-            manager->is_streaming = false;
-            bsp_audio_stop();
-            ESP_LOGI(TAG, "流式播放自然结束 (无剩余数据)");
-            
         } else {
             // 数据不够，休息一下，避免死循环占用 CPU
-            vTaskDelay(pdMS_TO_TICKS(10)); 
+            // 最多等半个块（不超过10ms），低延迟配置的小块也来得及接上
+            uint32_t wait_ms = chunk_size / sizeof(int16_t) * 1000 / manager->sample_rate / 2;
+            vTaskDelay(pdMS_TO_TICKS(wait_ms >= 10 ? 10 : (wait_ms > 0 ? wait_ms : 1)));
         }
     }
     // 理论上不会运行到这里，但为了严谨，如果任务退出要释放内存
     free(temp_buffer);
 }
 
+esp_err_t AudioManager::setPlaybackChunkMs(uint32_t ms) {
+    size_t bytes = (size_t)sample_rate * ms / 1000 * sizeof(int16_t);
+    if (ms < 10 || bytes > STREAMING_CHUNK_MAX) {
+        ESP_LOGE(TAG, "播放块长度超出范围: %lu ms", (unsigned long)ms);
+        return ESP_ERR_INVALID_ARG;
+    }
+    streaming_chunk_size = bytes;
+    ESP_LOGI(TAG, "播放块: %lu ms (%zu 字节)", (unsigned long)ms, bytes);
+    return ESP_OK;
+}
+
+void AudioManager::setPlaybackVolume(int percent) {
+    if (percent < 10) percent = 10;
+    if (percent > 400) percent = 400;
+    playback_chain.stage<0>().q8 = percent * 256 / 100;
+    ESP_LOGI(TAG, "播放音量: %d%%", percent);
+}
+
+void AudioManager::processPlayback(uint8_t* data, size_t len) {
+    int16_t* samples = (int16_t*)data;
+    size_t count = len / sizeof(int16_t);
+    // 原音量时只跳过增益：服务器发来的满幅样本仍要经过限幅
+    if (playback_chain.stage<0>().q8 == 256) {
+        const auto& clip = playback_chain.stage<1>();
+        for (size_t i = 0; i < count; i++) {
+            samples[i] = (int16_t)clip.sample(samples[i]);
+        }
+        return;
+    }
+    playback_chain.process(samples, count);
+}
 
 // 🔇 ========== AEC支持功能实现 ==========
 
@@ -5,7 +5,7 @@
  * 这个类就像一个“音频指挥家”，负责协调所有音频相关的工作：
  * 
  * 🎙️ 录音功能：
- * - 管理录音缓冲区（最多10秒）
+ * - 按引用保存最近的采集帧（补发用），录音时长最多10秒
  * - 控制录音的开始/停止
  * - 跟踪录音时长
  * 
@@ -27,7 +27,11 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/queue.h"
+#include "freertos/semphr.h"
 #include "esp_err.h"
+#include "audio_frame_pool.h"
+#include "deadline_monitor.h"
+#include "dsp_pipeline.h"
 
 class AudioManager {
 public:
@@ -82,25 +86,30 @@ public:
     bool isRecording() const { return is_recording; }
 
     /**
-     * @brief 添加音频数据到录音缓冲区
+     * @brief 把一帧采集数据记入录音
      * 
-     * 每次从麦克风读到数据后，用这个函数保存起来。
+     * 每次从麦克风读到数据后调用。不拷贝数据：keep_history 为 true 时
+     * 增加一个引用放进最近帧历史（补发用），历史满了自动丢弃最旧的一帧。
+     * 已经在实时上传时不需要历史，传 false，帧只计入录音时长。
      * 
-     * @param data 音频数据指针
-     * @param samples 样本数量（注意：不是字节数！）
-     * @return true=添加成功，false=缓冲区满了
+     * @param frame 采集帧（调用方仍持有自己的引用）
+     * @param keep_history 是否保留到历史中
+     * @return true=添加成功，false=未在录音或已达时长上限
      */
-    bool addRecordingData(const int16_t* data, size_t samples);
+    bool addRecordingFrame(AudioFrame* frame, bool keep_history);
 
     /**
-     * @brief 获取录音数据
+     * @brief 取出历史中最近的若干帧（从旧到新），并清空历史
      * 
-     * 用于获取已经录制的全部音频数据。
+     * 取出的帧引用交给调用方，历史不再持有，调用方可以把它们当作
+     * 唯一持有者处理（例如原地掩码发送）。
      * 
-     * @param[out] length 会被设置为录音的样本数
-     * @return 指向录音数据的指针
+     * @param max_samples 要覆盖的样本数（按整帧，从最新的往前数）
+     * @param[out] out 帧引用数组
+     * @param max_frames out 的容量
+     * @return 取出的帧数
      */
-    const int16_t* getRecordingBuffer(size_t& length) const;
+    size_t takeRecentFrames(size_t max_samples, AudioFrameRef* out, size_t max_frames);
 
     /**
      * @brief 清空录音缓冲区
@@ -170,6 +179,28 @@ public:
      * @return true=添加成功，false=缓冲区满
      */
     bool addStreamingAudioChunk(const uint8_t* data, size_t size);
+
+    /**
+     * @brief 获取环形缓冲区中一段可直接写入的连续空间（零拷贝接收）
+     * 
+     * 网络层把数据直接收进返回的地址，再调用 commitStreamingWrite()。
+     * 空间在缓冲区末尾处截断，剩余部分下次再取。
+     * 
+     * @param want 希望写入的字节数
+     * @param granted 实际可写的字节数
+     * @return 写入地址，nullptr=未在流式播放或缓冲区已满
+     */
+    uint8_t* acquireStreamingWrite(size_t want, size_t* granted);
+
+    /**
+     * @brief 提交直接写入环形缓冲区的数据
+     * 
+     * 每次成功的 acquireStreamingWrite() 都要对应一次提交，接收失败时提交0字节。
+     * 接收期间流式播放被重新开始（读写位置已重置）时，这段数据属于上一段音频，直接丢弃。
+     *
+     * @param size 实际写入的字节数（不超过 acquireStreamingWrite 给出的大小）
+     */
+    void commitStreamingWrite(size_t size);
     
     /**
      * @brief 结束流式播放
@@ -184,6 +215,15 @@ public:
      * @return true 正在播放，false 未在播放
      */
     bool isStreamingActive() const { return is_streaming; }
+
+    /**
+     * @brief 环形缓冲区里等待播放的字节数（播放任务读走之前的排队量）
+     */
+    size_t getStreamingBufferedBytes() const {
+        size_t w = streaming_write_pos;
+        size_t r = streaming_read_pos;
+        return w >= r ? w - r : streaming_buffer_size - r + w;
+    }
     
     /**
      * @brief 标记流式播放已完成
@@ -252,12 +292,14 @@ public:
     uint32_t getSampleRate() const { return sample_rate; }
 
     /**
-     * @brief 获取录音缓冲区大小（样本数）
+     * @brief 获取最大录音长度（样本数）
      * 
-     * @return 缓冲区大小
+     * @return 最大样本数
      */
     size_t getRecordingBufferSize() const { return recording_buffer_size; }
 
+    static const size_t RECORDING_HISTORY_FRAMES = 20;  // 最近帧历史（512样本/帧时约640ms，够500ms补发）
+
     /**
      * @brief 获取响应缓冲区大小（字节）
      * 
@@ -265,6 +307,71 @@ public:
      */
     size_t getResponseBufferSize() const { return response_buffer_size; }
 
+    /**
+     * @brief 获取流式播放环形缓冲区容量（字节），握手时告知服务器
+     * 
+     * @return 缓冲区容量
+     */
+    static constexpr size_t getStreamingBufferCapacity() { return STREAMING_BUFFER_SIZE; }
+
+    /**
+     * @brief 当前实际分配的环形缓冲区大小（字节），内存紧张时可能小于 getStreamingBufferCapacity()
+     */
+    size_t getStreamingBufferSize() const { return streaming_buffer_size; }
+
+    /**
+     * @brief 重新分配流式播放环形缓冲区（内存紧张时缩小，缓解后恢复）
+     *
+     * 只能在没有流式播放时调用。先释放旧缓冲区再分配（内存紧张时两块可能同时放不下），
+     * 分配失败退回 STREAMING_BUFFER_MIN。和写入方（开始播放、添加数据、直接接收）及播放任务的收尾重置共用一把锁，
+     * 其他任务同时开始播放也不会写到已释放的缓冲区。
+     *
+     * @param size 新的大小（字节），不超过 getStreamingBufferCapacity()
+     * @return ESP_OK=成功（大小可能退回最小值），ESP_ERR_INVALID_STATE=正在流式播放，ESP_ERR_NO_MEM=连最小值都分配不到
+     */
+    esp_err_t setStreamingBufferSize(size_t size);
+
+    static constexpr size_t STREAMING_BUFFER_MIN = 65536;  // 64KB，16kHz下约2秒
+
+    /**
+     * @brief 设置播放音量
+     *
+     * 超过100%时由软限幅压住峰值；100%时播放链路不处理数据。
+     *
+     * @param percent 音量百分比（10~400）
+     */
+    void setPlaybackVolume(int percent);
+
+    /**
+     * @brief 播放处理链（音量 + 软限幅）原地处理一块PCM
+     *
+     * 播放任务在写I2S之前调用；回归测试工具也直接调用，保证测的是同一条路径。
+     */
+    void processPlayback(uint8_t* data, size_t len);
+
+    /**
+     * @brief 设置流式播放每次写I2S的块长度
+     *
+     * 块越小，下行数据越早送进DMA，但播放任务唤醒越频繁；
+     * 低延迟配置用10~20ms，默认100ms。播放中修改从下一块开始生效。
+     *
+     * @param ms 块时长（毫秒），10 ~ STREAMING_CHUNK_MAX 对应的时长
+     * @return ESP_OK=成功，ESP_ERR_INVALID_ARG=超出范围
+     */
+    esp_err_t setPlaybackChunkMs(uint32_t ms);
+
+    /**
+     * @brief 一个播放块的时长（微秒），播放任务每隔这么久必须写一次I2S
+     */
+    uint32_t getPlaybackChunkUs() const {
+        return (uint32_t)((uint64_t)streaming_chunk_size / sizeof(int16_t) * 1000000 / sample_rate);
+    }
+
+    /**
+     * @brief 给播放任务挂上截止时间记账（见 deadline_monitor.h），nullptr=不记账
+     */
+    void setPlayerDeadline(DeadlineLoop* loop) { player_deadline = loop; }
+
 private:
     // 🎶 音频参数
     uint32_t sample_rate;               // 采样率（Hz）
@@ -272,10 +379,13 @@ private:
     uint32_t response_duration_sec;     // 最大回复时长（秒）
 
     // 🎙️ 录音相关变量
-    int16_t* recording_buffer;          // 录音数据缓冲区
-    size_t recording_buffer_size;       // 缓冲区大小（样本数）
+    size_t recording_buffer_size;       // 最大录音长度（样本数）
     size_t recording_length;            // 已录制的样本数
     bool is_recording;                  // 是否正在录音
+    AudioFrameRef recording_history[RECORDING_HISTORY_FRAMES];
+    size_t history_head;                // 最旧一帧的位置
+    size_t history_count;               // 历史中的帧数
+    void clearRecordingHistory();
 
     // 🔊 响应音频相关变量
     int16_t* response_buffer;           // AI回复音频缓冲区
@@ -286,14 +396,27 @@ private:
     
     // 🌊 流式播放相关变量
     bool is_streaming;                  // 是否在流式播放中
+    SemaphoreHandle_t streaming_lock;   // 保护环形缓冲区指针、大小和读写位置不被重新分配打断（见 setStreamingBufferSize）
+    bool ring_writer_active;            // acquireStreamingWrite 给出的空间还没提交
+    uint32_t streaming_generation;      // 每次重置读写位置加一
+    uint32_t ring_writer_generation;    // acquireStreamingWrite 时的 streaming_generation，提交时不同就丢弃
     uint8_t* streaming_buffer;          // 环形缓冲区
     size_t streaming_buffer_size;       // 缓冲区大小
     size_t streaming_write_pos;         // 写入位置
     size_t streaming_read_pos;          // 读取位置
     static const size_t STREAMING_BUFFER_SIZE = 204800; // 200KB环形缓冲区
-    static const size_t STREAMING_CHUNK_SIZE = 3200;   // 每次播放3200字节（200ms）
+    static uint8_t* allocStreamingBuffer(size_t size);
+    esp_err_t resizeStreamingLocked(size_t size);
+    bool writeStreamingLocked(const uint8_t* data, size_t size);
+    static const size_t STREAMING_CHUNK_MAX = 3200;    // 播放块上限，也是默认值（16kHz下100ms）
+    volatile size_t streaming_chunk_size;               // 每次写I2S的字节数
+
+    // 🎛️ 播放处理链：音量 + 软限幅，一次遍历完成（AEC参考用的也是处理后的数据）
+    using PlaybackChain = dsp::Pipeline<dsp::Gain, dsp::SoftClip<>>;
+    PlaybackChain playback_chain;
 
     TaskHandle_t player_task_handle; // 播放任务句柄
+    DeadlineLoop* volatile player_deadline;     // 播放任务的截止时间记账
     static void player_task(void* pvParameters); // 静态任务函数
 
     // 🔇 AEC参考音频队列
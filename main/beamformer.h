@@ -0,0 +1,270 @@
+/**
+ * @file beamformer.h
+ * @brief 🎯 双麦克风延迟求和波束形成 - 两路采集合成一路，对准说话人方向
+ *
+ * 两个麦克风相距几厘米，同一个声源到达两边有几个样本的时间差。把先到的一路延迟这么多样本再相加，
+ * 说话人的声音同相叠加，各麦克风自己的噪声和其他方向来的声音叠加时部分抵消：
+ * 不相关噪声理论上提高 3dB，偏离波束方向的干扰视频率和角度衰减更多。
+ *
+ * - 固定模式：延迟由配置决定（0 = 说话人在两个麦克风连线的垂直方向）
+ * - 自适应模式：有声音的帧（能量高出底噪 6dB 以上）计算两路在物理可能范围内的互相关，
+ *   平滑后取峰值作为延迟；新峰值明显高于当前延迟的相关值时才切换，避免来回跳
+ *
+ * 内循环：
+ * - 每个样本的相加（两路平均）在 ESP32-S3 上用 esp-dsp 的 dsps_add_s16（PIE 128位SIMD，
+ *   一条指令处理8个样本）。SIMD 要求16字节对齐，所以被延迟的一路先拷进对齐的缓冲区，
+ *   读指针始终对齐，延迟体现在写入位置上
+ * - 互相关只在自适应模式、有声音的帧里算，每个延迟一次点积。不同延迟的起点不可能都对齐，
+ *   用64位累加的标量循环；先做一阶差分（相当于高频预加重），低频为主的语音互相关峰才够尖
+ *
+ * 延迟只取整数样本：16kHz、6cm间距时最大时间差约2.8个样本，整数延迟的指向误差在主机仿真里
+ * 计入了结果（tools/beamform_sim）。纯头文件，不依赖ESP-IDF（S3上的esp-dsp除外），主机端可以直接编译。
+ */
+
+#ifndef BEAMFORMER_H
+#define BEAMFORMER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#if defined(ESP_PLATFORM)
+#include "sdkconfig.h"
+#if CONFIG_IDF_TARGET_ESP32S3
+#include "dsps_add.h"
+#define BEAMFORMER_USE_ESP_DSP 1
+#endif
+#endif
+
+namespace dsp {
+
+namespace beam {
+
+/**
+ * @brief out[i] = (a[i] + b[i]) >> 1（可以原地：out 与 a 或 b 相同）
+ */
+inline void average_scalar(const int16_t* a, const int16_t* b, int16_t* out, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        out[i] = (int16_t)(((int32_t)a[i] + (int32_t)b[i]) >> 1);
+    }
+}
+
+/**
+ * @brief 同上，S3 上走 PIE SIMD
+ *
+ * 三个指针都16字节对齐且 n 是8的倍数时 dsps_add_s16 用向量指令，否则它自己退回标量实现。
+ * 向量版先饱和相加再移位：只有两路同时接近满幅时结果才会和标量版不同。
+ */
+inline void average(const int16_t* a, const int16_t* b, int16_t* out, size_t n)
+{
+#if BEAMFORMER_USE_ESP_DSP
+    dsps_add_s16(a, b, out, (int)n, 1, 1, 1, 1);
+#else
+    average_scalar(a, b, out, n);
+#endif
+}
+
+/**
+ * @brief sum(a[i] * b[i])，64位累加不会溢出
+ */
+inline int64_t dot(const int16_t* a, const int16_t* b, size_t n)
+{
+    int64_t acc = 0;
+    for (size_t i = 0; i < n; i++) {
+        acc += (int32_t)a[i] * (int32_t)b[i];
+    }
+    return acc;
+}
+
+} // namespace beam
+
+/**
+ * @brief 两路延迟求和
+ *
+ * 延迟约定：delay > 0 表示声音先到右麦克风（B），B 延迟 delay 个样本再与 A 相加；
+ * delay < 0 则 A 延迟 -delay 个样本。
+ *
+ * 输入按 BLOCK 个样本分片处理，自适应模式每片估计一次延迟。
+ */
+class Beamformer {
+public:
+    static constexpr int MAX_LAG = 8;               // 16kHz下约17cm间距
+    static constexpr size_t BLOCK = 256;            // 16ms
+
+    enum class Mode { FIXED, ADAPTIVE };
+
+    struct Stats {
+        uint32_t blocks;            // 处理的片数
+        uint32_t voiced_blocks;     // 参与延迟估计的片数（能量高于底噪）
+        uint32_t delay_changes;     // 自适应模式切换延迟的次数
+        int32_t delay;              // 当前延迟
+    };
+
+    /**
+     * @param mode 固定 / 自适应
+     * @param delay 固定模式的延迟，自适应模式的初始延迟
+     * @param max_lag 自适应模式搜索的最大延迟（间距 / 声速 * 采样率，向上取整），不超过 MAX_LAG
+     */
+    Beamformer(Mode mode = Mode::FIXED, int delay = 0, int max_lag = 3)
+        : mode_(mode)
+        , max_lag_(clampLag(max_lag < 0 ? -max_lag : max_lag))
+        , initial_delay_(clampLag(delay))
+    {
+        reset();
+    }
+
+    /**
+     * @brief 处理一段两路数据
+     *
+     * @param a 左麦克风（A）
+     * @param b 右麦克风（B）
+     * @param out 输出，可以与 a 或 b 相同
+     * @param n 样本数
+     */
+    void process(const int16_t* a, const int16_t* b, int16_t* out, size_t n)
+    {
+        while (n > 0) {
+            size_t len = n < BLOCK ? n : BLOCK;
+            if (mode_ == Mode::ADAPTIVE) {
+                estimate(a, b, len);
+            }
+            const int16_t* da = delayed(a, len, delay_ < 0 ? -delay_ : 0, hist_a_, line_a_);
+            const int16_t* db = delayed(b, len, delay_ > 0 ? delay_ : 0, hist_b_, line_b_);
+            // 先存历史：原地处理时 out 会覆盖输入
+            pushHistory(hist_a_, a, len);
+            pushHistory(hist_b_, b, len);
+            beam::average(da, db, out, len);
+            stats_.blocks++;
+            a += len;
+            b += len;
+            out += len;
+            n -= len;
+        }
+        stats_.delay = delay_;
+    }
+
+    /**
+     * @brief 直接设置延迟（固定模式改指向；自适应模式会被下一次估计覆盖）
+     */
+    void setDelay(int delay) { delay_ = clampLag(delay); }
+
+    int delay() const { return delay_; }
+    Mode mode() const { return mode_; }
+    int maxLag() const { return max_lag_; }
+    Stats getStats() const { return stats_; }
+
+    /**
+     * @brief 清空历史和自适应状态，延迟回到初始值
+     */
+    void reset()
+    {
+        delay_ = initial_delay_;
+        memset(hist_a_, 0, sizeof(hist_a_));
+        memset(hist_b_, 0, sizeof(hist_b_));
+        memset(corr_, 0, sizeof(corr_));
+        noise_floor_ = 0;
+        memset(&stats_, 0, sizeof(stats_));
+        stats_.delay = delay_;
+    }
+
+private:
+    static constexpr int SMOOTH_SHIFT = 3;          // 互相关平滑：每片新值占 1/8
+    static constexpr int FLOOR_RISE_SHIFT = 7;      // 底噪每片最多上升 1/128（约每秒 +2dB）
+    static constexpr int VOICED_RATIO = 4;          // 能量高于底噪 4 倍（6dB）才估计
+    static constexpr int SWITCH_MARGIN_Q3 = 9;      // 新峰值超过当前延迟相关值的 9/8 才切换
+
+    static int clampLag(int lag) { return lag > MAX_LAG ? MAX_LAG : (lag < -MAX_LAG ? -MAX_LAG : lag); }
+
+    /**
+     * @brief 返回延迟 d 个样本后的这一片：d=0 直接用输入，否则拷进对齐的缓冲区
+     *
+     * line[i] = x[i - d]，前 d 个来自上一片末尾的历史。读指针 line 始终对齐，供SIMD加法使用。
+     */
+    static const int16_t* delayed(const int16_t* x, size_t n, int d, const int16_t* hist, int16_t* line)
+    {
+        if (d == 0) {
+            return x;
+        }
+        size_t head = (size_t)d < n ? (size_t)d : n;
+        memcpy(line, hist + MAX_LAG - d, head * sizeof(int16_t));
+        if (n > head) {
+            memcpy(line + head, x, (n - head) * sizeof(int16_t));
+        }
+        return line;
+    }
+
+    // 保留每路最后 MAX_LAG 个样本（片长不足 MAX_LAG 时与旧历史拼接）
+    static void pushHistory(int16_t* hist, const int16_t* x, size_t n)
+    {
+        if (n >= (size_t)MAX_LAG) {
+            memcpy(hist, x + n - MAX_LAG, MAX_LAG * sizeof(int16_t));
+        } else {
+            memmove(hist, hist + n, (MAX_LAG - n) * sizeof(int16_t));
+            memcpy(hist + MAX_LAG - n, x, n * sizeof(int16_t));
+        }
+    }
+
+    /**
+     * @brief 自适应模式：有声音时更新平滑互相关，峰值明显更高时切换延迟
+     */
+    void estimate(const int16_t* a, const int16_t* b, size_t n)
+    {
+        int64_t energy = beam::dot(a, a, n) / (int64_t)n;
+        if (noise_floor_ == 0 || energy < noise_floor_) {
+            noise_floor_ = energy > 0 ? energy : 1;
+        } else {
+            noise_floor_ += (noise_floor_ >> FLOOR_RISE_SHIFT) + 1;
+        }
+        if (energy < noise_floor_ * VOICED_RATIO || n <= (size_t)(2 * max_lag_ + 1)) {
+            return;
+        }
+        stats_.voiced_blocks++;
+
+        // 一阶差分，两端各留 max_lag_ 个样本给错位
+        size_t m = n - 1;
+        for (size_t i = 0; i < m; i++) {
+            diff_a_[i] = (int16_t)(((int32_t)a[i + 1] - a[i]) >> 1);
+            diff_b_[i] = (int16_t)(((int32_t)b[i + 1] - b[i]) >> 1);
+        }
+        size_t span = m - 2 * max_lag_;
+        const int16_t* center_a = diff_a_ + max_lag_;
+        for (int lag = -max_lag_; lag <= max_lag_; lag++) {
+            // 延迟 lag：A[i] 与 B[i - lag] 对齐
+            int64_t c = beam::dot(center_a, diff_b_ + max_lag_ - lag, span);
+            int64_t& r = corr_[lag + MAX_LAG];
+            r += (c - r) >> SMOOTH_SHIFT;
+        }
+        int best = -max_lag_;
+        for (int lag = -max_lag_ + 1; lag <= max_lag_; lag++) {
+            if (corr_[lag + MAX_LAG] > corr_[best + MAX_LAG]) {
+                best = lag;
+            }
+        }
+
+        int64_t current = corr_[delay_ + MAX_LAG];
+        if (best != delay_ && (current <= 0 || corr_[best + MAX_LAG] * 8 > current * SWITCH_MARGIN_Q3)) {
+            delay_ = best;
+            stats_.delay_changes++;
+        }
+    }
+
+    Mode mode_;
+    int max_lag_;
+    int initial_delay_;
+    int delay_;
+
+    alignas(16) int16_t line_a_[BLOCK];
+    alignas(16) int16_t line_b_[BLOCK];
+    int16_t hist_a_[MAX_LAG];
+    int16_t hist_b_[MAX_LAG];
+    int16_t diff_a_[BLOCK];
+    int16_t diff_b_[BLOCK];
+    int64_t corr_[2 * MAX_LAG + 1];
+    int64_t noise_floor_;
+    Stats stats_;
+};
+
+} // namespace dsp
+
+#endif // BEAMFORMER_H
@@ -24,8 +24,16 @@
 #include "esp_err.h"
 #include "esp_log.h"
 #include "esp_check.h"
+#include "esp_heap_caps.h"
+#include "esp_attr.h"
+#include "esp_memory_utils.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "sdkconfig.h"
+#include "sample_format.h"
+#include "beamformer.h"
 
 // INMP441 I2S 引脚配置
 // INMP441 是一个数字 MEMS 麦克风，通过 I2S 接口与 ESP32-S3 通信
@@ -47,6 +55,52 @@
 #define BITS_PER_SAMPLE 16    // 每个采样点 16 位
 #define CHANNELS 1            // 单声道配置
 
+// I2S 槽上的硬件采样格式（编译期选择，见 Kconfig "Audio Pipeline Configuration"）
+// 对上层的接口始终是 16位单声道 PCM，格式转换在这里完成
+// 双麦克风时两个槽都采集（左=A，右=B），波束形成后合成一路
+#if CONFIG_BSP_MIC_DUAL && CONFIG_BSP_MIC_FORMAT_S24_IN_32
+using MicFormat = sample_format::S24In32Stereo;
+#elif CONFIG_BSP_MIC_DUAL
+using MicFormat = sample_format::S16Stereo;
+#elif CONFIG_BSP_MIC_FORMAT_S24_IN_32
+using MicFormat = sample_format::S24In32Mono;       // INMP441 全精度：32位槽中24位左对齐
+#else
+using MicFormat = sample_format::S16Mono;           // I2S 只取高16位
+#endif
+
+#if CONFIG_BSP_SPEAKER_FORMAT_S16_STEREO
+using SpeakerFormat = sample_format::S16Stereo;
+#elif CONFIG_BSP_SPEAKER_FORMAT_S32_STEREO
+using SpeakerFormat = sample_format::S32Stereo;
+#else
+using SpeakerFormat = sample_format::S16Mono;       // MAX98357A 单声道
+#endif
+
+#ifdef CONFIG_BSP_MIC_SHIFT
+#define MIC_SHIFT CONFIG_BSP_MIC_SHIFT  // 麦克风数字增益（左移位数，每位+6dB）
+#else
+#define MIC_SHIFT 0
+#endif
+#define MIC_GAIN_Q8 256                 // 麦克风额外增益（Q8，256=1.0，测试表明原始电平已足够唤醒词检测）
+#define TX_CONVERT_FRAMES 256           // 播放格式转换每批的帧数
+// 播放格式转换缓冲区大小，格式相同时不需要转换
+#define TX_CONVERT_BYTES (SpeakerFormat::is_pcm16_mono ? 4 : sample_format::bytes_for<SpeakerFormat>(TX_CONVERT_FRAMES))
+#define SPEED_OF_SOUND_MM_S 343000      // 声速，换算麦克风间距对应的最大时间差
+
+template <typename F>
+static constexpr i2s_data_bit_width_t i2s_bit_width()
+{
+    return F::container_bytes == 4 ? I2S_DATA_BIT_WIDTH_32BIT
+         : F::container_bytes == 3 ? I2S_DATA_BIT_WIDTH_24BIT
+         : I2S_DATA_BIT_WIDTH_16BIT;
+}
+
+template <typename F>
+static constexpr i2s_slot_mode_t i2s_slot_mode()
+{
+    return F::channels == 1 ? I2S_SLOT_MODE_MONO : I2S_SLOT_MODE_STEREO;
+}
+
 static const char *TAG = "bsp_board";
 
 // I2S 接收通道句柄，用于管理音频数据接收
@@ -55,36 +109,231 @@ static i2s_chan_handle_t rx_handle = nullptr;
 static i2s_chan_handle_t tx_handle = nullptr;
 // I2S 发送通道状态标志
 static bool tx_channel_enabled = false;
+// 串行化所有发送操作：提示音（bsp_play_audio）、流式播放、停止，以及重建发送通道
+static SemaphoreHandle_t tx_lock = nullptr;
+// 麦克风格式不是16位单声道时，I2S原始数据先读到这里再转换
+static uint8_t *rx_raw_buffer = nullptr;
+static size_t rx_raw_capacity = 0;
+
+#if CONFIG_BSP_MIC_DUAL
+// 右麦克风（B）转换后的16位数据，16字节对齐供波束形成的SIMD加法使用；左麦克风直接转进调用者的缓冲区
+static int16_t *rx_mic_b = nullptr;
+static size_t rx_mic_b_capacity = 0;
+static dsp::Beamformer mic_beam;
+#endif
+
+// DMA几何参数（默认值与 I2S_CHANNEL_DEFAULT_CONFIG 相同），由 bsp_i2s_set_dma_geometry 修改
+static bsp_i2s_dma_geometry_t rx_geometry = {6, 240};
+static bsp_i2s_dma_geometry_t tx_geometry = {6, 240};
+// 重建通道时沿用初始化时的采样率
+static uint32_t rx_sample_rate = 0;
+static uint32_t tx_sample_rate = 0;
+
+/**
+ * @brief 一个方向的DMA队列记账
+ *
+ * 中断回调（收满/发完一个DMA缓冲区）和读写调用两边更新 queued_bytes，
+ * 即DMA里已采到还没读走（接收）或已写入还没播出（发送）的字节数，
+ * 除以字节率就是数据在DMA里排队的时长。
+ */
+struct DmaQueueTracker {
+    portMUX_TYPE lock;
+    uint32_t queued_bytes;
+    int64_t last_event_us;          // 最近一次DMA缓冲区完成的时间，0=还没有
+    uint32_t byte_rate;             // I2S槽上每秒的字节数
+    uint32_t overflows;
+    uint32_t count;
+    uint64_t total_latency_us;
+    uint32_t max_latency_us;
+};
+
+static DmaQueueTracker rx_tracker = {portMUX_INITIALIZER_UNLOCKED, 0, 0, 0, 0, 0, 0, 0};
+static DmaQueueTracker tx_tracker = {portMUX_INITIALIZER_UNLOCKED, 0, 0, 0, 0, 0, 0, 0};
+
+static void tracker_reset(DmaQueueTracker *t, uint32_t byte_rate)
+{
+    portENTER_CRITICAL(&t->lock);
+    t->queued_bytes = 0;
+    t->last_event_us = 0;
+    t->byte_rate = byte_rate;
+    portEXIT_CRITICAL(&t->lock);
+}
+
+static void tracker_record_latency(DmaQueueTracker *t, int64_t latency_us)
+{
+    uint32_t latency = latency_us > 0 ? (uint32_t)latency_us : 0;
+    t->count++;
+    t->total_latency_us += latency;
+    if (latency > t->max_latency_us)
+    {
+        t->max_latency_us = latency;
+    }
+}
+
+static bool IRAM_ATTR on_rx_recv(i2s_chan_handle_t handle, i2s_event_data_t *event, void *user_ctx)
+{
+    portENTER_CRITICAL_ISR(&rx_tracker.lock);
+    rx_tracker.queued_bytes += event->size;
+    rx_tracker.last_event_us = esp_timer_get_time();
+    portEXIT_CRITICAL_ISR(&rx_tracker.lock);
+    return false;
+}
+
+static bool IRAM_ATTR on_rx_queue_overflow(i2s_chan_handle_t handle, i2s_event_data_t *event, void *user_ctx)
+{
+    // 最旧的一个DMA缓冲区被丢弃，不会再被读到
+    portENTER_CRITICAL_ISR(&rx_tracker.lock);
+    rx_tracker.overflows++;
+    rx_tracker.queued_bytes = rx_tracker.queued_bytes > event->size ? rx_tracker.queued_bytes - event->size : 0;
+    portEXIT_CRITICAL_ISR(&rx_tracker.lock);
+    return false;
+}
+
+static bool IRAM_ATTR on_tx_sent(i2s_chan_handle_t handle, i2s_event_data_t *event, void *user_ctx)
+{
+    portENTER_CRITICAL_ISR(&tx_tracker.lock);
+    tx_tracker.queued_bytes = tx_tracker.queued_bytes > event->size ? tx_tracker.queued_bytes - event->size : 0;
+    tx_tracker.last_event_us = esp_timer_get_time();
+    portEXIT_CRITICAL_ISR(&tx_tracker.lock);
+    return false;
+}
+
+static bool IRAM_ATTR on_tx_queue_overflow(i2s_chan_handle_t handle, i2s_event_data_t *event, void *user_ctx)
+{
+    portENTER_CRITICAL_ISR(&tx_tracker.lock);
+    tx_tracker.overflows++;
+    portEXIT_CRITICAL_ISR(&tx_tracker.lock);
+    return false;
+}
+
+/**
+ * @brief 读出 bytes 字节之后记一次采集延迟
+ *
+ * 最近完成的DMA缓冲区的最后一个样本是 last_event_us 时采到的；
+ * 本次读到的最旧样本比它早 (剩余排队 + 本次读出) 字节。
+ */
+static void rx_track_read(size_t bytes)
+{
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&rx_tracker.lock);
+    rx_tracker.queued_bytes = rx_tracker.queued_bytes > bytes ? rx_tracker.queued_bytes - bytes : 0;
+    if (rx_tracker.last_event_us != 0 && rx_tracker.byte_rate != 0)
+    {
+        int64_t backlog_us = (int64_t)(rx_tracker.queued_bytes + bytes) * 1000000 / rx_tracker.byte_rate;
+        tracker_record_latency(&rx_tracker, now - rx_tracker.last_event_us + backlog_us);
+    }
+    portEXIT_CRITICAL(&rx_tracker.lock);
+}
+
+/**
+ * @brief 写I2S，写入的字节计入发送队列
+ */
+static esp_err_t tx_write(const void *data, size_t len, size_t *bytes_written, TickType_t timeout)
+{
+    esp_err_t ret = i2s_channel_write(tx_handle, data, len, bytes_written, timeout);
+    portENTER_CRITICAL(&tx_tracker.lock);
+    tx_tracker.queued_bytes += *bytes_written;
+    portEXIT_CRITICAL(&tx_tracker.lock);
+    return ret;
+}
+
+/**
+ * @brief 写入播放数据之后记一次播放延迟
+ *
+ * 写入返回时，刚写的最后一个样本要等DMA里排在它前面的数据都播完；
+ * 从最近一个缓冲区播完到现在，正在播的缓冲区已经播出去一部分。
+ */
+static void tx_track_latency(void)
+{
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&tx_tracker.lock);
+    if (tx_tracker.byte_rate != 0)
+    {
+        int64_t queued_us = (int64_t)tx_tracker.queued_bytes * 1000000 / tx_tracker.byte_rate;
+        int64_t descriptor_us = (int64_t)tx_geometry.frame_num * 1000000 / tx_sample_rate;
+        int64_t played_us = now - tx_tracker.last_event_us;
+        // DMA刚启动或者之前空转过，最近一次完成时间不代表正在播的缓冲区
+        if (tx_tracker.last_event_us == 0 || played_us > descriptor_us)
+        {
+            played_us = 0;
+        }
+        tracker_record_latency(&tx_tracker, queued_us - played_us);
+    }
+    portEXIT_CRITICAL(&tx_tracker.lock);
+}
+
+/**
+ * @brief 按当前几何参数生成通道配置
+ */
+static i2s_chan_config_t make_chan_config(i2s_port_t port, const bsp_i2s_dma_geometry_t &geometry)
+{
+    i2s_chan_config_t chan_cfg = I2S_CHANNEL_DEFAULT_CONFIG(port, I2S_ROLE_MASTER);
+    chan_cfg.dma_desc_num = geometry.desc_num;
+    chan_cfg.dma_frame_num = geometry.frame_num;
+    return chan_cfg;
+}
+
+/**
+ * @brief 检查上层请求的数据格式
+ *
+ * 上层（唤醒词、VAD、编码、播放）只处理16位单声道；
+ * I2S槽上的实际格式由 MicFormat / SpeakerFormat 在编译期决定。
+ */
+static esp_err_t check_pcm_format(const char *who, int channel_format, int bits_per_chan)
+{
+    if (channel_format != 1 || bits_per_chan != 16)
+    {
+        ESP_LOGE(TAG, "%s: 数据接口固定为16位单声道，不支持 %d位/%d声道（硬件槽格式请在 menuconfig 中选择）",
+                 who, bits_per_chan, channel_format);
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    return ESP_OK;
+}
 
 /**
  * @brief 初始化 I2S 接口用于 INMP441 麦克风
  *
  * INMP441 是一个数字 MEMS 麦克风，需要特定的 I2S 配置：
  * - 使用标准 I2S 协议 (Philips 格式)
- * - 单声道模式，只使用左声道
- * - 16 位数据宽度
+ * - 单声道模式只使用左声道；双麦克风（CONFIG_BSP_MIC_DUAL）时采集左右两个槽
+ * - 槽位宽度由 MicFormat 决定（16位，或32位槽取24位全精度）
  *
  * @param sample_rate 采样率 (Hz)
- * @param channel_format 声道数 (1=单声道, 2=立体声)
- * @param bits_per_chan 每个采样点的位数 (16 或 32)
+ * @param channel_format 上层数据的声道数（必须为1）
+ * @param bits_per_chan 上层数据的位数（必须为16）
  * @return esp_err_t 初始化结果
  */
 static esp_err_t bsp_i2s_init(uint32_t sample_rate, int channel_format, int bits_per_chan)
 {
-    esp_err_t ret = ESP_OK;
+    esp_err_t ret = check_pcm_format("麦克风", channel_format, bits_per_chan);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
 
     // 创建 I2S 通道配置
-    // 设置为主模式，ESP32-S3 作为时钟源
-    i2s_chan_config_t chan_cfg = I2S_CHANNEL_DEFAULT_CONFIG(I2S_PORT_RX, I2S_ROLE_MASTER);
+    // 设置为主模式，ESP32-S3 作为时钟源；DMA几何参数见 bsp_i2s_set_dma_geometry
+    i2s_chan_config_t chan_cfg = make_chan_config(I2S_PORT_RX, rx_geometry);
     ret = i2s_new_channel(&chan_cfg, nullptr, &rx_handle);
     if (ret != ESP_OK)
     {
         ESP_LOGE(TAG, "创建 I2S 通道失败: %s", esp_err_to_name(ret));
         return ret;
     }
+    rx_sample_rate = sample_rate;
+
+    i2s_event_callbacks_t callbacks = {};
+    callbacks.on_recv = on_rx_recv;
+    callbacks.on_recv_q_ovf = on_rx_queue_overflow;
+    ret = i2s_channel_register_event_callback(rx_handle, &callbacks, nullptr);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "注册 I2S 接收回调失败: %s", esp_err_to_name(ret));
+        return ret;
+    }
 
     // 确定数据位宽度
-    i2s_data_bit_width_t bit_width = (bits_per_chan == 32) ? I2S_DATA_BIT_WIDTH_32BIT : I2S_DATA_BIT_WIDTH_16BIT;
+    constexpr i2s_data_bit_width_t bit_width = i2s_bit_width<MicFormat>();
 
     // 配置 I2S 标准模式，专门针对 INMP441 优化
     i2s_std_config_t std_cfg = {
@@ -92,7 +341,7 @@ static esp_err_t bsp_i2s_init(uint32_t sample_rate, int channel_format, int bits
             .sample_rate_hz = sample_rate,
             .clk_src = I2S_CLK_SRC_DEFAULT,
             .mclk_multiple = I2S_MCLK_MULTIPLE_256},
-        .slot_cfg = I2S_STD_PHILIPS_SLOT_DEFAULT_CONFIG(bit_width, I2S_SLOT_MODE_MONO), // 插槽配置
+        .slot_cfg = I2S_STD_PHILIPS_SLOT_DEFAULT_CONFIG(bit_width, i2s_slot_mode<MicFormat>()), // 插槽配置
         .gpio_cfg = {
             .mclk = I2S_GPIO_UNUSED, // INMP441 不需要主时钟
             .bclk = I2S_SCK_PIN,     // 位时钟引脚
@@ -108,9 +357,9 @@ static esp_err_t bsp_i2s_init(uint32_t sample_rate, int channel_format, int bits
     };
 
     // INMP441 特定配置调整
-    // INMP441 输出左对齐数据，我们只使用左声道
-    std_cfg.slot_cfg.slot_mode = I2S_SLOT_MODE_MONO;
-    std_cfg.slot_cfg.slot_mask = I2S_STD_SLOT_LEFT;
+    // INMP441 输出左对齐数据，单麦克风只使用左声道；双麦克风时第二个（L/R接高）在右声道
+    std_cfg.slot_cfg.slot_mode = i2s_slot_mode<MicFormat>();
+    std_cfg.slot_cfg.slot_mask = MicFormat::channels == 1 ? I2S_STD_SLOT_LEFT : I2S_STD_SLOT_BOTH;
 
     // 初始化 I2S 标准模式
     ret = i2s_channel_init_std_mode(rx_handle, &std_cfg);
@@ -140,8 +389,28 @@ static esp_err_t bsp_i2s_init(uint32_t sample_rate, int channel_format, int bits
         free(discard_buffer);
         ESP_LOGD(TAG, "已清理I2S输入缓冲区初始数据");
     }
+    tracker_reset(&rx_tracker, sample_rate * sample_format::bytes_for<MicFormat>(1));
+
+#if CONFIG_BSP_MIC_DUAL
+    // 搜索范围：间距 / 声速 * 采样率，向上取整
+    int max_lag = (int)((CONFIG_BSP_MIC_SPACING_MM * sample_rate + SPEED_OF_SOUND_MM_S - 1) / SPEED_OF_SOUND_MM_S);
+    // 选择项里没选中的那个在 sdkconfig.h 中不定义，只能用预处理判断
+#if CONFIG_BSP_MIC_BEAM_ADAPTIVE
+    constexpr dsp::Beamformer::Mode beam_mode = dsp::Beamformer::Mode::ADAPTIVE;
+    const char* beam_mode_name = "自适应";
+#else
+    constexpr dsp::Beamformer::Mode beam_mode = dsp::Beamformer::Mode::FIXED;
+    const char* beam_mode_name = "固定";
+#endif
+    mic_beam = dsp::Beamformer(beam_mode, CONFIG_BSP_MIC_BEAM_DELAY, max_lag);
+    ESP_LOGI(TAG, "双麦克风波束形成: %s, 初始延迟 %d 样本, 间距 %d mm（搜索 ±%d）",
+             beam_mode_name, mic_beam.delay(),
+             CONFIG_BSP_MIC_SPACING_MM, mic_beam.maxLag());
+#endif
 
-    ESP_LOGI(TAG, "I2S 初始化成功");
+    ESP_LOGI(TAG, "I2S 初始化成功（槽格式: %d位容器/%d位有效，数字增益 %d 位，DMA %lu x %lu 帧）",
+             MicFormat::container_bytes * 8, MicFormat::valid_bits, MIC_SHIFT,
+             (unsigned long)rx_geometry.desc_num, (unsigned long)rx_geometry.frame_num);
     return ESP_OK;
 }
 
@@ -174,11 +443,11 @@ esp_err_t bsp_board_init(uint32_t sample_rate, int channel_format, int bits_per_
  * 
  * 工作流程：
  * 1. 从I2S接口读取原始数据
- * 2. 对INMP441的输出进行格式转换
- * 3. 可选择性应用增益调整
+ * 2. 按 MicFormat 转换成16位单声道
+ * 3. 可选择性应用增益调整（移位+饱和）
  * 4. 确保数据适合语音识别
  *
- * @param is_get_raw_channel 是否获取原始数据（true=不处理）
+ * @param is_get_raw_channel 是否获取原始数据（true=只转格式，不加增益）
  * @param buffer 存储音频数据的缓冲区
  * @param buffer_len 缓冲区长度（字节）
  * @return esp_err_t 读取结果
@@ -187,58 +456,103 @@ esp_err_t bsp_get_feed_data(bool is_get_raw_channel, int16_t *buffer, int buffer
 {
     esp_err_t ret = ESP_OK;
     size_t bytes_read = 0;
+    const size_t frames = buffer_len / sizeof(int16_t);
+    void *raw = buffer;
+    size_t raw_len = buffer_len;
+
+    // 16位单声道直接读进调用者的缓冲区；其他格式先读到原始缓冲区
+    if constexpr (!MicFormat::is_pcm16_mono)
+    {
+        raw_len = sample_format::bytes_for<MicFormat>(frames);
+        if (rx_raw_capacity < raw_len)
+        {
+            heap_caps_free(rx_raw_buffer);
+            rx_raw_buffer = (uint8_t *)heap_caps_aligned_alloc(64, raw_len, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+            rx_raw_capacity = rx_raw_buffer ? raw_len : 0;
+            if (rx_raw_buffer == nullptr)
+            {
+                ESP_LOGE(TAG, "I2S原始数据缓冲区分配失败: %zu 字节", raw_len);
+                return ESP_ERR_NO_MEM;
+            }
+        }
+        raw = rx_raw_buffer;
+    }
 
     // 从I2S通道读取音频数据
-    ret = i2s_channel_read(rx_handle, buffer, buffer_len, &bytes_read, portMAX_DELAY);
+    ret = i2s_channel_read(rx_handle, raw, raw_len, &bytes_read, portMAX_DELAY);
 
     if (ret != ESP_OK)
     {
         ESP_LOGE(TAG, "读取I2S数据失败: %s", esp_err_to_name(ret));
         return ret;
     }
+    rx_track_read(bytes_read);
 
     // 🔍 检查读取的数据长度是否符合预期
-    if (bytes_read != buffer_len)
+    if (bytes_read != raw_len)
     {
-        ESP_LOGW(TAG, "预期读取%d字节，实际读取%d字节", buffer_len, bytes_read);
+        ESP_LOGW(TAG, "预期读取%zu字节，实际读取%zu字节", raw_len, bytes_read);
     }
 
-    // INMP441特定的数据处理
-    // INMP441输出24位数据在 32位帧中，左对齐
-    // 我们需要提取最高有效的16位用于语音识别
-    if (!is_get_raw_channel)
+    // 🎶 转换成16位单声道：格式在编译期确定，内循环没有分支
+    // 16位单声道且不加增益时什么也不做
+    if (is_get_raw_channel)
     {
-        int samples = buffer_len / sizeof(int16_t);
+        sample_format::to_pcm16<MicFormat>(raw, buffer, frames);
+    }
+    else
+    {
+        sample_format::to_pcm16<MicFormat, 0, MIC_SHIFT, MIC_GAIN_Q8>(raw, buffer, frames);
+    }
 
-        // 🎶 对INMP441的数据进行处理
-        // 麦克风输出左对齐数据，进行信号电平调整
-        for (int i = 0; i < samples; i++)
+#if CONFIG_BSP_MIC_DUAL
+    // 🎯 右麦克风单独转出来，两路波束形成后原地写回 buffer（raw=true 时同样合成，只是不加增益）
+    if (rx_mic_b_capacity < frames)
+    {
+        heap_caps_free(rx_mic_b);
+        rx_mic_b = (int16_t *)heap_caps_aligned_alloc(16, frames * sizeof(int16_t), MALLOC_CAP_INTERNAL);
+        rx_mic_b_capacity = rx_mic_b ? frames : 0;
+        if (rx_mic_b == nullptr)
         {
-            // 当前使用原始信号电平（无增益）
-            // 测试表明原始电平已足够满足唤醒词检测需求
-            int32_t sample = static_cast<int32_t>(buffer[i]);
-
-            // 可选：应用2倍增益以提升信号强度（当前已禁用）
-            // 如果发现声音太小，可以取消下面这行的注释
-            // sample = sample * 2;
-
-            // 限制在16位有符号整数范围内
-            if (sample > 32767)
-            {
-                sample = 32767;
-            }
-            if (sample < -32768)
-            {
-                sample = -32768;
-            }
-
-            buffer[i] = static_cast<int16_t>(sample);
+            ESP_LOGE(TAG, "右麦克风缓冲区分配失败: %zu 字节", frames * sizeof(int16_t));
+            return ESP_ERR_NO_MEM;
         }
     }
+    if (is_get_raw_channel)
+    {
+        sample_format::to_pcm16<MicFormat, 1>(raw, rx_mic_b, frames);
+    }
+    else
+    {
+        sample_format::to_pcm16<MicFormat, 1, MIC_SHIFT, MIC_GAIN_Q8>(raw, rx_mic_b, frames);
+    }
+    mic_beam.process(buffer, rx_mic_b, buffer, frames);
+#endif
 
     return ESP_OK;
 }
 
+/**
+ * @brief 读取双麦克风波束形成的统计
+ *
+ * @return ESP_ERR_NOT_SUPPORTED=单麦克风配置
+ */
+esp_err_t bsp_mic_get_beam_stats(bsp_mic_beam_stats_t *stats)
+{
+#if CONFIG_BSP_MIC_DUAL
+    dsp::Beamformer::Stats st = mic_beam.getStats();
+    stats->adaptive = mic_beam.mode() == dsp::Beamformer::Mode::ADAPTIVE;
+    stats->delay = st.delay;
+    stats->blocks = st.blocks;
+    stats->voiced_blocks = st.voiced_blocks;
+    stats->delay_changes = st.delay_changes;
+    return ESP_OK;
+#else
+    memset(stats, 0, sizeof(*stats));
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
 // /**
 //  * @brief 获取音频输入通道数
 //  *
@@ -259,18 +573,21 @@ esp_err_t bsp_get_feed_data(bool is_get_raw_channel, int16_t *buffer, int buffer
  * 
  * 🔧 I2S配置特点：
  * - 使用Philips标准协议
- * - 支持单声道/立体声
- * - 16位数据宽度
+ * - 槽格式由 SpeakerFormat 决定（单声道/立体声，16/32位）
  * - 3W输出功率
  *
  * @param sample_rate 采样率（Hz）
- * @param channel_format 声道数（1=单声道，2=立体声）
- * @param bits_per_chan 每个采样点的位数（16或32）
+ * @param channel_format 上层数据的声道数（必须为1）
+ * @param bits_per_chan 上层数据的位数（必须为16）
  * @return esp_err_t 初始化结果
  */
 esp_err_t bsp_audio_init(uint32_t sample_rate, int channel_format, int bits_per_chan)
 {
-    esp_err_t ret = ESP_OK;
+    esp_err_t ret = check_pcm_format("扬声器", channel_format, bits_per_chan);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
 
     // 初始化MAX98357A的SD引脚（控制功放开关）
     gpio_config_t io_conf = {
@@ -284,18 +601,39 @@ esp_err_t bsp_audio_init(uint32_t sample_rate, int channel_format, int bits_per_
     gpio_set_level(I2S_OUT_SD_PIN, 1); // 高电平启用功放
     ESP_LOGI(TAG, "MAX98357A SD引脚已初始化（GPIO%d）", I2S_OUT_SD_PIN);
 
+    // 重建通道时在锁里再次调用本函数，锁只创建一次
+    if (tx_lock == nullptr)
+    {
+        tx_lock = xSemaphoreCreateMutex();
+        if (tx_lock == nullptr)
+        {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
     // 🔧 创建I2S发送通道配置
-    // ESP32作为主机（Master），提供时钟信号给功放
-    i2s_chan_config_t chan_cfg = I2S_CHANNEL_DEFAULT_CONFIG(I2S_PORT_TX, I2S_ROLE_MASTER);
+    // ESP32作为主机（Master），提供时钟信号给功放；DMA几何参数见 bsp_i2s_set_dma_geometry
+    i2s_chan_config_t chan_cfg = make_chan_config(I2S_PORT_TX, tx_geometry);
     ret = i2s_new_channel(&chan_cfg, &tx_handle, nullptr);
     if (ret != ESP_OK)
     {
         ESP_LOGE(TAG, "创建I2S发送通道失败: %s", esp_err_to_name(ret));
         return ret;
     }
+    tx_sample_rate = sample_rate;
+
+    i2s_event_callbacks_t callbacks = {};
+    callbacks.on_sent = on_tx_sent;
+    callbacks.on_send_q_ovf = on_tx_queue_overflow;
+    ret = i2s_channel_register_event_callback(tx_handle, &callbacks, nullptr);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "注册I2S发送回调失败: %s", esp_err_to_name(ret));
+        return ret;
+    }
 
     // 确定数据位宽度
-    i2s_data_bit_width_t bit_width = (bits_per_chan == 32) ? I2S_DATA_BIT_WIDTH_32BIT : I2S_DATA_BIT_WIDTH_16BIT;
+    constexpr i2s_data_bit_width_t bit_width = i2s_bit_width<SpeakerFormat>();
 
     // 🎶 配置I2S标准模式（专门为MAX98357A优化）
     i2s_std_config_t std_cfg = {
@@ -304,7 +642,7 @@ esp_err_t bsp_audio_init(uint32_t sample_rate, int channel_format, int bits_per_
             .clk_src = I2S_CLK_SRC_DEFAULT,
             .mclk_multiple = I2S_MCLK_MULTIPLE_256,
         },
-        .slot_cfg = I2S_STD_PHILIPS_SLOT_DEFAULT_CONFIG(bit_width, (channel_format == 1) ? I2S_SLOT_MODE_MONO : I2S_SLOT_MODE_STEREO),
+        .slot_cfg = I2S_STD_PHILIPS_SLOT_DEFAULT_CONFIG(bit_width, i2s_slot_mode<SpeakerFormat>()),
         .gpio_cfg = {
             .mclk = I2S_GPIO_UNUSED,   // MCLK：MAX98357A不需要主时钟
             .bclk = I2S_OUT_BCLK_PIN,  // BCLK：位时钟→ GPIO15
@@ -337,11 +675,63 @@ esp_err_t bsp_audio_init(uint32_t sample_rate, int channel_format, int bits_per_
 
     // 设置通道状态标志
     tx_channel_enabled = true;
+    tracker_reset(&tx_tracker, sample_rate * sample_format::bytes_for<SpeakerFormat>(1));
 
-    ESP_LOGI(TAG, "I2S音频播放初始化成功");
+    ESP_LOGI(TAG, "I2S音频播放初始化成功（DMA %lu x %lu 帧）",
+             (unsigned long)tx_geometry.desc_num, (unsigned long)tx_geometry.frame_num);
     return ESP_OK;
 }
 
+/**
+ * @brief 把16位单声道数据按 SpeakerFormat 写入I2S发送通道
+ *
+ * 格式相同时直接写；否则每次转换一批（最多 TX_CONVERT_FRAMES 帧）再写。调用者持有 tx_lock。
+ *
+ * @param data 16位单声道数据
+ * @param len 数据长度（字节）
+ * @param bytes_written 实际消耗的输入字节数
+ * @param convert_buffer 格式转换缓冲区（TX_CONVERT_BYTES 字节），每个写入方各用一块
+ * @return esp_err_t 写入结果
+ */
+static esp_err_t i2s_write_pcm16(const uint8_t *data, size_t len, size_t *bytes_written, uint8_t *convert_buffer)
+{
+    if constexpr (SpeakerFormat::is_pcm16_mono)
+    {
+        esp_err_t ret = tx_write(data, len, bytes_written, portMAX_DELAY);
+        tx_track_latency();
+        return ret;
+    }
+    else
+    {
+        size_t frames = len / sizeof(int16_t);
+        if (frames == 0)
+        {
+            *bytes_written = len; // 不足一个样本的尾巴直接丢弃
+            return ESP_OK;
+        }
+        if (frames > TX_CONVERT_FRAMES)
+        {
+            frames = TX_CONVERT_FRAMES;
+        }
+        sample_format::from_pcm16<SpeakerFormat>((const int16_t *)data, convert_buffer, frames);
+
+        const size_t out_len = sample_format::bytes_for<SpeakerFormat>(frames);
+        size_t out_written = 0;
+        esp_err_t ret = ESP_OK;
+        while (out_written < out_len && ret == ESP_OK)
+        {
+            size_t n = 0;
+            ret = tx_write(convert_buffer + out_written, out_len - out_written, &n, portMAX_DELAY);
+            out_written += n;
+        }
+        tx_track_latency();
+        *bytes_written = frames * sizeof(int16_t);
+        return ret;
+    }
+}
+
+static esp_err_t audio_stop_locked(void);
+
 /**
  * @brief 通过 I2S 播放音频数据
  *
@@ -349,12 +739,16 @@ esp_err_t bsp_audio_init(uint32_t sample_rate, int channel_format, int bits_per_
  * 1. 将音频数据写入 I2S 发送通道
  * 2. 确保数据完全发送
  *
+ * 调用者持有 tx_lock。
+ *
  * @param audio_data 指向音频数据的指针
  * @param data_len 音频数据长度（字节）
  * @return esp_err_t 播放结果
  */
-esp_err_t bsp_play_audio(const uint8_t *audio_data, size_t data_len)
+static esp_err_t play_audio_locked(const uint8_t *audio_data, size_t data_len)
 {
+    // 提示音在主任务里播放，与播放任务的流式写入各用一块转换缓冲区
+    static uint8_t convert_buffer[TX_CONVERT_BYTES] __attribute__((aligned(4)));
     esp_err_t ret = ESP_OK;
     size_t bytes_written = 0;
     size_t total_written = 0;
@@ -386,13 +780,14 @@ esp_err_t bsp_play_audio(const uint8_t *audio_data, size_t data_len)
             return ret;
         }
         tx_channel_enabled = true;
+        tracker_reset(&tx_tracker, tx_tracker.byte_rate);
         ESP_LOGD(TAG, "I2S发送通道已重新启用");
         
         // 发送一小段静音数据来初始化通道
         const size_t init_silence_size = 256; // 减小到256字节，避免大量内存分配
         static uint8_t init_silence[256] = {0}; // 使用静态数组，避免动态分配
         size_t silence_written = 0;
-        i2s_channel_write(tx_handle, init_silence, init_silence_size, &silence_written, pdMS_TO_TICKS(10));
+        tx_write(init_silence, init_silence_size, &silence_written, pdMS_TO_TICKS(10));
     }
 
     // 循环写入音频数据，确保所有数据都被发送
@@ -401,7 +796,7 @@ esp_err_t bsp_play_audio(const uint8_t *audio_data, size_t data_len)
         size_t bytes_to_write = data_len - total_written;
         
         // 将音频数据写入 I2S 发送通道
-        ret = i2s_channel_write(tx_handle, audio_data + total_written, bytes_to_write, &bytes_written, portMAX_DELAY);
+        ret = i2s_write_pcm16(audio_data + total_written, bytes_to_write, &bytes_written, convert_buffer);
 
         if (ret != ESP_OK)
         {
@@ -426,7 +821,7 @@ esp_err_t bsp_play_audio(const uint8_t *audio_data, size_t data_len)
     }
 
     // 播放完成后停止I2S输出以防止噪音
-    esp_err_t stop_ret = bsp_audio_stop();
+    esp_err_t stop_ret = audio_stop_locked();
     if (stop_ret != ESP_OK)
     {
         ESP_LOGW(TAG, "停止音频输出时出现警告: %s", esp_err_to_name(stop_ret));
@@ -436,18 +831,33 @@ esp_err_t bsp_play_audio(const uint8_t *audio_data, size_t data_len)
     return ESP_OK;
 }
 
+esp_err_t bsp_play_audio(const uint8_t *audio_data, size_t data_len)
+{
+    if (tx_lock == nullptr)
+    {
+        ESP_LOGE(TAG, "I2S发送通道未初始化");
+        return ESP_ERR_INVALID_STATE;
+    }
+    xSemaphoreTake(tx_lock, portMAX_DELAY);
+    esp_err_t ret = play_audio_locked(audio_data, data_len);
+    xSemaphoreGive(tx_lock);
+    return ret;
+}
+
 /**
  * @brief 通过 I2S 播放音频数据（流式版本，不停止I2S）
  *
  * 这个函数与 bsp_play_audio 类似，但不会在播放完成后停止I2S，
- * 适用于连续播放多个音频块的流式场景。
+ * 适用于连续播放多个音频块的流式场景。调用者持有 tx_lock。
  *
  * @param audio_data 指向音频数据的指针
  * @param data_len 音频数据长度（字节）
  * @return esp_err_t 播放结果
  */
-esp_err_t bsp_play_audio_stream(const uint8_t *audio_data, size_t data_len)
+static esp_err_t play_audio_stream_locked(const uint8_t *audio_data, size_t data_len)
 {
+    // 流式播放只在播放任务里进行
+    static uint8_t convert_buffer[TX_CONVERT_BYTES] __attribute__((aligned(4)));
     esp_err_t ret = ESP_OK;
     size_t bytes_written = 0;
     size_t total_written = 0;
@@ -479,13 +889,14 @@ esp_err_t bsp_play_audio_stream(const uint8_t *audio_data, size_t data_len)
             return ret;
         }
         tx_channel_enabled = true;
+        tracker_reset(&tx_tracker, tx_tracker.byte_rate);
         ESP_LOGD(TAG, "I2S发送通道已重新启用");
         
         // 发送一小段静音数据来初始化通道
         const size_t init_silence_size = 256; // 减小到256字节，避免大量内存分配
         static uint8_t init_silence[256] = {0}; // 使用静态数组，避免动态分配
         size_t silence_written = 0;
-        i2s_channel_write(tx_handle, init_silence, init_silence_size, &silence_written, pdMS_TO_TICKS(10));
+        tx_write(init_silence, init_silence_size, &silence_written, pdMS_TO_TICKS(10));
     }
 
     // 循环写入音频数据，确保所有数据都被发送
@@ -494,7 +905,7 @@ esp_err_t bsp_play_audio_stream(const uint8_t *audio_data, size_t data_len)
         size_t bytes_to_write = data_len - total_written;
         
         // 将音频数据写入 I2S 发送通道
-        ret = i2s_channel_write(tx_handle, audio_data + total_written, bytes_to_write, &bytes_written, portMAX_DELAY);
+        ret = i2s_write_pcm16(audio_data + total_written, bytes_to_write, &bytes_written, convert_buffer);
 
         if (ret != ESP_OK)
         {
@@ -523,16 +934,29 @@ esp_err_t bsp_play_audio_stream(const uint8_t *audio_data, size_t data_len)
     return ESP_OK;
 }
 
+esp_err_t bsp_play_audio_stream(const uint8_t *audio_data, size_t data_len)
+{
+    if (tx_lock == nullptr)
+    {
+        ESP_LOGE(TAG, "I2S发送通道未初始化");
+        return ESP_ERR_INVALID_STATE;
+    }
+    xSemaphoreTake(tx_lock, portMAX_DELAY);
+    esp_err_t ret = play_audio_stream_locked(audio_data, data_len);
+    xSemaphoreGive(tx_lock);
+    return ret;
+}
+
 /**
  * @brief 停止 I2S 音频输出以防止噪音
  *
  * 这个函数会暂时禁用 I2S 发送通道，停止向 MAX98357A 发送数据，
  * 从而消除播放完成后的噪音。当需要再次播放音频时，
- * 可以重新启用通道。
+ * 可以重新启用通道。调用者持有 tx_lock。
  *
  * @return esp_err_t 停止结果
  */
-esp_err_t bsp_audio_stop(void)
+static esp_err_t audio_stop_locked(void)
 {
     esp_err_t ret = ESP_OK;
 
@@ -550,7 +974,7 @@ esp_err_t bsp_audio_stop(void)
         uint8_t *silence_buffer = (uint8_t *)calloc(silence_size, 1);
         if (silence_buffer) {
             size_t bytes_written = 0;
-            i2s_channel_write(tx_handle, silence_buffer, silence_size, &bytes_written, pdMS_TO_TICKS(100));
+            tx_write(silence_buffer, silence_size, &bytes_written, pdMS_TO_TICKS(100));
             free(silence_buffer);
             ESP_LOGD(TAG, "已发送静音数据清空缓冲区");
         }
@@ -580,3 +1004,175 @@ esp_err_t bsp_audio_stop(void)
 
     return ESP_OK;
 }
+
+esp_err_t bsp_audio_stop(void)
+{
+    if (tx_lock == nullptr)
+    {
+        ESP_LOGW(TAG, "I2S发送通道未初始化，无需停止");
+        return ESP_OK;
+    }
+    xSemaphoreTake(tx_lock, portMAX_DELAY);
+    esp_err_t ret = audio_stop_locked();
+    xSemaphoreGive(tx_lock);
+    return ret;
+}
+
+/**
+ * @brief 检查DMA几何参数：至少2个描述符，单个描述符不超过4092字节
+ */
+static esp_err_t check_geometry(const char *who, const bsp_i2s_dma_geometry_t *g, size_t frame_bytes)
+{
+    if (g->desc_num < 2 || g->frame_num == 0 || g->frame_num * frame_bytes > 4092)
+    {
+        ESP_LOGE(TAG, "%s DMA几何参数无效: %lu x %lu 帧（每帧 %zu 字节）", who,
+                 (unsigned long)g->desc_num, (unsigned long)g->frame_num, frame_bytes);
+        return ESP_ERR_INVALID_ARG;
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief 设置I2S DMA几何参数
+ *
+ * 描述符数量和大小在创建通道时确定，通道已经存在时删除后按新参数重建。
+ * 发送通道在 tx_lock 里重建：正在播放的提示音或流式块写完之后才删除旧通道。
+ * 描述符越小，采到的数据越早交给应用、写入的数据越早播出，但中断越频繁；
+ * 描述符越少，能吸收的读写抖动越小，更容易溢出/欠载。
+ *
+ * @param rx 接收方向参数，nullptr=不变
+ * @param tx 发送方向参数，nullptr=不变
+ * @return esp_err_t 设置结果
+ */
+esp_err_t bsp_i2s_set_dma_geometry(const bsp_i2s_dma_geometry_t *rx, const bsp_i2s_dma_geometry_t *tx)
+{
+    esp_err_t ret = ESP_OK;
+    if (rx != nullptr && (ret = check_geometry("接收", rx, sample_format::bytes_for<MicFormat>(1))) != ESP_OK)
+    {
+        return ret;
+    }
+    if (tx != nullptr && (ret = check_geometry("发送", tx, sample_format::bytes_for<SpeakerFormat>(1))) != ESP_OK)
+    {
+        return ret;
+    }
+
+    if (rx != nullptr && (rx->desc_num != rx_geometry.desc_num || rx->frame_num != rx_geometry.frame_num))
+    {
+        rx_geometry = *rx;
+        if (rx_handle != nullptr)
+        {
+            i2s_channel_disable(rx_handle);
+            i2s_del_channel(rx_handle);
+            rx_handle = nullptr;
+            ret = bsp_i2s_init(rx_sample_rate, 1, 16);
+            if (ret != ESP_OK)
+            {
+                return ret;
+            }
+        }
+    }
+
+    if (tx != nullptr && (tx->desc_num != tx_geometry.desc_num || tx->frame_num != tx_geometry.frame_num))
+    {
+        tx_geometry = *tx;
+        if (tx_handle != nullptr)
+        {
+            xSemaphoreTake(tx_lock, portMAX_DELAY);
+            audio_stop_locked();
+            i2s_del_channel(tx_handle);
+            tx_handle = nullptr;
+            ret = bsp_audio_init(tx_sample_rate, 1, 16);
+            xSemaphoreGive(tx_lock);
+            if (ret != ESP_OK)
+            {
+                return ret;
+            }
+            // 与初始化后一样保持通道启用、功放打开，等第一次播放
+        }
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief 读取I2S队列溢出次数和DMA排队延迟
+ *
+ * @param stats 输出
+ * @param reset 读完是否清零（几何参数不变）
+ */
+void bsp_i2s_get_stats(bsp_i2s_stats_t *stats, bool reset)
+{
+    DmaQueueTracker *trackers[2] = {&rx_tracker, &tx_tracker};
+    uint32_t overflows[2], counts[2], avg[2], max[2];
+    for (int i = 0; i < 2; i++)
+    {
+        DmaQueueTracker *t = trackers[i];
+        portENTER_CRITICAL(&t->lock);
+        overflows[i] = t->overflows;
+        counts[i] = t->count;
+        avg[i] = t->count > 0 ? (uint32_t)(t->total_latency_us / t->count) : 0;
+        max[i] = t->max_latency_us;
+        if (reset)
+        {
+            t->overflows = 0;
+            t->count = 0;
+            t->total_latency_us = 0;
+            t->max_latency_us = 0;
+        }
+        portEXIT_CRITICAL(&t->lock);
+    }
+    stats->rx_queue_overflows = overflows[0];
+    stats->rx_reads = counts[0];
+    stats->rx_latency_avg_us = avg[0];
+    stats->rx_latency_max_us = max[0];
+    stats->tx_queue_overflows = overflows[1];
+    stats->tx_writes = counts[1];
+    stats->tx_latency_avg_us = avg[1];
+    stats->tx_latency_max_us = max[1];
+}
+
+/**
+ * @brief 检查I2S中断路径是否flash安全
+ *
+ * 擦写flash时cache关闭，只有IRAM里的中断还能跑：打开 CONFIG_I2S_ISR_IRAM_SAFE 后，
+ * 驱动的中断和我们的事件回调照常执行，DMA队列记账和溢出计数不会漏，
+ * 但前提是回调本身在IRAM、它们碰的数据在内部RAM（PSRAM同样走cache）。
+ * 任务（播放循环、采集读取）在flash操作期间两个核都会停，这里不检查，
+ * 由flash写入闸门保证实时音频期间不写flash（见 flash_write_gate.h）。
+ */
+esp_err_t bsp_i2s_check_iram_safety(void)
+{
+    struct {
+        const char *name;
+        const void *ptr;
+        bool code;
+    } items[] = {
+        {"on_rx_recv", (const void *)on_rx_recv, true},
+        {"on_rx_queue_overflow", (const void *)on_rx_queue_overflow, true},
+        {"on_tx_sent", (const void *)on_tx_sent, true},
+        {"on_tx_queue_overflow", (const void *)on_tx_queue_overflow, true},
+        {"rx_tracker", &rx_tracker, false},
+        {"tx_tracker", &tx_tracker, false},
+    };
+    esp_err_t ret = ESP_OK;
+    for (const auto &item : items)
+    {
+        bool ok = item.code ? esp_ptr_in_iram(item.ptr) : esp_ptr_internal(item.ptr);
+        if (!ok)
+        {
+            ESP_LOGE(TAG, "%s 不在%s（%p），flash操作期间中断会访问失效",
+                     item.name, item.code ? "IRAM" : "内部RAM", item.ptr);
+            ret = ESP_ERR_INVALID_STATE;
+        }
+    }
+#if !CONFIG_I2S_ISR_IRAM_SAFE
+    ESP_LOGW(TAG, "CONFIG_I2S_ISR_IRAM_SAFE 未开启：flash操作期间I2S中断被推迟，溢出计数会漏记");
+#endif
+#if !CONFIG_ESP_TIMER_IN_IRAM
+    ESP_LOGW(TAG, "CONFIG_ESP_TIMER_IN_IRAM 未开启：中断回调里的 esp_timer_get_time() 不是flash安全的");
+#endif
+    if (ret == ESP_OK)
+    {
+        ESP_LOGI(TAG, "I2S中断路径flash安全检查通过");
+    }
+    return ret;
+}
@@ -1,7 +1,38 @@
 // main/bsp_board.h
 #pragma once
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 #include "esp_err.h"
 
+// I2S DMA 几何参数：desc_num 个描述符，每个描述符 frame_num 帧
+// 总缓冲时长 = desc_num * frame_num / 采样率；单个描述符不能超过4092字节
+typedef struct {
+    uint32_t desc_num;
+    uint32_t frame_num;
+} bsp_i2s_dma_geometry_t;
+
+// I2S 队列和延迟统计（自上次清零以来）
+typedef struct {
+    uint32_t rx_queue_overflows;    // 接收队列溢出：应用读得太慢，最旧的采集数据被丢弃
+    uint32_t tx_queue_overflows;    // 发送队列溢出：应用写得太慢，DMA空转（播放欠载）
+    uint32_t rx_reads;
+    uint32_t rx_latency_avg_us;     // 采集到被读出：本次读到的最旧样本在DMA里待了多久
+    uint32_t rx_latency_max_us;
+    uint32_t tx_writes;
+    uint32_t tx_latency_avg_us;     // 写入到出声：写入返回时DMA里排在前面的数据时长
+    uint32_t tx_latency_max_us;
+} bsp_i2s_stats_t;
+
+// 双麦克风波束形成统计（自启动以来）
+typedef struct {
+    bool adaptive;                  // 自适应模式
+    int32_t delay;                  // 当前延迟（样本，正数=声音先到右麦克风）
+    uint32_t blocks;                // 处理的片数（每片16ms）
+    uint32_t voiced_blocks;         // 参与延迟估计的片数
+    uint32_t delay_changes;         // 延迟切换次数
+} bsp_mic_beam_stats_t;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -18,6 +49,15 @@ esp_err_t bsp_play_audio(const uint8_t *audio_data, size_t data_len);
 esp_err_t bsp_play_audio_stream(const uint8_t *audio_data, size_t data_len);
 // 停止音频输出
 esp_err_t bsp_audio_stop(void);
+// 设置I2S DMA几何参数（nullptr=该方向不变）；通道已创建时重建通道。
+// 发送方向与播放、停止函数互斥（内部加锁）；接收方向调用者保证此时没有读
+esp_err_t bsp_i2s_set_dma_geometry(const bsp_i2s_dma_geometry_t *rx, const bsp_i2s_dma_geometry_t *tx);
+// 读取I2S统计，reset=true 时读完清零
+void bsp_i2s_get_stats(bsp_i2s_stats_t *stats, bool reset);
+// 检查I2S中断路径在flash操作期间能否继续运行（回调在IRAM、记账数据在内部RAM）
+esp_err_t bsp_i2s_check_iram_safety(void);
+// 读取双麦克风波束形成统计；单麦克风配置返回 ESP_ERR_NOT_SUPPORTED
+esp_err_t bsp_mic_get_beam_stats(bsp_mic_beam_stats_t *stats);
 #ifdef __cplusplus
 }
 #endif
\ No newline at end of file
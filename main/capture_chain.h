@@ -0,0 +1,29 @@
+/**
+ * @file capture_chain.h
+ * @brief 🎙️ 采集处理链 - 麦克风帧在噪音抑制之前的原地处理
+ *
+ * 主程序和主机端回归测试共用这个类型，测试跑的就是固件里的组合。
+ */
+
+#ifndef CAPTURE_CHAIN_H
+#define CAPTURE_CHAIN_H
+
+#include "sdkconfig.h"
+#include "dsp_pipeline.h"
+
+#if CONFIG_AUDIO_CAPTURE_AGC
+using CaptureAgc = dsp::Agc<CONFIG_AUDIO_AGC_TARGET_DBFS, CONFIG_AUDIO_AGC_MAX_GAIN_DB, CONFIG_AUDIO_AGC_GATE_DBFS>;
+#endif
+
+// 先去直流再做自动增益：直流偏置会被当成电平
+#if CONFIG_AUDIO_CAPTURE_DC_BLOCK && CONFIG_AUDIO_CAPTURE_AGC
+using CaptureChain = dsp::Pipeline<dsp::DcBlock<>, CaptureAgc>;
+#elif CONFIG_AUDIO_CAPTURE_DC_BLOCK
+using CaptureChain = dsp::Pipeline<dsp::DcBlock<>>;
+#elif CONFIG_AUDIO_CAPTURE_AGC
+using CaptureChain = dsp::Pipeline<CaptureAgc>;
+#else
+using CaptureChain = dsp::Pipeline<>;
+#endif
+
+#endif // CAPTURE_CHAIN_H
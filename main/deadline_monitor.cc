@@ -0,0 +1,203 @@
+/**
+ * @file deadline_monitor.cc
+ * @brief ⏱️ 实时任务截止时间监控实现
+ */
+
+#include "deadline_monitor.h"
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/task.h"
+
+static const char *TAG = "Deadline";
+
+// ==================== DeadlineLoop ====================
+
+int DeadlineLoop::lateBucket(int32_t late_us)
+{
+    if (late_us <= 0) {
+        return 0;
+    }
+    int bucket = 1;
+    for (int32_t limit = 1000; late_us >= limit && bucket < LATE_BUCKETS - 1; limit *= 2) {
+        bucket++;
+    }
+    return bucket;
+}
+
+void DeadlineLoop::stamp()
+{
+    int64_t now = esp_timer_get_time();
+    uint32_t late = 0;
+    if (last_stamp_us_ != 0) {
+        int32_t late_us = (int32_t)(now - last_stamp_us_ - period_us_);
+        stats_.late_hist[lateBucket(late_us)]++;
+        stats_.iterations++;
+        if (late_us > 0) {
+            late = (uint32_t)late_us;
+            if (late > stats_.max_late_us) {
+                stats_.max_late_us = late;
+            }
+        }
+    }
+    last_stamp_us_ = now;
+    working_ = true;
+    monitor_->trace(id_, DeadlineMonitor::TRACE_STAMP, now, late);
+}
+
+void DeadlineLoop::waitStart()
+{
+    // 读失败后重试时会连续调用两次，只有第一次结束处理时间
+    if (!working_) {
+        return;
+    }
+    working_ = false;
+
+    int64_t now = esp_timer_get_time();
+    uint32_t work = (uint32_t)(now - last_stamp_us_);
+    stats_.total_work_us += work;
+    if (work > stats_.max_work_us) {
+        stats_.max_work_us = work;
+    }
+    monitor_->trace(id_, DeadlineMonitor::TRACE_WAIT, now, work);
+
+    if (work > budget_us_) {
+        stats_.misses++;
+        monitor_->trace(id_, DeadlineMonitor::TRACE_MISS, now, work);
+        monitor_->freeze(id_);
+    }
+}
+
+void DeadlineLoop::skip()
+{
+    if (last_stamp_us_ == 0 && !working_) {
+        return;
+    }
+    last_stamp_us_ = 0;
+    working_ = false;
+    stats_.skipped++;
+    monitor_->trace(id_, DeadlineMonitor::TRACE_SKIP, esp_timer_get_time(), 0);
+}
+
+void DeadlineLoop::setTiming(uint32_t period_us, uint32_t budget_us)
+{
+    skip();
+    period_us_ = period_us;
+    budget_us_ = budget_us;
+}
+
+void DeadlineLoop::resetStats()
+{
+    memset(&stats_, 0, sizeof(stats_));
+}
+
+// ==================== DeadlineMonitor ====================
+
+DeadlineMonitor::DeadlineMonitor(bool snapshot_on_miss)
+    : loop_count_(0)
+    , snapshot_on_miss_(snapshot_on_miss)
+    , trace_head_(0)
+    , snapshot_valid_(false)
+    , snapshot_loop_(0)
+    , snapshot_count_(0)
+{
+    portMUX_INITIALIZE(&lock_);
+    memset(trace_, 0, sizeof(trace_));
+    memset(snapshot_, 0, sizeof(snapshot_));
+}
+
+DeadlineLoop* DeadlineMonitor::registerLoop(const char* name, uint32_t period_us, uint32_t budget_us)
+{
+    if (loop_count_ >= MAX_LOOPS) {
+        ESP_LOGE(TAG, "实时循环注册已满，忽略 %s", name);
+        return nullptr;
+    }
+    DeadlineLoop* loop = &loops_[loop_count_];
+    loop->monitor_ = this;
+    loop->id_ = (uint8_t)loop_count_;
+    loop->name_ = name;
+    loop->period_us_ = period_us;
+    loop->budget_us_ = budget_us;
+    loop->last_stamp_us_ = 0;
+    loop->working_ = false;
+    loop->resetStats();
+    loop_count_++;
+    ESP_LOGI(TAG, "注册实时循环 %s: 周期 %lu us, 预算 %lu us",
+             name, (unsigned long)period_us, (unsigned long)budget_us);
+    return loop;
+}
+
+void DeadlineMonitor::trace(uint8_t loop, uint8_t kind, int64_t now_us, uint32_t value_us)
+{
+    portENTER_CRITICAL(&lock_);
+    TraceEvent& e = trace_[trace_head_ % TRACE_EVENTS];
+    e.time_us = (uint32_t)now_us;
+    e.value_us = value_us;
+    e.loop = loop;
+    e.kind = kind;
+    e.core = (uint8_t)xPortGetCoreID();
+    e.reserved = 0;
+    trace_head_++;
+    portEXIT_CRITICAL(&lock_);
+}
+
+void DeadlineMonitor::freeze(uint8_t loop)
+{
+    if (!snapshot_on_miss_) {
+        return;
+    }
+    portENTER_CRITICAL(&lock_);
+    if (!snapshot_valid_) {
+        // 按时间顺序（最旧的在前）拷出环形轨迹
+        uint32_t count = trace_head_ < TRACE_EVENTS ? trace_head_ : TRACE_EVENTS;
+        uint32_t first = trace_head_ - count;
+        for (uint32_t i = 0; i < count; i++) {
+            snapshot_[i] = trace_[(first + i) % TRACE_EVENTS];
+        }
+        snapshot_count_ = count;
+        snapshot_loop_ = loop;
+        snapshot_valid_ = true;
+    }
+    portEXIT_CRITICAL(&lock_);
+}
+
+void DeadlineMonitor::report(bool verbose)
+{
+    for (int i = 0; i < loop_count_; i++) {
+        const DeadlineLoop& loop = loops_[i];
+        DeadlineLoop::Stats s = loop.getStats();
+        if (s.iterations == 0) {
+            continue;
+        }
+        uint32_t avg_work = (uint32_t)(s.total_work_us / s.iterations);
+        ESP_LOGI(TAG, "%s: %lu 次, 超时 %lu, 处理 平均 %lu / 最长 %lu us (预算 %lu us, 占用 %.1f%%), 最大迟到 %lu us",
+                 loop.name(), (unsigned long)s.iterations, (unsigned long)s.misses,
+                 (unsigned long)avg_work, (unsigned long)s.max_work_us, (unsigned long)loop.budgetUs(),
+                 avg_work * 100.0f / loop.periodUs(), (unsigned long)s.max_late_us);
+        if (verbose) {
+            ESP_LOGI(TAG, "  迟到分布 准时:%lu <1ms:%lu <2ms:%lu <4ms:%lu <8ms:%lu <16ms:%lu <32ms:%lu <64ms:%lu >=64ms:%lu",
+                     (unsigned long)s.late_hist[0], (unsigned long)s.late_hist[1],
+                     (unsigned long)s.late_hist[2], (unsigned long)s.late_hist[3],
+                     (unsigned long)s.late_hist[4], (unsigned long)s.late_hist[5],
+                     (unsigned long)s.late_hist[6], (unsigned long)s.late_hist[7],
+                     (unsigned long)s.late_hist[8]);
+        }
+    }
+
+    if (!snapshot_valid_) {
+        return;
+    }
+    static const char* const KIND_NAMES[] = { "开始", "等待", "超时", "跳过" };
+    ESP_LOGW(TAG, "⚠ %s 超时快照（时间相对超时时刻）:", loops_[snapshot_loop_].name());
+    uint32_t end_us = snapshot_count_ > 0 ? snapshot_[snapshot_count_ - 1].time_us : 0;
+    for (uint32_t i = 0; i < snapshot_count_; i++) {
+        const TraceEvent& e = snapshot_[i];
+        int32_t rel_us = (int32_t)(e.time_us - end_us);
+        ESP_LOGW(TAG, "  %8.1f ms  核%u %-10s %s %lu us",
+                 rel_us / 1000.0f, e.core, e.loop < loop_count_ ? loops_[e.loop].name() : "?",
+                 KIND_NAMES[e.kind & 3], (unsigned long)e.value_us);
+    }
+    portENTER_CRITICAL(&lock_);
+    snapshot_valid_ = false;
+    portEXIT_CRITICAL(&lock_);
+}
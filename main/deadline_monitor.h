@@ -0,0 +1,163 @@
+/**
+ * @file deadline_monitor.h
+ * @brief ⏱️ 实时任务截止时间监控 - 每个实时循环声明周期和预算，逐次打点统计超时
+ *
+ * 采集循环必须每个唤醒词帧周期读一次I2S，player_task必须每100ms写3200字节，
+ * 晚了就是I2S溢出或欠载：声音悄悄坏掉，没有任何日志。这里给每个实时循环记账：
+ *
+ * - 循环注册时声明周期（period）和每次迭代允许的处理时间（budget）
+ * - 阻塞等待之前调用 waitStart()，等待返回后调用 stamp()：
+ *   两次 stamp() 的间隔减去周期是迟到时间，stamp() 到下一次 waitStart() 是处理时间
+ * - 处理时间超过预算记一次超时（miss），迟到时间按对数分桶记直方图
+ * - 所有循环的打点写进一个共享的小环形轨迹，第一次超时时冻结一份快照，
+ *   能看到超时前后各个循环（在哪个核上）都在干什么
+ *
+ * 故意阻塞的迭代（播放提示音、等待重连）调用 skip()，不计入统计。
+ * 每次打点只是一次 esp_timer_get_time() 和几次加法，默认一直开着，
+ * 用来确认加上噪音抑制、编码等处理之后每个核上的实时循环还在预算内。
+ */
+
+#ifndef DEADLINE_MONITOR_H
+#define DEADLINE_MONITOR_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "freertos/FreeRTOS.h"
+
+class DeadlineMonitor;
+
+/**
+ * @brief 一个实时循环的记账
+ */
+class DeadlineLoop {
+public:
+    // 迟到直方图：[准时] [<1ms] [<2ms] [<4ms] ... [<64ms] [>=64ms]
+    static constexpr int LATE_BUCKETS = 9;
+
+    struct Stats {
+        uint32_t iterations;            // 统计到的迭代数
+        uint32_t misses;                // 处理时间超过预算的次数
+        uint32_t skipped;               // 调用 skip() 跳过的迭代数
+        uint32_t max_work_us;           // 最长处理时间
+        uint64_t total_work_us;         // 处理时间总和（算平均和占用率）
+        uint32_t max_late_us;           // 最大迟到时间
+        uint32_t late_hist[LATE_BUCKETS];
+    };
+
+    /**
+     * @brief 阻塞等待（读I2S、写I2S）之前调用，结束上一次迭代的处理时间
+     */
+    void waitStart();
+
+    /**
+     * @brief 阻塞等待返回后调用，开始新的一次迭代
+     */
+    void stamp();
+
+    /**
+     * @brief 本次迭代故意阻塞或循环暂停，下一次 stamp() 重新开始计时
+     */
+    void skip();
+
+    /**
+     * @brief 修改周期和预算（例如播放块长度变了），同时结束当前的计时
+     */
+    void setTiming(uint32_t period_us, uint32_t budget_us);
+
+    Stats getStats() const { return stats_; }
+    void resetStats();
+
+    const char* name() const { return name_; }
+    uint32_t periodUs() const { return period_us_; }
+    uint32_t budgetUs() const { return budget_us_; }
+
+private:
+    friend class DeadlineMonitor;
+
+    static int lateBucket(int32_t late_us);
+
+    DeadlineMonitor* monitor_;
+    uint8_t id_;
+    const char* name_;
+    uint32_t period_us_;
+    uint32_t budget_us_;
+    int64_t last_stamp_us_;         // 0=没有可比较的上一次打点
+    bool working_;                  // stamp() 之后、waitStart() 之前
+    Stats stats_;
+};
+
+/**
+ * @brief 实时循环注册表
+ */
+class DeadlineMonitor {
+public:
+    static constexpr int MAX_LOOPS = 4;
+    static constexpr int TRACE_EVENTS = 32;
+
+    /**
+     * @brief 轨迹里的一个事件（12字节）
+     */
+    struct TraceEvent {
+        uint32_t time_us;           // esp_timer 时间的低32位
+        uint32_t value_us;          // STAMP: 迟到时间；WAIT: 处理时间
+        uint8_t loop;
+        uint8_t kind;               // TRACE_*
+        uint8_t core;
+        uint8_t reserved;
+    };
+
+    enum : uint8_t {
+        TRACE_STAMP = 0,            // 等待返回，开始处理
+        TRACE_WAIT = 1,             // 处理结束，开始等待
+        TRACE_MISS = 2,             // 处理时间超过预算
+        TRACE_SKIP = 3,
+    };
+
+    /**
+     * @param snapshot_on_miss 第一次超时时是否冻结轨迹快照
+     */
+    explicit DeadlineMonitor(bool snapshot_on_miss);
+
+    /**
+     * @brief 注册一个实时循环
+     *
+     * @param name 名字（不拷贝，传字符串常量）
+     * @param period_us 循环周期
+     * @param budget_us 每次迭代允许的处理时间
+     * @return 循环句柄，注册满时返回nullptr
+     */
+    DeadlineLoop* registerLoop(const char* name, uint32_t period_us, uint32_t budget_us);
+
+    /**
+     * @brief 输出各循环的统计；有冻结的快照时一并输出并清除，下一次超时可以再冻结
+     *
+     * @param verbose 是否输出迟到直方图
+     */
+    void report(bool verbose);
+
+    /**
+     * @brief 是否有尚未输出的超时快照
+     */
+    bool hasSnapshot() const { return snapshot_valid_; }
+
+private:
+    friend class DeadlineLoop;
+
+    void trace(uint8_t loop, uint8_t kind, int64_t now_us, uint32_t value_us);
+    void freeze(uint8_t loop);
+
+    DeadlineLoop loops_[MAX_LOOPS];
+    int loop_count_;
+    bool snapshot_on_miss_;
+
+    portMUX_TYPE lock_;
+    TraceEvent trace_[TRACE_EVENTS];
+    uint32_t trace_head_;           // 下一个写入位置（单调递增）
+
+    bool snapshot_valid_;
+    uint8_t snapshot_loop_;
+    uint32_t snapshot_count_;
+    TraceEvent snapshot_[TRACE_EVENTS];
+};
+
+#endif // DEADLINE_MONITOR_H
@@ -0,0 +1,292 @@
+/**
+ * @file dsp_pipeline.h
+ * @brief 🎛️ DSP流水线模板 - 编译期组合处理级，逐样本级融合成一次遍历
+ *
+ * 每加一个处理（增益、高通、限幅……）就多一遍对整个缓冲区的读写。
+ * Pipeline<Stages...> 在编译期把处理级串起来：
+ *
+ * - 逐样本级（提供 int32_t sample(int32_t)）：相邻的逐样本级融合进同一个循环，
+ *   每个样本只读写内存一次，中间值用32位保存，整组结束时才饱和到16位
+ * - 整块级（提供 void block(int16_t*, size_t)）：按块调用，例如电平统计
+ *
+ * 缓冲区按 TILE 个样本分片处理，一片在所有处理级之间流转时始终留在cache里。
+ * 整块级因此每次拿到的是一片（不超过 TILE 个样本），不能假设固定长度。
+ *
+ * 纯头文件，不依赖ESP-IDF，主机端基准测试也可以直接编译。
+ */
+
+#ifndef DSP_PIPELINE_H
+#define DSP_PIPELINE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <tuple>
+#include <utility>
+#include <type_traits>
+
+namespace dsp {
+
+namespace detail {
+
+template <typename S, typename = void>
+struct is_sample_stage : std::false_type {};
+
+template <typename S>
+struct is_sample_stage<S, decltype((void)std::declval<S&>().sample(int32_t(0)))> : std::true_type {};
+
+inline int16_t saturate16(int32_t v) {
+    return (int16_t)(v < -32768 ? -32768 : (v > 32767 ? 32767 : v));
+}
+
+} // namespace detail
+
+/**
+ * @brief 处理级组合
+ *
+ * @tparam Stages 按顺序执行的处理级
+ */
+template <typename... Stages>
+class Pipeline {
+public:
+    static constexpr size_t TILE = 256;         // 512字节一片
+
+    /**
+     * @brief 原地处理一段16位样本
+     */
+    void process(int16_t* data, size_t count) {
+        while (count > 0) {
+            size_t n = count < TILE ? count : TILE;
+            run<0>(data, n);
+            data += n;
+            count -= n;
+        }
+    }
+
+    /**
+     * @brief 取第 I 个处理级（调整参数、读统计）
+     */
+    template <size_t I>
+    auto& stage() { return std::get<I>(stages_); }
+
+    /**
+     * @brief 清空所有处理级的内部状态
+     */
+    void reset() {
+        std::apply([](auto&... s) { (s.reset(), ...); }, stages_);
+    }
+
+    static constexpr size_t size() { return sizeof...(Stages); }
+
+private:
+    template <size_t I>
+    using StageAt = std::tuple_element_t<I, std::tuple<Stages...>>;
+
+    // 从 I 开始连续的逐样本级在哪里结束
+    template <size_t I>
+    static constexpr size_t sample_run_end() {
+        if constexpr (I < sizeof...(Stages)) {
+            if constexpr (detail::is_sample_stage<StageAt<I>>::value) {
+                return sample_run_end<I + 1>();
+            } else {
+                return I;
+            }
+        } else {
+            return I;
+        }
+    }
+
+    template <size_t I>
+    void run(int16_t* data, size_t n) {
+        if constexpr (I < sizeof...(Stages)) {
+            if constexpr (detail::is_sample_stage<StageAt<I>>::value) {
+                constexpr size_t end = sample_run_end<I>();
+                fused(data, n, std::make_index_sequence<end - I>{}, std::integral_constant<size_t, I>{});
+                run<end>(data, n);
+            } else {
+                std::get<I>(stages_).block(data, n);
+                run<I + 1>(data, n);
+            }
+        }
+    }
+
+    // 一个循环跑完 [First, First + sizeof(Is)) 这几个逐样本级
+    template <size_t First, size_t... Is>
+    void fused(int16_t* data, size_t n, std::index_sequence<Is...>, std::integral_constant<size_t, First>) {
+        // 状态拷到局部变量，循环里留在寄存器，不必每个样本写回对象
+        auto stages = std::make_tuple(std::get<First + Is>(stages_)...);
+        for (size_t i = 0; i < n; i++) {
+            int32_t x = data[i];
+            ((x = std::get<Is>(stages).sample(x)), ...);
+            data[i] = detail::saturate16(x);
+        }
+        ((std::get<First + Is>(stages_) = std::get<Is>(stages)), ...);
+    }
+
+    std::tuple<Stages...> stages_;
+};
+
+// ========== 常用处理级 ==========
+
+/**
+ * @brief 直流阻断（一阶高通）：y[n] = x[n] - x[n-1] + R*y[n-1]
+ *
+ * R = 1 - 2^-Shift，Shift=7 时 16kHz 下截止约 20Hz。
+ * 麦克风的直流偏置会抬高VAD/唤醒词看到的能量，这里把它去掉。
+ */
+template <int Shift = 7>
+struct DcBlock {
+    int32_t x1 = 0;
+    int32_t y1 = 0;     // Q8，保留小数避免极限环
+
+    int32_t sample(int32_t x) {
+        int32_t y = ((x - x1) << 8) + y1 - (y1 >> Shift);
+        x1 = x;
+        y1 = y;
+        return y >> 8;
+    }
+    void reset() { x1 = 0; y1 = 0; }
+};
+
+/**
+ * @brief 增益（Q8，256=1.0），可以运行时调整
+ */
+struct Gain {
+    int32_t q8 = 256;
+
+    int32_t sample(int32_t x) const { return (x * q8) >> 8; }
+    void reset() {}
+};
+
+/**
+ * @brief 软限幅：超过阈值的部分压缩为 1/2^Ratio，避免硬削波的刺耳失真
+ */
+template <int32_t Threshold = 24576, int Ratio = 2>
+struct SoftClip {
+    int32_t sample(int32_t x) const {
+        if (x > Threshold) return Threshold + ((x - Threshold) >> Ratio);
+        if (x < -Threshold) return -Threshold + ((x + Threshold) >> Ratio);
+        return x;
+    }
+    void reset() {}
+};
+
+/**
+ * @brief 整数 dB 换算成线性倍数（ref * 10^(db/20)），编译期计算
+ */
+constexpr int32_t db_to_linear(int db, int32_t ref)
+{
+    double v = ref;
+    for (int i = 0; i < (db < 0 ? -db : db); i++) {
+        v = db < 0 ? v / 1.1220184543019633 : v * 1.1220184543019633;   // 10^(1/20)
+    }
+    return (int32_t)(v + 0.5);
+}
+
+/**
+ * @brief 自动增益（整块级）：把说话电平拉到目标值，与说话人距离无关
+ *
+ * 每块（流水线的一片，不超过 TILE 个样本）算一次平均绝对值作为电平，
+ * 包络跟随：电平上升时每块追上差值的 1/2^AttackShift，下降时 1/2^ReleaseShift，
+ * 增益 = 目标电平 / 包络，限制在 [MinGainDb, MaxGainDb]。增益下降立即生效，上升每块只走差值的 1/2^RiseShift，
+ * 轻声的开头不会把增益一下拉满、紧接着的重音再冲过头。块内增益从上一块的值线性过渡到新值，没有阶跃噪声。
+ *
+ * - 噪声门：包络低于 GateDbfs、或不到底噪的 GATE_OVER_FLOOR 倍时不再调整增益（静音不会被拉到目标电平），
+ *   持续 HOLD_SAMPLES 以上才按释放速度慢慢回到 0dB。底噪取各块电平的最小值，每块最多上升 1/128，
+ *   房间噪声比固定门限高时也不会被当成说话放大
+ * - 防削波：这块的峰值乘新增益会超过 CLIP_LIMIT 时立即降到刚好不超过，不做过渡
+ *
+ * 全部定点运算，每块一次除法。电平都按 16 位满量程计：-20dBFS 约为 3277（平均绝对值，语音的RMS约高 2dB）。
+ */
+template <int TargetDbfs = -20, int MaxGainDb = 24, int GateDbfs = -55,
+          int AttackShift = 1, int ReleaseShift = 5, int RiseShift = 2, int MinGainDb = -12>
+struct Agc {
+    static_assert(MaxGainDb >= 0 && MaxGainDb <= 30, "最大增益 0~30dB");
+    static_assert(MinGainDb <= 0 && MinGainDb >= -30, "最小增益 -30~0dB");
+
+    static constexpr int32_t UNITY_Q8 = 256;
+    static constexpr int32_t TARGET = db_to_linear(TargetDbfs, 32768);
+    static constexpr int32_t GATE = db_to_linear(GateDbfs, 32768);
+    static constexpr int32_t MAX_GAIN_Q8 = db_to_linear(MaxGainDb, UNITY_Q8);
+    static constexpr int32_t MIN_GAIN_Q8 = db_to_linear(MinGainDb, UNITY_Q8);
+    static constexpr int32_t CLIP_LIMIT = 29205;        // -1dBFS
+    static constexpr uint32_t HOLD_SAMPLES = 16000;     // 16kHz下1秒
+    static constexpr int32_t GATE_OVER_FLOOR = 3;       // 约10dB
+
+    int32_t env_q8 = 0;             // 电平包络（平均绝对值，Q8）
+    int32_t floor_q8 = 0;           // 底噪（各块电平的慢速最小值，Q8）
+    int32_t gain_q8 = UNITY_Q8;     // 当前增益
+    uint32_t gated_samples = 0;     // 连续处于噪声门以下的样本数
+
+    void block(int16_t* data, size_t n) {
+        if (n == 0) {
+            return;
+        }
+        int32_t sum = 0;
+        int32_t peak = 0;
+        for (size_t i = 0; i < n; i++) {
+            int32_t a = data[i] < 0 ? -(int32_t)data[i] : data[i];
+            sum += a;
+            peak = a > peak ? a : peak;
+        }
+        int32_t level_q8 = (int32_t)(((int64_t)sum << 8) / (int64_t)n);
+        int32_t diff = level_q8 - env_q8;
+        env_q8 += diff > 0 ? diff >> AttackShift : -((-diff) >> ReleaseShift);
+        if (floor_q8 == 0 || level_q8 < floor_q8) {
+            floor_q8 = level_q8 > 0 ? level_q8 : 1;
+        } else {
+            floor_q8 += (floor_q8 >> 7) + 1;
+        }
+
+        int32_t target_q8 = gain_q8;
+        if (env_q8 >= (GATE << 8) && env_q8 / GATE_OVER_FLOOR >= floor_q8) {
+            gated_samples = 0;
+            target_q8 = (int32_t)(((int64_t)TARGET << 16) / env_q8);
+        } else if (gated_samples < HOLD_SAMPLES) {
+            gated_samples += (uint32_t)n;
+        } else {
+            target_q8 = gain_q8 + ((UNITY_Q8 - gain_q8) >> ReleaseShift);
+        }
+        target_q8 = target_q8 > MAX_GAIN_Q8 ? MAX_GAIN_Q8 : (target_q8 < MIN_GAIN_Q8 ? MIN_GAIN_Q8 : target_q8);
+        if (target_q8 > gain_q8) {
+            target_q8 = gain_q8 + ((target_q8 - gain_q8 + (1 << RiseShift) - 1) >> RiseShift);
+        }
+
+        int32_t start_q8 = gain_q8;
+        if (peak * target_q8 > (CLIP_LIMIT << 8)) {
+            target_q8 = (CLIP_LIMIT << 8) / peak;
+            start_q8 = target_q8;
+        }
+
+        // 块内线性过渡：增益用Q16累加，乘的时候取Q8
+        int32_t g_q16 = start_q8 << 8;
+        int32_t step_q16 = ((target_q8 - start_q8) << 8) / (int32_t)n;
+        for (size_t i = 0; i < n; i++) {
+            g_q16 += step_q16;
+            data[i] = detail::saturate16((data[i] * (g_q16 >> 8)) >> 8);
+        }
+        gain_q8 = target_q8;
+    }
+    void reset() { env_q8 = 0; floor_q8 = 0; gain_q8 = UNITY_Q8; gated_samples = 0; }
+};
+
+/**
+ * @brief 峰值电平统计（整块级，不改数据）
+ */
+struct PeakMeter {
+    int32_t peak = 0;       // 自上次 take() 以来的最大绝对值
+
+    void block(int16_t* data, size_t n) {
+        int32_t p = peak;
+        for (size_t i = 0; i < n; i++) {
+            int32_t a = data[i] < 0 ? -(int32_t)data[i] : data[i];
+            p = a > p ? a : p;
+        }
+        peak = p;
+    }
+    int32_t take() { int32_t p = peak; peak = 0; return p; }
+    void reset() { peak = 0; }
+};
+
+} // namespace dsp
+
+#endif // DSP_PIPELINE_H
@@ -0,0 +1,21 @@
+/**
+ * @file dsp_pipeline_bench.h
+ * @brief 📊 DSP处理链基准测试 - 融合成一次遍历和逐级分开遍历的对比
+ *
+ * 启动时运行（CONFIG_AUDIO_DSP_BENCH）。同样四个处理级（直流阻断、增益、软限幅、峰值统计），
+ * 一种用 dsp::Pipeline 融合，一种每级单独走一遍缓冲区（每级之后饱和并写回16位），
+ * 分别在内部RAM的麦克风帧（512样本）和PSRAM的播放块（1600样本）上测每样本CPU周期，
+ * 并检查两种方式结果一致。
+ */
+
+#ifndef DSP_PIPELINE_BENCH_H
+#define DSP_PIPELINE_BENCH_H
+
+/**
+ * @brief 运行基准测试并打印结果（阻塞，不到1秒）
+ *
+ * @return 两种方式结果一致返回 true
+ */
+bool dsp_pipeline_bench_run(void);
+
+#endif // DSP_PIPELINE_BENCH_H
@@ -0,0 +1,180 @@
+/**
+ * @file echo_test.cc
+ * @brief 🔁 本地回声测试实现
+ */
+
+#include "echo_test.h"
+#include "audio_manager.h"
+#include "bsp_board.h"
+#include "capture_chain.h"
+#include "dsp_pipeline.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <string.h>
+
+static const char *TAG = "EchoTest";
+
+static constexpr size_t FRAME_SAMPLES = 512;            // 与主程序的采集帧相同（32ms）
+static constexpr size_t PACKET_BYTES = CONFIG_AUDIO_ECHO_TEST_PACKET_BYTES;
+static constexpr uint32_t WARMUP_MS = 1000;             // 开头这段不计入统计：播放还没起来，欠载是必然的
+static constexpr uint32_t REPORT_INTERVAL_MS = 5000;
+static constexpr uint32_t DRAIN_TIMEOUT_MS = 3000;
+
+/**
+ * @brief 一级的耗时/排队统计（微秒）
+ */
+struct StageStats {
+    uint64_t sum;
+    uint32_t min;
+    uint32_t max;
+    uint32_t count;
+
+    void reset() { sum = 0; min = UINT32_MAX; max = 0; count = 0; }
+    void add(uint32_t v) {
+        sum += v;
+        min = v < min ? v : min;
+        max = v > max ? v : max;
+        count++;
+    }
+    uint32_t avg() const { return count > 0 ? (uint32_t)(sum / count) : 0; }
+    uint32_t lo() const { return count > 0 ? min : 0; }
+};
+
+struct EchoStats {
+    StageStats process_us;          // 采集处理链每帧耗时
+    StageStats hold_us;             // 攒包等待
+    StageStats ring_us;             // 送入环形缓冲区时排在前面的数据时长
+    uint32_t packets;
+    uint32_t drops;                 // 环形缓冲区满，整包丢弃
+
+    void reset() {
+        process_us.reset();
+        hold_us.reset();
+        ring_us.reset();
+        packets = 0;
+        drops = 0;
+    }
+};
+
+static uint32_t bytes_to_us(size_t bytes, uint32_t sample_rate)
+{
+    return (uint32_t)((uint64_t)bytes / sizeof(int16_t) * 1000000 / sample_rate);
+}
+
+static void report(const EchoStats& s, const bsp_i2s_stats_t& i2s, AudioManager* audio)
+{
+    ESP_LOGI(TAG, "采集DMA   平均 %6lu / 最大 %6lu us",
+             (unsigned long)i2s.rx_latency_avg_us, (unsigned long)i2s.rx_latency_max_us);
+    ESP_LOGI(TAG, "处理      平均 %6lu / 最大 %6lu us",
+             (unsigned long)s.process_us.avg(), (unsigned long)s.process_us.max);
+    ESP_LOGI(TAG, "攒包      平均 %6lu / 最大 %6lu us（%u 字节一包，%lu 包）",
+             (unsigned long)s.hold_us.avg(), (unsigned long)s.hold_us.max,
+             (unsigned)PACKET_BYTES, (unsigned long)s.packets);
+    ESP_LOGI(TAG, "环形缓冲  最小 %6lu / 平均 %6lu / 最大 %6lu us，丢包 %lu",
+             (unsigned long)s.ring_us.lo(), (unsigned long)s.ring_us.avg(), (unsigned long)s.ring_us.max,
+             (unsigned long)s.drops);
+    ESP_LOGI(TAG, "播放DMA   平均 %6lu / 最大 %6lu us（播放块 %lu us），欠载 %lu",
+             (unsigned long)i2s.tx_latency_avg_us, (unsigned long)i2s.tx_latency_max_us,
+             (unsigned long)audio->getPlaybackChunkUs(), (unsigned long)i2s.tx_queue_overflows);
+    uint32_t total = i2s.rx_latency_avg_us + s.process_us.avg() + s.hold_us.avg() + s.ring_us.avg() +
+                     i2s.tx_latency_avg_us;
+    ESP_LOGI(TAG, "采集→播放 合计约 %lu ms（不含喇叭到麦克风的空气传播）", (unsigned long)(total / 1000));
+}
+
+bool echo_test_run(AudioManager* audio, uint32_t duration_sec)
+{
+    static int16_t frame[FRAME_SAMPLES];
+    static uint8_t packet[PACKET_BYTES];
+    CaptureChain capture_chain;
+    // 麦克风直接进喇叭，先衰减避免啸叫
+    dsp::Pipeline<dsp::Gain> attenuate;
+    attenuate.stage<0>().q8 = CONFIG_AUDIO_ECHO_TEST_GAIN_PCT * 256 / 100;
+    const uint32_t sample_rate = audio->getSampleRate();
+
+    ESP_LOGI(TAG, "开始本地回声测试 %lu 秒：%u 字节一包，输出 %d%%",
+             (unsigned long)duration_sec, (unsigned)PACKET_BYTES, CONFIG_AUDIO_ECHO_TEST_GAIN_PCT);
+    audio->startStreamingPlayback();
+
+    EchoStats stats;
+    stats.reset();
+    uint32_t total_drops = 0;
+    uint32_t total_underruns = 0;
+    size_t packet_fill = 0;
+    int64_t packet_first_us = 0;
+    bool warm = false;
+    const int64_t start_us = esp_timer_get_time();
+    const int64_t end_us = start_us + (int64_t)duration_sec * 1000000;
+    int64_t next_report_us = start_us + (int64_t)(WARMUP_MS + REPORT_INTERVAL_MS) * 1000;
+
+    while (esp_timer_get_time() < end_us) {
+        if (bsp_get_feed_data(false, frame, sizeof(frame)) != ESP_OK) {
+            vTaskDelay(pdMS_TO_TICKS(10));
+            continue;
+        }
+        int64_t read_us = esp_timer_get_time();
+        capture_chain.process(frame, FRAME_SAMPLES);
+        attenuate.process(frame, FRAME_SAMPLES);
+        stats.process_us.add((uint32_t)(esp_timer_get_time() - read_us));
+
+        // 按网络包大小切分：一帧可能跨两包，一包也可能由几帧拼成
+        const uint8_t* src = (const uint8_t*)frame;
+        size_t left = sizeof(frame);
+        while (left > 0) {
+            if (packet_fill == 0) {
+                packet_first_us = read_us;
+            }
+            size_t n = PACKET_BYTES - packet_fill < left ? PACKET_BYTES - packet_fill : left;
+            memcpy(packet + packet_fill, src, n);
+            packet_fill += n;
+            src += n;
+            left -= n;
+            if (packet_fill == PACKET_BYTES) {
+                stats.ring_us.add(bytes_to_us(audio->getStreamingBufferedBytes(), sample_rate));
+                stats.hold_us.add((uint32_t)(esp_timer_get_time() - packet_first_us));
+                stats.packets++;
+                if (!audio->addStreamingAudioChunk(packet, PACKET_BYTES)) {
+                    stats.drops++;
+                }
+                packet_fill = 0;
+            }
+        }
+
+        int64_t now = esp_timer_get_time();
+        if (!warm && now - start_us >= (int64_t)WARMUP_MS * 1000) {
+            bsp_i2s_stats_t discard;
+            bsp_i2s_get_stats(&discard, true);
+            stats.reset();
+            warm = true;
+        } else if (warm && now >= next_report_us) {
+            bsp_i2s_stats_t i2s;
+            bsp_i2s_get_stats(&i2s, true);
+            report(stats, i2s, audio);
+            total_drops += stats.drops;
+            total_underruns += i2s.tx_queue_overflows;
+            stats.reset();
+            next_report_us += (int64_t)REPORT_INTERVAL_MS * 1000;
+        }
+    }
+
+    // 最后一段不足一个报告周期的也算进总数
+    bsp_i2s_stats_t i2s;
+    bsp_i2s_get_stats(&i2s, true);
+    if (warm) {
+        total_drops += stats.drops;
+        total_underruns += i2s.tx_queue_overflows;
+    }
+
+    audio->finishStreamingPlayback();
+    int64_t drain_end_us = esp_timer_get_time() + (int64_t)DRAIN_TIMEOUT_MS * 1000;
+    while (audio->isStreamingActive() && esp_timer_get_time() < drain_end_us) {
+        vTaskDelay(pdMS_TO_TICKS(20));
+    }
+
+    bool ok = total_drops == 0 && total_underruns == 0;
+    ESP_LOGI(TAG, "本地回声测试结束：丢包 %lu，播放欠载 %lu%s", (unsigned long)total_drops,
+             (unsigned long)total_underruns, ok ? "" : "（有问题，见上面各级统计）");
+    return ok;
+}
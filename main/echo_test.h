@@ -0,0 +1,40 @@
+/**
+ * @file echo_test.h
+ * @brief 🔁 本地回声测试 - 采集直接送进流式播放，不经过网络测本机音频链路
+ *
+ * 启动时运行（CONFIG_AUDIO_ECHO_TEST）。以前测采集→播放的延迟要靠 loopback_server.py，
+ * 中间隔着WiFi；这里把网络换成一根"直连线"，其余都和正常对话相同：
+ *
+ *   bsp_get_feed_data → 采集处理链 → 按网络包大小攒包 → addStreamingAudioChunk → 环形缓冲区
+ *   → 播放任务按播放块取数 → bsp_play_audio_stream
+ *
+ * 包大小按下行的实际分块配置（WebSocket 1024字节、UDP 20ms 640字节），
+ * 播放块和I2S DMA跟随当前的延迟配置。每隔几秒输出每一级的延迟和缓冲区占用：
+ *
+ * - 采集DMA：读到的最旧样本在DMA里待了多久（bsp_i2s_get_stats）
+ * - 处理：采集处理链每帧耗时
+ * - 攒包：一包的第一帧读到后，等凑满一包才送出的时间
+ * - 环形缓冲区：送入时排在前面的数据时长（先进先出，正是这一包要等的时间）、缓冲区满丢包
+ * - 播放DMA：写入时DMA里排在前面的数据时长，以及播放欠载次数
+ *
+ * 固件没有编解码器（上下行都是 pcm_s16le），链路里没有编码/解码这一级。
+ * 麦克风直接进喇叭会啸叫：输出先衰减（CONFIG_AUDIO_ECHO_TEST_GAIN_PCT），最好戴耳机或把喇叭拿远。
+ */
+
+#ifndef ECHO_TEST_H
+#define ECHO_TEST_H
+
+#include <stdint.h>
+
+class AudioManager;
+
+/**
+ * @brief 运行回声测试并周期性打印各级统计（阻塞 duration_sec 秒）
+ *
+ * @param audio 已初始化的音频管理器（测试期间不能有别的播放和采集）
+ * @param duration_sec 运行时长
+ * @return 全程没有丢包和播放欠载返回 true
+ */
+bool echo_test_run(AudioManager* audio, uint32_t duration_sec);
+
+#endif // ECHO_TEST_H
@@ -0,0 +1,83 @@
+/**
+ * @file endpointer.h
+ * @brief 🛑 端点检测 - 根据逐帧VAD结果判断一轮说话何时结束
+ *
+ * 录音状态下每帧把VAD结果交给 update()：
+ *
+ * - 说话帧：清零静音计数
+ * - 说过话之后的静音帧：累计，达到阈值即说话结束；
+ *   录音长度超过最短要求是 END_OF_TURN（上报服务器），否则是 TOO_SHORT（丢弃重录）
+ * - 还没说话之前的静音帧：不计数（等待用户开口由连续对话超时处理）
+ *
+ * 纯头文件，不依赖ESP-IDF，主机端回归测试也可以直接编译。
+ */
+
+#ifndef ENDPOINTER_H
+#define ENDPOINTER_H
+
+#include <stddef.h>
+
+class Endpointer {
+public:
+    static constexpr int SILENCE_FRAMES_REQUIRED = 20;  // 约600ms静音判断为结束
+    static constexpr int MIN_TURN_MS = 250;             // 更短的录音丢弃
+
+    enum class Event {
+        WAITING,            // 还没检测到说话
+        SPEECH,             // 说话帧
+        TRAILING_SILENCE,   // 说话之后的静音，还没到阈值
+        END_OF_TURN,        // 说话结束，录音有效
+        TOO_SHORT,          // 说话结束，但录音太短
+    };
+
+    /**
+     * @param silence_frames_required 连续多少个静音帧判断为说话结束
+     * @param min_turn_samples 有效录音的最短长度（样本数，不含）
+     */
+    Endpointer(int silence_frames_required, size_t min_turn_samples)
+        : silence_frames_required_(silence_frames_required)
+        , min_turn_samples_(min_turn_samples)
+        , speech_detected_(false)
+        , silence_frames_(0) {}
+
+    /**
+     * @brief 开始新的一段录音时清空状态
+     */
+    void reset() {
+        speech_detected_ = false;
+        silence_frames_ = 0;
+    }
+
+    /**
+     * @brief 处理一帧VAD结果
+     *
+     * @param speech 本帧是否是说话
+     * @param recorded_samples 包含本帧在内已录制的样本数
+     */
+    Event update(bool speech, size_t recorded_samples) {
+        if (speech) {
+            speech_detected_ = true;
+            silence_frames_ = 0;
+            return Event::SPEECH;
+        }
+        if (!speech_detected_) {
+            return Event::WAITING;
+        }
+        silence_frames_++;
+        if (silence_frames_ < silence_frames_required_) {
+            return Event::TRAILING_SILENCE;
+        }
+        return recorded_samples > min_turn_samples_ ? Event::END_OF_TURN : Event::TOO_SHORT;
+    }
+
+    bool speechDetected() const { return speech_detected_; }
+    int silenceFrames() const { return silence_frames_; }
+
+private:
+    int silence_frames_required_;
+    size_t min_turn_samples_;
+    bool speech_detected_;
+    int silence_frames_;
+};
+
+#endif // ENDPOINTER_H
@@ -0,0 +1,192 @@
+/**
+ * @file flash_stress_bench.cc
+ * @brief 📊 flash写入压力测试实现
+ */
+
+#include "flash_stress_bench.h"
+#include "audio_manager.h"
+#include "bsp_board.h"
+#include "deadline_monitor.h"
+#include "flash_write_gate.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "nvs.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "FlashStress";
+
+static constexpr const char* NVS_NAMESPACE = "flash_stress";
+static constexpr const char* NVS_KEY = "blob";
+static constexpr size_t BLOB_SIZE = 1024;               // 每次写1KB，几次提交就会写满一页、触发擦除
+static constexpr uint32_t WRITE_INTERVAL_MS = 20;
+static constexpr uint32_t SETTLE_MS = 300;              // 开始播放后先等DMA填满再清零统计
+static constexpr size_t TONE_PERIOD = 16;               // 16kHz下1kHz正弦，一个周期正好1ms
+static constexpr int16_t TONE_AMPLITUDE = 2000;         // 约-24dBFS，听得见但不吵
+static constexpr uint32_t CHUNK_MS = 20;                // 每次送进环形缓冲区的时长
+static constexpr uint32_t LEAD_MS = 500;                // 送入的数据领先播放进度多久
+
+struct WriterContext {
+    FlashWriteGate* gate;               // nullptr=直接写
+    volatile bool stop;
+    volatile bool done;
+    uint32_t writes;
+    uint32_t deferred;
+    uint32_t max_commit_us;
+};
+
+static void writer_task(void* arg)
+{
+    WriterContext* ctx = static_cast<WriterContext*>(arg);
+    uint8_t* blob = (uint8_t*)malloc(BLOB_SIZE);
+    nvs_handle_t nvs;
+    if (blob == nullptr || nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs) != ESP_OK) {
+        ESP_LOGE(TAG, "写入任务初始化失败");
+        free(blob);
+        ctx->done = true;
+        vTaskDelete(NULL);
+        return;
+    }
+
+    uint32_t seq = 0;
+    while (!ctx->stop) {
+        if (ctx->gate != nullptr && !ctx->gate->waitIdle(WRITE_INTERVAL_MS)) {
+            ctx->deferred++;
+            continue;
+        }
+        // 内容每次都不同，NVS不会因为数据相同而跳过写入
+        seq++;
+        for (size_t i = 0; i < BLOB_SIZE; i += sizeof(seq)) {
+            memcpy(blob + i, &seq, sizeof(seq));
+        }
+        int64_t start_us = esp_timer_get_time();
+        if (nvs_set_blob(nvs, NVS_KEY, blob, BLOB_SIZE) == ESP_OK && nvs_commit(nvs) == ESP_OK) {
+            uint32_t commit_us = (uint32_t)(esp_timer_get_time() - start_us);
+            if (commit_us > ctx->max_commit_us) {
+                ctx->max_commit_us = commit_us;
+            }
+            ctx->writes++;
+        }
+        vTaskDelay(pdMS_TO_TICKS(WRITE_INTERVAL_MS));
+    }
+
+    nvs_erase_key(nvs, NVS_KEY);
+    nvs_commit(nvs);
+    nvs_close(nvs);
+    free(blob);
+    ctx->done = true;
+    vTaskDelete(NULL);
+}
+
+/**
+ * @brief 按播放进度补正弦波，保持领先 LEAD_MS
+ *
+ * 环形缓冲区能装好几秒，一次灌满的话结束时要等很久才播完。
+ *
+ * @param start_us 开始播放的时间
+ * @param fed_ms 已经送进去的时长（累加）
+ */
+static void feed_tone(AudioManager* audio, int64_t start_us, uint32_t* fed_ms)
+{
+    static int16_t chunk[TONE_PERIOD * CHUNK_MS];
+    static bool table_ready = false;
+    if (!table_ready) {
+        for (size_t i = 0; i < sizeof(chunk) / sizeof(chunk[0]); i++) {
+            chunk[i] = (int16_t)(TONE_AMPLITUDE * sinf(2.0f * (float)M_PI * (i % TONE_PERIOD) / TONE_PERIOD));
+        }
+        table_ready = true;
+    }
+    // 整块都是完整周期，块与块之间相位连续
+    uint32_t target_ms = (uint32_t)((esp_timer_get_time() - start_us) / 1000) + LEAD_MS;
+    while (*fed_ms < target_ms && audio->addStreamingAudioChunk((const uint8_t*)chunk, sizeof(chunk))) {
+        *fed_ms += CHUNK_MS;
+    }
+}
+
+/**
+ * @brief 一轮：播放 duration_ms，同时写NVS
+ *
+ * @return 本轮的发送队列溢出（播放欠载）次数
+ */
+static uint32_t run_phase(const char* name, AudioManager* audio, FlashWriteGate* gate,
+                          DeadlineLoop* player_deadline, uint32_t duration_ms)
+{
+    WriterContext ctx = {};
+    ctx.gate = gate;
+
+    if (gate != nullptr) {
+        gate->hold();
+    }
+    audio->startStreamingPlayback();
+    int64_t start_us = esp_timer_get_time();
+    uint32_t fed_ms = 0;
+    feed_tone(audio, start_us, &fed_ms);
+    vTaskDelay(pdMS_TO_TICKS(SETTLE_MS));
+
+    bsp_i2s_stats_t stats;
+    bsp_i2s_get_stats(&stats, true);
+    if (player_deadline != nullptr) {
+        player_deadline->resetStats();
+    }
+
+    // 写入任务优先级高于播放任务，不经过闸门时flash操作抢在播放前面
+    xTaskCreate(writer_task, "flash_stress", 4096, &ctx, 6, NULL);
+    int64_t end_us = esp_timer_get_time() + (int64_t)duration_ms * 1000;
+    while (esp_timer_get_time() < end_us) {
+        feed_tone(audio, start_us, &fed_ms);
+        vTaskDelay(pdMS_TO_TICKS(CHUNK_MS));
+    }
+
+    // 结束前读统计：收尾和停止通道时的空转不算欠载
+    bsp_i2s_get_stats(&stats, true);
+    uint32_t writes_during_playback = ctx.writes;
+    DeadlineLoop::Stats deadline_stats = {};
+    if (player_deadline != nullptr) {
+        deadline_stats = player_deadline->getStats();
+    }
+
+    audio->finishStreamingPlayback();
+    while (audio->isStreamingActive()) {
+        vTaskDelay(pdMS_TO_TICKS(20));
+    }
+    if (gate != nullptr) {
+        gate->release();
+    }
+    // 经过闸门的一轮，推迟的写入在这里放行
+    vTaskDelay(pdMS_TO_TICKS(WRITE_INTERVAL_MS * 5));
+    ctx.stop = true;
+    while (!ctx.done) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+
+    ESP_LOGI(TAG, "%s: 播放 %lu ms，期间NVS写入 %lu 次（最长提交 %lu us），推迟 %lu 次，播放后写入 %lu 次",
+             name, (unsigned long)duration_ms, (unsigned long)writes_during_playback,
+             (unsigned long)ctx.max_commit_us, (unsigned long)ctx.deferred,
+             (unsigned long)(ctx.writes - writes_during_playback));
+    ESP_LOGI(TAG, "%s: 播放欠载 %lu 次，I2S写入 %lu 次（DMA排队 平均 %lu / 最长 %lu us），播放任务超时 %lu / %lu",
+             name, (unsigned long)stats.tx_queue_overflows, (unsigned long)stats.tx_writes,
+             (unsigned long)stats.tx_latency_avg_us, (unsigned long)stats.tx_latency_max_us,
+             (unsigned long)deadline_stats.misses, (unsigned long)deadline_stats.iterations);
+    return stats.tx_queue_overflows;
+}
+
+bool flash_stress_bench_run(AudioManager* audio, FlashWriteGate* gate, DeadlineLoop* player_deadline)
+{
+    const uint32_t duration_ms = CONFIG_AUDIO_FLASH_STRESS_SEC * 1000;
+    ESP_LOGI(TAG, "开始flash写入压力测试：每 %lu ms 写一次 %u 字节NVS",
+             (unsigned long)WRITE_INTERVAL_MS, (unsigned)BLOB_SIZE);
+
+    uint32_t raw_underruns = run_phase("直接写入", audio, nullptr, player_deadline, duration_ms);
+    uint32_t gated_underruns = run_phase("经过闸门", audio, gate, player_deadline, duration_ms);
+
+    bool ok = gated_underruns == 0;
+    if (ok) {
+        ESP_LOGI(TAG, "✅ 经过闸门零欠载（直接写入时 %lu 次）", (unsigned long)raw_underruns);
+    } else {
+        ESP_LOGE(TAG, "❌ 经过闸门仍有 %lu 次欠载", (unsigned long)gated_underruns);
+    }
+    return ok;
+}
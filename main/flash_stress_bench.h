@@ -0,0 +1,30 @@
+/**
+ * @file flash_stress_bench.h
+ * @brief 📊 flash写入压力测试 - 播放期间狂写NVS，统计播放欠载
+ *
+ * 启动时运行（CONFIG_AUDIO_FLASH_STRESS）。流式播放一段低音量的正弦波，
+ * 同时另一个任务不停地写NVS并提交，分两轮：
+ * - 不经过闸门：写入直接进行，flash操作期间播放任务停顿，预期出现欠载
+ * - 经过闸门：播放期间写入被推迟到播放结束（见 flash_write_gate.h），欠载应为0
+ *
+ * 欠载以I2S发送队列溢出计数为准，另外报告播放任务的截止时间超时次数。
+ */
+
+#ifndef FLASH_STRESS_BENCH_H
+#define FLASH_STRESS_BENCH_H
+
+class AudioManager;
+class FlashWriteGate;
+class DeadlineLoop;
+
+/**
+ * @brief 运行压力测试并打印结果（阻塞，约 2*CONFIG_AUDIO_FLASH_STRESS_SEC 秒）
+ *
+ * @param audio 已初始化的音频管理器（测试期间不能有别的播放）
+ * @param gate 实时音频期间挡住flash写入的闸门
+ * @param player_deadline 播放任务的截止时间记账，nullptr=不报告
+ * @return 经过闸门的一轮没有欠载返回 true
+ */
+bool flash_stress_bench_run(AudioManager* audio, FlashWriteGate* gate, DeadlineLoop* player_deadline);
+
+#endif // FLASH_STRESS_BENCH_H
@@ -0,0 +1,63 @@
+/**
+ * @file flash_write_gate.cc
+ * @brief 🚧 flash写入闸门实现
+ */
+
+#include "flash_write_gate.h"
+#include "esp_timer.h"
+
+FlashWriteGate::FlashWriteGate()
+    : events_(xEventGroupCreate())
+    , lock_(xSemaphoreCreateMutex())
+    , holders_(0)
+    , stats_()
+{
+    xEventGroupSetBits(events_, IDLE_BIT);
+}
+
+FlashWriteGate::~FlashWriteGate()
+{
+    vSemaphoreDelete(lock_);
+    vEventGroupDelete(events_);
+}
+
+void FlashWriteGate::hold()
+{
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    if (holders_++ == 0) {
+        xEventGroupClearBits(events_, IDLE_BIT);
+    }
+    xSemaphoreGive(lock_);
+}
+
+void FlashWriteGate::release()
+{
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    if (holders_ > 0 && --holders_ == 0) {
+        xEventGroupSetBits(events_, IDLE_BIT);
+    }
+    xSemaphoreGive(lock_);
+}
+
+bool FlashWriteGate::waitIdle(uint32_t timeout_ms)
+{
+    int64_t start_us = esp_timer_get_time();
+    EventBits_t bits = xEventGroupWaitBits(events_, IDLE_BIT, pdFALSE, pdTRUE, pdMS_TO_TICKS(timeout_ms));
+    uint32_t waited_ms = (uint32_t)((esp_timer_get_time() - start_us) / 1000);
+
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    if ((bits & IDLE_BIT) == 0) {
+        stats_.deferred++;
+    } else {
+        stats_.writes++;
+        if (waited_ms > 0) {
+            stats_.waited++;
+        }
+        if (waited_ms > stats_.max_wait_ms) {
+            stats_.max_wait_ms = waited_ms;
+        }
+    }
+    xSemaphoreGive(lock_);
+
+    return (bits & IDLE_BIT) != 0;
+}
@@ -0,0 +1,65 @@
+/**
+ * @file flash_write_gate.h
+ * @brief 🚧 flash写入闸门 - 实时音频进行中时推迟NVS写入
+ *
+ * 擦写flash（NVS提交、以后的OTA）期间cache被关掉，两个核上的任务都停下来，
+ * 只有放在IRAM里的中断还能跑。I2S的DMA会继续循环，但没有任务补数据：
+ * 擦一个扇区要几十到几百毫秒，远超DMA里缓冲的音频，播放欠载、采集溢出。
+ * 把任务代码挪进IRAM解决不了这个问题，能做的是别在说话和播放的时候写flash：
+ *
+ * - 实时音频开始时 hold()，结束时 release()（可以多方同时持有）
+ * - 写flash之前 waitIdle()：没有持有者时立即返回，否则等到释放或超时
+ * - 超时的写入由调用者决定推迟还是放弃，统计里记一笔
+ */
+
+#ifndef FLASH_WRITE_GATE_H
+#define FLASH_WRITE_GATE_H
+
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/event_groups.h"
+#include "freertos/semphr.h"
+
+class FlashWriteGate {
+public:
+    struct Stats {
+        uint32_t writes;            // 放行的写入次数
+        uint32_t waited;            // 需要等待才放行的次数
+        uint32_t deferred;          // 等待超时、被推迟的次数
+        uint32_t max_wait_ms;       // 最长等待时间
+    };
+
+    FlashWriteGate();
+    ~FlashWriteGate();
+
+    /**
+     * @brief 实时音频开始，阻止flash写入
+     */
+    void hold();
+
+    /**
+     * @brief 实时音频结束
+     */
+    void release();
+
+    /**
+     * @brief 等待没有实时音频，准备写flash
+     *
+     * @param timeout_ms 最多等多久，0=不等
+     * @return true=可以写，false=超时（调用者应推迟写入）
+     */
+    bool waitIdle(uint32_t timeout_ms);
+
+    bool isHeld() const { return holders_ > 0; }
+    Stats getStats() const { return stats_; }
+
+private:
+    static constexpr EventBits_t IDLE_BIT = BIT0;
+
+    EventGroupHandle_t events_;
+    SemaphoreHandle_t lock_;            // 事件组操作不能放在临界区里，用互斥锁
+    int holders_;
+    Stats stats_;
+};
+
+#endif // FLASH_WRITE_GATE_H
@@ -0,0 +1,124 @@
+/**
+ * @file hello_handshake.cc
+ * @brief 🤝 连接握手实现
+ */
+
+#include "hello_handshake.h"
+#include "esp_log.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+static const char *TAG = "Hello";
+
+// 特性位与协议中的名字一一对应
+static const struct {
+    HelloHandshake::Feature bit;
+    const char* name;
+} FEATURE_NAMES[] = {
+    { HelloHandshake::FEATURE_UDP_AUDIO, "udp_audio" },
+    { HelloHandshake::FEATURE_HEARTBEAT_RTT, "heartbeat_rtt" },
+};
+
+HelloHandshake::HelloHandshake(const Capabilities& caps)
+    : caps_(caps) {
+    begin();
+}
+
+std::string HelloHandshake::begin() {
+    // 未协商前按旧协议：16kHz、不限制帧大小、不启用任何可选特性
+    config_.negotiated = false;
+    config_.version = 0;
+    config_.sample_rate_up = caps_.sample_rate;
+    config_.sample_rate_down = caps_.sample_rate;
+    config_.max_frame = caps_.max_frame;
+    config_.features = 0;
+
+    std::string features;
+    for (const auto& f : FEATURE_NAMES) {
+        if (caps_.features & f.bit) {
+            if (!features.empty()) {
+                features += ",";
+            }
+            features += "\"";
+            features += f.name;
+            features += "\"";
+        }
+    }
+
+    char msg[320];
+    snprintf(msg, sizeof(msg),
+             "{\"event\":\"hello\",\"version\":%d,\"codecs\":[\"pcm_s16le\"],\"sample_rates\":[%lu],"
+             "\"channels\":1,\"ring_bytes\":%lu,\"max_frame\":%lu,\"features\":[%s]}",
+             PROTOCOL_VERSION, (unsigned long)caps_.sample_rate, (unsigned long)caps_.ring_bytes,
+             (unsigned long)caps_.max_frame, features.c_str());
+    return msg;
+}
+
+bool HelloHandshake::handleAck(const char* json) {
+    int version = (int)parseNumber(json, "\"version\":", 0);
+    if (version < 1) {
+        ESP_LOGW(TAG, "hello_ack缺少版本号，按旧协议工作");
+        return false;
+    }
+
+    const char* codec = strstr(json, "\"codec\":\"");
+    if (codec != nullptr && strncmp(codec + strlen("\"codec\":\""), "pcm_s16le\"", 10) != 0) {
+        ESP_LOGW(TAG, "服务器选择了不支持的编码，按旧协议工作");
+        return false;
+    }
+
+    uint32_t rate_up = parseNumber(json, "\"sample_rate_up\":", caps_.sample_rate);
+    uint32_t rate_down = parseNumber(json, "\"sample_rate_down\":", caps_.sample_rate);
+    if (rate_up != caps_.sample_rate || rate_down != caps_.sample_rate) {
+        ESP_LOGW(TAG, "服务器选择了不支持的采样率 %lu/%lu，按旧协议工作",
+                 (unsigned long)rate_up, (unsigned long)rate_down);
+        return false;
+    }
+
+    uint32_t max_frame = parseNumber(json, "\"max_frame\":", caps_.max_frame);
+
+    config_.negotiated = true;
+    config_.version = version;
+    config_.sample_rate_up = rate_up;
+    config_.sample_rate_down = rate_down;
+    config_.max_frame = (max_frame > 0 && max_frame < caps_.max_frame) ? max_frame : caps_.max_frame;
+    // 服务器只能启用设备声明过的特性
+    config_.features = parseFeatures(json) & caps_.features;
+
+    ESP_LOGI(TAG, "握手完成: 协议v%d, %lu Hz, 单帧上限 %lu 字节, 特性 0x%02lx",
+             config_.version, (unsigned long)config_.sample_rate_down,
+             (unsigned long)config_.max_frame, (unsigned long)config_.features);
+    return true;
+}
+
+uint32_t HelloHandshake::parseFeatures(const char* json) {
+    const char* start = strstr(json, "\"features\":[");
+    if (start == nullptr) {
+        return 0;
+    }
+    start += strlen("\"features\":[");
+    const char* end = strchr(start, ']');
+    if (end == nullptr) {
+        return 0;
+    }
+
+    std::string list(start, end - start);
+    uint32_t features = 0;
+    for (const auto& f : FEATURE_NAMES) {
+        std::string quoted = std::string("\"") + f.name + "\"";
+        if (list.find(quoted) != std::string::npos) {
+            features |= f.bit;
+        }
+    }
+    return features;
+}
+
+uint32_t HelloHandshake::parseNumber(const char* json, const char* key, uint32_t fallback) {
+    const char* field = strstr(json, key);
+    if (field == nullptr) {
+        return fallback;
+    }
+    long value = atol(field + strlen(key));
+    return value > 0 ? (uint32_t)value : fallback;
+}
@@ -0,0 +1,114 @@
+/**
+ * @file hello_handshake.h
+ * @brief 🤝 连接握手 - 设备与服务器的能力协商
+ *
+ * 连接建立后设备先发 hello，声明自己支持的编码、采样率、播放缓冲区容量、
+ * 单帧上限和可选特性；服务器回 hello_ack，给出本次连接实际采用的配置。
+ *
+ * 设备 -> 服务器：
+ *   {"event":"hello","version":1,"codecs":["pcm_s16le"],"sample_rates":[16000],
+ *    "channels":1,"ring_bytes":204800,"max_frame":8192,
+ *    "features":["udp_audio","heartbeat_rtt"]}
+ *
+ * 服务器 -> 设备：
+ *   {"event":"hello_ack","version":1,"codec":"pcm_s16le","sample_rate_up":16000,
+ *    "sample_rate_down":16000,"max_frame":3200,"features":["heartbeat_rtt"]}
+ *
+ * 协商出的 max_frame 对两个方向都生效：设备上行的二进制数据按它拆帧，
+ * 超过它的文本消息不发送（见 WebSocketClient::setMaxSendFrame）。
+ *
+ * 不认识 hello 的旧服务器不会应答，此时按旧协议工作（legacy配置），
+ * 所有可选特性保持关闭，因此新设备仍能连接旧服务器。
+ *
+ * 一段回复的结束统一用 response_finished 事件表示（不再使用ping帧），
+ * ping/pong只用于心跳保活。
+ */
+
+#ifndef HELLO_HANDSHAKE_H
+#define HELLO_HANDSHAKE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+
+class HelloHandshake {
+public:
+    static constexpr int PROTOCOL_VERSION = 1;
+
+    /**
+     * @brief 可选特性（按位组合）
+     */
+    enum Feature : uint32_t {
+        FEATURE_UDP_AUDIO     = 1u << 0,    // UDP音频通道（见 udp_audio.h）
+        FEATURE_HEARTBEAT_RTT = 1u << 1,    // 心跳ping携带时间戳，服务器原样回送
+    };
+
+    /**
+     * @brief 设备能力
+     */
+    struct Capabilities {
+        uint32_t sample_rate;   // 支持的采样率（上下行相同）
+        uint32_t ring_bytes;    // 播放环形缓冲区容量
+        uint32_t max_frame;     // 单个WebSocket帧的最大负载
+        uint32_t features;      // 支持的可选特性
+    };
+
+    /**
+     * @brief 本次连接协商出的配置
+     */
+    struct SessionConfig {
+        bool negotiated;        // false=服务器没有应答hello，按旧协议工作
+        int version;            // 服务器选用的协议版本
+        uint32_t sample_rate_up;
+        uint32_t sample_rate_down;
+        uint32_t max_frame;     // 单帧负载上限：服务器下行、设备上行都不超过此值
+        uint32_t features;      // 双方都启用的特性
+    };
+
+    explicit HelloHandshake(const Capabilities& caps);
+
+    /**
+     * @brief 开始一次新的握手（每次连接成功后调用）
+     *
+     * 配置重置为legacy，直到收到有效的 hello_ack。
+     *
+     * @return 要发送给服务器的 hello 消息
+     */
+    std::string begin();
+
+    /**
+     * @brief 处理服务器的 hello_ack
+     *
+     * 服务器选择了设备不支持的编码或采样率时拒绝应答，保持legacy配置。
+     *
+     * @param json hello_ack 消息（以'\0'结尾）
+     * @return true=协商成功
+     */
+    bool handleAck(const char* json);
+
+    /**
+     * @brief 当前连接的配置
+     */
+    const SessionConfig& config() const { return config_; }
+
+    /**
+     * @brief 某个特性在本次连接中是否启用
+     */
+    bool enabled(Feature feature) const { return (config_.features & feature) != 0; }
+
+    /**
+     * @brief 修改声明的播放缓冲区容量（缓冲区重新分配后调用），下一次 begin() 生效
+     */
+    void setRingBytes(uint32_t ring_bytes) { caps_.ring_bytes = ring_bytes; }
+
+private:
+    // 在 "features":[...] 中查找特性名，返回特性位组合
+    static uint32_t parseFeatures(const char* json);
+    // 读取数值字段，没有该字段时返回 fallback
+    static uint32_t parseNumber(const char* json, const char* key, uint32_t fallback);
+
+    Capabilities caps_;
+    SessionConfig config_;
+};
+
+#endif // HELLO_HANDSHAKE_H
@@ -0,0 +1,241 @@
+/**
+ * @file latency_probe.h
+ * @brief 📏 扬声器→麦克风回环延迟估计 - 播放MLS序列，互相关找到它在采集里出现的位置
+ *
+ * 测的是整条链路：bsp_play_audio_stream → I2S发送DMA → 功放 → 空气 → 麦克风 → I2S接收DMA →
+ * bsp_get_feed_data。回声消除的参考信号对齐、播放排空等待、打断判断都依赖这个数。
+ *
+ * 播放和采集是两个独立的流，只能通过时间戳对上：
+ *
+ * - 参考时刻：激励的第一个样本交给 bsp_play_audio_stream 的时刻（与播放任务给回声消除送参考信号的时刻相同）
+ * - 采集时间轴：每次读完记下时间戳和累计样本数。读取只会比数据到达晚、不会早，
+ *   所以取所有读取里"时间戳 - 样本数 × 采样周期"的最小值作为采集时间轴的零点，调度延迟不影响结果
+ *
+ * 参考时刻换算成采集样本序号后，在其后 MAX_DELAY_MS 以内逐个延迟做互相关，峰值位置就是延迟，
+ * 峰值两侧做抛物线插值得到小数样本。激励是 ±AMPLITUDE 的最大长度序列（2047点，约128ms）：
+ * 自相关只有一个尖峰，互相关只需加减，2047点的处理增益约33dB，背景噪声下也能测。
+ * 扬声器反相接线时峰值为负，按绝对值找峰并报告极性。
+ *
+ * 纯头文件，不依赖ESP-IDF，主机仿真（tools/latency_sim）直接编译同一份估计代码。
+ */
+
+#ifndef LATENCY_PROBE_H
+#define LATENCY_PROBE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+
+class LatencyProbe {
+public:
+    static constexpr uint32_t SAMPLE_RATE = 16000;
+    static constexpr int MLS_ORDER = 11;
+    static constexpr size_t MLS_LENGTH = (1u << MLS_ORDER) - 1;        // 2047
+    static constexpr int16_t AMPLITUDE = 8000;                          // 约-12dBFS
+    static constexpr uint32_t MAX_DELAY_MS = 250;
+    static constexpr size_t MAX_DELAY_SAMPLES = SAMPLE_RATE * MAX_DELAY_MS / 1000;
+    static constexpr float MIN_CONFIDENCE_DB = 18.0f;                   // 峰值高出其他延迟的RMS多少才算测到（纯噪声的最大值约12dB）
+    static constexpr int32_t MAX_SPREAD_US = 250;                       // 多次测量结果差距超过这个不采信
+    static constexpr size_t MAX_RUNS = 8;                               // combine() 最多合并的次数
+
+    struct Result {
+        bool valid;                 // 找到了足够突出的峰
+        int32_t delay_us;           // 回环延迟
+        float delay_samples;        // 同上，以样本计（含小数）
+        float confidence_db;        // 峰值相对其他延迟互相关RMS的高度
+        bool inverted;              // 峰值为负（扬声器反相）
+    };
+
+    LatencyProbe() {
+        // Fibonacci LFSR，x^11 + x^9 + 1
+        uint32_t state = 1;
+        for (size_t i = 0; i < MLS_LENGTH; i++) {
+            seq_[i] = (state & 1) ? 1 : -1;
+            uint32_t bit = ((state >> 0) ^ (state >> 2)) & 1;
+            state = (state >> 1) | (bit << (MLS_ORDER - 1));
+        }
+        begin(nullptr, 0);
+    }
+
+    /**
+     * @brief 开始一次测量
+     *
+     * @param buffer 采集缓冲区，至少装得下从开始采集到激励播完再加 MAX_DELAY_MS
+     * @param capacity 缓冲区样本数，装满后的数据丢弃
+     */
+    void begin(int16_t* buffer, size_t capacity) {
+        buffer_ = buffer;
+        capacity_ = capacity;
+        captured_ = 0;
+        total_ = 0;
+        anchor_valid_ = false;
+        anchor_us_ = 0;
+        ref_valid_ = false;
+        ref_us_ = 0;
+    }
+
+    /**
+     * @brief 取激励从 offset 开始的 n 个样本（offset 超出序列长度的部分填0）
+     */
+    void stimulus(size_t offset, int16_t* out, size_t n) const {
+        for (size_t i = 0; i < n; i++) {
+            size_t k = offset + i;
+            out[i] = k < MLS_LENGTH ? (int16_t)(seq_[k] * AMPLITUDE) : 0;
+        }
+    }
+
+    /**
+     * @brief 记录激励第一个样本交给播放的时刻
+     */
+    void markReference(int64_t us) {
+        ref_us_ = us;
+        ref_valid_ = true;
+    }
+
+    /**
+     * @brief 追加一次读取的采集数据
+     *
+     * @param end_us 读取返回的时刻
+     */
+    void addCapture(const int16_t* samples, size_t n, int64_t end_us) {
+        for (size_t i = 0; i < n && captured_ < capacity_; i++) {
+            buffer_[captured_++] = samples[i];
+        }
+        total_ += n;
+        int64_t zero_us = end_us - (int64_t)(total_ * 1000000 / SAMPLE_RATE);
+        if (!anchor_valid_ || zero_us < anchor_us_) {
+            anchor_us_ = zero_us;
+            anchor_valid_ = true;
+        }
+    }
+
+    /**
+     * @brief 采集够了没有：参考时刻之后已经录了激励长度加最大延迟
+     */
+    bool complete() const {
+        long ref = refIndex();
+        return ref >= 0 && captured_ >= (size_t)ref + MLS_LENGTH + MAX_DELAY_SAMPLES + 1;
+    }
+
+    /**
+     * @brief 估计延迟（一次遍历 MAX_DELAY_SAMPLES × MLS_LENGTH 次加减）
+     */
+    Result estimate() const {
+        Result r = {};
+        long ref = refIndex();
+        if (ref < 0 || captured_ < (size_t)ref + MLS_LENGTH + 3) {
+            return r;
+        }
+        size_t lags = captured_ - (size_t)ref - MLS_LENGTH + 1;
+        lags = lags > MAX_DELAY_SAMPLES + 1 ? MAX_DELAY_SAMPLES + 1 : lags;
+
+        // 第一遍：找峰值，同时累计平方和
+        const int16_t* x = buffer_ + ref;
+        size_t best = 0;
+        int64_t best_abs = -1;
+        double sum_sq = 0;
+        for (size_t lag = 0; lag < lags; lag++) {
+            int64_t c = correlate(x + lag);
+            int64_t a = c < 0 ? -c : c;
+            sum_sq += (double)c * c;
+            if (a > best_abs) {
+                best_abs = a;
+                best = lag;
+            }
+        }
+
+        // 其他延迟的RMS：去掉峰值附近（主瓣和插值用到的邻点）
+        double near_sq = 0;
+        size_t near = 0;
+        for (size_t lag = best >= EXCLUDE ? best - EXCLUDE : 0; lag < lags && lag <= best + EXCLUDE; lag++) {
+            int64_t c = correlate(x + lag);
+            near_sq += (double)c * c;
+            near++;
+        }
+        double noise = lags > near ? sqrt((sum_sq - near_sq) / (lags - near)) : 0;
+        r.confidence_db = noise > 0 ? (float)(20.0 * log10((double)best_abs / noise)) : 99.0f;
+
+        // 抛物线插值（两端的峰不插值）
+        int64_t peak = correlate(x + best);
+        r.inverted = peak < 0;
+        float frac = 0;
+        if (best > 0 && best + 1 < lags) {
+            double y0 = (double)correlate(x + best - 1) * (r.inverted ? -1 : 1);
+            double y1 = (double)best_abs;
+            double y2 = (double)correlate(x + best + 1) * (r.inverted ? -1 : 1);
+            double den = y0 - 2 * y1 + y2;
+            if (den < 0) {
+                frac = (float)(0.5 * (y0 - y2) / den);
+            }
+        }
+        // 峰值的采集时刻减参考时刻；参考时刻落在两个样本之间的小数部分也扣掉
+        double peak_us = (double)anchor_us_ + ((double)ref + best + frac) * 1e6 / SAMPLE_RATE;
+        r.delay_us = (int32_t)lround(peak_us - (double)ref_us_);
+        r.delay_samples = (float)(r.delay_us * (double)SAMPLE_RATE / 1e6);
+        r.valid = r.confidence_db >= MIN_CONFIDENCE_DB;
+        return r;
+    }
+
+    /**
+     * @brief 合并多次测量：取有效结果的中位数，有效结果不到一半或彼此差距太大则无效
+     */
+    static Result combine(const Result* results, size_t n) {
+        Result valid[MAX_RUNS];
+        size_t count = 0;
+        for (size_t i = 0; i < n && count < MAX_RUNS; i++) {
+            if (results[i].valid) {
+                valid[count++] = results[i];
+            }
+        }
+        Result r = {};
+        if (count == 0 || count * 2 < n) {
+            return r;
+        }
+        // 插入排序，最多 MAX_RUNS 个
+        for (size_t i = 1; i < count; i++) {
+            for (size_t j = i; j > 0 && valid[j].delay_us < valid[j - 1].delay_us; j--) {
+                Result t = valid[j];
+                valid[j] = valid[j - 1];
+                valid[j - 1] = t;
+            }
+        }
+        r = valid[count / 2];
+        r.valid = valid[count - 1].delay_us - valid[0].delay_us <= MAX_SPREAD_US;
+        return r;
+    }
+
+    size_t captured() const { return captured_; }
+
+    /**
+     * @brief 参考时刻对应的采集样本序号，-1=还不知道
+     */
+    long refIndex() const {
+        if (!ref_valid_ || !anchor_valid_ || ref_us_ < anchor_us_) {
+            return -1;
+        }
+        return (long)((ref_us_ - anchor_us_) * SAMPLE_RATE / 1000000);
+    }
+
+private:
+    static constexpr size_t EXCLUDE = 8;        // 峰值两侧各8个样本（0.5ms）不计入背景
+
+    int64_t correlate(const int16_t* x) const {
+        int32_t acc = 0;        // 2047 × 32768 不会溢出
+        for (size_t i = 0; i < MLS_LENGTH; i++) {
+            acc += seq_[i] > 0 ? x[i] : -x[i];
+        }
+        return acc;
+    }
+
+    int8_t seq_[MLS_LENGTH];
+    int16_t* buffer_;
+    size_t capacity_;
+    size_t captured_;
+    uint64_t total_;
+    bool anchor_valid_;
+    int64_t anchor_us_;
+    bool ref_valid_;
+    int64_t ref_us_;
+};
+
+#endif // LATENCY_PROBE_H
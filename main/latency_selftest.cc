@@ -0,0 +1,169 @@
+/**
+ * @file latency_selftest.cc
+ * @brief 📏 扬声器→麦克风回环延迟自检实现
+ */
+
+#include "latency_selftest.h"
+#include "bsp_board.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "nvs.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <string.h>
+
+static const char *TAG = "LatencyTest";
+
+static constexpr const char* NVS_NAMESPACE = "latency";
+static constexpr const char* NVS_KEY = "loop_us";
+static constexpr int RUNS = 3;
+static constexpr size_t READ_SAMPLES = 512;             // 与主程序的采集帧相同
+static constexpr size_t CHUNK_SAMPLES = 160;            // 每次写I2S 10ms
+static constexpr uint32_t PREROLL_MS = 200;             // 先播静音把发送DMA填满，测的是持续播放时的延迟
+static constexpr uint32_t TAIL_MS = 100;                // 激励之后再播这么久静音，最大延迟之外的余量
+static constexpr uint32_t GAP_MS = 300;                 // 两次测量之间等房间混响散掉
+static constexpr size_t CAPTURE_SAMPLES = LatencyProbe::SAMPLE_RATE *
+    (PREROLL_MS + LatencyProbe::MAX_DELAY_MS + TAIL_MS + 200) / 1000 + LatencyProbe::MLS_LENGTH;
+
+struct CaptureContext {
+    LatencyProbe* probe;
+    volatile bool stop;
+    volatile bool done;
+};
+
+static void capture_task(void* arg)
+{
+    CaptureContext* ctx = static_cast<CaptureContext*>(arg);
+    static int16_t read_buf[READ_SAMPLES];
+    while (!ctx->stop) {
+        if (bsp_get_feed_data(false, read_buf, sizeof(read_buf)) != ESP_OK) {
+            break;
+        }
+        ctx->probe->addCapture(read_buf, READ_SAMPLES, esp_timer_get_time());
+    }
+    ctx->done = true;
+    vTaskDelete(NULL);
+}
+
+static esp_err_t play_silence(uint32_t ms)
+{
+    static const int16_t silence[CHUNK_SAMPLES] = {};
+    for (uint32_t played = 0; played < ms; played += CHUNK_SAMPLES * 1000 / LatencyProbe::SAMPLE_RATE) {
+        esp_err_t ret = bsp_play_audio_stream((const uint8_t*)silence, sizeof(silence));
+        if (ret != ESP_OK) {
+            return ret;
+        }
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief 一次测量：静音 → 激励 → 静音，同时采集
+ */
+static LatencyProbe::Result measure_once(LatencyProbe* probe, int16_t* buffer)
+{
+    LatencyProbe::Result r = {};
+    probe->begin(buffer, CAPTURE_SAMPLES);
+
+    // 采集任务优先级高于当前任务：读取返回得越及时，采集时间轴越准
+    CaptureContext ctx = {};
+    ctx.probe = probe;
+    if (xTaskCreate(capture_task, "latency_cap", 4096, &ctx, 7, NULL) != pdPASS) {
+        ESP_LOGE(TAG, "采集任务创建失败");
+        return r;
+    }
+
+    static int16_t chunk[CHUNK_SAMPLES];
+    esp_err_t ret = play_silence(PREROLL_MS);
+    // 参考时刻：上一块写完、激励的第一块开始写（发送DMA满时写入阻塞，这一刻正好腾出空间）
+    probe->markReference(esp_timer_get_time());
+    for (size_t offset = 0; ret == ESP_OK && offset < LatencyProbe::MLS_LENGTH; offset += CHUNK_SAMPLES) {
+        probe->stimulus(offset, chunk, CHUNK_SAMPLES);
+        ret = bsp_play_audio_stream((const uint8_t*)chunk, sizeof(chunk));
+    }
+    if (ret == ESP_OK) {
+        ret = play_silence(LatencyProbe::MAX_DELAY_MS + TAIL_MS);
+    }
+
+    ctx.stop = true;
+    while (!ctx.done) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+    bsp_audio_stop();
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "播放失败: %s", esp_err_to_name(ret));
+        return r;
+    }
+    if (!probe->complete()) {
+        ESP_LOGW(TAG, "采集不完整: %zu 样本", probe->captured());
+        return r;
+    }
+
+    int64_t start_us = esp_timer_get_time();
+    r = probe->estimate();
+    ESP_LOGI(TAG, "延迟 %.2f ms（%.1f 样本），置信 %.1f dB%s%s，估计耗时 %lu ms",
+             r.delay_us / 1000.0, r.delay_samples, r.confidence_db,
+             r.inverted ? "，扬声器反相" : "", r.valid ? "" : "（无效）",
+             (unsigned long)((esp_timer_get_time() - start_us) / 1000));
+    return r;
+}
+
+esp_err_t latency_selftest_run(LatencyProbe::Result* result)
+{
+    memset(result, 0, sizeof(*result));
+    int16_t* buffer = (int16_t*)heap_caps_malloc(CAPTURE_SAMPLES * sizeof(int16_t),
+                                                 MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (buffer == nullptr) {
+        buffer = (int16_t*)heap_caps_malloc(CAPTURE_SAMPLES * sizeof(int16_t), MALLOC_CAP_8BIT);
+    }
+    // 序列表2KB，不放在任务栈上
+    LatencyProbe* probe = new LatencyProbe();
+    if (buffer == nullptr || probe == nullptr) {
+        ESP_LOGE(TAG, "缓冲区分配失败");
+        heap_caps_free(buffer);
+        delete probe;
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(TAG, "开始测量扬声器→麦克风回环延迟（%d 次）", RUNS);
+    LatencyProbe::Result runs[RUNS];
+    for (int i = 0; i < RUNS; i++) {
+        runs[i] = measure_once(probe, buffer);
+        vTaskDelay(pdMS_TO_TICKS(GAP_MS));
+    }
+    heap_caps_free(buffer);
+    delete probe;
+
+    *result = LatencyProbe::combine(runs, RUNS);
+    if (!result->valid) {
+        ESP_LOGW(TAG, "没有测到可信的回环延迟（扬声器没响、环境太吵或几次结果不一致）");
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    nvs_handle_t nvs;
+    esp_err_t ret = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (ret == ESP_OK) {
+        ret = nvs_set_u32(nvs, NVS_KEY, (uint32_t)result->delay_us);
+        if (ret == ESP_OK) {
+            ret = nvs_commit(nvs);
+        }
+        nvs_close(nvs);
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "保存回环延迟失败: %s", esp_err_to_name(ret));
+    }
+    ESP_LOGI(TAG, "回环延迟 %.2f ms（%d 次中位数），已保存", result->delay_us / 1000.0, RUNS);
+    return ESP_OK;
+}
+
+esp_err_t latency_selftest_load(uint32_t* delay_us)
+{
+    nvs_handle_t nvs;
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &nvs) != ESP_OK) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    esp_err_t ret = nvs_get_u32(nvs, NVS_KEY, delay_us);
+    nvs_close(nvs);
+    return ret == ESP_OK ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
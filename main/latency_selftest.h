@@ -0,0 +1,36 @@
+/**
+ * @file latency_selftest.h
+ * @brief 📏 扬声器→麦克风回环延迟自检 - 播放MLS序列测延迟，结果存NVS供回声消除对齐
+ *
+ * 启动时运行（CONFIG_AUDIO_LATENCY_SELFTEST）。直接通过 bsp_play_audio_stream 播放，
+ * 另一个任务同时用 bsp_get_feed_data 采集，测量方法见 latency_probe.h。
+ * 测 RUNS 次取中位数，结果有效才写入NVS；NVS里已经有结果时默认不再测。
+ *
+ * 会发出三声约0.13秒的噪声（约-12dBFS），测量期间不能有别的播放和采集。
+ */
+
+#ifndef LATENCY_SELFTEST_H
+#define LATENCY_SELFTEST_H
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "latency_probe.h"
+
+/**
+ * @brief 测量回环延迟，有效时写入NVS（阻塞，约2秒）
+ *
+ * @param result 合并后的结果（无效时 valid=false）
+ * @return ESP_OK=测到有效结果，ESP_ERR_NOT_FOUND=没有测到（扬声器没响、太吵或几次结果不一致），
+ *         ESP_ERR_NO_MEM=缓冲区分配失败
+ */
+esp_err_t latency_selftest_run(LatencyProbe::Result* result);
+
+/**
+ * @brief 读取NVS里保存的回环延迟
+ *
+ * @param delay_us 延迟（微秒）
+ * @return ESP_OK=有保存的结果，ESP_ERR_NOT_FOUND=还没测过
+ */
+esp_err_t latency_selftest_load(uint32_t* delay_us);
+
+#endif // LATENCY_SELFTEST_H
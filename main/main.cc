@@ -18,6 +18,7 @@ extern "C"
 #include "freertos/task.h"
 #include "freertos/stream_buffer.h" // 流缓冲区
 #include "freertos/event_groups.h"  // 事件组
+#include "freertos/semphr.h"        // 信号量
 // #include "mbedtls/base64.h"      // 未使用，已注释
 #include "esp_timer.h"              // ESP定时器，用于获取时间戳
 #include "esp_wn_iface.h"           // 唤醒词检测接口
@@ -29,10 +30,10 @@ extern "C"
 #include "model_path.h"             // 模型路径定义
 #include "bsp_board.h"              // 板级支持包，INMP441麦克风驱动
 #include "esp_log.h"                // ESP日志系统
+#if !CONFIG_AUDIO_PROMPT_STORE
 #include "mock_voices/hi.h"         // 欢迎音频数据文件
-#include "mock_voices/ok.h"         // 确认音频数据文件
 #include "mock_voices/bye.h"        // 再见音频数据文件
-#include "mock_voices/custom.h"     // 自定义音频数据文件
+#endif
 #include "driver/gpio.h"            // GPIO驱动
 #include "nvs_flash.h"              // NVS存储
 }
@@ -40,15 +41,45 @@ extern "C"
 #include "audio_manager.h"          // 音频管理器
 #include "wifi_manager.h"           // WiFi管理器
 #include "websocket_client.h"        // WebSocket客户端
+#include "server_selector.h"         // 服务器选择与故障切换
+#include "udp_audio.h"               // UDP音频通道
+#include "hello_handshake.h"         // 连接握手（能力协商）
+#include "server_event.h"            // 服务器事件识别
+#include "endpointer.h"              // 端点检测（说话结束判断）
+#include "uplink_quality.h"          // 上行音频质量统计
+#include "sampling_profiler.h"       // 采样分析器
+#include "deadline_monitor.h"        // 实时循环截止时间监控
+#include "flash_write_gate.h"        // 实时音频期间推迟flash写入
+#include "ws_transport_bench.h"      // WebSocket传输基准测试
+#include "async_copy_bench.h"        // 异步拷贝基准测试
+#include "audio_frame_pool.h"        // 音频帧池
+#include "audio_frame_pool_bench.h"  // 帧池基准测试
+#include "sample_format_bench.h"     // 采样格式转换基准测试
+#include "capture_chain.h"           // 采集处理链
+#include "dsp_pipeline_bench.h"      // DSP处理链基准测试
+#include "flash_stress_bench.h"      // flash写入压力测试
+#include "latency_selftest.h"        // 扬声器→麦克风回环延迟自检
+#include "echo_test.h"               // 本地回声测试（不经过网络）
+#include "model_manager.h"           // 语音模型生命周期管理
+#include "memory_governor.h"         // 内存压力下逐级关掉可选功能
+#include "model_store.h"             // flash映射的模型仓库（提示音）
 
 static const char *TAG = "语音识别"; // 日志标签
 
-// WebSocket服务器配置
-#define WS_URI "ws://139.196.221.55:8888/ws/esp32" // 请改为您的电脑IP地址:8888
+// WebSocket服务器配置：候选节点列表见 menuconfig → Voice Server Configuration
+// （可通过服务器下发 set_servers 事件修改，保存在NVS中）
 
 // WiFi和WebSocket管理器
 static WiFiManager* wifi_manager = nullptr;
 static WebSocketClient* websocket_client = nullptr;
+static ServerSelector* server_selector = nullptr;
+static UdpAudioChannel* udp_audio = nullptr;   // 可选的UDP音频通道（未启用时为空）
+static HelloHandshake* hello = nullptr;         // 连接握手，记录本次连接协商出的配置
+#define UDP_DRAIN_TIMEOUT_MS 300                // 结束信号后等待最后一个UDP包的时间
+
+#if CONFIG_AUDIO_PROFILER
+static SamplingProfiler* profiler = nullptr;    // 采样分析器，由服务器 profile 事件控制
+#endif
 
 // --- 3. 核心状态机 ---
 typedef enum
@@ -65,12 +96,22 @@ static system_state_t current_state = STATE_WAITING_WAKEUP;
 // static TickType_t command_timeout_start = 0; // 未使用
 static const TickType_t COMMAND_TIMEOUT_MS = 5000; // 5秒超时
 
-// VAD（语音活动检测）相关变量
-static vad_handle_t vad_inst = NULL;
-
-// NS（噪音抑制）相关变量  
-static esp_nsn_iface_t *nsn_handle = NULL;
-static esp_nsn_data_t *nsn_model_data = NULL;
+// 语音模型（唤醒词、VAD、降噪、命令词）：按状态懒加载，内存紧张时卸载
+static ModelManager* model_manager = nullptr;
+static uint32_t required_models = 0;    // 上一次 require() 的模型集合
+static SemaphoreHandle_t models_ready = nullptr;    // 启动时后台加载初始模型，完成后释放
+static int64_t model_load_us = 0;                   // 后台加载本身的耗时（串行加载时会全部加到启动时间上）
+#if CONFIG_AUDIO_NOISE_SUPPRESSION
+static bool ns_enabled = true;
+#else
+static bool ns_enabled = false;
+#endif
+
+// 内存调控器：内存紧张时逐级卸载缓存的模型、关掉降噪、缩小播放缓冲区（见 memory_governor.h）
+#if CONFIG_AUDIO_MEM_GOVERNOR
+static MemoryGovernor* mem_governor = nullptr;
+static bool ns_shed = false;            // 降噪是被调控器关掉的，恢复时重新打开
+#endif
 
 // 音频参数
 #define SAMPLE_RATE 16000 // 采样率 16kHz
@@ -78,10 +119,57 @@ static esp_nsn_data_t *nsn_model_data = NULL;
 // 音频管理器
 static AudioManager* audio_manager = nullptr;
 
-// VAD（语音活动检测）相关变量
-static bool vad_speech_detected = false;
-static int vad_silence_frames = 0;
-static const int VAD_SILENCE_FRAMES_REQUIRED = 20; // 约600ms静音判断为结束
+// 采集帧池：麦克风帧放在内部DMA内存，按cache行对齐
+// 录音历史 + 当前帧 + 噪音抑制输出，留一点余量
+static AudioFramePool* capture_pool = nullptr;
+#define CAPTURE_POOL_FRAMES (AudioManager::RECORDING_HISTORY_FRAMES + 4)
+
+// 采集处理链：在噪音抑制之前对每帧原地处理一遍（逐样本级融合成一个循环）
+static CaptureChain capture_chain;
+
+// 上行拷贝统计：上一轮结束时 getBinaryCopyBytes() 的值
+static uint64_t uplink_copy_mark = 0;
+
+// 实时循环截止时间监控：采集循环（本任务）和播放任务
+#if CONFIG_AUDIO_DEADLINE_SNAPSHOT
+static DeadlineMonitor deadline_monitor(true);
+#else
+static DeadlineMonitor deadline_monitor(false);
+#endif
+static DeadlineLoop* capture_deadline = nullptr;
+static DeadlineLoop* player_deadline = nullptr;
+
+// 录音和播放期间挡住NVS写入（擦写flash时两个核上的任务都会停顿）
+static FlashWriteGate* flash_gate = nullptr;
+static bool flash_gate_held = false;
+
+// I2S延迟配置：DMA几何参数 + 流式播放块长度
+struct AudioLatencyProfile {
+    const char* name;
+    bsp_i2s_dma_geometry_t rx;
+    bsp_i2s_dma_geometry_t tx;
+    uint32_t playback_chunk_ms;
+};
+static const AudioLatencyProfile AUDIO_LATENCY_PROFILES[] = {
+    // 与 I2S_CHANNEL_DEFAULT_CONFIG 相同：6 x 240帧（16kHz下90ms），100ms播放块
+    { "default", { 6, 240 }, { 6, 240 }, 100 },
+    { "low_latency",
+      { CONFIG_AUDIO_LL_RX_DMA_DESC, CONFIG_AUDIO_LL_RX_DMA_FRAMES },
+      { CONFIG_AUDIO_LL_TX_DMA_DESC, CONFIG_AUDIO_LL_TX_DMA_FRAMES },
+      CONFIG_AUDIO_LL_PLAYBACK_CHUNK_MS },
+};
+#if CONFIG_AUDIO_LATENCY_PROFILE_LOW
+static int audio_profile = 1;
+#else
+static int audio_profile = 0;
+#endif
+static volatile int pending_audio_profile = -1;     // 服务器请求的配置，主循环在播放空闲时切换
+static volatile bool udp_drain_done = false;        // UDP下行已排空，主循环接着处理回复结束
+
+// VAD（语音活动检测）之后的端点检测
+static Endpointer endpointer(Endpointer::SILENCE_FRAMES_REQUIRED, SAMPLE_RATE * Endpointer::MIN_TURN_MS / 1000);
+// 本轮录音的上行音频质量，随 recording_ended 上报
+static UplinkQuality uplink_quality;
 
 // 连续对话功能相关变量
 static bool is_continuous_conversation = false;
@@ -96,6 +184,389 @@ static bool is_realtime_streaming = false;
 static bool is_weather_report = false;
 static char weather_trigger_source[32] = {0}; // 存储触发者ID
 
+// 心跳间隔：对话中需要更快发现断链，空闲时降低开销
+#define HEARTBEAT_IDLE_MS 2000           // 等待唤醒时（约6秒判定断链）
+#define HEARTBEAT_CONVERSATION_MS 1000   // 对话进行中（约3秒判定断链）
+
+/**
+* @brief 根据当前状态调整心跳间隔
+*/
+static void update_heartbeat_for_state(void)
+{
+   if (websocket_client == nullptr) {
+       return;
+   }
+   websocket_client->setHeartbeatInterval(current_state == STATE_WAITING_WAKEUP ?
+                                          HEARTBEAT_IDLE_MS : HEARTBEAT_CONVERSATION_MS);
+}
+
+/**
+* @brief 每个状态需要的模型
+*
+* 等唤醒要唤醒词，录音要VAD；降噪打开时两个状态的采集都先过降噪。
+* 等回复和播放时不需要模型，已加载的留着，内存紧张时才卸载。
+*/
+static uint32_t models_for_state(system_state_t state)
+{
+   uint32_t ns = ns_enabled ? ModelManager::bit(ModelManager::NS) : 0;
+   switch (state) {
+   case STATE_WAITING_WAKEUP:
+       return ModelManager::bit(ModelManager::WAKENET) | ns;
+   case STATE_RECORDING:
+       return ModelManager::bit(ModelManager::VAD) | ns;
+   default:
+       return 0;
+   }
+}
+
+/**
+* @brief 重置VAD触发状态（还没加载时不用重置，新建的VAD本来就是干净的）
+*/
+static void reset_vad(void)
+{
+   if (model_manager->vad() != nullptr) {
+       vad_reset_trigger(model_manager->vad());
+   }
+}
+
+/**
+* @brief 输出并清零I2S队列溢出和DMA排队延迟统计
+*/
+static void log_i2s_stats(void)
+{
+   bsp_i2s_stats_t st;
+   bsp_i2s_get_stats(&st, true);
+   ESP_LOGI(TAG, "I2S[%s]: 采集延迟 平均 %lu / 最大 %lu us (%lu 次), 播放延迟 平均 %lu / 最大 %lu us (%lu 次), 溢出 接收 %lu / 发送 %lu",
+            AUDIO_LATENCY_PROFILES[audio_profile].name,
+            (unsigned long)st.rx_latency_avg_us, (unsigned long)st.rx_latency_max_us, (unsigned long)st.rx_reads,
+            (unsigned long)st.tx_latency_avg_us, (unsigned long)st.tx_latency_max_us, (unsigned long)st.tx_writes,
+            (unsigned long)st.rx_queue_overflows, (unsigned long)st.tx_queue_overflows);
+
+   bsp_mic_beam_stats_t beam;
+   if (bsp_mic_get_beam_stats(&beam) == ESP_OK) {
+       ESP_LOGI(TAG, "波束形成[%s]: 延迟 %ld 样本, 有声 %lu / %lu 片, 切换 %lu 次",
+                beam.adaptive ? "自适应" : "固定", (long)beam.delay, (unsigned long)beam.voiced_blocks,
+                (unsigned long)beam.blocks, (unsigned long)beam.delay_changes);
+   }
+}
+
+/**
+* @brief 切换I2S延迟配置（在采集任务里、播放空闲时调用）
+*
+* 重建I2S通道会丢掉DMA里的数据，先输出旧配置的统计。
+*/
+static void apply_audio_profile(int index)
+{
+   const AudioLatencyProfile& p = AUDIO_LATENCY_PROFILES[index];
+   log_i2s_stats();
+   esp_err_t ret = bsp_i2s_set_dma_geometry(&p.rx, &p.tx);
+   if (ret != ESP_OK) {
+       ESP_LOGE(TAG, "切换I2S配置 %s 失败: %s", p.name, esp_err_to_name(ret));
+       return;
+   }
+   audio_manager->setPlaybackChunkMs(p.playback_chunk_ms);
+   if (player_deadline != nullptr) {
+       uint32_t period_us = audio_manager->getPlaybackChunkUs();
+       player_deadline->setTiming(period_us, period_us * CONFIG_AUDIO_DEADLINE_PLAYER_BUDGET_PCT / 100);
+   }
+   audio_profile = index;
+   ESP_LOGI(TAG, "I2S配置切换为 %s: 接收DMA %lu x %lu, 发送DMA %lu x %lu, 播放块 %lu ms", p.name,
+            (unsigned long)p.rx.desc_num, (unsigned long)p.rx.frame_num,
+            (unsigned long)p.tx.desc_num, (unsigned long)p.tx.frame_num,
+            (unsigned long)p.playback_chunk_ms);
+}
+
+/**
+* @brief 播放缓冲区重新分配后重新声明 ring_bytes（服务器按它的3/4控制下发节奏，声明大了会被丢包）
+*/
+static void announce_ring_bytes(void)
+{
+   if (hello == nullptr) {
+       return;
+   }
+   hello->setRingBytes(audio_manager->getStreamingBufferSize());
+   if (websocket_client != nullptr && websocket_client->isConnected()) {
+       websocket_client->sendText(hello->begin());
+   }
+}
+
+#if CONFIG_AUDIO_MEM_GOVERNOR
+/**
+* @brief 发送内存级别变化事件（没连上时留着，连上后再发）
+*/
+static void send_memory_pressure(void)
+{
+   if (!mem_governor->telemetryPending() || websocket_client == nullptr || !websocket_client->isConnected()) {
+       return;
+   }
+   char msg[384];
+   mem_governor->formatTelemetry(msg, sizeof(msg));
+   websocket_client->sendText(msg);
+   mem_governor->clearTelemetryPending();
+}
+
+/**
+* @brief 按内存调控器的级别降级或恢复（在采集任务里调用）
+*
+* 卸载模型、开关降噪立即执行；播放缓冲区要等播放结束、回到等唤醒状态才重新分配。
+*/
+static void apply_memory_level(void)
+{
+   static size_t ring_target = 0;          // 待重新分配的播放缓冲区大小，0=不需要
+   static uint32_t trimmed_for = 0;        // 上一次按哪个模型集合卸载过
+   bool changed = mem_governor->update();
+   MemoryGovernor::Level level = mem_governor->level();
+
+   if (changed) {
+       if (level >= MemoryGovernor::NO_NS && ns_enabled) {
+           ns_enabled = false;
+           ns_shed = true;
+           model_manager->release(ModelManager::NS);
+           ESP_LOGW(TAG, "内存紧张，关闭噪音抑制");
+       } else if (level < MemoryGovernor::NO_NS && ns_shed) {
+           // 下一帧 models_for_state() 带上降噪，由 require() 重新加载
+           ns_enabled = true;
+           ns_shed = false;
+           ESP_LOGI(TAG, "内存恢复，重新打开噪音抑制");
+       }
+       ring_target = level >= MemoryGovernor::SMALL_RING ? AudioManager::STREAMING_BUFFER_MIN :
+                                                           AudioManager::getStreamingBufferCapacity();
+       if (ring_target == audio_manager->getStreamingBufferSize()) {
+           ring_target = 0;
+       }
+   }
+
+   // 降级期间每次换状态都把上一个状态留下的模型卸掉，不再当缓存留着
+   if (level >= MemoryGovernor::TRIM_CACHES && (changed || trimmed_for != required_models)) {
+       int released = model_manager->trim(required_models, true);
+       if (released > 0) {
+           ESP_LOGW(TAG, "内存紧张，卸载 %d 个暂时不用的模型", released);
+       }
+       trimmed_for = required_models;
+   }
+
+   // 这里的判断只是挑个空闲的时机，真正的互斥在 setStreamingBufferSize() 里：
+   // 网络任务刚好开始播放时返回 ESP_ERR_INVALID_STATE，下次再试
+   if (ring_target != 0 && current_state == STATE_WAITING_WAKEUP && !audio_manager->isStreamingActive()) {
+       esp_err_t ret = audio_manager->setStreamingBufferSize(ring_target);
+       if (ret != ESP_ERR_INVALID_STATE) {
+           if (ret != ESP_OK) {
+               ESP_LOGE(TAG, "播放缓冲区重新分配失败: %s", esp_err_to_name(ret));
+               mem_governor->noteAllocationFailure("streaming_buffer");
+           }
+           // 放大失败时已退回最小值，不反复重试，等下一次级别变化
+           ring_target = 0;
+           announce_ring_bytes();
+           capture_deadline->skip();
+       }
+   }
+
+   send_memory_pressure();
+}
+#endif
+
+/**
+* @brief 发送录音结束事件，附带链路RTT统计和本轮上行音频质量，供服务器做时延分析、与识别结果对照
+*
+* @param reason 结束原因："end_of_turn"（端点检测判断说完）或 "buffer_full"（录音缓冲区满）
+*/
+static void send_recording_ended(const char* reason)
+{
+   if (websocket_client == nullptr || !websocket_client->isConnected()) {
+       return;
+   }
+   WebSocketClient::RttStats rtt = websocket_client->getRttStats();
+   UplinkQuality::Summary q = uplink_quality.summary();
+   char snr[16];
+   if (q.snr_valid) {
+       snprintf(snr, sizeof(snr), "%.1f", q.snr_db);
+   } else {
+       snprintf(snr, sizeof(snr), "null");
+   }
+   char end_msg[512];
+   int len = snprintf(end_msg, sizeof(end_msg),
+            "{\"event\":\"recording_ended\",\"rtt_ms\":%lu,\"rtt_min_ms\":%lu,\"rtt_jitter_ms\":%lu,"
+            "\"audio\":{\"reason\":\"%s\",\"rms_dbfs\":%.1f,\"peak_dbfs\":%.1f,\"clip_ratio\":%.5f,"
+            "\"snr_db\":%s,\"frames\":%lu,\"speech_frames\":%lu,\"lost_frames\":%lu}",
+            (unsigned long)rtt.srtt_ms, (unsigned long)rtt.min_ms, (unsigned long)rtt.jitter_ms,
+            reason, q.rms_dbfs, q.peak_dbfs, q.clip_ratio, snr,
+            (unsigned long)q.frames, (unsigned long)q.speech_frames, (unsigned long)q.lost_frames);
+#if CONFIG_AUDIO_MEM_GOVERNOR
+   // 内存级别和启动以来的最低空闲量（KB），对照本轮是否在降级状态下录的
+   if (len > 0 && (size_t)len < sizeof(end_msg)) {
+       MemoryGovernor::RegionStats in = mem_governor->stats(MemoryGovernor::INTERNAL);
+       MemoryGovernor::RegionStats dma = mem_governor->stats(MemoryGovernor::DMA);
+       MemoryGovernor::RegionStats ps = mem_governor->stats(MemoryGovernor::PSRAM);
+       len += snprintf(end_msg + len, sizeof(end_msg) - len,
+                       ",\"mem\":{\"level\":\"%s\",\"internal_min_kb\":%lu,\"dma_min_kb\":%lu,\"psram_min_kb\":%lu,"
+                       "\"ring_bytes\":%lu}",
+                       MemoryGovernor::levelName(mem_governor->level()), (unsigned long)(in.min_free / 1024),
+                       (unsigned long)(dma.min_free / 1024), (unsigned long)(ps.min_free / 1024),
+                       (unsigned long)audio_manager->getStreamingBufferSize());
+   }
+#endif
+   if (len > 0 && (size_t)len < sizeof(end_msg) - 1) {
+       snprintf(end_msg + len, sizeof(end_msg) - len, "}");
+   }
+   websocket_client->sendText(end_msg);
+   ESP_LOGI(TAG, "链路RTT: 平滑 %lu ms, 最小 %lu ms, 抖动 %lu ms, 断链 %lu 次",
+            (unsigned long)rtt.srtt_ms, (unsigned long)rtt.min_ms,
+            (unsigned long)rtt.jitter_ms, (unsigned long)rtt.dead_links);
+   ESP_LOGI(TAG, "上行音频(%s): RMS %.1f dBFS, 峰值 %.1f dBFS, 削波 %.3f%%, 信噪比 %s dB, 说话 %lu/%lu 帧, 丢帧 %lu",
+            reason, q.rms_dbfs, q.peak_dbfs, q.clip_ratio * 100, snr,
+            (unsigned long)q.speech_frames, (unsigned long)q.frames, (unsigned long)q.lost_frames);
+
+   // 本轮上行在发送路径上被拷贝的字节数（采集帧本身按引用传递，不再拷进录音缓冲区）
+   uint64_t copied = websocket_client->getBinaryCopyBytes() - uplink_copy_mark;
+   uplink_copy_mark = websocket_client->getBinaryCopyBytes();
+   float speech_sec = audio_manager != nullptr ? audio_manager->getRecordingDuration() : 0;
+   ESP_LOGI(TAG, "上行拷贝: %llu 字节 / %.1f 秒语音 (%.1f KB/s)",
+            (unsigned long long)copied, speech_sec,
+            speech_sec > 0 ? copied / 1024.0 / speech_sec : 0.0);
+
+   // 实时循环的处理时间和超时；本轮有超时快照时连迟到分布一起输出
+   deadline_monitor.report(deadline_monitor.hasSnapshot());
+   log_i2s_stats();
+   model_manager->report();
+   FlashWriteGate::Stats fs = flash_gate->getStats();
+   ESP_LOGI(TAG, "flash写入: 放行 %lu 次（其中等待 %lu 次，最长 %lu ms），推迟 %lu 次",
+            (unsigned long)fs.writes, (unsigned long)fs.waited,
+            (unsigned long)fs.max_wait_ms, (unsigned long)fs.deferred);
+}
+
+/**
+* @brief 处理下行音频（WebSocket二进制帧或UDP通道）
+*/
+static void handle_downlink_audio(const uint8_t* data, size_t len)
+{
+   if (audio_manager != nullptr && len > 0 &&
+       (current_state == STATE_WAITING_RESPONSE || current_state == STATE_PLAYING_WEATHER)) {
+        // 先检查是否已经开始播放，避免竞态条件重复发送
+        bool was_already_streaming = audio_manager->isStreamingActive();
+
+        if (!was_already_streaming) {
+            ESP_LOGI(TAG, "开始流式音频播放");
+            audio_manager->startStreamingPlayback();
+        }
+        bool added = audio_manager->addStreamingAudioChunk(data, len);
+
+        if (added) {
+            ESP_LOGD(TAG, "添加流式音频块: %zu 字节", len);
+        } else {
+            ESP_LOGW(TAG, "流式音频缓冲区满");
+        }
+   }
+}
+
+/**
+* @brief 精简传输直接接收下行音频：返回播放环形缓冲区中的可写空间
+*
+* @return 写入地址，nullptr=当前不接收（数据改走 DATA_BINARY 事件）
+*/
+static uint8_t* acquire_downlink_buffer(size_t want, size_t* granted)
+{
+   *granted = 0;
+   if (audio_manager == nullptr ||
+       (current_state != STATE_WAITING_RESPONSE && current_state != STATE_PLAYING_WEATHER)) {
+       return nullptr;
+   }
+   if (!audio_manager->isStreamingActive()) {
+       ESP_LOGI(TAG, "开始流式音频播放");
+       audio_manager->startStreamingPlayback();
+   }
+   return audio_manager->acquireStreamingWrite(want, granted);
+}
+
+/**
+* @brief 发送一帧上行音频：UDP通道可用时走UDP，否则走WebSocket
+*
+* 调用方持有的是这帧的唯一引用时原地掩码发送（省掉一次拷贝），
+* 之后帧数据不可再用；还有别人引用时照常拷贝发送。
+*
+* @return 发送的字节数，-1=失败
+*/
+static int send_uplink_frame(AudioFrame* frame, int timeout_ms)
+{
+   if (udp_audio != nullptr && udp_audio->isActive()) {
+       return udp_audio->sendAudio(frame->samples(), frame->sampleCount());
+   }
+   if (websocket_client == nullptr || !websocket_client->isConnected()) {
+       return -1;
+   }
+   if (frame->refCount() == 1) {
+       return websocket_client->sendBinaryInPlace(frame->data, frame->length, timeout_ms);
+   }
+   return websocket_client->sendBinary(frame->data, frame->length, timeout_ms);
+}
+
+#if CONFIG_AUDIO_PROFILER
+// 串口输出几千行要好几秒，放到单独的低优先级任务里，不阻塞WebSocket事件处理
+static void profile_dump_task(void* arg)
+{
+   profiler->dump();
+   vTaskDelete(NULL);
+}
+
+static void handle_profile_command(const std::string& action)
+{
+   if (profiler == nullptr) {
+       return;
+   }
+   if (action == "start") {
+       profiler->start(CONFIG_AUDIO_PROFILER_HZ);
+   } else if (action == "stop") {
+       profiler->stop();
+   } else if (action == "dump") {
+       profiler->stop();
+       xTaskCreate(profile_dump_task, "profile_dump", 4096, NULL, 2, NULL);
+   } else {
+       ESP_LOGW(TAG, "未知的profile命令: %s", action.c_str());
+   }
+}
+#endif
+
+/**
+* @brief 服务器的一段回复发送完毕（response_finished 事件）
+*
+* UDP下行时由主循环在 UDP 通道排空之后调用。
+*/
+static void handle_response_finished(void)
+{
+   if (audio_manager != nullptr && audio_manager->isStreamingActive()) {
+       ESP_LOGI(TAG, "收到结束信号，停止流式接收，等待播放缓冲区排空...");
+
+       // 1. 告诉 AudioManager 网络数据传完了，剩下的自己播完
+       audio_manager->finishStreamingPlayback();
+
+       // 2. 根据当前状态决定下一步
+       if (current_state == STATE_WAITING_RESPONSE) {
+           current_state = STATE_PLAYING_FINISHED_WAITING;
+       } else if (current_state == STATE_PLAYING_WEATHER) {
+           // 天气播报也在等待播放结束，保持当前状态
+           ESP_LOGI(TAG, "天气播报接收完成，等待播放结束...");
+       }
+   } else {
+       // 🔧 修复：如果没有在播放（比如TTS失败返回空音频），
+       ESP_LOGW(TAG, "收到结束信号但没有音频在播放，可能是TTS失败");
+
+
+       // 根据状态决定下一步
+       if (current_state == STATE_WAITING_RESPONSE) {
+           current_state = STATE_RECORDING;
+           audio_manager->clearRecordingBuffer();
+           audio_manager->startRecording();
+           endpointer.reset();
+           uplink_quality.reset();
+           ESP_LOGI(TAG, "进入录音状态（无音频回复）");
+       } else if (current_state == STATE_PLAYING_WEATHER) {
+           // 天气播报无音频，返回等待唤醒
+           current_state = STATE_WAITING_WAKEUP;
+           is_weather_report = false;
+           ESP_LOGI(TAG, "天气播报无音频，返回等待唤醒状态");
+       }
+   }
+}
+
 /**
 * @brief WebSocket事件处理函数
 */
@@ -105,9 +576,20 @@ static void on_websocket_event(const WebSocketClient::EventData& event)
    {
    case WebSocketClient::EventType::CONNECTED:
        ESP_LOGI(TAG, "WebSocket已连接");
+       if (server_selector != nullptr) {
+           server_selector->reportConnected();
+       }
+       // 新连接先按旧协议不限制单帧大小，hello_ack 到了再按协商结果限制
+       websocket_client->setMaxSendFrame(0);
+       if (hello != nullptr) {
+           websocket_client->sendText(hello->begin());
+       }
        break;
    case WebSocketClient::EventType::DISCONNECTED:
        ESP_LOGI(TAG, "WebSocket已断开");
+       if (udp_audio != nullptr) {
+           udp_audio->deactivate();
+       }
        break;
    case WebSocketClient::EventType::DATA_BINARY:
    // 收到服务器发来的AI语音数据
@@ -121,28 +603,15 @@ static void on_websocket_event(const WebSocketClient::EventData& event)
            ESP_LOGI(TAG, "二进制数据内容: %s", debug_buf);
        }
        
-       if (audio_manager != nullptr && event.data_len > 0 && 
-           (current_state == STATE_WAITING_RESPONSE || current_state == STATE_PLAYING_WEATHER)) {
-            // 先检查是否已经开始播放，避免竞态条件重复发送
-            bool was_already_streaming = audio_manager->isStreamingActive();
-            
-            if (!was_already_streaming) {
-                ESP_LOGI(TAG, "开始流式音频播放");
-                audio_manager->startStreamingPlayback();
-            }
-            bool added = audio_manager->addStreamingAudioChunk(event.data, event.data_len);
-            
-            if (added) {
-                ESP_LOGD(TAG, "添加流式音频块: %zu 字节", event.data_len);
-            } else {
-                ESP_LOGW(TAG, "流式音频缓冲区满");
-            }
+       // data为空：精简传输已直接写入播放缓冲区
+       if (event.data != nullptr) {
+           handle_downlink_audio(event.data, event.data_len);
        }
    }
    break;
 
    case WebSocketClient::EventType::PING:
-        // 用 PING 包作为流式音频结束的标志
+        // ping只用于保活，回复结束统一用 response_finished 事件
         ESP_LOGD(TAG, "收到ping包");
         break;
 
@@ -153,45 +622,26 @@ static void on_websocket_event(const WebSocketClient::EventData& event)
                 memcpy(json_str, event.data, event.data_len);
                 json_str[event.data_len] = '\0';
                 ESP_LOGI(TAG, "收到JSON消息: %s", json_str);
-                if (strstr(json_str, "response_finished") != NULL) {
-                    if (audio_manager != nullptr && audio_manager->isStreamingActive()) {
-                        ESP_LOGI(TAG, "收到结束信号，停止流式接收，等待播放缓冲区排空...");
-
-                        // 1. 告诉 AudioManager 网络数据传完了，剩下的自己播完
-                        audio_manager->finishStreamingPlayback();
-
-                        // 2. 根据当前状态决定下一步
-                        if (current_state == STATE_WAITING_RESPONSE) {
-                            current_state = STATE_PLAYING_FINISHED_WAITING;
-                        } else if (current_state == STATE_PLAYING_WEATHER) {
-                            // 天气播报也在等待播放结束，保持当前状态
-                            ESP_LOGI(TAG, "天气播报接收完成，等待播放结束...");
-                        }
+                size_t field_len = 0;
+                const char* field = NULL;
+                switch (classify_server_event(json_str)) {
+                case ServerEvent::RESPONSE_FINISHED:
+                    if (udp_audio != nullptr && udp_audio->isActive()) {
+                        // UDP下行时结束信号可能比最后几个音频包先到：接收任务等到最后一包（或超时）
+                        // 再通知主循环，本任务不阻塞，后面的包照常写进播放缓冲区
+                        udp_audio->drain(UDP_DRAIN_TIMEOUT_MS, [] { udp_drain_done = true; });
                     } else {
-                        // 🔧 修复：如果没有在播放（比如TTS失败返回空音频），
-                        ESP_LOGW(TAG, "收到结束信号但没有音频在播放，可能是TTS失败");
-
-
-                        // 根据状态决定下一步
-                        if (current_state == STATE_WAITING_RESPONSE) {
-                            current_state = STATE_RECORDING;
-                            audio_manager->clearRecordingBuffer();
-                            audio_manager->startRecording();
-                            vad_speech_detected = false;
-                            vad_silence_frames = 0;
-                            ESP_LOGI(TAG, "进入录音状态（无音频回复）");
-                        } else if (current_state == STATE_PLAYING_WEATHER) {
-                            // 天气播报无音频，返回等待唤醒
-                            current_state = STATE_WAITING_WAKEUP;
-                            is_weather_report = false;
-                            ESP_LOGI(TAG, "天气播报无音频，返回等待唤醒状态");
-                        }
+                        handle_response_finished();
                     }
-                } else if (strstr(json_str, "\"event\":\"ping\"") != NULL) {
+                    break;
+
+                case ServerEvent::PING:
                     // 处理服务器心跳ping，忽略或记录
                     ESP_LOGD(TAG, "收到服务器心跳ping");
                     // 可选：发送pong响应，但服务器期望的是JSON ping，不是协议层pong
-                } else if (strstr(json_str, "\"event\":\"error\"") != NULL) {
+                    break;
+
+                case ServerEvent::ERROR:
                     // 处理错误消息
                     ESP_LOGE(TAG, "收到服务器错误消息: %s", json_str);
                         // 根据状态决定下一步
@@ -199,27 +649,24 @@ static void on_websocket_event(const WebSocketClient::EventData& event)
                         current_state = STATE_RECORDING;
                         audio_manager->clearRecordingBuffer();
                         audio_manager->startRecording();
-                        vad_speech_detected = false;
-                        vad_silence_frames = 0;
+                        endpointer.reset();
+                        uplink_quality.reset();
                         ESP_LOGI(TAG, "进入录音状态（服务器错误）");
                     }
-                } else if (strstr(json_str, "\"event\":\"play_weather\"") != NULL) {
+                    break;
+
+                case ServerEvent::PLAY_WEATHER:
                     // 🌤️ 收到天气播报指令
                     ESP_LOGI(TAG, "收到天气播报指令!");
                     
                     // 提取触发者信息
-                    char* triggered_by = strstr(json_str, "\"triggered_by\":\"");
-                    if (triggered_by) {
-                        triggered_by += strlen("\"triggered_by\":\"");
-                        char* end = strchr(triggered_by, '\"');
-                        if (end) {
-                            size_t len = end - triggered_by;
-                            if (len > sizeof(weather_trigger_source) - 1) {
-                                len = sizeof(weather_trigger_source) - 1;
-                            }
-                            strncpy(weather_trigger_source, triggered_by, len);
-                            weather_trigger_source[len] = '\0';
+                    field = json_string_field(json_str, "triggered_by", &field_len);
+                    if (field) {
+                        if (field_len > sizeof(weather_trigger_source) - 1) {
+                            field_len = sizeof(weather_trigger_source) - 1;
                         }
+                        strncpy(weather_trigger_source, field, field_len);
+                        weather_trigger_source[field_len] = '\0';
                     }
                     
                     // 停止当前录音
@@ -237,9 +684,76 @@ static void on_websocket_event(const WebSocketClient::EventData& event)
                     current_state = STATE_PLAYING_WEATHER;
                     
                     ESP_LOGI(TAG, "🌤️ 准备接收天气播报音频，触发者: %s", weather_trigger_source);
+                    break;
+
+                case ServerEvent::HELLO_ACK:
+                    // 🤝 服务器选定了本次连接的配置，按协商结果启用可选特性
+                    if (hello != nullptr && hello->handleAck(json_str)) {
+                        // 上行的帧同样不超过双方协商出的单帧上限
+                        websocket_client->setMaxSendFrame(hello->config().max_frame);
+                        if (hello->enabled(HelloHandshake::FEATURE_UDP_AUDIO) && udp_audio != nullptr) {
+                            websocket_client->sendText(udp_audio->buildOffer());
+                        }
+                    }
+                    break;
+
+                case ServerEvent::UDP_ANSWER:
+                    // 📡 服务器接受了UDP音频通道
+                    if (udp_audio != nullptr) {
+                        udp_audio->handleAnswer(json_str, websocket_client->getUri());
+                    }
+                    break;
+
+                case ServerEvent::SET_SERVERS:
+                    // 🌐 服务器下发新的候选节点列表，下次启动或故障切换时生效
+                    field = json_string_field(json_str, "servers", &field_len);
+                    if (field && server_selector != nullptr) {
+                        server_selector->setEndpoints(std::string(field, field_len));
+                    }
+                    break;
+
+                case ServerEvent::AUDIO_PROFILE:
+                    // 🎚️ {"event":"audio_profile","profile":"default|low_latency"}
+                    field = json_string_field(json_str, "profile", &field_len);
+                    if (field) {
+                        std::string name(field, field_len);
+                        int index = -1;
+                        for (size_t i = 0; i < sizeof(AUDIO_LATENCY_PROFILES) / sizeof(AUDIO_LATENCY_PROFILES[0]); i++) {
+                            if (name == AUDIO_LATENCY_PROFILES[i].name) {
+                                index = (int)i;
+                            }
+                        }
+                        if (index < 0) {
+                            ESP_LOGW(TAG, "未知的I2S配置: %s", name.c_str());
+                        } else {
+                            pending_audio_profile = index;
+                        }
+                    }
+                    break;
+
+                case ServerEvent::PROFILE:
+                    // 🔬 {"event":"profile","action":"start|stop|dump"}
+#if CONFIG_AUDIO_PROFILER
+                    field = json_string_field(json_str, "action", &field_len);
+                    if (field) {
+                        handle_profile_command(std::string(field, field_len));
+                    }
+#else
+                    ESP_LOGW(TAG, "固件未启用采样分析器 (CONFIG_AUDIO_PROFILER)");
+#endif
+                    break;
+
+                default:
+                    break;
                 }
                 free(json_str);
             }
+#if CONFIG_AUDIO_MEM_GOVERNOR
+            else if (mem_governor != nullptr) {
+                ESP_LOGE(TAG, "文本帧拷贝分配失败 (%zu 字节)", (size_t)event.data_len + 1);
+                mem_governor->noteAllocationFailure("text_frame");
+            }
+#endif
        }
        break;
 
@@ -261,11 +775,59 @@ static esp_err_t play_audio_with_stop(const uint8_t *audio_data, size_t data_len
    return ESP_ERR_INVALID_STATE;
 }
 
+#if CONFIG_AUDIO_PROMPT_STORE
+// 提示音在 assets 分区的模型仓库里，直接从flash映射播放
+static ModelStore prompt_store;
+#endif
+
+/**
+* @brief 按名字播放提示音（hi / bye）
+*/
+static esp_err_t play_prompt(const char *name, const char *description)
+{
+#if CONFIG_AUDIO_PROMPT_STORE
+   ModelStore::Blob blob;
+   if (!prompt_store.find(name, &blob)) {
+       ESP_LOGW(TAG, "assets 分区里没有提示音 %s", name);
+       return ESP_ERR_NOT_FOUND;
+   }
+   return play_audio_with_stop(blob.data, blob.size, description);
+#else
+   if (strcmp(name, "hi") == 0) {
+       return play_audio_with_stop(hi, hi_len, description);
+   }
+   if (strcmp(name, "bye") == 0) {
+       return play_audio_with_stop(bye, bye_len, description);
+   }
+   return ESP_ERR_NOT_FOUND;
+#endif
+}
+
+/**
+* @brief 启动时在后台加载初始状态的模型，和WiFi连接、服务器测速同时进行
+*/
+static void model_load_task(void *arg)
+{
+   int64_t start = esp_timer_get_time();
+   model_manager->require(required_models);
+   model_load_us = esp_timer_get_time() - start;
+   xSemaphoreGive(models_ready);
+   vTaskDelete(NULL);
+}
+
+/**
+* @brief 启动耗时打点（从应用启动算起）
+*/
+static void log_boot_stage(const char *stage)
+{
+   ESP_LOGI(TAG, "⏱️ 启动 %s: %lu ms", stage, (unsigned long)(esp_timer_get_time() / 1000));
+}
+
 // 退出连续对话的逻辑
 static void execute_exit_logic(void)
 {
    ESP_LOGI(TAG, "播放再见音频...");
-   play_audio_with_stop(bye, bye_len, "再见音频");
+   play_prompt("bye", "再见音频");
 
    if (websocket_client != nullptr) {
        websocket_client->disconnect();
@@ -279,8 +841,8 @@ static void execute_exit_logic(void)
    is_continuous_conversation = false;
    user_started_speaking = false;
    recording_timeout_start = 0;
-   vad_speech_detected = false;
-   vad_silence_frames = 0;
+   endpointer.reset();
+   uplink_quality.reset();
 
    ESP_LOGI(TAG, "返回等待唤醒状态，请说出唤醒词 '你好小智'");
 }
@@ -290,12 +852,6 @@ extern "C" void app_main(void)
 {
     // --- 初始化阶段 ---
     // 需要清理的资源指针
-    srmodel_list_t *models = nullptr;
-    esp_wn_iface_t *wakenet = nullptr;
-    model_iface_data_t *model_data = nullptr;
-    int16_t *buffer = nullptr;
-    char *model_name = nullptr;
-    int16_t *ns_out_buffer = nullptr;  // 噪音抑制输出缓冲区
     int audio_chunksize = 0;           // 音频块大小，稍后初始化
     size_t free_heap = 0;              // 内存状态变量，稍后初始化
     size_t free_internal = 0;
@@ -308,6 +864,18 @@ extern "C" void app_main(void)
         ret = nvs_flash_init();
     }
     ESP_ERROR_CHECK(ret);
+    log_boot_stage("NVS");
+
+#if CONFIG_AUDIO_PROMPT_STORE
+    prompt_store.open("assets");
+#endif
+
+    // 唤醒词模型加载要几百毫秒，不必排在WiFi和服务器测速后面
+    model_manager = new ModelManager(SAMPLE_RATE, CONFIG_AUDIO_MODEL_PSRAM_RESERVE_KB * 1024,
+                                     CONFIG_AUDIO_MODEL_INTERNAL_RESERVE_KB * 1024);
+    required_models = models_for_state(current_state);
+    models_ready = xSemaphoreCreateBinary();
+    xTaskCreatePinnedToCore(model_load_task, "model_load", 8192, NULL, 4, NULL, 1);
 
     ESP_LOGI(TAG, "正在连接WiFi...");
     wifi_manager = new WiFiManager(CONFIG_MY_WIFI_SSID, CONFIG_MY_WIFI_PASSWORD);
@@ -315,16 +883,83 @@ extern "C" void app_main(void)
         ESP_LOGE(TAG, "WiFi连接失败");
         goto cleanup;
     }
+    log_boot_stage("WiFi");
+
+    ESP_LOGI(TAG, "正在测速选择服务器...");
+    flash_gate = new FlashWriteGate();
+    server_selector = new ServerSelector(CONFIG_WS_SERVER_ENDPOINTS);
+    server_selector->setFlashGate(flash_gate);
+    if (server_selector->load() != ESP_OK) {
+        ESP_LOGE(TAG, "服务器列表无效");
+        goto cleanup;
+    }
+    server_selector->probeAll();
+
+#if CONFIG_AUDIO_UDP_TRANSPORT
+    udp_audio = new UdpAudioChannel(CONFIG_AUDIO_UDP_LOCAL_PORT);
+    if (udp_audio->open() == ESP_OK) {
+        udp_audio->setAudioSink(handle_downlink_audio);
+    } else {
+        ESP_LOGW(TAG, "UDP音频通道不可用，仅使用WebSocket传输音频");
+        delete udp_audio;
+        udp_audio = nullptr;
+    }
+#endif
+
+    {
+        HelloHandshake::Capabilities caps = {};
+        caps.sample_rate = SAMPLE_RATE;
+        caps.ring_bytes = AudioManager::getStreamingBufferCapacity();
+        caps.max_frame = WebSocketClient::getMaxFrameSize();
+        caps.features = HelloHandshake::FEATURE_HEARTBEAT_RTT;
+        if (udp_audio != nullptr) {
+            caps.features |= HelloHandshake::FEATURE_UDP_AUDIO;
+        }
+        hello = new HelloHandshake(caps);
+    }
+
+#if CONFIG_WS_TRANSPORT_BENCH
+    ws_transport_bench_run(server_selector->selectBest());
+#endif
 
     ESP_LOGI(TAG, "正在连接WebSocket服务器...");
-    websocket_client = new WebSocketClient(WS_URI, true, 5000);
+    websocket_client = new WebSocketClient(server_selector->selectBest(), true, 5000);
     websocket_client->setEventCallback(on_websocket_event);
+#if CONFIG_WS_LEAN_TRANSPORT
+    {
+        websocket_client->setTransport(WebSocketClient::Transport::LEAN);
+        LeanWsTransport::BinaryReceiver receiver;
+        receiver.acquire = acquire_downlink_buffer;
+        receiver.commit = [](size_t n) { audio_manager->commitStreamingWrite(n); };
+        websocket_client->setBinaryReceiver(receiver);
+    }
+#endif
+    websocket_client->setFailoverHandler([](int failures) -> std::string {
+        // 每连续失败 N 次切换一次节点
+        if (failures % CONFIG_WS_FAILOVER_AFTER_ATTEMPTS != 0) {
+            return std::string();
+        }
+        return server_selector->failover();
+    });
+    websocket_client->setAddressLookup([](const std::string& uri) -> std::string {
+        return server_selector->cachedAddress(uri);
+    });
     if (websocket_client->connect() != ESP_OK) {
         ESP_LOGE(TAG, "WebSocket连接失败");
         goto cleanup;
     }
+    log_boot_stage("服务器");
+    server_selector->startBackgroundProbe(CONFIG_WS_PROBE_INTERVAL_SEC * 1000);
 
     ESP_LOGI(TAG, "正在初始化INMP441数字麦克风...");
+    // DMA几何参数在创建I2S通道时生效，先于初始化设置
+    ret = bsp_i2s_set_dma_geometry(&AUDIO_LATENCY_PROFILES[audio_profile].rx,
+                                   &AUDIO_LATENCY_PROFILES[audio_profile].tx);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGW(TAG, "I2S配置 %s 无效，使用默认DMA参数", AUDIO_LATENCY_PROFILES[audio_profile].name);
+        audio_profile = 0;
+    }
     ret = bsp_board_init(16000, 1, 16);
     if (ret != ESP_OK)
     {
@@ -341,14 +976,9 @@ extern "C" void app_main(void)
         goto cleanup;
     }
     ESP_LOGI(TAG, "音频播放初始化成功");
-
-    ESP_LOGI(TAG, "正在初始化语音活动检测（VAD）...");
-    vad_inst = vad_create_with_param(VAD_MODE_1, SAMPLE_RATE, 30, 200, 1000);
-    if (vad_inst == NULL) {
-        ESP_LOGE(TAG, "创建VAD实例失败");
-        goto cleanup;
-    }
-    ESP_LOGI(TAG, "VAD初始化成功");
+    log_boot_stage("音频");
+    // 只检查不阻止启动：不安全时flash操作期间的溢出计数会漏记
+    bsp_i2s_check_iram_safety();
 
     ESP_LOGI(TAG, "正在加载唤醒词检测模型...");
     free_heap = heap_caps_get_free_size(MALLOC_CAP_8BIT);
@@ -360,31 +990,28 @@ extern "C" void app_main(void)
     ESP_LOGI(TAG, "  - 内部RAM: %zu KB", free_internal / 1024);
     ESP_LOGI(TAG, "  - PSRAM: %zu KB", free_spiram / 1024);
 
-   models = esp_srmodel_init("model");
-   if (models == NULL) {
-       ESP_LOGE(TAG, "语音识别模型初始化失败");
-       goto cleanup;
-   }
-   model_name = esp_srmodel_filter(models, ESP_WN_PREFIX, NULL);
-   if (model_name == NULL) {
-       ESP_LOGE(TAG, "未找到任何唤醒词模型！");
-       goto cleanup;
-   }
-   ESP_LOGI(TAG, "选择唤醒词模型: %s", model_name);
-   wakenet = (esp_wn_iface_t *)esp_wn_handle_from_name(model_name);
-   if (wakenet == NULL) {
-       ESP_LOGE(TAG, "获取唤醒词接口失败，模型: %s", model_name);
-       goto cleanup;
+   // 等后台加载完初始状态（等唤醒）的模型：采集帧的大小由唤醒词模型决定
+   {
+       int64_t wait_start = esp_timer_get_time();
+       xSemaphoreTake(models_ready, portMAX_DELAY);
+       int64_t waited_us = esp_timer_get_time() - wait_start;
+       vSemaphoreDelete(models_ready);
+       models_ready = nullptr;
+       log_boot_stage("模型");
+       // 串行：加载耗时全部排在启动路径上；并行：启动路径只多等了还没加载完的部分
+       ESP_LOGI(TAG, "⏱️ 模型加载 %lu ms（串行），启动路径等待 %lu ms（并行），省下 %lu ms",
+                (unsigned long)(model_load_us / 1000), (unsigned long)(waited_us / 1000),
+                (unsigned long)(model_load_us > waited_us ? (model_load_us - waited_us) / 1000 : 0));
    }
-   model_data = wakenet->create(model_name, DET_MODE_90);
-   if (model_data == NULL) {
-       ESP_LOGE(TAG, "创建唤醒词模型数据失败");
+   if (model_manager->wakenet() == nullptr) {
+       ESP_LOGE(TAG, "语音识别模型初始化失败");
        goto cleanup;
    }
 
-   audio_chunksize = wakenet->get_samp_chunksize(model_data) * sizeof(int16_t);
-   buffer = (int16_t *)malloc(audio_chunksize);
-   if (buffer == NULL) {
+   audio_chunksize = model_manager->wakenet()->get_samp_chunksize(model_manager->wakenetData()) * sizeof(int16_t);
+   capture_pool = new AudioFramePool("capture", audio_chunksize, CAPTURE_POOL_FRAMES,
+                                     MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+   if (capture_pool->init() != ESP_OK) {
        ESP_LOGE(TAG, "音频缓冲区内存分配失败");
        goto cleanup;
    }
@@ -396,42 +1023,187 @@ extern "C" void app_main(void)
        goto cleanup;
    }
    ESP_LOGI(TAG, "音频管理器初始化成功");
+   if (audio_manager->getStreamingBufferSize() != AudioManager::getStreamingBufferCapacity()) {
+       // 播放缓冲区退回了最小值，握手里声明的容量要跟着改
+       announce_ring_bytes();
+   }
+
+   audio_manager->setPlaybackChunkMs(AUDIO_LATENCY_PROFILES[audio_profile].playback_chunk_ms);
+   {
+       uint32_t capture_period_us = (uint32_t)((uint64_t)audio_chunksize / sizeof(int16_t) * 1000000 / SAMPLE_RATE);
+       uint32_t player_period_us = audio_manager->getPlaybackChunkUs();
+       capture_deadline = deadline_monitor.registerLoop("capture", capture_period_us,
+                                                        capture_period_us * CONFIG_AUDIO_DEADLINE_CAPTURE_BUDGET_PCT / 100);
+       player_deadline = deadline_monitor.registerLoop("player", player_period_us,
+                                                       player_period_us * CONFIG_AUDIO_DEADLINE_PLAYER_BUDGET_PCT / 100);
+       audio_manager->setPlayerDeadline(player_deadline);
+   }
+
+#if CONFIG_AUDIO_ASYNC_COPY_BENCH
+   async_copy_bench_run();
+#endif
+#if CONFIG_AUDIO_FRAME_POOL_BENCH
+   audio_frame_pool_bench_run();
+#endif
+#if CONFIG_AUDIO_FORMAT_BENCH
+   sample_format_bench_run();
+#endif
+#if CONFIG_AUDIO_DSP_BENCH
+   dsp_pipeline_bench_run();
+#endif
+#if CONFIG_AUDIO_FLASH_STRESS
+   flash_stress_bench_run(audio_manager, flash_gate, player_deadline);
+#endif
+   {
+       // 回环延迟供回声消除对齐参考信号；没测过（或配置了每次都测）时先测一次
+       uint32_t loop_delay_us = 0;
+       bool have_delay = latency_selftest_load(&loop_delay_us) == ESP_OK;
+#if CONFIG_AUDIO_LATENCY_SELFTEST
+#if CONFIG_AUDIO_LATENCY_SELFTEST_ALWAYS
+       bool measure = true;
+#else
+       bool measure = !have_delay;
+#endif
+       LatencyProbe::Result loop_result;
+       if (measure && latency_selftest_run(&loop_result) == ESP_OK) {
+           loop_delay_us = (uint32_t)loop_result.delay_us;
+           have_delay = true;
+       }
+#endif
+       if (have_delay) {
+           ESP_LOGI(TAG, "扬声器→麦克风回环延迟: %.2f ms", loop_delay_us / 1000.0);
+       }
+   }
+#if CONFIG_AUDIO_ECHO_TEST
+   echo_test_run(audio_manager, CONFIG_AUDIO_ECHO_TEST_SEC);
+#endif
+#if CONFIG_AUDIO_PROFILER
+   profiler = new SamplingProfiler(CONFIG_AUDIO_PROFILER_SAMPLES);
+   if (profiler->init() != ESP_OK) {
+       delete profiler;
+       profiler = nullptr;
+   }
+#if CONFIG_AUDIO_PROFILER_AUTOSTART
+   else {
+       profiler->start(CONFIG_AUDIO_PROFILER_HZ);
+   }
+#endif
+#endif
 
+#if CONFIG_AUDIO_MEM_GOVERNOR
+   {
+       // 最大连续块下限：文本帧拷贝、采集帧、模型分块加载各自需要的最大单次分配
+       static const MemoryGovernor::Limits limits[MemoryGovernor::REGION_COUNT] = {
+           { CONFIG_AUDIO_MEM_INTERNAL_LOW_KB * 1024, 8 * 1024 },
+           { CONFIG_AUDIO_MEM_DMA_LOW_KB * 1024, 4 * 1024 },
+           { CONFIG_AUDIO_MEM_PSRAM_LOW_KB * 1024, 32 * 1024 },
+       };
+       mem_governor = new MemoryGovernor(limits);
+       mem_governor->report();
+   }
+#endif
+
+   log_boot_stage("就绪");
    ESP_LOGI(TAG, "智能语音助手系统配置完成，请说出唤醒词 '你好小智'");
 
    // --- 主循环 ---
    while (1)
    {
+        update_heartbeat_for_state();
+
+        // 每帧从采集帧池取新的缓冲区：录音历史、VAD和上行发送都按引用使用，不再拷贝
+        AudioFrameRef frame = capture_pool->acquireRef();
+        if (!frame) {
+            ESP_LOGW(TAG, "采集帧池已空");
+            vTaskDelay(pdMS_TO_TICKS(10));
+            continue;
+        }
+
+        // 服务器请求切换I2S配置：重建通道要在本任务里做（不能和读并发），并且等播放结束
+        if (pending_audio_profile >= 0 && !audio_manager->isStreamingActive()) {
+            apply_audio_profile(pending_audio_profile);
+            pending_audio_profile = -1;
+            capture_deadline->skip();
+        }
+
+        if (udp_drain_done) {
+            udp_drain_done = false;
+            handle_response_finished();
+        }
+
+#if CONFIG_AUDIO_MEM_GOVERNOR
+        apply_memory_level();
+#endif
+
+        // 进入新状态时加载它需要的模型（加载耗时不算采集超时）
+        uint32_t models_needed = models_for_state(current_state);
+        if (models_needed != required_models) {
+            model_manager->require(models_needed);
+            required_models = models_needed;
+            capture_deadline->skip();
+        }
+
+        // 录音和播放是实时的，期间的flash写入由写入方推迟（见 flash_write_gate.h）
+        bool audio_realtime = current_state == STATE_RECORDING || audio_manager->isStreamingActive();
+        if (audio_realtime != flash_gate_held) {
+            if (audio_realtime) {
+                flash_gate->hold();
+            } else {
+                flash_gate->release();
+            }
+            flash_gate_held = audio_realtime;
+        }
+
         // 从麦克风读取音频数据
-        ret = bsp_get_feed_data(false, buffer, audio_chunksize);
+        // 只有等唤醒词和录音时采集是实时的，其他状态下数据直接丢弃，不计入截止时间统计
+        bool capture_realtime = current_state == STATE_WAITING_WAKEUP || current_state == STATE_RECORDING;
+        if (capture_realtime) {
+            capture_deadline->waitStart();
+        } else {
+            capture_deadline->skip();
+        }
+        ret = bsp_get_feed_data(false, frame->samples(), audio_chunksize);
         if (ret != ESP_OK) {
             vTaskDelay(pdMS_TO_TICKS(10));
             continue;
         }
+        if (capture_realtime) {
+            capture_deadline->stamp();
+        }
+        frame->length = audio_chunksize;
+        if (current_state == STATE_RECORDING) {
+            uplink_quality.addRaw(frame->samples(), frame->sampleCount());
+        }
+        capture_chain.process(frame->samples(), frame->sampleCount());
 
-        int16_t *processed_audio = buffer;
-        // 噪音抑制输出缓冲区
+        // 噪音抑制输出到另一帧，之后都使用处理后的帧
+        esp_nsn_iface_t *nsn_handle = model_manager->ns();
+        esp_nsn_data_t *nsn_model_data = model_manager->nsData();
         if (nsn_handle != NULL && nsn_model_data != NULL) {
-            // 如果输出缓冲区未分配，分配它
-            if (ns_out_buffer == NULL) {
-                int ns_chunksize = nsn_handle->get_samp_chunksize(nsn_model_data);
-                ns_out_buffer = (int16_t *)malloc(ns_chunksize * sizeof(int16_t));
-                if (ns_out_buffer == NULL) {
-                    ESP_LOGW(TAG, "噪音抑制输出缓冲区分配失败");
-                    nsn_handle = NULL;  // 禁用噪音抑制
+            int ns_chunksize = nsn_handle->get_samp_chunksize(nsn_model_data);
+            if (ns_chunksize * sizeof(int16_t) > capture_pool->blockSize()) {
+                ESP_LOGW(TAG, "噪音抑制块大小超过采集帧");
+                ns_enabled = false;  // 禁用噪音抑制
+                model_manager->release(ModelManager::NS);
+            } else {
+                AudioFrameRef ns_frame = capture_pool->acquireRef();
+                if (ns_frame) {
+                    // 执行噪音抑制
+                    nsn_handle->process(nsn_model_data, frame->samples(), ns_frame->samples());
+                    ns_frame->length = ns_chunksize * sizeof(int16_t);
+                    frame = std::move(ns_frame);
                 }
             }
-            
-            if (ns_out_buffer != NULL) {
-                // 执行噪音抑制
-                nsn_handle->process(nsn_model_data, buffer, ns_out_buffer);
-                processed_audio = ns_out_buffer;  // 使用噪音抑制后的数据
-            }
         }
+        int16_t *processed_audio = frame->samples();
+
        if (current_state == STATE_WAITING_WAKEUP)
        {
            // 休眠状态：监听唤醒词
-           wakenet_state_t wn_state = wakenet->detect(model_data, processed_audio);
+           // 模型加载失败时唤醒词不可用，只能等下次进入这个状态重试
+           esp_wn_iface_t *wakenet = model_manager->wakenet();
+           wakenet_state_t wn_state = wakenet != nullptr ?
+               wakenet->detect(model_manager->wakenetData(), processed_audio) : WAKENET_NO_DETECT;
            if (wn_state == WAKENET_DETECTED)
            {
                ESP_LOGI(TAG, "检测到唤醒词 '你好小智'！");
@@ -447,21 +1219,24 @@ extern "C" void app_main(void)
                    websocket_client->sendText(start_msg);
                }
 
-               play_audio_with_stop(hi, hi_len, "欢迎音频");
+               play_prompt("hi", "欢迎音频");
 
                // 进入录音状态
                current_state = STATE_RECORDING;
                audio_manager->startRecording();
 
                // 初始化状态变量
-               vad_speech_detected = false;
-               vad_silence_frames = 0;
+               endpointer.reset();
+               uplink_quality.reset();
                is_continuous_conversation = false;
                user_started_speaking = false;
                recording_timeout_start = 0;
                is_realtime_streaming = false;
 
-               vad_reset_trigger(vad_inst);
+               reset_vad();
+
+               // 重连和欢迎音频是故意阻塞的，不算采集超时
+               capture_deadline->skip();
 
                ESP_LOGI(TAG, "开始录音，请说话...");
            }
@@ -471,57 +1246,53 @@ extern "C" void app_main(void)
            // 录音状态：记录用户说的话
            if (audio_manager->isRecording() && !audio_manager->isRecordingBufferFull())
            {
-               int samples = audio_chunksize / sizeof(int16_t);
-               audio_manager->addRecordingData(processed_audio, samples);
-
-               if (is_realtime_streaming && websocket_client != nullptr && websocket_client->isConnected()) {
-                   websocket_client->sendBinary((const uint8_t*)processed_audio, samples * sizeof(int16_t));
+               // 录音只记帧引用；已经在实时上传时不需要保留历史
+               audio_manager->addRecordingFrame(frame.get(), !is_realtime_streaming);
+
+               // 使用VAD检测用户是否在说话（先于发送：原地掩码发送会改写帧数据）
+               vad_state_t vad_state = model_manager->vad() != nullptr ?
+                   vad_process(model_manager->vad(), processed_audio, SAMPLE_RATE, 30) : VAD_SILENCE;
+               Endpointer::Event ep_event = endpointer.update(vad_state == VAD_SPEECH,
+                                                              audio_manager->getRecordingLength());
+               uplink_quality.addFrame(processed_audio, frame->sampleCount(), vad_state == VAD_SPEECH);
+
+               if (is_realtime_streaming && send_uplink_frame(frame.get(), portMAX_DELAY) < 0) {
+                   uplink_quality.addLost(1);
                }
 
-               // 使用VAD检测用户是否在说话
-               vad_state_t vad_state = vad_process(vad_inst, processed_audio, SAMPLE_RATE, 30);
-
                 if (vad_state == VAD_SPEECH) {
-                    vad_speech_detected = true;
-                    vad_silence_frames = 0;
                     user_started_speaking = true;
                     recording_timeout_start = 0;
 
                     if (!is_realtime_streaming) {
                         is_realtime_streaming = true;
                         ESP_LOGI(TAG, "检测到说话，补发前500ms数据并开始实时传输...");
-                        // 1. 计算需要回溯多少数据 (比如 500ms)
-                        // 500ms * 16000Hz = 8000 样本
+                        // 1. 回溯 500ms：500ms * 16000Hz = 8000 样本
                         const size_t PREROLL_SAMPLES = 8000; 
-                        // 每次最多发送 1000 样本 (2000 字节)，避免缓冲区溢出
+                        // 每补发约 1000 样本 (2000 字节) 停顿一下，避免缓冲区溢出
                         const size_t MAX_CHUNK_SAMPLES = 1000;
                         
-                        size_t current_len = 0;
-                        const int16_t* full_buffer = audio_manager->getRecordingBuffer(current_len);
-                        
-                        // 2. 计算起始位置
-                        size_t start_pos = 0;
-                        if (current_len > PREROLL_SAMPLES) {
-                            start_pos = current_len - PREROLL_SAMPLES;
+                        // 2. 从录音历史中取出最近的帧（历史同时清空，这些帧只剩这里的引用）
+                        AudioFrameRef preroll[AudioManager::RECORDING_HISTORY_FRAMES];
+                        size_t preroll_frames = audio_manager->takeRecentFrames(PREROLL_SAMPLES, preroll,
+                                                                                AudioManager::RECORDING_HISTORY_FRAMES);
+                        size_t send_samples = 0;
+                        for (size_t i = 0; i < preroll_frames; i++) {
+                            send_samples += preroll[i]->sampleCount();
                         }
                         
-                        // 3. 计算要发送的总长度
-                        size_t send_samples = current_len - start_pos;
-                        
-                        // 4. 【关键修复】分块发送，避免一次性发送太多导致断开
+                        // 3. 【关键修复】逐帧发送，避免一次性发送太多导致断开
+                        size_t sent_frames = 0;
                         if (send_samples > 0 && websocket_client != nullptr && websocket_client->isConnected()) {
                             size_t sent = 0;
+                            size_t since_pause = 0;
                             bool send_failed = false;
-                            while (sent < send_samples && websocket_client->isConnected() && !send_failed) {
-                                size_t chunk = (send_samples - sent > MAX_CHUNK_SAMPLES) ? 
-                                               MAX_CHUNK_SAMPLES : (send_samples - sent);
+                            for (size_t i = 0; i < preroll_frames && websocket_client->isConnected(); i++) {
+                                size_t chunk = preroll[i]->sampleCount();
                                 
                                 // 【关键】检查发送返回值，失败则停止
-                                int ret = websocket_client->sendBinary(
-                                    (const uint8_t*)(full_buffer + start_pos + sent), 
-                                    chunk * sizeof(int16_t),
-                                    500  // 500ms超时
-                                );
+                                int ret = send_uplink_frame(preroll[i].get(), 500);  // 500ms超时
+                                preroll[i].reset();
                                 
                                 if (ret < 0) {
                                     ESP_LOGW(TAG, "发送音频块失败 (%d)，停止补发", ret);
@@ -530,10 +1301,14 @@ extern "C" void app_main(void)
                                 }
                                 
                                 sent += chunk;
+                                sent_frames++;
+                                since_pause += chunk;
                                 
                                 // 增加延时，给服务器处理时间
-                                if (sent < send_samples && websocket_client->isConnected()) {
+                                if (since_pause >= MAX_CHUNK_SAMPLES && sent < send_samples &&
+                                    websocket_client->isConnected()) {
                                     vTaskDelay(pdMS_TO_TICKS(20)); // 增加到20ms
+                                    since_pause = 0;
                                 }
                             }
                             if (!send_failed) {
@@ -542,6 +1317,8 @@ extern "C" void app_main(void)
                                 ESP_LOGW(TAG, "补发中断，已发送 %zu/%zu 样本", sent, send_samples);
                             }
                         }
+                        // 没发出去的历史帧（发送失败、中途断链或根本没连上）都算丢帧
+                        uplink_quality.addLost(preroll_frames - sent_frames);
                     }
 
                    // 显示录音进度（每100ms显示一次）
@@ -552,50 +1329,42 @@ extern "C" void app_main(void)
                         last_log_time = current_time;
                     }
 
-               } else if (vad_state == VAD_SILENCE && vad_speech_detected) {
-                   vad_silence_frames++;
-
-                   if (vad_silence_frames >= VAD_SILENCE_FRAMES_REQUIRED) {
-                       ESP_LOGI(TAG, "VAD检测到用户说话结束，录音长度: %.2f 秒", audio_manager->getRecordingDuration());
-                       audio_manager->stopRecording();
-                       is_realtime_streaming = false;
-
-                       size_t rec_len = 0;
-                       audio_manager->getRecordingBuffer(rec_len);
-                       if (user_started_speaking && rec_len > SAMPLE_RATE / 4)
-                       {
-                           if (websocket_client != nullptr && websocket_client->isConnected()) {
-                               const char* end_msg = "{\"event\":\"recording_ended\"}";
-                               websocket_client->sendText(end_msg);
-                           }
-                           current_state = STATE_WAITING_RESPONSE;
-                           audio_manager->resetResponsePlayedFlag();
-                           ESP_LOGI(TAG, "等待服务器响应音频...");
-                       }
-                       else
-                       {
-                            ESP_LOGI(TAG, "录音时间过短或用户未说话，重新开始录音");
-                            // 发送录音取消事件
-                            if (websocket_client != nullptr && websocket_client->isConnected())
-                            {
-                                const char* cancel_msg = "{\"event\":\"recording_cancelled\"}";
-                                websocket_client->sendText(cancel_msg);
-                            }
-                            // 重新开始录音
-                            audio_manager->clearRecordingBuffer();
-                            audio_manager->startRecording();
-                            vad_speech_detected = false;
-                            vad_silence_frames = 0;
-                            user_started_speaking = false;
-                            is_realtime_streaming = !is_continuous_conversation;  // 只在非连续对话模式下开启流式传输
-                            if (is_continuous_conversation)
-                            {
-                                recording_timeout_start = xTaskGetTickCount();
-                            }
-                            vad_reset_trigger(vad_inst);
-                            // multinet->clean(mn_model_data);
-                        }
+               } else if (ep_event == Endpointer::Event::END_OF_TURN ||
+                          ep_event == Endpointer::Event::TOO_SHORT) {
+                   ESP_LOGI(TAG, "VAD检测到用户说话结束，录音长度: %.2f 秒", audio_manager->getRecordingDuration());
+                   audio_manager->stopRecording();
+                   is_realtime_streaming = false;
+
+                   if (ep_event == Endpointer::Event::END_OF_TURN)
+                   {
+                       send_recording_ended("end_of_turn");
+                       current_state = STATE_WAITING_RESPONSE;
+                       audio_manager->resetResponsePlayedFlag();
+                       ESP_LOGI(TAG, "等待服务器响应音频...");
                    }
+                   else
+                   {
+                        ESP_LOGI(TAG, "录音时间过短或用户未说话，重新开始录音");
+                        // 发送录音取消事件
+                        if (websocket_client != nullptr && websocket_client->isConnected())
+                        {
+                            const char* cancel_msg = "{\"event\":\"recording_cancelled\"}";
+                            websocket_client->sendText(cancel_msg);
+                        }
+                        // 重新开始录音
+                        audio_manager->clearRecordingBuffer();
+                        audio_manager->startRecording();
+                        endpointer.reset();
+                        uplink_quality.reset();
+                        user_started_speaking = false;
+                        is_realtime_streaming = !is_continuous_conversation;  // 只在非连续对话模式下开启流式传输
+                        if (is_continuous_conversation)
+                        {
+                            recording_timeout_start = xTaskGetTickCount();
+                        }
+                        reset_vad();
+                        // multinet->clean(mn_model_data);
+                    }
                }
            }
            else if (audio_manager->isRecordingBufferFull())
@@ -604,10 +1373,7 @@ extern "C" void app_main(void)
                audio_manager->stopRecording();
                is_realtime_streaming = false;
 
-               if (websocket_client != nullptr && websocket_client->isConnected()) {
-                   const char* end_msg = "{\"event\":\"recording_ended\"}";
-                   websocket_client->sendText(end_msg);
-               }
+               send_recording_ended("buffer_full");
                current_state = STATE_WAITING_RESPONSE;
                audio_manager->resetResponsePlayedFlag();
                ESP_LOGI(TAG, "等待服务器响应音频...");
@@ -647,15 +1413,7 @@ extern "C" void app_main(void)
                continue;  // 跳过本次循环，等待重连
            }
            
-           // 定期发送 ping 保活，防止 WebSocket 空闲断开
-           static TickType_t last_ping_time = 0;
-           TickType_t now = xTaskGetTickCount();
-           if (now - last_ping_time > pdMS_TO_TICKS(5000)) {  // 每5秒 ping 一次
-               if (websocket_client != nullptr && websocket_client->isConnected()) {
-                   websocket_client->sendPing();
-               }
-               last_ping_time = now;
-           }
+           // 保活与断链检测由WebSocketClient的心跳任务负责
            
            if (audio_manager->isResponsePlayed())
            {
@@ -671,14 +1429,14 @@ extern "C" void app_main(void)
                current_state = STATE_RECORDING;
                audio_manager->clearRecordingBuffer();
                audio_manager->startRecording();
-               vad_speech_detected = false;
-               vad_silence_frames = 0;
+               endpointer.reset();
+               uplink_quality.reset();
                is_continuous_conversation = true;
                user_started_speaking = false;
                recording_timeout_start = xTaskGetTickCount();
                is_realtime_streaming = false;
                audio_manager->resetResponsePlayedFlag();
-               vad_reset_trigger(vad_inst);
+               reset_vad();
                ESP_LOGI(TAG, "进入连续对话模式，请在%d秒内继续说话...", RECORDING_TIMEOUT_MS / 1000);
            }
         }  else if (current_state == STATE_PLAYING_FINISHED_WAITING) {
@@ -708,15 +1466,15 @@ extern "C" void app_main(void)
                 audio_manager->startRecording();
                 
                 // 重置所有计数器
-                vad_speech_detected = false;
-                vad_silence_frames = 0;
+                endpointer.reset();
+                uplink_quality.reset();
                 is_continuous_conversation = true; // 保持连续对话
                 user_started_speaking = false;
                 recording_timeout_start = xTaskGetTickCount(); // 【关键】现在才开始倒计时！
                 is_realtime_streaming = false;
                 
                 // 重置 VAD
-                vad_reset_trigger(vad_inst);
+                reset_vad();
                 
                 ESP_LOGI(TAG, "进入连续对话模式，请在10秒内继续说话...");
             } else {
@@ -747,8 +1505,8 @@ extern "C" void app_main(void)
                 current_state = STATE_WAITING_WAKEUP;
                 
                 // 重置所有状态
-                vad_speech_detected = false;
-                vad_silence_frames = 0;
+                endpointer.reset();
+                uplink_quality.reset();
                 is_continuous_conversation = false;
                 user_started_speaking = false;
                 recording_timeout_start = 0;
@@ -767,13 +1525,19 @@ extern "C" void app_main(void)
 cleanup:
    // 资源清理
    ESP_LOGI(TAG, "正在清理系统资源...");
-   if (vad_inst != NULL) vad_destroy(vad_inst);
-   if (model_data != NULL) wakenet->destroy(model_data);
-   if (buffer != NULL) free(buffer);
-   if (ns_out_buffer != NULL) free(ns_out_buffer);
-   // 注意：models 由 esp_srmodel_deinit 释放，但 esp-sr 库可能没有提供此函数
+   // 后台加载还没结束时先等它，模型管理器才能释放
+   if (models_ready != nullptr) {
+       xSemaphoreTake(models_ready, portMAX_DELAY);
+       vSemaphoreDelete(models_ready);
+   }
+   if (model_manager != nullptr) delete model_manager;
    if (websocket_client != nullptr) delete websocket_client;
+   if (server_selector != nullptr) delete server_selector;
+   if (flash_gate != nullptr) delete flash_gate;
+   if (udp_audio != nullptr) delete udp_audio;
+   if (hello != nullptr) delete hello;
    if (wifi_manager != nullptr) delete wifi_manager;
    if (audio_manager != nullptr) delete audio_manager;
+   if (capture_pool != nullptr) delete capture_pool;
    vTaskDelete(NULL);
 }
\ No newline at end of file
@@ -0,0 +1,160 @@
+/**
+ * @file memory_governor.cc
+ * @brief 🩺 内存调控器实现
+ */
+
+#include "memory_governor.h"
+#include <stdio.h>
+#include <string.h>
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+static const char *TAG = "MemGovernor";
+
+static const uint32_t REGION_CAPS[MemoryGovernor::REGION_COUNT] = {
+    MALLOC_CAP_INTERNAL,
+    MALLOC_CAP_DMA,
+    MALLOC_CAP_SPIRAM,
+};
+
+MemoryGovernor::MemoryGovernor(const Limits (&limits)[REGION_COUNT])
+    : level_(NORMAL)
+    , last_sample_us_(0)
+    , last_change_us_(0)
+    , calm_since_us_(0)
+    , reason_("")
+    , failed_alloc_(nullptr)
+    , alloc_failures_(0)
+    , escalations_(0)
+    , recoveries_(0)
+    , telemetry_pending_(false)
+{
+    memcpy(limits_, limits, sizeof(limits_));
+    memset(stats_, 0, sizeof(stats_));
+    sample();
+}
+
+const char* MemoryGovernor::levelName(Level level)
+{
+    static const char* const NAMES[LEVEL_COUNT] = { "normal", "trim_caches", "no_ns", "small_ring" };
+    return NAMES[level];
+}
+
+const char* MemoryGovernor::regionName(Region region)
+{
+    static const char* const NAMES[REGION_COUNT] = { "internal", "dma", "psram" };
+    return NAMES[region];
+}
+
+void MemoryGovernor::sample()
+{
+    for (int r = 0; r < REGION_COUNT; r++) {
+        stats_[r].free = heap_caps_get_free_size(REGION_CAPS[r]);
+        stats_[r].largest = heap_caps_get_largest_free_block(REGION_CAPS[r]);
+        stats_[r].min_free = heap_caps_get_minimum_free_size(REGION_CAPS[r]);
+    }
+}
+
+MemoryGovernor::Region MemoryGovernor::pressured(size_t scale) const
+{
+    for (int r = 0; r < REGION_COUNT; r++) {
+        // 没有这类内存（比如没焊PSRAM）时不参与判断
+        if (limits_[r].free_low == 0 || (stats_[r].free == 0 && stats_[r].min_free == 0)) {
+            continue;
+        }
+        if (stats_[r].free < limits_[r].free_low * scale || stats_[r].largest < limits_[r].block_low * scale) {
+            return (Region)r;
+        }
+    }
+    return REGION_COUNT;
+}
+
+bool MemoryGovernor::update()
+{
+    // 分配失败也等到下一次采样再处理：查最大连续块要遍历堆，不能每帧都查
+    int64_t now = esp_timer_get_time();
+    if (now - last_sample_us_ < (int64_t)SAMPLE_INTERVAL_MS * 1000) {
+        return false;
+    }
+    const char* failed = failed_alloc_;
+    last_sample_us_ = now;
+    sample();
+
+    Region tight = pressured(1);
+    bool want_more = failed != nullptr || tight != REGION_COUNT;
+    if (want_more) {
+        calm_since_us_ = 0;
+        if (level_ + 1 < LEVEL_COUNT && now - last_change_us_ >= (int64_t)ESCALATE_INTERVAL_MS * 1000) {
+            failed_alloc_ = nullptr;
+            reason_ = failed != nullptr ? failed : regionName(tight);
+            level_ = (Level)(level_ + 1);
+            last_change_us_ = now;
+            escalations_++;
+            telemetry_pending_ = true;
+            ESP_LOGW(TAG, "内存紧张（%s），降级到 %s", reason_, levelName(level_));
+            report();
+            return true;
+        }
+        if (level_ + 1 >= LEVEL_COUNT) {
+            failed_alloc_ = nullptr;        // 已经降到底了，失败只计数
+        }
+        return false;
+    }
+
+    // 全部高于两倍下限并持续一段时间才恢复一级，避免在门限附近来回切换
+    if (level_ == NORMAL || pressured(2) != REGION_COUNT) {
+        calm_since_us_ = 0;
+        return false;
+    }
+    if (calm_since_us_ == 0) {
+        calm_since_us_ = now;
+        return false;
+    }
+    if (now - calm_since_us_ < (int64_t)RECOVER_MS * 1000) {
+        return false;
+    }
+    level_ = (Level)(level_ - 1);
+    last_change_us_ = now;
+    calm_since_us_ = now;
+    recoveries_++;
+    reason_ = "recovered";
+    telemetry_pending_ = true;
+    ESP_LOGI(TAG, "内存恢复，升级到 %s", levelName(level_));
+    return true;
+}
+
+void MemoryGovernor::noteAllocationFailure(const char* what)
+{
+    alloc_failures_ = alloc_failures_ + 1;
+    failed_alloc_ = what;
+}
+
+int MemoryGovernor::formatTelemetry(char* buf, size_t len) const
+{
+    int n = snprintf(buf, len,
+                     "{\"event\":\"memory_pressure\",\"level\":%d,\"name\":\"%s\",\"reason\":\"%s\"",
+                     (int)level_, levelName(level_), reason_);
+    for (int r = 0; r < REGION_COUNT && n > 0 && (size_t)n < len; r++) {
+        n += snprintf(buf + n, len - n, ",\"%s\":{\"free\":%lu,\"largest\":%lu,\"min\":%lu}",
+                      regionName((Region)r), (unsigned long)stats_[r].free,
+                      (unsigned long)stats_[r].largest, (unsigned long)stats_[r].min_free);
+    }
+    if (n > 0 && (size_t)n < len) {
+        n += snprintf(buf + n, len - n, ",\"escalations\":%lu,\"recoveries\":%lu,\"alloc_failures\":%lu}",
+                      (unsigned long)escalations_, (unsigned long)recoveries_,
+                      (unsigned long)alloc_failures_);
+    }
+    return n;
+}
+
+void MemoryGovernor::report() const
+{
+    ESP_LOGI(TAG, "内存级别 %s（降级 %lu 次，恢复 %lu 次，分配失败 %lu 次）", levelName(level_),
+             (unsigned long)escalations_, (unsigned long)recoveries_, (unsigned long)alloc_failures_);
+    for (int r = 0; r < REGION_COUNT; r++) {
+        ESP_LOGI(TAG, "  %-8s 空闲 %6zu KB, 最大块 %6zu KB, 水位 %6zu KB（下限 %zu / %zu KB）",
+                 regionName((Region)r), stats_[r].free / 1024, stats_[r].largest / 1024,
+                 stats_[r].min_free / 1024, limits_[r].free_low / 1024, limits_[r].block_low / 1024);
+    }
+}
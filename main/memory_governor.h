@@ -0,0 +1,129 @@
+/**
+ * @file memory_governor.h
+ * @brief 🩺 内存调控器 - 按内存压力逐级关掉可选功能，赶在分配失败之前
+ *
+ * 内存不足以前表现为硬失败："流式播放缓冲区分配失败"、收到文本帧时拷贝分配失败、模型加载失败。
+ * 调控器定期检查三类内存的空闲量和最大连续块：
+ *
+ * - 内部RAM（MALLOC_CAP_INTERNAL）：任务栈、文本帧拷贝、esp-sr 的部分状态
+ * - DMA可用内存（MALLOC_CAP_DMA）：采集帧池、I2S/GDMA缓冲区
+ * - PSRAM（MALLOC_CAP_SPIRAM）：模型、流式播放环形缓冲区
+ *
+ * 任何一类低于下限（或有人报告了分配失败）就升一级，每次只升一级，隔 ESCALATE_INTERVAL_MS
+ * 再看上一级的效果；所有类都高于下限的两倍并持续 RECOVER_MS 才降一级。级别依次是：
+ *
+ *   NORMAL       正常
+ *   TRIM_CACHES  卸载当前状态用不到的模型（平时它们留着，下次用不必重新加载）
+ *   NO_NS        关掉降噪并卸载降噪模型
+ *   SMALL_RING   流式播放环形缓冲区缩到 AudioManager::STREAMING_BUFFER_MIN（空闲时才重新分配）
+ *
+ * 调控器只决定级别，各级的动作由主程序执行（降噪开关、模型、环形缓冲区都在主程序手里）。
+ * 固件没有编解码器，所以没有"降低编码复杂度"这一级。
+ * 级别变化和内存水位作为遥测发给服务器，见 formatTelemetry()。
+ */
+
+#ifndef MEMORY_GOVERNOR_H
+#define MEMORY_GOVERNOR_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+class MemoryGovernor {
+public:
+    enum Level {
+        NORMAL = 0,
+        TRIM_CACHES,
+        NO_NS,
+        SMALL_RING,
+        LEVEL_COUNT
+    };
+
+    enum Region {
+        INTERNAL = 0,
+        DMA,
+        PSRAM,
+        REGION_COUNT
+    };
+
+    struct Limits {
+        size_t free_low;            // 空闲低于此值算紧张
+        size_t block_low;           // 最大连续块低于此值算紧张（碎片化）
+    };
+
+    struct RegionStats {
+        size_t free;                // 最近一次检查的空闲量
+        size_t largest;             // 最近一次检查的最大连续块
+        size_t min_free;            // 启动以来的最低空闲量（水位）
+    };
+
+    static constexpr uint32_t SAMPLE_INTERVAL_MS = 1000;
+    static constexpr uint32_t ESCALATE_INTERVAL_MS = 2000;
+    static constexpr uint32_t RECOVER_MS = 30000;
+
+    /**
+     * @param limits 每类内存的下限，按 Region 顺序
+     */
+    explicit MemoryGovernor(const Limits (&limits)[REGION_COUNT]);
+
+    /**
+     * @brief 定期调用（主循环每帧调用即可，内部按 SAMPLE_INTERVAL_MS 节流）
+     *
+     * @return 级别有变化返回 true，新级别用 level() 读
+     */
+    bool update();
+
+    /**
+     * @brief 报告一次分配失败（任何任务都可以调用），下一次采样时直接升级
+     *
+     * @param what 失败的分配，用于日志和遥测
+     */
+    void noteAllocationFailure(const char* what);
+
+    Level level() const { return level_; }
+    RegionStats stats(Region r) const { return stats_[r]; }
+    uint32_t escalations() const { return escalations_; }
+    uint32_t recoveries() const { return recoveries_; }
+    uint32_t allocationFailures() const { return alloc_failures_; }
+
+    /**
+     * @brief 有还没发给服务器的级别变化
+     */
+    bool telemetryPending() const { return telemetry_pending_; }
+    void clearTelemetryPending() { telemetry_pending_ = false; }
+
+    /**
+     * @brief 生成遥测JSON：{"event":"memory_pressure","level":..,"name":..,"reason":..,
+     *        "internal":{"free":..,"largest":..,"min":..},"dma":{...},"psram":{...},...}（字节）
+     *
+     * @return 写入的长度（不含'\0'），缓冲区不够时截断
+     */
+    int formatTelemetry(char* buf, size_t len) const;
+
+    /**
+     * @brief 输出当前级别和每类内存的空闲、最大块、水位
+     */
+    void report() const;
+
+    static const char* levelName(Level level);
+    static const char* regionName(Region region);
+
+private:
+    void sample();
+    // 返回第一类低于下限的内存，没有返回 REGION_COUNT
+    Region pressured(size_t scale) const;
+
+    Limits limits_[REGION_COUNT];
+    RegionStats stats_[REGION_COUNT];
+    Level level_;
+    int64_t last_sample_us_;
+    int64_t last_change_us_;
+    int64_t calm_since_us_;             // 所有类都高于两倍下限的起始时刻，0=现在不满足
+    const char* reason_;                // 最近一次升级的原因
+    const char* volatile failed_alloc_; // 未处理的分配失败
+    volatile uint32_t alloc_failures_;
+    uint32_t escalations_;
+    uint32_t recoveries_;
+    bool telemetry_pending_;
+};
+
+#endif // MEMORY_GOVERNOR_H
@@ -0,0 +1,265 @@
+/**
+ * @file model_manager.cc
+ * @brief 🧠 语音模型生命周期管理实现
+ */
+
+#include "model_manager.h"
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+
+extern "C" {
+#include "esp_wn_models.h"
+#include "esp_mn_models.h"
+#include "esp_nsn_models.h"
+}
+
+static const char *TAG = "ModelManager";
+
+ModelManager::ModelManager(uint32_t sample_rate, size_t psram_reserve, size_t internal_reserve)
+    : sample_rate_(sample_rate)
+    , psram_reserve_(psram_reserve)
+    , internal_reserve_(internal_reserve)
+    , models_(nullptr)
+    , wakenet_(nullptr)
+    , wakenet_data_(nullptr)
+    , vad_(nullptr)
+    , ns_(nullptr)
+    , ns_data_(nullptr)
+    , multinet_(nullptr)
+    , multinet_data_(nullptr)
+{
+    memset(stats_, 0, sizeof(stats_));
+}
+
+ModelManager::~ModelManager()
+{
+    for (int m = 0; m < MODEL_COUNT; m++) {
+        release((Model)m);
+    }
+}
+
+const char* ModelManager::modelLabel(Model m)
+{
+    static const char* const LABELS[MODEL_COUNT] = { "wakenet", "vad", "ns", "multinet" };
+    return LABELS[m];
+}
+
+bool ModelManager::underPressure() const
+{
+    return heap_caps_get_free_size(MALLOC_CAP_SPIRAM) < psram_reserve_ ||
+           heap_caps_get_free_size(MALLOC_CAP_INTERNAL) < internal_reserve_;
+}
+
+esp_err_t ModelManager::require(uint32_t mask)
+{
+    if (underPressure()) {
+        trim(mask);
+    }
+    esp_err_t first_error = ESP_OK;
+    for (int m = 0; m < MODEL_COUNT; m++) {
+        if ((mask & bit((Model)m)) == 0 || stats_[m].loaded) {
+            continue;
+        }
+        esp_err_t ret = load((Model)m);
+        if (ret != ESP_OK && first_error == ESP_OK) {
+            first_error = ret;
+        }
+    }
+    return first_error;
+}
+
+int ModelManager::trim(uint32_t keep, bool force)
+{
+    int released = 0;
+    // 先卸最重的：命令词、降噪、唤醒词（和枚举顺序相反）
+    for (int m = MODEL_COUNT - 1; m >= 0 && (force || underPressure()); m--) {
+        if (!stats_[m].loaded || !isHeavy((Model)m) || (keep & bit((Model)m)) != 0) {
+            continue;
+        }
+        ESP_LOGW(TAG, "内存紧张（PSRAM %zu KB / 内部 %zu KB 可用），卸载 %s",
+                 heap_caps_get_free_size(MALLOC_CAP_SPIRAM) / 1024,
+                 heap_caps_get_free_size(MALLOC_CAP_INTERNAL) / 1024, modelLabel((Model)m));
+        release((Model)m);
+        released++;
+    }
+    return released;
+}
+
+esp_err_t ModelManager::openPartition()
+{
+    if (models_ != nullptr) {
+        return ESP_OK;
+    }
+    models_ = esp_srmodel_init("model");
+    if (models_ == nullptr) {
+        ESP_LOGE(TAG, "模型分区初始化失败");
+        return ESP_ERR_NOT_FOUND;
+    }
+    return ESP_OK;
+}
+
+void ModelManager::closePartitionIfUnused()
+{
+    if (models_ == nullptr) {
+        return;
+    }
+    for (int m = 0; m < MODEL_COUNT; m++) {
+        if (stats_[m].loaded && usesModelPartition((Model)m)) {
+            return;
+        }
+    }
+    esp_srmodel_deinit(models_);
+    models_ = nullptr;
+}
+
+esp_err_t ModelManager::load(Model m)
+{
+    size_t internal_before = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    size_t psram_before = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+    int64_t start_us = esp_timer_get_time();
+
+    esp_err_t ret = usesModelPartition(m) ? openPartition() : ESP_OK;
+    if (ret == ESP_OK) {
+        ret = create(m);
+    }
+    if (ret != ESP_OK) {
+        closePartitionIfUnused();
+        return ret;
+    }
+
+    ModelStats& s = stats_[m];
+    s.loaded = true;
+    s.loads++;
+    s.load_us = (uint32_t)(esp_timer_get_time() - start_us);
+    s.internal_bytes = (int32_t)(internal_before - heap_caps_get_free_size(MALLOC_CAP_INTERNAL));
+    s.psram_bytes = (int32_t)(psram_before - heap_caps_get_free_size(MALLOC_CAP_SPIRAM));
+    ESP_LOGI(TAG, "加载 %s: %lu ms, 内部RAM %ld KB, PSRAM %ld KB", modelLabel(m),
+             (unsigned long)(s.load_us / 1000), (long)(s.internal_bytes / 1024), (long)(s.psram_bytes / 1024));
+    return ESP_OK;
+}
+
+esp_err_t ModelManager::create(Model m)
+{
+    switch (m) {
+    case WAKENET: {
+        char* name = esp_srmodel_filter(models_, ESP_WN_PREFIX, NULL);
+        if (name == nullptr) {
+            ESP_LOGE(TAG, "未找到任何唤醒词模型！");
+            return ESP_ERR_NOT_FOUND;
+        }
+        wakenet_ = (esp_wn_iface_t *)esp_wn_handle_from_name(name);
+        if (wakenet_ == nullptr) {
+            ESP_LOGE(TAG, "获取唤醒词接口失败，模型: %s", name);
+            return ESP_ERR_NOT_FOUND;
+        }
+        wakenet_data_ = wakenet_->create(name, DET_MODE_90);
+        if (wakenet_data_ == nullptr) {
+            ESP_LOGE(TAG, "创建唤醒词模型数据失败");
+            wakenet_ = nullptr;
+            return ESP_ERR_NO_MEM;
+        }
+        ESP_LOGI(TAG, "唤醒词模型: %s", name);
+        return ESP_OK;
+    }
+    case VAD:
+        vad_ = vad_create_with_param(VAD_MODE_1, sample_rate_, 30, 200, 1000);
+        if (vad_ == nullptr) {
+            ESP_LOGE(TAG, "创建VAD实例失败");
+            return ESP_ERR_NO_MEM;
+        }
+        return ESP_OK;
+    case NS: {
+        char* name = esp_srmodel_filter(models_, ESP_NSNET_PREFIX, NULL);
+        if (name == nullptr) {
+            ESP_LOGE(TAG, "未找到降噪模型");
+            return ESP_ERR_NOT_FOUND;
+        }
+        ns_ = (esp_nsn_iface_t *)esp_nsnet_handle_from_name(name);
+        if (ns_ == nullptr) {
+            ESP_LOGE(TAG, "获取降噪接口失败，模型: %s", name);
+            return ESP_ERR_NOT_FOUND;
+        }
+        ns_data_ = ns_->create(name);
+        if (ns_data_ == nullptr) {
+            ESP_LOGE(TAG, "创建降噪模型数据失败");
+            ns_ = nullptr;
+            return ESP_ERR_NO_MEM;
+        }
+        return ESP_OK;
+    }
+    case MULTINET: {
+        char* name = esp_srmodel_filter(models_, ESP_MN_PREFIX, NULL);
+        if (name == nullptr) {
+            ESP_LOGE(TAG, "未找到命令词模型");
+            return ESP_ERR_NOT_FOUND;
+        }
+        multinet_ = (esp_mn_iface_t *)esp_mn_handle_from_name(name);
+        if (multinet_ == nullptr) {
+            ESP_LOGE(TAG, "获取命令词接口失败，模型: %s", name);
+            return ESP_ERR_NOT_FOUND;
+        }
+        multinet_data_ = multinet_->create(name, MULTINET_TIMEOUT_MS);
+        if (multinet_data_ == nullptr) {
+            ESP_LOGE(TAG, "创建命令词模型数据失败");
+            multinet_ = nullptr;
+            return ESP_ERR_NO_MEM;
+        }
+        return ESP_OK;
+    }
+    default:
+        return ESP_ERR_INVALID_ARG;
+    }
+}
+
+void ModelManager::destroy(Model m)
+{
+    switch (m) {
+    case WAKENET:
+        wakenet_->destroy(wakenet_data_);
+        wakenet_ = nullptr;
+        wakenet_data_ = nullptr;
+        break;
+    case VAD:
+        vad_destroy(vad_);
+        vad_ = nullptr;
+        break;
+    case NS:
+        ns_->destroy(ns_data_);
+        ns_ = nullptr;
+        ns_data_ = nullptr;
+        break;
+    case MULTINET:
+        multinet_->destroy(multinet_data_);
+        multinet_ = nullptr;
+        multinet_data_ = nullptr;
+        break;
+    default:
+        break;
+    }
+}
+
+void ModelManager::release(Model m)
+{
+    if (!stats_[m].loaded) {
+        return;
+    }
+    destroy(m);
+    stats_[m].loaded = false;
+    closePartitionIfUnused();
+    ESP_LOGI(TAG, "卸载 %s", modelLabel(m));
+}
+
+void ModelManager::report() const
+{
+    for (int m = 0; m < MODEL_COUNT; m++) {
+        const ModelStats& s = stats_[m];
+        if (s.loads == 0) {
+            continue;
+        }
+        ESP_LOGI(TAG, "%-8s %s, 加载 %lu 次, 最近一次 %lu ms, 内部RAM %ld KB, PSRAM %ld KB",
+                 modelLabel((Model)m), s.loaded ? "已加载" : "已卸载", (unsigned long)s.loads,
+                 (unsigned long)(s.load_us / 1000), (long)(s.internal_bytes / 1024), (long)(s.psram_bytes / 1024));
+    }
+}
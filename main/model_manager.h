@@ -0,0 +1,134 @@
+/**
+ * @file model_manager.h
+ * @brief 🧠 语音模型生命周期管理 - 按状态懒加载，内存紧张时卸载
+ *
+ * 原来 app_main 一次性加载唤醒词模型，再也不释放，esp_srmodel_init 也没有对应的 deinit；
+ * 再加上命令词、降噪模型就会全部常驻PSRAM。模型管理器持有所有模型句柄：
+ *
+ * - 状态机每次切换状态时用 require() 声明这个状态需要哪些模型，缺的当场加载
+ * - 不再需要的模型先留着（下次用不用重新加载），剩余内存低于预留值时才卸载重模型
+ * - 模型分区（esp_srmodel_init）在第一个需要它的模型加载时打开，最后一个卸载时关闭
+ * - 每个模型记录加载次数、加载耗时和占用的内部RAM/PSRAM，report() 输出
+ *
+ * 内存占用是加载前后空闲堆的差值，加载期间别的任务也在分配时会有误差，只作参考。
+ * 不加锁：启动时初始模型在后台任务里加载，主循环开始前等它结束；之后只在主循环里调用。
+ */
+
+#ifndef MODEL_MANAGER_H
+#define MODEL_MANAGER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+extern "C" {
+#include "esp_wn_iface.h"
+#include "esp_mn_iface.h"
+#include "esp_nsn_iface.h"
+#include "esp_vad.h"
+#include "model_path.h"
+}
+
+class ModelManager {
+public:
+    enum Model {
+        WAKENET = 0,    // 唤醒词（重，PSRAM）
+        VAD,            // 语音活动检测（轻，常驻）
+        NS,             // 降噪（重）
+        MULTINET,       // 命令词（重，目前没有状态需要）
+        MODEL_COUNT
+    };
+
+    static constexpr uint32_t bit(Model m) { return 1u << m; }
+
+    struct ModelStats {
+        bool loaded;
+        uint32_t loads;             // 加载次数（卸载后重新加载会增加）
+        uint32_t load_us;           // 最近一次加载耗时
+        int32_t internal_bytes;     // 最近一次加载占用的内部RAM
+        int32_t psram_bytes;        // 最近一次加载占用的PSRAM
+    };
+
+    /**
+     * @param sample_rate VAD采样率
+     * @param psram_reserve PSRAM空闲低于这个值算内存紧张
+     * @param internal_reserve 内部RAM空闲低于这个值算内存紧张
+     */
+    ModelManager(uint32_t sample_rate, size_t psram_reserve, size_t internal_reserve);
+    ~ModelManager();
+
+    /**
+     * @brief 声明当前需要的模型，缺的立即加载
+     *
+     * 内存紧张时先卸载不在 mask 里的重模型再加载。
+     *
+     * @param mask bit(Model) 的组合
+     * @return ESP_OK=全部就绪，否则是第一个加载失败的错误（其余模型照常加载）
+     */
+    esp_err_t require(uint32_t mask);
+
+    /**
+     * @brief 卸载一个模型（没加载时什么也不做）
+     */
+    void release(Model m);
+
+    /**
+     * @brief 内存紧张时卸载不在 keep 里的重模型
+     *
+     * @param force true=不管剩余内存，卸载所有不在 keep 里的重模型（内存调控器降级时用）
+     * @return 卸载的模型个数
+     */
+    int trim(uint32_t keep, bool force = false);
+
+    /**
+     * @brief 剩余内存是否低于预留值
+     */
+    bool underPressure() const;
+
+    bool isLoaded(Model m) const { return stats_[m].loaded; }
+    ModelStats getStats(Model m) const { return stats_[m]; }
+
+    // 模型句柄，没加载时为 nullptr
+    esp_wn_iface_t* wakenet() const { return wakenet_; }
+    model_iface_data_t* wakenetData() const { return wakenet_data_; }
+    vad_handle_t vad() const { return vad_; }
+    esp_nsn_iface_t* ns() const { return ns_; }
+    esp_nsn_data_t* nsData() const { return ns_data_; }
+    esp_mn_iface_t* multinet() const { return multinet_; }
+    model_iface_data_t* multinetData() const { return multinet_data_; }
+
+    /**
+     * @brief 输出每个加载过的模型的状态、加载耗时和内存占用
+     */
+    void report() const;
+
+private:
+    static constexpr int MULTINET_TIMEOUT_MS = 6000;    // 命令词识别超时
+
+    static const char* modelLabel(Model m);
+    static bool usesModelPartition(Model m) { return m != VAD; }
+    static bool isHeavy(Model m) { return m != VAD; }
+
+    esp_err_t load(Model m);
+    esp_err_t create(Model m);
+    void destroy(Model m);
+    esp_err_t openPartition();
+    void closePartitionIfUnused();
+
+    uint32_t sample_rate_;
+    size_t psram_reserve_;
+    size_t internal_reserve_;
+
+    srmodel_list_t* models_;
+    esp_wn_iface_t* wakenet_;
+    model_iface_data_t* wakenet_data_;
+    vad_handle_t vad_;
+    esp_nsn_iface_t* ns_;
+    esp_nsn_data_t* ns_data_;
+    esp_mn_iface_t* multinet_;
+    model_iface_data_t* multinet_data_;
+
+    ModelStats stats_[MODEL_COUNT];
+};
+
+#endif // MODEL_MANAGER_H
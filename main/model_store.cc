@@ -0,0 +1,180 @@
+/**
+ * @file model_store.cc
+ * @brief 🗄️ 模型仓库实现
+ */
+
+#include "model_store.h"
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_rom_crc.h"
+#include "nvs.h"
+
+static const char *TAG = "ModelStore";
+
+ModelStore::ModelStore()
+    : base_(nullptr)
+    , mmap_handle_(0)
+    , open_us_(0)
+    , fully_verified_(false)
+{
+}
+
+ModelStore::~ModelStore()
+{
+    close();
+}
+
+esp_err_t ModelStore::checkLayout(size_t partition_size) const
+{
+    const Header* h = header();
+    if (h->magic != MAGIC) {
+        ESP_LOGE(TAG, "不是模型仓库镜像（magic 0x%08lx）", (unsigned long)h->magic);
+        return ESP_ERR_INVALID_VERSION;
+    }
+    if (h->version != VERSION) {
+        ESP_LOGE(TAG, "镜像版本 %u 不支持（需要 %u）", h->version, VERSION);
+        return ESP_ERR_INVALID_VERSION;
+    }
+    size_t index_end = sizeof(Header) + (size_t)h->entry_count * sizeof(Entry);
+    if (h->image_size > partition_size || h->data_offset < index_end || h->data_offset > h->image_size) {
+        ESP_LOGE(TAG, "镜像大小 %lu 字节和分区（%zu 字节）不符", (unsigned long)h->image_size, partition_size);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    uint32_t index_crc = esp_rom_crc32_le(0, (const uint8_t*)entries(), h->entry_count * sizeof(Entry));
+    if (index_crc != h->index_crc32) {
+        ESP_LOGE(TAG, "索引表CRC错误");
+        return ESP_ERR_INVALID_CRC;
+    }
+    for (uint16_t i = 0; i < h->entry_count; i++) {
+        const Entry& e = entries()[i];
+        if (e.name[NAME_LEN - 1] != '\0' || e.offset < h->data_offset ||
+            e.offset > h->image_size || e.size > h->image_size - e.offset) {
+            ESP_LOGE(TAG, "索引项 %u 越界", i);
+            return ESP_ERR_INVALID_SIZE;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t ModelStore::verifyDataOnce(const char* partition_label)
+{
+    const Header* h = header();
+    nvs_handle_t nvs;
+    bool have_nvs = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs) == ESP_OK;
+    uint32_t verified_crc = 0;
+    if (have_nvs && nvs_get_u32(nvs, partition_label, &verified_crc) == ESP_OK &&
+        verified_crc == h->data_crc32) {
+        nvs_close(nvs);
+        return ESP_OK;
+    }
+
+    // 新镜像（或NVS被清过）：整个数据区读一遍
+    uint32_t crc = esp_rom_crc32_le(0, base_ + h->data_offset, h->image_size - h->data_offset);
+    fully_verified_ = true;
+    if (crc != h->data_crc32) {
+        ESP_LOGE(TAG, "数据区CRC错误（0x%08lx，应为 0x%08lx）", (unsigned long)crc, (unsigned long)h->data_crc32);
+        if (have_nvs) {
+            nvs_close(nvs);
+        }
+        return ESP_ERR_INVALID_CRC;
+    }
+    if (have_nvs) {
+        nvs_set_u32(nvs, partition_label, h->data_crc32);
+        nvs_commit(nvs);
+        nvs_close(nvs);
+    }
+    return ESP_OK;
+}
+
+esp_err_t ModelStore::open(const char* partition_label)
+{
+    close();
+    fully_verified_ = false;
+    int64_t start_us = esp_timer_get_time();
+
+    const esp_partition_t* part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY,
+                                                           partition_label);
+    if (part == nullptr) {
+        ESP_LOGW(TAG, "没有 %s 分区", partition_label);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    // 先只映射文件头拿到镜像大小，再映射整个镜像
+    const void* ptr = nullptr;
+    esp_err_t ret = esp_partition_mmap(part, 0, sizeof(Header), ESP_PARTITION_MMAP_DATA, &ptr, &mmap_handle_);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "映射 %s 失败: %s", partition_label, esp_err_to_name(ret));
+        return ret;
+    }
+    uint32_t image_size = ((const Header*)ptr)->image_size;
+    bool plausible = ((const Header*)ptr)->magic == MAGIC && image_size >= sizeof(Header) && image_size <= part->size;
+    esp_partition_munmap(mmap_handle_);
+    if (!plausible) {
+        ESP_LOGW(TAG, "%s 分区里没有模型仓库镜像", partition_label);
+        return ESP_ERR_INVALID_VERSION;
+    }
+
+    ret = esp_partition_mmap(part, 0, image_size, ESP_PARTITION_MMAP_DATA, &ptr, &mmap_handle_);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "映射 %s 失败: %s", partition_label, esp_err_to_name(ret));
+        return ret;
+    }
+    base_ = (const uint8_t*)ptr;
+
+    ret = checkLayout(part->size);
+    if (ret == ESP_OK) {
+        ret = verifyDataOnce(partition_label);
+    }
+    if (ret != ESP_OK) {
+        close();
+        return ret;
+    }
+
+    open_us_ = (uint32_t)(esp_timer_get_time() - start_us);
+    ESP_LOGI(TAG, "%s: %u 项, %lu KB, 打开 %lu us%s", partition_label, header()->entry_count,
+             (unsigned long)(image_size / 1024), (unsigned long)open_us_,
+             fully_verified_ ? "（新镜像，已校验数据区）" : "");
+    return ESP_OK;
+}
+
+void ModelStore::close()
+{
+    if (base_ == nullptr) {
+        return;
+    }
+    esp_partition_munmap(mmap_handle_);
+    base_ = nullptr;
+    mmap_handle_ = 0;
+}
+
+bool ModelStore::find(const char* name, Blob* out) const
+{
+    if (!isOpen()) {
+        return false;
+    }
+    // 索引只有几项，线性查找就够了
+    for (uint16_t i = 0; i < header()->entry_count; i++) {
+        const Entry& e = entries()[i];
+        if (strncmp(e.name, name, NAME_LEN) == 0) {
+            out->data = base_ + e.offset;
+            out->size = e.size;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ModelStore::verify(const char* name) const
+{
+    if (!isOpen()) {
+        return false;
+    }
+    for (uint16_t i = 0; i < header()->entry_count; i++) {
+        const Entry& e = entries()[i];
+        if (strncmp(e.name, name, NAME_LEN) == 0) {
+            return esp_rom_crc32_le(0, base_ + e.offset, e.size) == e.crc32;
+        }
+    }
+    return false;
+}
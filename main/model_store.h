@@ -0,0 +1,105 @@
+/**
+ * @file model_store.h
+ * @brief 🗄️ 模型仓库 - 直接从flash映射使用的打包镜像
+ *
+ * 一个分区里放一个镜像：文件头 + 索引表 + 按64字节对齐的数据块，
+ * 由 tools/model_pack/pack_models.py 在主机上打包。设备上整块映射到地址空间（esp_partition_mmap），
+ * find() 返回的指针直接指向flash映射，不拷贝到RAM，也不经过文件系统。
+ *
+ * 校验分两级：
+ * - 每次打开都检查文件头和索引表（索引表有自己的CRC32，只有几百字节）
+ * - 数据区的CRC32很贵（要把整个镜像从flash读一遍），只在镜像第一次出现时算一次，
+ *   通过后把镜像的CRC记进NVS，以后启动看到同一个镜像就跳过
+ *
+ * 所有多字节字段都是小端，和 pack_models.py 的 struct 格式一一对应。
+ */
+
+#ifndef MODEL_STORE_H
+#define MODEL_STORE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "esp_partition.h"
+
+class ModelStore {
+public:
+    static constexpr uint32_t MAGIC = 0x5254534D;       // "MSTR"
+    static constexpr uint16_t VERSION = 1;
+    static constexpr size_t NAME_LEN = 32;
+
+    struct Header {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t entry_count;
+        uint32_t data_offset;       // 第一个数据块的偏移（文件头 + 索引表之后，已对齐）
+        uint32_t image_size;        // 整个镜像的字节数
+        uint32_t data_crc32;        // [data_offset, image_size) 的CRC32
+        uint32_t index_crc32;       // 索引表的CRC32
+        uint32_t alignment;         // 数据块对齐（字节）
+        uint8_t reserved[36];
+    };
+
+    struct Entry {
+        char name[NAME_LEN];        // 以0结尾
+        uint32_t offset;            // 相对镜像开头
+        uint32_t size;
+        uint32_t crc32;             // 这一块的CRC32，verify() 用
+        uint32_t flags;             // 保留
+    };
+
+    static_assert(sizeof(Header) == 64, "文件头格式和打包工具不一致");
+    static_assert(sizeof(Entry) == 48, "索引项格式和打包工具不一致");
+
+    struct Blob {
+        const uint8_t* data;        // 指向flash映射，只读
+        size_t size;
+    };
+
+    ModelStore();
+    ~ModelStore();
+
+    /**
+     * @brief 映射分区里的镜像并检查
+     *
+     * @param partition_label 分区名
+     * @return ESP_OK=可以使用，ESP_ERR_NOT_FOUND=没有这个分区，
+     *         ESP_ERR_INVALID_VERSION / ESP_ERR_INVALID_CRC / ESP_ERR_INVALID_SIZE=镜像不对
+     */
+    esp_err_t open(const char* partition_label);
+
+    /**
+     * @brief 解除映射，之前 find() 得到的指针全部失效
+     */
+    void close();
+
+    /**
+     * @brief 按名字查找数据块
+     */
+    bool find(const char* name, Blob* out) const;
+
+    /**
+     * @brief 单独校验一块数据的CRC32（数据区整体已经校验过时一般不需要）
+     */
+    bool verify(const char* name) const;
+
+    bool isOpen() const { return base_ != nullptr; }
+    uint16_t entryCount() const { return isOpen() ? header()->entry_count : 0; }
+    uint32_t openUs() const { return open_us_; }
+    bool fullyVerified() const { return fully_verified_; }
+
+private:
+    static constexpr const char* NVS_NAMESPACE = "model_store";
+
+    const Header* header() const { return (const Header*)base_; }
+    const Entry* entries() const { return (const Entry*)(base_ + sizeof(Header)); }
+    esp_err_t checkLayout(size_t partition_size) const;
+    esp_err_t verifyDataOnce(const char* partition_label);
+
+    const uint8_t* base_;
+    esp_partition_mmap_handle_t mmap_handle_;
+    uint32_t open_us_;
+    bool fully_verified_;           // 本次启动算过数据区CRC
+};
+
+#endif // MODEL_STORE_H
@@ -0,0 +1,52 @@
+/**
+ * @file net_connect.h
+ * @brief 🔌 带超时的TCP连接
+ *
+ * lwIP 的阻塞 connect() 不受 SO_RCVTIMEO/SO_SNDTIMEO 限制：对方不回SYN（地址被黑洞）时
+ * 要等完整的SYN重传才失败，远超调用方给的超时。这里先切成非阻塞，用 select() 等可写，
+ * 超时即放弃；连接结果之后恢复原来的阻塞模式。
+ */
+
+#ifndef NET_CONNECT_H
+#define NET_CONNECT_H
+
+#include <errno.h>
+#include "lwip/sockets.h"
+
+/**
+ * @brief 连接 addr，最多等 timeout_ms
+ *
+ * @return 0=已连接，-1=失败（errno：ETIMEDOUT=超时，其他为连接错误）
+ */
+inline int net_connect_timeout(int sock, const struct sockaddr* addr, socklen_t addr_len, int timeout_ms)
+{
+    int flags = fcntl(sock, F_GETFL, 0);
+    fcntl(sock, F_SETFL, flags | O_NONBLOCK);
+
+    int ret = connect(sock, addr, addr_len);
+    if (ret != 0 && errno == EINPROGRESS) {
+        fd_set wfds;
+        FD_ZERO(&wfds);
+        FD_SET(sock, &wfds);
+        struct timeval tv;
+        tv.tv_sec = timeout_ms / 1000;
+        tv.tv_usec = (timeout_ms % 1000) * 1000;
+        ret = select(sock + 1, nullptr, &wfds, nullptr, &tv);
+        if (ret > 0) {
+            // 可写不代表成功，连接结果在 SO_ERROR 里
+            int err = 0;
+            socklen_t err_len = sizeof(err);
+            getsockopt(sock, SOL_SOCKET, SO_ERROR, &err, &err_len);
+            ret = err == 0 ? 0 : -1;
+            errno = err;
+        } else {
+            errno = ret == 0 ? ETIMEDOUT : errno;
+            ret = -1;
+        }
+    }
+
+    fcntl(sock, F_SETFL, flags);
+    return ret;
+}
+
+#endif // NET_CONNECT_H
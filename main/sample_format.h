@@ -0,0 +1,221 @@
+/**
+ * @file sample_format.h
+ * @brief 🎚️ 采样格式转换内核 - 编译期确定格式，每种配置一个无分支的内循环
+ *
+ * 整条音频链路内部统一使用 16位单声道 PCM。I2S 两端的硬件格式却各不相同：
+ * INMP441 在32位槽里输出24位左对齐数据，有的功放要立体声，有的编解码器是大端……
+ * 这里用 constexpr 特征描述一种格式（容器大小、有效位数、声道数、字节序），
+ * 转换函数按特征在编译期展开，内循环里没有运行时的格式判断：
+ *
+ * - to_pcm16<Format, Channel, Shift, GainQ8>()：硬件格式 → 16位单声道（取某个声道或混合，带移位、增益和饱和）
+ * - from_pcm16<Format, GainQ8>()：16位单声道 → 硬件格式（复制到所有声道）
+ *
+ * 换一个麦克风或编解码器只需要写一个新的 Format 别名。
+ * 纯头文件，不依赖ESP-IDF，主机端基准测试也可以直接编译。
+ */
+
+#ifndef SAMPLE_FORMAT_H
+#define SAMPLE_FORMAT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+namespace sample_format {
+
+enum class Endian { LITTLE, BIG };
+
+/**
+ * @brief 一种PCM格式的编译期描述
+ *
+ * @tparam ContainerBytes 每个样本占用的字节数（2、3、4）
+ * @tparam ValidBits 有效位数（左对齐在容器里，例如32位槽中的24位）
+ * @tparam Channels 每帧的声道数（I2S槽数）
+ * @tparam ByteOrder 容器的字节序
+ */
+template <int ContainerBytes, int ValidBits, int Channels, Endian ByteOrder = Endian::LITTLE>
+struct Format {
+    static_assert(ContainerBytes == 2 || ContainerBytes == 3 || ContainerBytes == 4, "容器只能是2/3/4字节");
+    static_assert(ValidBits >= 8 && ValidBits <= ContainerBytes * 8, "有效位数超出容器");
+    static_assert(Channels >= 1 && Channels <= 8, "声道数超出范围");
+
+    static constexpr int container_bytes = ContainerBytes;
+    static constexpr int valid_bits = ValidBits;
+    static constexpr int channels = Channels;
+    static constexpr Endian byte_order = ByteOrder;
+    static constexpr size_t bytes_per_frame = (size_t)ContainerBytes * Channels;
+
+    // 与内部格式完全相同，可以直接读写、不需要转换
+    static constexpr bool is_pcm16_mono = ContainerBytes == 2 && Channels == 1 && ByteOrder == Endian::LITTLE;
+};
+
+// 常用格式
+using S16Mono     = Format<2, 16, 1>;                   // 内部格式
+using S16Stereo   = Format<2, 16, 2>;
+using S16MonoBE   = Format<2, 16, 1, Endian::BIG>;
+using S24In32Mono = Format<4, 24, 1>;                   // INMP441：32位槽中24位左对齐
+using S24In32Stereo = Format<4, 24, 2>;
+using S32Mono     = Format<4, 32, 1>;
+using S32Stereo   = Format<4, 32, 2>;
+using S24Packed   = Format<3, 24, 1>;                   // 紧凑24位（3字节）
+
+constexpr int MIX_ALL = -1;     // Channel 参数：所有声道取平均
+
+namespace detail {
+
+/**
+ * @brief 读取一个样本，返回左对齐到32位的值（有效位以下清零）
+ */
+template <typename F>
+inline int32_t load(const uint8_t* p) {
+    uint32_t raw;
+    if constexpr (F::container_bytes == 2) {
+        uint16_t v;
+        memcpy(&v, p, 2);
+        if constexpr (F::byte_order == Endian::BIG) v = __builtin_bswap16(v);
+        raw = (uint32_t)v << 16;
+    } else if constexpr (F::container_bytes == 3) {
+        if constexpr (F::byte_order == Endian::BIG) {
+            raw = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8);
+        } else {
+            raw = ((uint32_t)p[2] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[0] << 8);
+        }
+    } else {
+        memcpy(&raw, p, 4);
+        if constexpr (F::byte_order == Endian::BIG) raw = __builtin_bswap32(raw);
+    }
+    if constexpr (F::valid_bits < F::container_bytes * 8) {
+        raw &= ~((1u << (32 - F::valid_bits)) - 1);     // 丢掉有效位以下的噪声位
+    }
+    return (int32_t)raw;
+}
+
+/**
+ * @brief 写入一个左对齐的32位样本
+ */
+template <typename F>
+inline void store(uint8_t* p, int32_t value) {
+    uint32_t raw = (uint32_t)value;
+    if constexpr (F::valid_bits < F::container_bytes * 8) {
+        raw &= ~((1u << (32 - F::valid_bits)) - 1);
+    }
+    if constexpr (F::container_bytes == 2) {
+        uint16_t v = (uint16_t)(raw >> 16);
+        if constexpr (F::byte_order == Endian::BIG) v = __builtin_bswap16(v);
+        memcpy(p, &v, 2);
+    } else if constexpr (F::container_bytes == 3) {
+        if constexpr (F::byte_order == Endian::BIG) {
+            p[0] = (uint8_t)(raw >> 24); p[1] = (uint8_t)(raw >> 16); p[2] = (uint8_t)(raw >> 8);
+        } else {
+            p[2] = (uint8_t)(raw >> 24); p[1] = (uint8_t)(raw >> 16); p[0] = (uint8_t)(raw >> 8);
+        }
+    } else {
+        if constexpr (F::byte_order == Endian::BIG) raw = __builtin_bswap32(raw);
+        memcpy(p, &raw, 4);
+    }
+}
+
+inline int32_t clamp16(int32_t v) {
+    // 编译成 min/max（Xtensa 上是 MIN/MAX 或 CLAMPS 指令），没有分支
+    return v < -32768 ? -32768 : (v > 32767 ? 32767 : v);
+}
+
+} // namespace detail
+
+/**
+ * @brief 硬件格式 → 16位单声道
+ *
+ * @tparam F 输入格式
+ * @tparam Channel 取第几个声道（0起），MIX_ALL=所有声道平均
+ * @tparam Shift 额外左移位数（0~8）：取左对齐数据的更低16位，每位+6dB，
+ *               适合INMP441这类满量程很大、说话电平只占低位的麦克风
+ * @tparam GainQ8 增益（Q8定点，256=1.0）
+ * @param src 输入数据（frames * F::bytes_per_frame 字节）
+ * @param dst 输出（frames 个样本），可以与 src 相同（输入每帧不小于2字节，从前往后写不会覆盖未读数据）
+ * @param frames 帧数
+ *
+ * 移位和增益之后饱和到16位。
+ */
+template <typename F, int Channel = 0, int Shift = 0, int GainQ8 = 256>
+inline void to_pcm16(const void* src, int16_t* dst, size_t frames) {
+    static_assert(Channel == MIX_ALL || (Channel >= 0 && Channel < F::channels), "声道超出范围");
+    static_assert(Shift >= 0 && Shift <= 8, "移位范围 0~8");
+    static_assert(GainQ8 > 0 && GainQ8 < 65536, "增益范围 (0, 256.0)");
+    const uint8_t* in = (const uint8_t*)src;
+
+    if constexpr (F::is_pcm16_mono && Shift == 0 && GainQ8 == 256) {
+        if ((const void*)dst != src) {
+            memcpy(dst, src, frames * sizeof(int16_t));
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < frames; i++) {
+        const uint8_t* frame = in + i * F::bytes_per_frame;
+        int32_t s16;
+        if constexpr (Channel == MIX_ALL && F::channels > 1) {
+            int32_t sum = 0;
+            for (int c = 0; c < F::channels; c++) {
+                sum += detail::load<F>(frame + c * F::container_bytes) >> (16 - Shift);
+            }
+            s16 = sum / F::channels;
+        } else {
+            constexpr int ch = Channel == MIX_ALL ? 0 : Channel;
+            s16 = detail::load<F>(frame + ch * F::container_bytes) >> (16 - Shift);
+        }
+        if constexpr (Shift != 0) {
+            s16 = detail::clamp16(s16);
+        }
+        if constexpr (GainQ8 != 256) {
+            s16 = detail::clamp16((s16 * GainQ8) >> 8);
+        }
+        dst[i] = (int16_t)s16;
+    }
+}
+
+/**
+ * @brief 16位单声道 → 硬件格式（复制到每个声道）
+ *
+ * @tparam F 输出格式
+ * @tparam GainQ8 增益（Q8定点，256=1.0），结果饱和
+ * @param src 输入样本
+ * @param dst 输出（frames * F::bytes_per_frame 字节），不能与 src 重叠（除非格式就是16位单声道）
+ * @param frames 帧数
+ */
+template <typename F, int GainQ8 = 256>
+inline void from_pcm16(const int16_t* src, void* dst, size_t frames) {
+    static_assert(GainQ8 > 0 && GainQ8 < 65536, "增益范围 (0, 256.0)");
+    uint8_t* out = (uint8_t*)dst;
+
+    if constexpr (F::is_pcm16_mono && GainQ8 == 256) {
+        if (dst != (const void*)src) {
+            memcpy(dst, src, frames * sizeof(int16_t));
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < frames; i++) {
+        int32_t s = src[i];
+        if constexpr (GainQ8 != 256) {
+            s = detail::clamp16((s * GainQ8) >> 8);
+        }
+        int32_t wide = (int32_t)((uint32_t)s << 16);
+        uint8_t* frame = out + i * F::bytes_per_frame;
+        for (int c = 0; c < F::channels; c++) {
+            detail::store<F>(frame + c * F::container_bytes, wide);
+        }
+    }
+}
+
+/**
+ * @brief 转换 n 字节硬件数据需要多少帧 / 多少字节
+ */
+template <typename F>
+constexpr size_t frames_in(size_t bytes) { return bytes / F::bytes_per_frame; }
+
+template <typename F>
+constexpr size_t bytes_for(size_t frames) { return frames * F::bytes_per_frame; }
+
+} // namespace sample_format
+
+#endif // SAMPLE_FORMAT_H
@@ -0,0 +1,177 @@
+/**
+ * @file sample_format_bench.cc
+ * @brief 📊 采样格式转换基准测试实现
+ */
+
+#include "sample_format_bench.h"
+#include "sample_format.h"
+#include "esp_log.h"
+#include "esp_cpu.h"
+#include "esp_heap_caps.h"
+#include <string.h>
+
+static const char *TAG = "FormatBench";
+
+using namespace sample_format;
+
+static constexpr size_t FRAMES = 512;                   // 一帧麦克风数据（32ms）
+static constexpr int ROUNDS = 200;
+static constexpr size_t MAX_FRAME_BYTES = 8;            // 最宽的格式：32位立体声
+
+/**
+ * @brief 运行时判断格式的通用转换（对比用，相当于没有特化时的手写循环）
+ */
+static void generic_to_pcm16(const uint8_t* src, int16_t* dst, size_t frames,
+                             int container_bytes, int channels, bool big_endian)
+{
+    for (size_t i = 0; i < frames; i++) {
+        const uint8_t* p = src + i * container_bytes * channels;
+        int32_t v;
+        switch (container_bytes) {
+        case 2:
+            v = big_endian ? (int16_t)((p[0] << 8) | p[1]) : (int16_t)((p[1] << 8) | p[0]);
+            break;
+        case 3:
+            v = big_endian ? (int16_t)((p[0] << 8) | p[1]) : (int16_t)((p[2] << 8) | p[1]);
+            break;
+        default:
+            v = big_endian ? (int16_t)((p[0] << 8) | p[1]) : (int16_t)((p[3] << 8) | p[2]);
+            break;
+        }
+        dst[i] = (int16_t)v;
+    }
+}
+
+struct Buffers {
+    int16_t* pcm;               // 参考信号
+    int16_t* back;              // 往返结果
+    uint8_t* wire;              // 硬件格式数据
+};
+
+/**
+ * @brief 参考信号：包含满量程、零附近和扫频的样本
+ */
+static void fill_reference(int16_t* pcm, size_t frames)
+{
+    static const int16_t edges[] = { 32767, -32768, 0, 1, -1, 256, -256, 12345, -12345 };
+    for (size_t i = 0; i < frames; i++) {
+        pcm[i] = i < sizeof(edges) / sizeof(edges[0]) ? edges[i] : (int16_t)(i * 2654435761u >> 16);
+    }
+}
+
+template <typename F>
+static bool check_and_time(const char* name, Buffers& buf)
+{
+    // 往返：16位 → 硬件格式 → 16位 必须逐样本相同
+    memset(buf.back, 0, FRAMES * sizeof(int16_t));
+    from_pcm16<F>(buf.pcm, buf.wire, FRAMES);
+    to_pcm16<F>(buf.wire, buf.back, FRAMES);
+    bool ok = memcmp(buf.pcm, buf.back, FRAMES * sizeof(int16_t)) == 0;
+
+    uint32_t start = esp_cpu_get_cycle_count();
+    for (int r = 0; r < ROUNDS; r++) {
+        to_pcm16<F>(buf.wire, buf.back, FRAMES);
+    }
+    uint32_t in_cycles = esp_cpu_get_cycle_count() - start;
+
+    start = esp_cpu_get_cycle_count();
+    for (int r = 0; r < ROUNDS; r++) {
+        from_pcm16<F>(buf.pcm, buf.wire, FRAMES);
+    }
+    uint32_t out_cycles = esp_cpu_get_cycle_count() - start;
+
+    start = esp_cpu_get_cycle_count();
+    for (int r = 0; r < ROUNDS; r++) {
+        generic_to_pcm16(buf.wire, buf.back, FRAMES, F::container_bytes, F::channels,
+                         F::byte_order == Endian::BIG);
+    }
+    uint32_t generic_cycles = esp_cpu_get_cycle_count() - start;
+
+    const double samples = (double)FRAMES * ROUNDS;
+    ESP_LOGI(TAG, "%-14s 输入 %5.2f  输出 %5.2f  通用循环 %5.2f 周期/样本%s", name,
+             in_cycles / samples, out_cycles / samples, generic_cycles / samples,
+             ok ? "" : "  [往返不一致!]");
+    return ok;
+}
+
+/**
+ * @brief 已知向量：覆盖往返测不到的路径
+ */
+static bool check_vectors()
+{
+    bool ok = true;
+    int16_t out[2];
+
+    // 24位槽：低8位是噪声，必须被丢掉；有效位以下不影响结果
+    const int32_t s24[2] = { (int32_t)0x12345678, (int32_t)0xFEDCBA98 };
+    to_pcm16<S24In32Mono>(s24, out, 2);
+    ok &= out[0] == 0x1234 && out[1] == (int16_t)0xFEDC;
+
+    // 移位4位（+24dB）：小信号放大，大信号饱和
+    const int32_t s32[2] = { 0x01234000, (int32_t)0x80000000 };
+    to_pcm16<S32Mono, 0, 4>(s32, out, 2);
+    ok &= out[0] == 0x1234 && out[1] == -32768;
+
+    // 增益 2.0 饱和
+    const int16_t loud[2] = { 20000, -20000 };
+    to_pcm16<S16Mono, 0, 0, 512>(loud, out, 2);
+    ok &= out[0] == 32767 && out[1] == -32768;
+
+    // 立体声：取右声道 / 两声道平均
+    const int16_t lr[2] = { 1000, 3000 };
+    to_pcm16<S16Stereo, 1>(lr, out, 1);
+    ok &= out[0] == 3000;
+    to_pcm16<S16Stereo, MIX_ALL>(lr, out, 1);
+    ok &= out[0] == 2000;
+
+    // 大端 / 紧凑24位的字节顺序
+    const uint8_t be[2] = { 0x12, 0x34 };
+    to_pcm16<S16MonoBE>(be, out, 1);
+    ok &= out[0] == 0x1234;
+    const uint8_t packed[3] = { 0x56, 0x34, 0x12 };
+    to_pcm16<S24Packed>(packed, out, 1);
+    ok &= out[0] == 0x1234;
+
+    // 输出到32位立体声：两个槽都是左对齐的同一个样本
+    const int16_t mono = -2;
+    int32_t wide[2] = { 0, 0 };
+    from_pcm16<S32Stereo>(&mono, wide, 1);
+    ok &= wide[0] == (int32_t)0xFFFE0000 && wide[1] == wide[0];
+
+    if (!ok) {
+        ESP_LOGE(TAG, "已知向量检查失败");
+    }
+    return ok;
+}
+
+bool sample_format_bench_run(void)
+{
+    Buffers buf;
+    buf.pcm = (int16_t*)heap_caps_malloc(FRAMES * sizeof(int16_t), MALLOC_CAP_INTERNAL);
+    buf.back = (int16_t*)heap_caps_malloc(FRAMES * sizeof(int16_t), MALLOC_CAP_INTERNAL);
+    buf.wire = (uint8_t*)heap_caps_malloc(FRAMES * MAX_FRAME_BYTES, MALLOC_CAP_INTERNAL);
+    bool ok = false;
+
+    if (buf.pcm == nullptr || buf.back == nullptr || buf.wire == nullptr) {
+        ESP_LOGW(TAG, "基准测试缓冲区分配失败");
+    } else {
+        fill_reference(buf.pcm, FRAMES);
+        ESP_LOGI(TAG, "========== 采样格式转换基准测试 ==========");
+        ok = check_vectors();
+        ok &= check_and_time<S16Mono>("16位单声道", buf);
+        ok &= check_and_time<S16MonoBE>("16位大端", buf);
+        ok &= check_and_time<S16Stereo>("16位立体声", buf);
+        ok &= check_and_time<S24Packed>("24位紧凑", buf);
+        ok &= check_and_time<S24In32Mono>("24位/32槽", buf);
+        ok &= check_and_time<S24In32Stereo>("24位/32槽立体声", buf);
+        ok &= check_and_time<S32Mono>("32位单声道", buf);
+        ok &= check_and_time<S32Stereo>("32位立体声", buf);
+        ESP_LOGI(TAG, "检查%s", ok ? "全部通过" : "失败");
+        ESP_LOGI(TAG, "==========================================");
+    }
+
+    heap_caps_free(buf.pcm);
+    heap_caps_free(buf.back);
+    heap_caps_free(buf.wire);
+    return ok;
+}
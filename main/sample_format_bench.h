@@ -0,0 +1,20 @@
+/**
+ * @file sample_format_bench.h
+ * @brief 📊 采样格式转换基准测试 - 每种格式的正确性检查和每样本CPU周期
+ *
+ * 启动时运行（CONFIG_AUDIO_FORMAT_BENCH）。对 sample_format.h 中的每种格式：
+ * 先做往返转换和几组已知向量的检查（24位槽低位噪声、移位饱和、大端、声道混合），
+ * 再测 to_pcm16 / from_pcm16 每样本的CPU周期，并与运行时判断格式的通用循环对比。
+ */
+
+#ifndef SAMPLE_FORMAT_BENCH_H
+#define SAMPLE_FORMAT_BENCH_H
+
+/**
+ * @brief 运行检查和基准测试并打印结果（阻塞，不到1秒）
+ *
+ * @return 所有检查都通过返回 true
+ */
+bool sample_format_bench_run(void);
+
+#endif // SAMPLE_FORMAT_BENCH_H
@@ -0,0 +1,282 @@
+/**
+ * @file sampling_profiler.cc
+ * @brief 🔬 采样分析器实现
+ */
+
+#include "sampling_profiler.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "esp_attr.h"
+#include "esp_cpu.h"
+#include "esp_ipc.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "freertos/task.h"
+#include "xtensa_context.h"
+
+static const char *TAG = "Profiler";
+
+static constexpr uint32_t TIMER_RESOLUTION_HZ = 1000000;   // 1us
+
+namespace {
+
+struct StartArgs {
+    SamplingProfiler* profiler;
+    gptimer_handle_t* timer;
+    uint32_t period_us;
+    esp_err_t result;
+};
+
+bool sample_less(const SamplingProfiler::Sample& a, const SamplingProfiler::Sample& b)
+{
+    if (a.core != b.core) {
+        return a.core < b.core;
+    }
+    int by_task = strncmp(a.task, b.task, sizeof(a.task));
+    if (by_task != 0) {
+        return by_task < 0;
+    }
+    return a.pc < b.pc;
+}
+
+bool sample_same(const SamplingProfiler::Sample& a, const SamplingProfiler::Sample& b)
+{
+    return a.core == b.core && a.pc == b.pc && strncmp(a.task, b.task, sizeof(a.task)) == 0;
+}
+
+} // namespace
+
+SamplingProfiler::SamplingProfiler(size_t capacity)
+    : capacity_(capacity)
+    , buffer_(nullptr)
+    , count_(0)
+    , dropped_(0)
+    , hz_(0)
+    , running_(false)
+    , start_us_(0)
+    , stop_us_(0)
+{
+    for (auto& c : cores_) {
+        c.timer = nullptr;
+        c.isr_cycles.store(0);
+    }
+}
+
+SamplingProfiler::~SamplingProfiler()
+{
+    stop();
+    heap_caps_free(buffer_);
+}
+
+esp_err_t SamplingProfiler::init()
+{
+    if (buffer_ != nullptr) {
+        return ESP_OK;
+    }
+    buffer_ = (Sample*)heap_caps_malloc(sizeof(Sample) * capacity_, MALLOC_CAP_SPIRAM);
+    if (buffer_ == nullptr) {
+        ESP_LOGE(TAG, "采样缓冲区分配失败: %zu x %zu 字节", capacity_, sizeof(Sample));
+        return ESP_ERR_NO_MEM;
+    }
+    ESP_LOGI(TAG, "✓ 采样分析器就绪: 最多 %zu 个采样 (%zu KB PSRAM)",
+             capacity_, sizeof(Sample) * capacity_ / 1024);
+    return ESP_OK;
+}
+
+void IRAM_ATTR SamplingProfiler::record(int core)
+{
+    uint32_t t0 = esp_cpu_get_cycle_count();
+
+    size_t index = count_.fetch_add(1, std::memory_order_relaxed);
+    if (index >= capacity_) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    Sample& s = buffer_[index];
+    TaskHandle_t task = xTaskGetCurrentTaskHandleForCore(core);
+    s.pc = 0;
+    // 定时器中断本身已经让嵌套计数加了1（_frxt_int_enter 在调用处理函数之前加），
+    // 所以 xPortInterruptedFromISRContext() 在这里总是真；计数正好是1才是打断了任务
+    if (task != NULL && port_interruptNesting[core] == 1) {
+        // 这一级进入中断时 _frxt_int_enter 把被打断任务的栈指针存进TCB的第一个字段（pxTopOfStack），
+        // 那里正是保存现场的异常帧；嵌套的中断不会更新它，所以计数大于1时只能记为 [isr]
+        const XtExcFrame* frame = *(const XtExcFrame* const*)task;
+        s.pc = (uint32_t)frame->pc;
+    }
+    const char* name = task != NULL ? pcTaskGetName(task) : "?";
+    size_t i = 0;
+    for (; i < sizeof(s.task) && name[i] != '\0'; i++) {
+        s.task[i] = name[i];
+    }
+    for (; i < sizeof(s.task); i++) {
+        s.task[i] = '\0';
+    }
+    s.core = (uint8_t)core;
+
+    cores_[core].isr_cycles.fetch_add(esp_cpu_get_cycle_count() - t0, std::memory_order_relaxed);
+}
+
+// 放在IRAM减少采样本身的cache未命中；定时器中断在flash操作期间会被屏蔽，不要求IRAM安全
+bool IRAM_ATTR SamplingProfiler::on_alarm(gptimer_handle_t timer, const gptimer_alarm_event_data_t* edata, void* ctx)
+{
+    ((SamplingProfiler*)ctx)->record(esp_cpu_get_core_id());
+    return false;
+}
+
+void SamplingProfiler::start_on_core(void* arg)
+{
+    // 在目标核上执行：GPTimer在注册回调时把中断装在当前核上
+    StartArgs* args = (StartArgs*)arg;
+    gptimer_config_t config = {};
+    config.clk_src = GPTIMER_CLK_SRC_DEFAULT;
+    config.direction = GPTIMER_COUNT_UP;
+    config.resolution_hz = TIMER_RESOLUTION_HZ;
+    args->result = gptimer_new_timer(&config, args->timer);
+    if (args->result != ESP_OK) {
+        return;
+    }
+
+    gptimer_event_callbacks_t callbacks = {};
+    callbacks.on_alarm = on_alarm;
+    gptimer_alarm_config_t alarm = {};
+    alarm.alarm_count = args->period_us;
+    alarm.reload_count = 0;
+    alarm.flags.auto_reload_on_alarm = true;
+
+    args->result = gptimer_register_event_callbacks(*args->timer, &callbacks, args->profiler);
+    if (args->result == ESP_OK) {
+        args->result = gptimer_set_alarm_action(*args->timer, &alarm);
+    }
+    if (args->result == ESP_OK) {
+        args->result = gptimer_enable(*args->timer);
+    }
+    if (args->result == ESP_OK) {
+        args->result = gptimer_start(*args->timer);
+    }
+    if (args->result != ESP_OK) {
+        gptimer_del_timer(*args->timer);
+        *args->timer = nullptr;
+    }
+}
+
+esp_err_t SamplingProfiler::start(uint32_t hz)
+{
+    if (buffer_ == nullptr || running_) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (hz < 10 || hz > 10000) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    count_.store(0);
+    dropped_.store(0);
+    for (auto& c : cores_) {
+        c.isr_cycles.store(0);
+    }
+    hz_ = hz;
+    start_us_ = esp_timer_get_time();
+    running_ = true;
+
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        StartArgs args = { this, &cores_[core].timer, TIMER_RESOLUTION_HZ / hz, ESP_FAIL };
+        esp_err_t ret = esp_ipc_call_blocking(core, start_on_core, &args);
+        if (ret == ESP_OK) {
+            ret = args.result;
+        }
+        if (ret != ESP_OK) {
+            ESP_LOGE(TAG, "核%d 采样定时器启动失败: %s", core, esp_err_to_name(ret));
+            stop();
+            return ret;
+        }
+    }
+    ESP_LOGI(TAG, "开始采样: %lu Hz x %d 核", (unsigned long)hz, portNUM_PROCESSORS);
+    return ESP_OK;
+}
+
+void SamplingProfiler::stop()
+{
+    if (!running_) {
+        return;
+    }
+    for (auto& c : cores_) {
+        if (c.timer != nullptr) {
+            gptimer_stop(c.timer);
+            gptimer_disable(c.timer);
+            gptimer_del_timer(c.timer);
+            c.timer = nullptr;
+        }
+    }
+    stop_us_ = esp_timer_get_time();
+    running_ = false;
+
+    Stats s = stats();
+    ESP_LOGI(TAG, "停止采样: %zu 个采样 (丢弃 %lu), %lu ms, 开销 %.2f%%",
+             s.samples, (unsigned long)s.dropped, (unsigned long)s.duration_ms, s.overhead_pct);
+}
+
+SamplingProfiler::Stats SamplingProfiler::stats() const
+{
+    Stats s;
+    s.running = running_;
+    s.hz = hz_;
+    s.samples = std::min(count_.load(), capacity_);
+    s.capacity = capacity_;
+    s.dropped = dropped_.load();
+    int64_t end_us = running_ ? esp_timer_get_time() : stop_us_;
+    s.duration_ms = (uint32_t)((end_us - start_us_) / 1000);
+
+    uint64_t cycles = 0;
+    for (const auto& c : cores_) {
+        cycles += c.isr_cycles.load();
+    }
+    double elapsed_cycles = (double)(end_us - start_us_) * CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ * portNUM_PROCESSORS;
+    s.overhead_pct = elapsed_cycles > 0 ? (float)(cycles * 100.0 / elapsed_cycles) : 0.0f;
+    return s;
+}
+
+void SamplingProfiler::dump()
+{
+    stop();
+    Stats s = stats();
+    if (buffer_ == nullptr) {
+        return;
+    }
+
+    // 排序后相同的 (核, 任务, PC) 相邻，一遍输出计数
+    std::sort(buffer_, buffer_ + s.samples, sample_less);
+
+    printf("PROFILE_BEGIN hz=%lu samples=%zu dropped=%lu duration_ms=%lu\n",
+           (unsigned long)s.hz, s.samples, (unsigned long)s.dropped, (unsigned long)s.duration_ms);
+    size_t lines = 0;
+    size_t isr_samples = 0;
+    for (size_t i = 0; i < s.samples;) {
+        size_t j = i + 1;
+        while (j < s.samples && sample_same(buffer_[i], buffer_[j])) {
+            j++;
+        }
+        char task[sizeof(Sample::task) + 1];
+        memcpy(task, buffer_[i].task, sizeof(Sample::task));
+        task[sizeof(Sample::task)] = '\0';
+        for (char* p = task; *p; p++) {
+            if (*p == ' ') *p = '_';
+        }
+        printf("P %u %s 0x%08lx %u\n", buffer_[i].core, task[0] ? task : "?",
+               (unsigned long)buffer_[i].pc, (unsigned)(j - i));
+        if (buffer_[i].pc == 0) {
+            isr_samples += j - i;
+        }
+        lines++;
+        i = j;
+    }
+    printf("PROFILE_END\n");
+    fflush(stdout);
+    ESP_LOGI(TAG, "已输出 %zu 个采样（%zu 行），其中打断中断的 %zu 个", s.samples, lines, isr_samples);
+    if (s.samples > 0 && isr_samples == s.samples) {
+        // 正常负载下绝大部分采样都应落在任务里，全是 [isr] 说明取不到被打断的PC
+        ESP_LOGW(TAG, "全部采样都没有PC，火焰图没有信息");
+    }
+}
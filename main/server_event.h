@@ -0,0 +1,92 @@
+/**
+ * @file server_event.h
+ * @brief 📨 服务器JSON事件识别
+ *
+ * 服务器的文本消息都是 {"event":"xxx",...} 形式的小JSON。
+ * 这里只做事件分类和取字符串字段，不做完整的JSON解析；
+ * 匹配顺序与原来主程序里的判断链一致（response_finished 优先）。
+ *
+ * 纯头文件，不依赖ESP-IDF，主机端基准测试也可以直接编译。
+ */
+
+#ifndef SERVER_EVENT_H
+#define SERVER_EVENT_H
+
+#include <stddef.h>
+#include <string.h>
+
+enum class ServerEvent {
+    UNKNOWN,
+    RESPONSE_FINISHED,      // 一段回复结束
+    PING,                   // 服务器心跳
+    ERROR,                  // 服务器错误
+    PLAY_WEATHER,           // 天气播报指令
+    HELLO_ACK,              // 握手应答（见 hello_handshake.h）
+    UDP_ANSWER,             // UDP音频通道应答（见 udp_audio.h）
+    SET_SERVERS,            // 下发候选服务器列表（见 server_selector.h）
+    PROFILE,                // 采样分析器控制（见 sampling_profiler.h）
+    AUDIO_PROFILE,          // 切换I2S延迟配置（default / low_latency）
+};
+
+/**
+ * @brief 识别一条文本消息的事件类型
+ *
+ * @param json 以'\0'结尾的消息
+ */
+inline ServerEvent classify_server_event(const char* json)
+{
+    static const struct {
+        const char* pattern;
+        ServerEvent event;
+    } PATTERNS[] = {
+        { "response_finished", ServerEvent::RESPONSE_FINISHED },
+        { "\"event\":\"ping\"", ServerEvent::PING },
+        { "\"event\":\"error\"", ServerEvent::ERROR },
+        { "\"event\":\"play_weather\"", ServerEvent::PLAY_WEATHER },
+        { "\"event\":\"hello_ack\"", ServerEvent::HELLO_ACK },
+        { "\"event\":\"udp_answer\"", ServerEvent::UDP_ANSWER },
+        { "\"event\":\"set_servers\"", ServerEvent::SET_SERVERS },
+        { "\"event\":\"profile\"", ServerEvent::PROFILE },
+        { "\"event\":\"audio_profile\"", ServerEvent::AUDIO_PROFILE },
+    };
+    for (const auto& p : PATTERNS) {
+        if (strstr(json, p.pattern) != NULL) {
+            return p.event;
+        }
+    }
+    return ServerEvent::UNKNOWN;
+}
+
+/**
+ * @brief 取字符串字段的值（不处理转义）
+ *
+ * @param json 以'\0'结尾的消息
+ * @param key 字段名，例如 "triggered_by"
+ * @param len 输出：值的长度
+ * @return 指向值第一个字符的指针，字段不存在或没有结束引号时返回 NULL
+ */
+inline const char* json_string_field(const char* json, const char* key, size_t* len)
+{
+    char pattern[48];
+    size_t key_len = strlen(key);
+    if (key_len + 5 > sizeof(pattern)) {
+        return NULL;
+    }
+    pattern[0] = '"';
+    memcpy(pattern + 1, key, key_len);
+    memcpy(pattern + 1 + key_len, "\":\"", 4);
+
+    const char* value = strstr(json, pattern);
+    if (value == NULL) {
+        return NULL;
+    }
+    value += key_len + 4;
+    const char* end = strchr(value, '"');
+    if (end == NULL) {
+        return NULL;
+    }
+    *len = (size_t)(end - value);
+    return value;
+}
+
+#endif // SERVER_EVENT_H
@@ -0,0 +1,442 @@
+/**
+ * @file server_selector.cc
+ * @brief 🌐 语音服务器选择器实现
+ *
+ * RTT探测使用一次轻量的HTTP请求（GET /health）：
+ * 从请求发出到收到第一个响应字节的时间，包含了网络往返和服务器的处理延迟，
+ * 比单纯的TCP握手更能反映真实的对话体验。
+ * 服务器没有 /health 接口时会返回404，同样可以用来测速。
+ */
+
+#include "server_selector.h"
+#include "flash_write_gate.h"
+#include "net_connect.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "nvs.h"
+#include "lwip/sockets.h"
+#include "lwip/netdb.h"
+#include <algorithm>
+#include <cstring>
+
+static const char *TAG = "ServerSelector";
+
+ServerSelector::ServerSelector(const char* default_endpoints)
+    : default_endpoints_(default_endpoints ? default_endpoints : ""),
+      current_(0), lock_(xSemaphoreCreateMutex()),
+      probe_task_handle_(nullptr), probe_stop_(false), probe_interval_ms_(0),
+      flash_gate_(nullptr) {
+}
+
+ServerSelector::~ServerSelector() {
+    stopBackgroundProbe();
+    if (lock_ != nullptr) {
+        vSemaphoreDelete(lock_);
+    }
+}
+
+bool ServerSelector::parseList(const std::string& list, std::vector<Endpoint>& out) {
+    out.clear();
+    size_t start = 0;
+    while (start < list.size()) {
+        size_t end = list.find(',', start);
+        if (end == std::string::npos) {
+            end = list.size();
+        }
+        std::string item = list.substr(start, end - start);
+        start = end + 1;
+
+        // 去掉 ws:// 前缀和首尾空格
+        if (item.compare(0, 5, "ws://") == 0) {
+            item = item.substr(5);
+        }
+        item.erase(0, item.find_first_not_of(' '));
+        item.erase(item.find_last_not_of(' ') + 1);
+        if (item.empty()) {
+            continue;
+        }
+
+        Endpoint ep;
+        size_t slash = item.find('/');
+        ep.path = (slash == std::string::npos) ? "/" : item.substr(slash);
+        std::string hostport = item.substr(0, slash);
+        size_t colon = hostport.find(':');
+        ep.host = hostport.substr(0, colon);
+        ep.port = (colon == std::string::npos) ? 80 : (uint16_t)atoi(hostport.c_str() + colon + 1);
+        ep.rtt_ms = UNREACHABLE;
+        ep.failures = 0;
+        if (ep.host.empty() || ep.port == 0) {
+            ESP_LOGW(TAG, "忽略格式错误的节点: %s", item.c_str());
+            continue;
+        }
+        out.push_back(ep);
+    }
+    return !out.empty();
+}
+
+esp_err_t ServerSelector::load() {
+    std::string list = default_endpoints_;
+    std::string dns_cache;
+
+    nvs_handle_t nvs;
+    if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &nvs) == ESP_OK) {
+        std::string saved;
+        if (readNvsString(nvs, NVS_KEY_ENDPOINTS, saved) == ESP_OK) {
+            list = saved;
+            ESP_LOGI(TAG, "使用NVS中保存的服务器列表");
+        }
+        readNvsString(nvs, NVS_KEY_DNS, dns_cache);
+        nvs_close(nvs);
+    }
+
+    std::vector<Endpoint> parsed;
+    if (!parseList(list, parsed)) {
+        ESP_LOGE(TAG, "服务器列表为空或格式错误: %s", list.c_str());
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // 恢复DNS缓存："host=ip;host=ip"
+    for (Endpoint& ep : parsed) {
+        std::string key = ep.host + "=";
+        size_t pos = dns_cache.find(key);
+        if (pos != std::string::npos && (pos == 0 || dns_cache[pos - 1] == ';')) {
+            size_t end = dns_cache.find(';', pos);
+            ep.cached_ip = dns_cache.substr(pos + key.size(),
+                                            end == std::string::npos ? std::string::npos : end - pos - key.size());
+        }
+    }
+
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    endpoints_.swap(parsed);
+    current_ = 0;
+    xSemaphoreGive(lock_);
+
+    ESP_LOGI(TAG, "已加载 %zu 个候选服务器", endpoints_.size());
+    return ESP_OK;
+}
+
+esp_err_t ServerSelector::readNvsString(nvs_handle_t nvs, const char* key, std::string& out) {
+    // 先查长度（含'\0'）再读，服务器下发的节点列表没有长度上限
+    size_t len = 0;
+    esp_err_t ret = nvs_get_str(nvs, key, nullptr, &len);
+    if (ret != ESP_OK || len == 0) {
+        return ret != ESP_OK ? ret : ESP_ERR_NVS_NOT_FOUND;
+    }
+    std::string value(len, '\0');
+    ret = nvs_get_str(nvs, key, &value[0], &len);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    value.resize(len - 1);
+    out.swap(value);
+    return ESP_OK;
+}
+
+esp_err_t ServerSelector::persistEndpoints(const std::string& list) {
+    nvs_handle_t nvs;
+    esp_err_t ret = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "打开NVS失败: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    ret = nvs_set_str(nvs, NVS_KEY_ENDPOINTS, list.c_str());
+    if (ret == ESP_OK) {
+        ret = nvs_commit(nvs);
+    }
+    nvs_close(nvs);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "保存服务器列表失败: %s", esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+esp_err_t ServerSelector::setEndpoints(const std::string& list) {
+    std::vector<Endpoint> parsed;
+    if (!parseList(list, parsed)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // 这条消息可能正好在播放回复时到达：写flash会让两个核停顿几十毫秒，
+    // 那就先只改内存，NVS留给下一次探测后的 saveDnsCache()
+    esp_err_t ret = ESP_OK;
+    bool deferred = flash_gate_ != nullptr && !flash_gate_->waitIdle(0);
+    if (!deferred) {
+        ret = persistEndpoints(list);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+    }
+
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    endpoints_.swap(parsed);
+    current_ = 0;
+    pending_endpoints_ = deferred ? list : std::string();
+    xSemaphoreGive(lock_);
+
+    ESP_LOGI(TAG, "服务器列表已更新%s: %s", deferred ? "（稍后保存）" : "", list.c_str());
+    return ESP_OK;
+}
+
+bool ServerSelector::resolve(Endpoint& ep) {
+    struct addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo* res = nullptr;
+
+    int err = getaddrinfo(ep.host.c_str(), nullptr, &hints, &res);
+    if (err != 0 || res == nullptr) {
+        ESP_LOGW(TAG, "DNS解析失败: %s (err=%d)", ep.host.c_str(), err);
+        return false;
+    }
+    char ip[16];
+    inet_ntop(AF_INET, &((struct sockaddr_in*)res->ai_addr)->sin_addr, ip, sizeof(ip));
+    freeaddrinfo(res);
+
+    if (ep.cached_ip != ip) {
+        ESP_LOGI(TAG, "DNS: %s -> %s", ep.host.c_str(), ip);
+        ep.cached_ip = ip;
+    }
+    return true;
+}
+
+uint32_t ServerSelector::probe(const std::string& host, const std::string& ip, uint16_t port, int timeout_ms) {
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if (inet_pton(AF_INET, ip.c_str(), &addr.sin_addr) != 1) {
+        return UNREACHABLE;
+    }
+
+    int sock = socket(AF_INET, SOCK_STREAM, IPPROTO_IP);
+    if (sock < 0) {
+        return UNREACHABLE;
+    }
+
+    struct timeval tv;
+    tv.tv_sec = timeout_ms / 1000;
+    tv.tv_usec = (timeout_ms % 1000) * 1000;
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+    uint32_t rtt = UNREACHABLE;
+    // 连接也要受 timeout_ms 限制，否则黑洞地址会把 probeAll() 卡住整个SYN重传周期
+    if (net_connect_timeout(sock, (struct sockaddr*)&addr, sizeof(addr), timeout_ms) == 0) {
+        char req[192];
+        int req_len = snprintf(req, sizeof(req),
+                               "GET /health HTTP/1.1\r\nHost: %s\r\nConnection: close\r\n\r\n", host.c_str());
+        int64_t start_us = esp_timer_get_time();
+        char first;
+        if (send(sock, req, req_len, 0) == req_len && recv(sock, &first, 1, 0) == 1) {
+            rtt = (uint32_t)((esp_timer_get_time() - start_us) / 1000);
+        }
+    }
+    close(sock);
+    return rtt;
+}
+
+std::string ServerSelector::buildUri(const Endpoint& ep) {
+    // URI保留主机名：WebSocket握手的 Host 头要用它（虚拟主机、反向代理按名字分发），
+    // 缓存的IP只在建立连接时代替DNS解析，见 cachedAddress()
+    return "ws://" + ep.host + ":" + std::to_string(ep.port) + ep.path;
+}
+
+std::string ServerSelector::cachedAddress(const std::string& uri) const {
+    std::string ip;
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    for (const Endpoint& ep : endpoints_) {
+        if (buildUri(ep) == uri) {
+            ip = ep.cached_ip;
+            break;
+        }
+    }
+    xSemaphoreGive(lock_);
+    return ip;
+}
+
+void ServerSelector::saveDnsCache() {
+    // 后台探测不着急，等这一轮对话结束；等不到就下次再说
+    if (flash_gate_ != nullptr && !flash_gate_->waitIdle(FLASH_WAIT_MS)) {
+        ESP_LOGD(TAG, "实时音频进行中，推迟保存DNS缓存");
+        return;
+    }
+
+    std::string cache;
+    std::string pending;
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    for (const Endpoint& ep : endpoints_) {
+        if (!ep.cached_ip.empty() && ep.cached_ip != ep.host) {
+            cache += ep.host + "=" + ep.cached_ip + ";";
+        }
+    }
+    pending.swap(pending_endpoints_);
+    xSemaphoreGive(lock_);
+
+    if (!pending.empty() && persistEndpoints(pending) != ESP_OK) {
+        xSemaphoreTake(lock_, portMAX_DELAY);
+        if (pending_endpoints_.empty()) {
+            pending_endpoints_.swap(pending);
+        }
+        xSemaphoreGive(lock_);
+    }
+
+    nvs_handle_t nvs;
+    if (nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs) != ESP_OK) {
+        return;
+    }
+    // 内容未变时不写flash，减少磨损
+    std::string old;
+    if (readNvsString(nvs, NVS_KEY_DNS, old) != ESP_OK || cache != old) {
+        nvs_set_str(nvs, NVS_KEY_DNS, cache.c_str());
+        nvs_commit(nvs);
+    }
+    nvs_close(nvs);
+}
+
+void ServerSelector::probeAll() {
+    // 先拷贝一份，探测期间不持锁（每个节点可能阻塞 PROBE_TIMEOUT_MS）
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    std::vector<Endpoint> snapshot = endpoints_;
+    xSemaphoreGive(lock_);
+
+    for (Endpoint& ep : snapshot) {
+        if (!resolve(ep) && ep.cached_ip.empty()) {
+            ep.rtt_ms = UNREACHABLE;
+            continue;
+        }
+        ep.rtt_ms = probe(ep.host, ep.cached_ip, ep.port, PROBE_TIMEOUT_MS);
+        if (ep.rtt_ms == UNREACHABLE) {
+            ESP_LOGW(TAG, "节点不可达: %s:%u", ep.host.c_str(), ep.port);
+        } else {
+            ESP_LOGI(TAG, "节点 %s:%u RTT %lu ms", ep.host.c_str(), ep.port, (unsigned long)ep.rtt_ms);
+        }
+    }
+
+    // 写回探测结果（列表可能已被setEndpoints替换，按主机和端口匹配）
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    for (Endpoint& ep : endpoints_) {
+        for (const Endpoint& probed : snapshot) {
+            if (probed.host == ep.host && probed.port == ep.port) {
+                ep.cached_ip = probed.cached_ip;
+                ep.rtt_ms = probed.rtt_ms;
+            }
+        }
+    }
+    xSemaphoreGive(lock_);
+
+    saveDnsCache();
+}
+
+int ServerSelector::pickBestLocked(int exclude) const {
+    int best = -1;
+    for (int i = 0; i < (int)endpoints_.size(); i++) {
+        if (i == exclude) {
+            continue;
+        }
+        const Endpoint& ep = endpoints_[i];
+        if (best < 0) {
+            best = i;
+            continue;
+        }
+        const Endpoint& cur = endpoints_[best];
+        // 失败次数少的优先，其次RTT低的优先
+        if (ep.failures < cur.failures ||
+            (ep.failures == cur.failures && ep.rtt_ms < cur.rtt_ms)) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+std::string ServerSelector::selectBest() {
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    int best = pickBestLocked(-1);
+    if (best >= 0) {
+        current_ = best;
+    }
+    std::string uri = endpoints_.empty() ? std::string() : buildUri(endpoints_[current_]);
+    xSemaphoreGive(lock_);
+
+    ESP_LOGI(TAG, "选择服务器: %s", uri.c_str());
+    return uri;
+}
+
+std::string ServerSelector::currentUri() const {
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    std::string uri = endpoints_.empty() ? std::string() : buildUri(endpoints_[current_]);
+    xSemaphoreGive(lock_);
+    return uri;
+}
+
+std::string ServerSelector::failover() {
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    if (endpoints_.empty()) {
+        xSemaphoreGive(lock_);
+        return std::string();
+    }
+    Endpoint& failed = endpoints_[current_];
+    failed.failures++;
+    // IP可能已经变化，下次使用域名重新解析
+    failed.cached_ip.clear();
+
+    int next = pickBestLocked(current_);
+    if (next >= 0) {
+        current_ = next;
+    }
+    std::string uri = buildUri(endpoints_[current_]);
+    xSemaphoreGive(lock_);
+
+    ESP_LOGW(TAG, "故障切换到: %s", uri.c_str());
+    return uri;
+}
+
+void ServerSelector::reportConnected() {
+    xSemaphoreTake(lock_, portMAX_DELAY);
+    if (!endpoints_.empty()) {
+        endpoints_[current_].failures = 0;
+    }
+    xSemaphoreGive(lock_);
+}
+
+void ServerSelector::probe_task(void* arg) {
+    ServerSelector* selector = static_cast<ServerSelector*>(arg);
+
+    while (!selector->probe_stop_) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(selector->probe_interval_ms_));
+        if (selector->probe_stop_) {
+            break;
+        }
+        selector->probeAll();
+    }
+
+    selector->probe_task_handle_ = nullptr;
+    vTaskDelete(NULL);
+}
+
+void ServerSelector::startBackgroundProbe(int interval_ms) {
+    if (probe_task_handle_ != nullptr || interval_ms <= 0) {
+        return;
+    }
+    probe_interval_ms_ = interval_ms;
+    probe_stop_ = false;
+    // 优先级低于音频和网络任务
+    xTaskCreate(probe_task, "srv_probe", PROBE_TASK_STACK_SIZE, this, 2, &probe_task_handle_);
+    ESP_LOGI(TAG, "后台测速任务已启动，间隔 %d 秒", interval_ms / 1000);
+}
+
+void ServerSelector::stopBackgroundProbe() {
+    if (probe_task_handle_ == nullptr) {
+        return;
+    }
+    probe_stop_ = true;
+    xTaskNotifyGive(probe_task_handle_);
+
+    // 等待任务退出（最多等待一次探测的时间）
+    TickType_t timeout = xTaskGetTickCount() + pdMS_TO_TICKS(PROBE_TIMEOUT_MS * 2);
+    while (probe_task_handle_ != nullptr && xTaskGetTickCount() < timeout) {
+        vTaskDelay(pdMS_TO_TICKS(50));
+    }
+    if (probe_task_handle_ != nullptr) {
+        vTaskDelete(probe_task_handle_);
+        probe_task_handle_ = nullptr;
+    }
+}
@@ -0,0 +1,168 @@
+/**
+ * @file server_selector.h
+ * @brief 🌐 语音服务器选择器 - 多节点测速与故障切换
+ *
+ * 维护一组候选WebSocket服务器（保存在NVS中），负责：
+ * - 解析域名并缓存DNS结果，精简传输重连时直接连缓存的IP（URI仍用主机名）；
+ *   esp_websocket_client 用同一个主机名做解析和 Host 头，没有单独的连接地址，仍由它自己解析
+ * - 启动时及后台定期测量每个节点的应用层RTT
+ * - 选择最快的健康节点
+ * - 当前节点连续失败时切换到下一个节点
+ *
+ * 节点列表格式："host:port/path,host2:port/path"，例如
+ * "139.196.221.55:8888/ws/esp32,gw2.example.com:8888/ws/esp32"
+ */
+
+#ifndef SERVER_SELECTOR_H
+#define SERVER_SELECTOR_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "esp_err.h"
+#include "nvs.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+class FlashWriteGate;
+
+class ServerSelector {
+public:
+    /**
+     * @brief 单个候选服务器
+     */
+    struct Endpoint {
+        std::string host;       // 主机名或IP
+        uint16_t port;          // 端口
+        std::string path;       // WebSocket路径（如 /ws/esp32）
+        std::string cached_ip;  // DNS缓存结果（空=尚未解析）
+        uint32_t rtt_ms;        // 最近一次探测RTT（UNREACHABLE=不可达）
+        uint32_t failures;      // 连续失败次数
+    };
+
+    static constexpr uint32_t UNREACHABLE = UINT32_MAX;
+
+    /**
+     * @brief 创建服务器选择器
+     *
+     * @param default_endpoints NVS中没有配置时使用的默认节点列表
+     */
+    explicit ServerSelector(const char* default_endpoints);
+    ~ServerSelector();
+
+    /**
+     * @brief 从NVS加载节点列表和DNS缓存
+     *
+     * NVS中没有配置时使用默认列表。
+     *
+     * @return ESP_OK=成功，ESP_ERR_INVALID_ARG=列表为空或格式错误
+     */
+    esp_err_t load();
+
+    /**
+     * @brief 替换节点列表并写入NVS
+     *
+     * 内存里的列表立即生效；实时音频进行中时NVS写入推迟到下一次探测后。
+     *
+     * @param list 节点列表字符串
+     */
+    esp_err_t setEndpoints(const std::string& list);
+
+    /**
+     * @brief 对所有节点做一次DNS解析和RTT探测
+     *
+     * 阻塞调用，每个节点最多等待 PROBE_TIMEOUT_MS。
+     */
+    void probeAll();
+
+    /**
+     * @brief 选出最快的健康节点并设为当前节点
+     *
+     * @return 当前节点的WebSocket URI
+     */
+    std::string selectBest();
+
+    /**
+     * @brief 当前节点的WebSocket URI（主机名形式）
+     */
+    std::string currentUri() const;
+
+    /**
+     * @brief URI对应节点缓存的IP，连接时代替DNS解析（只有精简传输使用）
+     *
+     * @return 点分十进制IP，没有缓存（或不是已知节点）时返回空串
+     */
+    std::string cachedAddress(const std::string& uri) const;
+
+    /**
+     * @brief 当前节点失败，切换到下一个最优节点
+     *
+     * @return 新节点的URI（只有一个节点时返回原URI）
+     */
+    std::string failover();
+
+    /**
+     * @brief 当前节点连接成功，清零失败计数
+     */
+    void reportConnected();
+
+    /**
+     * @brief 启动后台探测任务
+     *
+     * 后台探测只更新排名，实际切换发生在下一次重连或故障切换时，
+     * 避免在对话中途换服务器。
+     *
+     * @param interval_ms 探测间隔（毫秒）
+     */
+    void startBackgroundProbe(int interval_ms);
+
+    /**
+     * @brief 停止后台探测任务
+     */
+    void stopBackgroundProbe();
+
+    /**
+     * @brief 写NVS前先问flash写入闸门（见 flash_write_gate.h），nullptr=随时写
+     */
+    void setFlashGate(FlashWriteGate* gate) { flash_gate_ = gate; }
+
+private:
+    // 解析 "host:port/path,..." 格式
+    static bool parseList(const std::string& list, std::vector<Endpoint>& out);
+    // 解析域名，结果写入cached_ip
+    static bool resolve(Endpoint& ep);
+    // 测量一次应用层RTT：TCP连接 + HTTP请求 + 首字节返回（host 用于 Host 头，ip 用于连接）
+    static uint32_t probe(const std::string& host, const std::string& ip, uint16_t port, int timeout_ms);
+    // 生成URI
+    static std::string buildUri(const Endpoint& ep);
+    // 保存DNS缓存（和推迟的节点列表）到NVS
+    void saveDnsCache();
+    // 节点列表写入NVS
+    static esp_err_t persistEndpoints(const std::string& list);
+    // 按实际长度读出NVS中的字符串
+    static esp_err_t readNvsString(nvs_handle_t nvs, const char* key, std::string& out);
+    // 在持锁状态下选最优节点（排除exclude）
+    int pickBestLocked(int exclude) const;
+
+    static void probe_task(void* arg);
+
+    std::string default_endpoints_;
+    std::vector<Endpoint> endpoints_;
+    int current_;
+    SemaphoreHandle_t lock_;
+    TaskHandle_t probe_task_handle_;
+    volatile bool probe_stop_;
+    int probe_interval_ms_;
+    FlashWriteGate* flash_gate_;
+    std::string pending_endpoints_;     // 等待写入NVS的节点列表（持锁访问）
+
+    static constexpr int PROBE_TIMEOUT_MS = 1500;       // 单个节点探测超时
+    static constexpr int PROBE_TASK_STACK_SIZE = 4096;  // 后台探测任务栈大小
+    static constexpr uint32_t FLASH_WAIT_MS = 2000;     // 保存DNS缓存时最多等实时音频结束这么久
+    static constexpr const char* NVS_NAMESPACE = "ws_servers";
+    static constexpr const char* NVS_KEY_ENDPOINTS = "endpoints";
+    static constexpr const char* NVS_KEY_DNS = "dns_cache";
+};
+
+#endif // SERVER_SELECTOR_H
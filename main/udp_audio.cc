@@ -0,0 +1,442 @@
+/**
+ * @file udp_audio.cc
+ * @brief 📡 UDP音频通道实现
+ */
+
+#include "udp_audio.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_random.h"
+#include "esp_heap_caps.h"
+#include "lwip/sockets.h"
+#include "lwip/netdb.h"
+#include <cstring>
+#include <cstdlib>
+
+static const char *TAG = "UdpAudio";
+
+UdpAudioChannel::UdpAudioChannel(uint16_t local_port)
+    : local_port_(local_port), sock_(-1), ssrc_(esp_random()), active_(false), stop_(false),
+      rx_task_handle_(nullptr), tx_buffer_(nullptr), tx_seq_(0), tx_timestamp_(0),
+      remote_addr_(0), remote_port_(0), slots_(nullptr), have_expected_(false),
+      expected_seq_(0), gap_since_us_(0), last_len_(0), consecutive_lost_(0), eos_seen_(false),
+      rx_lock_(xSemaphoreCreateMutex()), reset_pending_(false), drain_deadline_us_(0),
+      tx_packets_(0), tx_errors_(0), rx_packets_(0), rx_reordered_(0), rx_late_(0), concealed_frames_(0) {
+}
+
+UdpAudioChannel::~UdpAudioChannel() {
+    close();
+    vSemaphoreDelete(rx_lock_);
+}
+
+esp_err_t UdpAudioChannel::open() {
+    if (sock_ >= 0) {
+        return ESP_OK;
+    }
+
+    // 收发缓冲区放在内部RAM，接收任务在网络栈旁边频繁访问
+    tx_buffer_ = (uint8_t*)heap_caps_malloc(HEADER_SIZE + MAX_PAYLOAD, MALLOC_CAP_INTERNAL);
+    slots_ = (Slot*)heap_caps_calloc(REORDER_DEPTH, sizeof(Slot), MALLOC_CAP_INTERNAL);
+    if (tx_buffer_ == nullptr || slots_ == nullptr) {
+        ESP_LOGE(TAG, "UDP音频缓冲区分配失败");
+        close();
+        return ESP_ERR_NO_MEM;
+    }
+
+    sock_ = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock_ < 0) {
+        ESP_LOGE(TAG, "创建UDP socket失败: errno %d", errno);
+        close();
+        return ESP_FAIL;
+    }
+
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(local_port_);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(sock_, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        ESP_LOGE(TAG, "绑定UDP端口 %u 失败: errno %d", local_port_, errno);
+        close();
+        return ESP_FAIL;
+    }
+
+    // 接收超时用于检查缺包等待是否超时
+    struct timeval tv = { .tv_sec = 0, .tv_usec = 10000 };
+    setsockopt(sock_, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    stop_ = false;
+    xTaskCreatePinnedToCore(rx_task, "udp_audio_rx", RX_TASK_STACK_SIZE, this, 6, &rx_task_handle_, 0);
+    ESP_LOGI(TAG, "UDP音频通道已打开，本地端口 %u, SSRC %08lx", local_port_, (unsigned long)ssrc_);
+    return ESP_OK;
+}
+
+void UdpAudioChannel::close() {
+    active_ = false;
+    if (rx_task_handle_ != nullptr) {
+        stop_ = true;
+        TickType_t timeout = xTaskGetTickCount() + pdMS_TO_TICKS(500);
+        while (rx_task_handle_ != nullptr && xTaskGetTickCount() < timeout) {
+            vTaskDelay(pdMS_TO_TICKS(20));
+        }
+        if (rx_task_handle_ != nullptr) {
+            vTaskDelete(rx_task_handle_);
+            rx_task_handle_ = nullptr;
+        }
+    }
+    if (sock_ >= 0) {
+        ::close(sock_);
+        sock_ = -1;
+    }
+    if (tx_buffer_ != nullptr) {
+        heap_caps_free(tx_buffer_);
+        tx_buffer_ = nullptr;
+    }
+    if (slots_ != nullptr) {
+        heap_caps_free(slots_);
+        slots_ = nullptr;
+    }
+}
+
+std::string UdpAudioChannel::buildOffer() const {
+    char msg[160];
+    snprintf(msg, sizeof(msg),
+             "{\"event\":\"udp_offer\",\"port\":%u,\"ssrc\":%lu,\"payload\":\"pcm_s16le\","
+             "\"sample_rate\":16000,\"max_payload\":%u}",
+             local_port_, (unsigned long)ssrc_, (unsigned)MAX_PAYLOAD);
+    return msg;
+}
+
+std::string UdpAudioChannel::hostFromUri(const std::string& uri) {
+    size_t start = uri.find("://");
+    start = (start == std::string::npos) ? 0 : start + 3;
+    size_t end = uri.find_first_of(":/", start);
+    return uri.substr(start, end == std::string::npos ? std::string::npos : end - start);
+}
+
+esp_err_t UdpAudioChannel::handleAnswer(const char* json, const std::string& ws_uri) {
+    const char* port_field = strstr(json, "\"port\":");
+    if (port_field == nullptr || sock_ < 0) {
+        ESP_LOGW(TAG, "UDP协商应答无效");
+        return ESP_ERR_INVALID_ARG;
+    }
+    int port = atoi(port_field + strlen("\"port\":"));
+    std::string host = hostFromUri(ws_uri);
+
+    // URI里是主机名时解析一次（lwIP有DNS缓存，刚连上WebSocket时通常直接命中）
+    struct in_addr ip;
+    if (port > 0 && port <= 65535 && inet_pton(AF_INET, host.c_str(), &ip) != 1) {
+        struct addrinfo hints = {};
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_DGRAM;
+        struct addrinfo* res = nullptr;
+        if (getaddrinfo(host.c_str(), nullptr, &hints, &res) != 0 || res == nullptr) {
+            port = 0;
+        } else {
+            ip = ((struct sockaddr_in*)res->ai_addr)->sin_addr;
+            freeaddrinfo(res);
+        }
+    }
+    if (port <= 0 || port > 65535) {
+        ESP_LOGW(TAG, "UDP协商应答地址无效: %s:%d", host.c_str(), port);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // 每次应答都是服务器新建的会话，下行序号从0重新开始（接收任务处理下一个包之前重置）
+    xSemaphoreTake(rx_lock_, portMAX_DELAY);
+    reset_pending_ = true;
+    xSemaphoreGive(rx_lock_);
+
+    remote_addr_ = ip.s_addr;
+    remote_port_ = htons((uint16_t)port);
+    active_ = true;
+    ESP_LOGI(TAG, "UDP音频通道已启用 -> %s:%d", host.c_str(), port);
+    return ESP_OK;
+}
+
+void UdpAudioChannel::deactivate() {
+    if (active_) {
+        ESP_LOGI(TAG, "UDP音频通道停用，音频回退到WebSocket");
+    }
+    active_ = false;
+    xSemaphoreTake(rx_lock_, portMAX_DELAY);
+    reset_pending_ = true;
+    xSemaphoreGive(rx_lock_);
+}
+
+void UdpAudioChannel::resetReceiver() {
+    // 等待中的排空属于上一个会话，窗口里的包不再输出
+    finishDrain(false);
+    for (int i = 0; i < REORDER_DEPTH; i++) {
+        slots_[i].valid = false;
+    }
+    have_expected_ = false;
+    gap_since_us_ = 0;
+    last_len_ = 0;
+    consecutive_lost_ = 0;
+    // 上一个会话遗留的结束标记不能算到新会话头上
+    eos_seen_ = false;
+}
+
+int UdpAudioChannel::sendAudio(const int16_t* samples, size_t count) {
+    if (!active_ || sock_ < 0 || samples == nullptr) {
+        return -1;
+    }
+
+    struct sockaddr_in to = {};
+    to.sin_family = AF_INET;
+    to.sin_port = remote_port_;
+    to.sin_addr.s_addr = remote_addr_;
+
+    const uint8_t* data = (const uint8_t*)samples;
+    size_t total = count * sizeof(int16_t);
+    size_t sent = 0;
+    while (sent < total) {
+        size_t chunk = (total - sent > MAX_PAYLOAD) ? MAX_PAYLOAD : total - sent;
+
+        // RTP风格包头（网络字节序）
+        uint8_t* hdr = tx_buffer_;
+        hdr[0] = 0x80;
+        hdr[1] = PT_PCM_S16LE_16K;
+        hdr[2] = tx_seq_ >> 8;
+        hdr[3] = tx_seq_ & 0xFF;
+        uint32_t ts = htonl(tx_timestamp_);
+        uint32_t ssrc = htonl(ssrc_);
+        memcpy(hdr + 4, &ts, 4);
+        memcpy(hdr + 8, &ssrc, 4);
+        memcpy(hdr + HEADER_SIZE, data + sent, chunk);
+
+        int ret = sendto(sock_, tx_buffer_, HEADER_SIZE + chunk, MSG_DONTWAIT,
+                         (struct sockaddr*)&to, sizeof(to));
+        // 无论成功与否序号都递增，服务器据此识别丢包
+        tx_seq_++;
+        tx_timestamp_ += chunk / sizeof(int16_t);
+        if (ret < 0) {
+            tx_errors_++;
+            ESP_LOGD(TAG, "UDP发送失败: errno %d", errno);
+            return -1;
+        }
+        tx_packets_++;
+        sent += chunk;
+    }
+    return (int)sent;
+}
+
+void UdpAudioChannel::rx_task(void* arg) {
+    UdpAudioChannel* ch = static_cast<UdpAudioChannel*>(arg);
+    uint8_t* rx_buffer = (uint8_t*)malloc(HEADER_SIZE + MAX_PAYLOAD);
+    if (rx_buffer == nullptr) {
+        ESP_LOGE(TAG, "接收缓冲区分配失败，任务退出");
+        ch->rx_task_handle_ = nullptr;
+        vTaskDelete(NULL);
+        return;
+    }
+
+    while (!ch->stop_) {
+        int len = recv(ch->sock_, rx_buffer, HEADER_SIZE + MAX_PAYLOAD, 0);
+
+        // 锁里只取出其他任务的请求；窗口状态只有本任务访问，输出回调（写播放缓冲区）不在锁里
+        xSemaphoreTake(ch->rx_lock_, portMAX_DELAY);
+        bool reset = ch->reset_pending_;
+        ch->reset_pending_ = false;
+        int64_t drain_deadline = ch->drain_deadline_us_;
+        xSemaphoreGive(ch->rx_lock_);
+
+        if (reset) {
+            ch->resetReceiver();
+            drain_deadline = 0;
+        }
+        if (len > (int)HEADER_SIZE && ch->active_) {
+            ch->handleDatagram(rx_buffer, len);
+        }
+        // 缺包等待超时：补偿缺失的包，继续输出后面已到的数据
+        int64_t now = esp_timer_get_time();
+        if (ch->gap_since_us_ != 0 && now - ch->gap_since_us_ > REORDER_WAIT_MS * 1000) {
+            ch->concealOne();
+            ch->emitReady();
+        }
+        if (drain_deadline != 0 && (ch->eos_seen_ || now >= drain_deadline)) {
+            if (!ch->eos_seen_) {
+                ESP_LOGW(TAG, "等待最后一个UDP音频包超时");
+            }
+            ch->finishDrain(true);
+        }
+    }
+
+    free(rx_buffer);
+    ch->rx_task_handle_ = nullptr;
+    vTaskDelete(NULL);
+}
+
+void UdpAudioChannel::handleDatagram(const uint8_t* data, size_t len) {
+    if (data[0] != 0x80 || (data[1] & 0x7F) != PT_PCM_S16LE_16K) {
+        return;
+    }
+    bool marker = (data[1] & 0x80) != 0;
+    uint16_t seq = ((uint16_t)data[2] << 8) | data[3];
+    size_t payload_len = len - HEADER_SIZE;
+    rx_packets_++;
+
+    if (!have_expected_) {
+        have_expected_ = true;
+        expected_seq_ = seq;
+    }
+
+    int16_t d = (int16_t)(seq - expected_seq_);
+    // 序号向前或向后跳变太大（服务器重启了会话，新会话从0开始），直接重新同步
+    if (d >= 4 * REORDER_DEPTH || d < -4 * REORDER_DEPTH) {
+        ESP_LOGW(TAG, "下行序号跳变 %d，重新同步", d);
+        for (int i = 0; i < REORDER_DEPTH; i++) {
+            slots_[i].valid = false;
+        }
+        gap_since_us_ = 0;
+        expected_seq_ = seq;
+        d = 0;
+    }
+    if (d < 0) {
+        // 已经补偿过或重复的包
+        rx_late_++;
+        return;
+    }
+    // 超出重排窗口：窗口前面缺的包只能放弃
+    while (d >= REORDER_DEPTH) {
+        forceAdvance();
+        d = (int16_t)(seq - expected_seq_);
+    }
+
+    Slot& slot = slots_[seq % REORDER_DEPTH];
+    if (slot.valid) {
+        rx_late_++;
+        return;
+    }
+    if (d > 0) {
+        rx_reordered_++;
+    }
+    slot.valid = true;
+    slot.marker = marker;
+    slot.len = payload_len;
+    memcpy(slot.data, data + HEADER_SIZE, payload_len);
+
+    emitReady();
+}
+
+void UdpAudioChannel::emitReady() {
+    while (true) {
+        Slot& slot = slots_[expected_seq_ % REORDER_DEPTH];
+        if (!slot.valid) {
+            break;
+        }
+        emit(slot.data, slot.len);
+        memcpy(last_payload_, slot.data, slot.len);
+        last_len_ = slot.len;
+        consecutive_lost_ = 0;
+        slot.valid = false;
+        expected_seq_++;
+        eos_seen_ = slot.marker;
+    }
+
+    // 窗口里还有数据但期望的包没到，开始计时
+    bool pending = false;
+    for (int i = 0; i < REORDER_DEPTH; i++) {
+        pending |= slots_[i].valid;
+    }
+    if (!pending) {
+        gap_since_us_ = 0;
+    } else if (gap_since_us_ == 0) {
+        gap_since_us_ = esp_timer_get_time();
+    }
+}
+
+void UdpAudioChannel::concealOne() {
+    // 第一个丢包重复上一包并衰减一半，连续丢包补静音，避免金属声
+    size_t len = last_len_ ? last_len_ : MAX_PAYLOAD;
+    size_t samples = len / sizeof(int16_t);
+    if (consecutive_lost_ == 0 && last_len_ > 0) {
+        const int16_t* prev = (const int16_t*)last_payload_;
+        for (size_t i = 0; i < samples; i++) {
+            concealed_[i] = prev[i] >> 1;
+        }
+    } else {
+        memset(concealed_, 0, len);
+    }
+    emit((const uint8_t*)concealed_, len);
+    consecutive_lost_++;
+    concealed_frames_++;
+    eos_seen_ = false;
+    expected_seq_++;
+    gap_since_us_ = 0;
+}
+
+void UdpAudioChannel::forceAdvance() {
+    Slot& slot = slots_[expected_seq_ % REORDER_DEPTH];
+    if (slot.valid) {
+        emitReady();
+    } else {
+        concealOne();
+    }
+}
+
+void UdpAudioChannel::emit(const uint8_t* data, size_t len) {
+    if (sink_) {
+        sink_(data, len);
+    }
+}
+
+void UdpAudioChannel::drain(int timeout_ms, DrainHandler done) {
+    if (!active_ || rx_task_handle_ == nullptr) {
+        if (done) {
+            done();
+        }
+        return;
+    }
+    xSemaphoreTake(rx_lock_, portMAX_DELAY);
+    drain_done_ = done;
+    drain_deadline_us_ = esp_timer_get_time() + (int64_t)timeout_ms * 1000;
+    xSemaphoreGive(rx_lock_);
+}
+
+void UdpAudioChannel::finishDrain(bool flush) {
+    xSemaphoreTake(rx_lock_, portMAX_DELAY);
+    bool pending = drain_deadline_us_ != 0;
+    DrainHandler done = drain_done_;
+    drain_deadline_us_ = 0;
+    drain_done_ = nullptr;
+    xSemaphoreGive(rx_lock_);
+    if (!pending) {
+        return;
+    }
+
+    if (flush) {
+        // 输出窗口中剩余的包，缺口用补偿帧填上
+        for (int guard = 0; guard < 2 * REORDER_DEPTH; guard++) {
+            bool waiting = false;
+            for (int i = 0; i < REORDER_DEPTH; i++) {
+                waiting |= slots_[i].valid;
+            }
+            if (!waiting) {
+                break;
+            }
+            forceAdvance();
+        }
+        gap_since_us_ = 0;
+    }
+    eos_seen_ = false;
+
+    Stats st = getStats();
+    ESP_LOGI(TAG, "UDP下行统计: 收到 %lu, 重排 %lu, 迟到 %lu, 补偿 %lu",
+             (unsigned long)st.rx_packets, (unsigned long)st.rx_reordered,
+             (unsigned long)st.rx_late, (unsigned long)st.concealed);
+    if (done) {
+        done();
+    }
+}
+
+UdpAudioChannel::Stats UdpAudioChannel::getStats() const {
+    Stats stats;
+    stats.tx_packets = tx_packets_.load();
+    stats.tx_errors = tx_errors_.load();
+    stats.rx_packets = rx_packets_.load();
+    stats.rx_reordered = rx_reordered_.load();
+    stats.rx_late = rx_late_.load();
+    stats.concealed = concealed_frames_.load();
+    return stats;
+}
@@ -0,0 +1,201 @@
+/**
+ * @file udp_audio.h
+ * @brief 📡 UDP音频通道 - 与WebSocket控制通道并行的低延迟音频传输
+ *
+ * TCP上丢一个包会阻塞后面所有数据直到重传完成（队头阻塞），
+ * 在信号差的WiFi下表现为录音卡顿、下行音频一阵一阵地到。
+ * 这个通道把音频放到UDP上传输，WebSocket仍然负责可靠的控制消息：
+ *
+ * - 通过WebSocket协商：设备发 udp_offer，服务器回 udp_answer
+ * - RTP风格的包头：序号 + 时间戳 + SSRC，marker位标记一段回复的最后一包
+ * - 下行：小窗口重排 + 丢包补偿（重复上一包并衰减，连续丢包则补静音）
+ * - 上行：按帧打包直接发送，重排和丢包处理在服务器端
+ *
+ * 包格式与服务器端 rtp_audio.py 保持一致。
+ */
+
+#ifndef UDP_AUDIO_H
+#define UDP_AUDIO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <functional>
+#include <atomic>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+class UdpAudioChannel {
+public:
+    /**
+     * @brief 下行音频输出回调（按序输出，已做丢包补偿）
+     */
+    using AudioSink = std::function<void(const uint8_t* data, size_t len)>;
+
+    /**
+     * @brief 排空完成回调（在接收任务中调用）
+     */
+    using DrainHandler = std::function<void()>;
+
+    /**
+     * @brief 通道统计
+     */
+    struct Stats {
+        uint32_t tx_packets;    // 上行发送包数
+        uint32_t tx_errors;     // 上行发送失败数
+        uint32_t rx_packets;    // 下行收到包数
+        uint32_t rx_reordered;  // 乱序到达后被重排的包数
+        uint32_t rx_late;       // 迟到（已被补偿）或重复而丢弃的包数
+        uint32_t concealed;     // 丢包补偿的帧数
+    };
+
+    /**
+     * @brief 创建UDP音频通道
+     *
+     * @param local_port 本地监听端口（下行音频发到这个端口）
+     */
+    explicit UdpAudioChannel(uint16_t local_port);
+    ~UdpAudioChannel();
+
+    /**
+     * @brief 打开本地socket并启动接收任务
+     *
+     * @return ESP_OK=成功，ESP_FAIL=socket创建或绑定失败
+     */
+    esp_err_t open();
+
+    /**
+     * @brief 关闭socket并停止接收任务
+     */
+    void close();
+
+    /**
+     * @brief 生成协商请求（通过WebSocket发给服务器）
+     *
+     * @return JSON字符串，如 {"event":"udp_offer","port":5004,"ssrc":123,...}
+     */
+    std::string buildOffer() const;
+
+    /**
+     * @brief 处理服务器的协商应答
+     *
+     * @param json 服务器发来的 udp_answer 消息
+     * @param ws_uri 当前WebSocket地址，UDP发往同一主机
+     * @return ESP_OK=通道已启用，ESP_ERR_INVALID_ARG=应答格式错误
+     */
+    esp_err_t handleAnswer(const char* json, const std::string& ws_uri);
+
+    /**
+     * @brief 控制通道断开时停用通道，音频回退到WebSocket
+     */
+    void deactivate();
+
+    /**
+     * @brief 通道是否已协商成功
+     */
+    bool isActive() const { return active_; }
+
+    /**
+     * @brief 发送上行音频
+     *
+     * 按 MAX_PAYLOAD 切成多个数据报，非阻塞发送。
+     *
+     * @param samples 音频数据
+     * @param count 样本数
+     * @return 发送的字节数，-1=失败
+     */
+    int sendAudio(const int16_t* samples, size_t count);
+
+    /**
+     * @brief 设置下行音频输出回调
+     */
+    void setAudioSink(AudioSink sink) { sink_ = sink; }
+
+    /**
+     * @brief 请求排空：等当前回复的最后一包到达，输出重排窗口中剩余的数据后调用 done
+     *
+     * 控制通道上的结束信号可能比最后几个UDP包先到，收到结束信号后调用此函数，保证音频不被截断。
+     * 立即返回，等待和输出都在接收任务里进行，不阻塞调用方（WebSocket事件任务）。
+     * 通道未启用时直接调用 done；排空期间通道被停用或重新协商也会调用 done。
+     *
+     * @param timeout_ms 最长等待时间，超时后缺口用补偿帧填上
+     * @param done 排空完成回调
+     */
+    void drain(int timeout_ms, DrainHandler done);
+
+    /**
+     * @brief 获取统计快照
+     */
+    Stats getStats() const;
+
+    static constexpr size_t HEADER_SIZE = 12;           // 包头大小
+    static constexpr size_t MAX_PAYLOAD = 1024;         // 单包最大负载（小于WiFi MTU）
+    static constexpr uint8_t PT_PCM_S16LE_16K = 96;     // 负载类型：16kHz单声道PCM
+
+private:
+    static void rx_task(void* arg);
+    void handleDatagram(const uint8_t* data, size_t len);
+    void emitReady();
+    void concealOne();
+    void forceAdvance();
+    // 丢掉重排窗口和序号状态（新会话的序号从0重新开始）
+    void resetReceiver();
+    // 结束排空请求：flush=true 时先输出窗口中剩余的包，然后调用 done
+    void finishDrain(bool flush);
+    void emit(const uint8_t* data, size_t len);
+    static std::string hostFromUri(const std::string& uri);
+
+    // 下行重排窗口
+    struct Slot {
+        bool valid;
+        bool marker;
+        uint16_t len;
+        uint8_t data[MAX_PAYLOAD];
+    };
+    static constexpr int REORDER_DEPTH = 8;             // 重排窗口（包数）
+    static constexpr int REORDER_WAIT_MS = 40;          // 缺包最多等待时间，超时即补偿
+    static constexpr int RX_TASK_STACK_SIZE = 4096;
+
+    uint16_t local_port_;
+    int sock_;
+    uint32_t ssrc_;
+    volatile bool active_;
+    volatile bool stop_;
+    TaskHandle_t rx_task_handle_;
+    AudioSink sink_;
+
+    // 上行
+    uint8_t* tx_buffer_;
+    uint16_t tx_seq_;
+    uint32_t tx_timestamp_;
+    uint32_t remote_addr_;      // 网络字节序
+    uint16_t remote_port_;      // 网络字节序
+
+    // 下行（只在接收任务中访问，输出回调因此不在任何锁里调用）
+    Slot* slots_;
+    bool have_expected_;
+    uint16_t expected_seq_;
+    int64_t gap_since_us_;      // 开始等待缺失包的时间（0=没有缺包）
+    uint8_t last_payload_[MAX_PAYLOAD];
+    uint16_t last_len_;
+    int consecutive_lost_;
+    int16_t concealed_[MAX_PAYLOAD / sizeof(int16_t)];  // 补偿帧
+    bool eos_seen_;             // 最近输出的一包带结束标记
+
+    // 其他任务交给接收任务的请求，由 rx_lock_ 保护
+    SemaphoreHandle_t rx_lock_;
+    bool reset_pending_;        // 重新协商或停用，接收任务处理下一个包之前重置
+    int64_t drain_deadline_us_; // 排空截止时间（0=没有排空请求）
+    DrainHandler drain_done_;
+
+    std::atomic<uint32_t> tx_packets_;
+    std::atomic<uint32_t> tx_errors_;
+    std::atomic<uint32_t> rx_packets_;
+    std::atomic<uint32_t> rx_reordered_;
+    std::atomic<uint32_t> rx_late_;
+    std::atomic<uint32_t> concealed_frames_;
+};
+
+#endif // UDP_AUDIO_H
@@ -0,0 +1,151 @@
+/**
+ * @file uplink_quality.h
+ * @brief 📊 上行音频质量统计 - 每轮录音的电平、削波、信噪比和丢帧
+ *
+ * 服务器报"ASR 失败"时，光看设备日志分不清是声音太小、削波、太吵，还是发送失败丢了帧。
+ * 录音状态下每帧顺手累计几个数，说话结束时随 recording_ended 一起上报，服务器可以按设备统计、
+ * 和识别结果对照：
+ *
+ * - 电平：整轮的RMS和峰值（dBFS），在处理后、要发出去的数据上统计
+ * - 削波：原始采集数据（处理链之前）里达到满量程的样本比例，处理链的增益和限幅会掩盖削波
+ * - 信噪比：VAD判为说话的帧与静音帧的平均功率之比。说话帧里也有噪声，先减掉噪声功率再算
+ * - 丢帧：发送失败、或补发中断没发出去的帧数
+ *
+ * 每帧只做一遍平方累加和比较，没有除法和浮点；dB换算只在 summary() 里做一次。
+ * 纯头文件，不依赖ESP-IDF，主机端回归测试也可以直接编译。
+ */
+
+#ifndef UPLINK_QUALITY_H
+#define UPLINK_QUALITY_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <math.h>
+
+class UplinkQuality {
+public:
+    static constexpr int32_t CLIP_LEVEL = 32767;        // 绝对值达到满量程即算削波
+    static constexpr float FLOOR_DBFS = -96.0f;         // 全零数据的电平（16位动态范围）
+
+    struct Summary {
+        float rms_dbfs;             // 整轮RMS
+        float peak_dbfs;            // 整轮峰值
+        float clip_ratio;           // 原始数据削波样本比例（0~1）
+        float snr_db;               // 估计信噪比，snr_valid 为 false 时无意义
+        bool snr_valid;             // 说话帧和静音帧都有才能估计
+        uint32_t frames;            // 统计的帧数
+        uint32_t speech_frames;     // 其中VAD判为说话的帧数
+        uint32_t lost_frames;       // 发送失败丢掉的帧数
+    };
+
+    UplinkQuality() { reset(); }
+
+    /**
+     * @brief 开始新的一轮录音时清空统计
+     */
+    void reset() {
+        sum_sq_ = 0;
+        samples_ = 0;
+        peak_ = 0;
+        raw_samples_ = 0;
+        clipped_ = 0;
+        speech_sq_ = 0;
+        speech_samples_ = 0;
+        noise_sq_ = 0;
+        noise_samples_ = 0;
+        frames_ = 0;
+        speech_frames_ = 0;
+        lost_frames_ = 0;
+    }
+
+    /**
+     * @brief 统计一帧原始采集数据的削波（在处理链之前调用）
+     */
+    void addRaw(const int16_t* samples, size_t n) {
+        uint32_t clipped = 0;
+        for (size_t i = 0; i < n; i++) {
+            int32_t a = samples[i] < 0 ? -(int32_t)samples[i] : samples[i];
+            clipped += a >= CLIP_LEVEL ? 1 : 0;
+        }
+        clipped_ += clipped;
+        raw_samples_ += n;
+    }
+
+    /**
+     * @brief 统计一帧要上行的数据（处理后，发送前调用：原地掩码发送会改写帧数据）
+     *
+     * @param speech 这一帧的VAD判决
+     */
+    void addFrame(const int16_t* samples, size_t n, bool speech) {
+        uint64_t sq = 0;
+        int32_t peak = peak_;
+        for (size_t i = 0; i < n; i++) {
+            int32_t s = samples[i];
+            int32_t a = s < 0 ? -s : s;
+            sq += (uint64_t)(s * s);
+            peak = a > peak ? a : peak;
+        }
+        peak_ = peak;
+        sum_sq_ += sq;
+        samples_ += n;
+        frames_++;
+        if (speech) {
+            speech_sq_ += sq;
+            speech_samples_ += n;
+            speech_frames_++;
+        } else {
+            noise_sq_ += sq;
+            noise_samples_ += n;
+        }
+    }
+
+    /**
+     * @brief 记录发送失败丢掉的帧
+     */
+    void addLost(uint32_t frames) { lost_frames_ += frames; }
+
+    uint32_t lostFrames() const { return lost_frames_; }
+
+    Summary summary() const {
+        Summary s;
+        s.rms_dbfs = samples_ > 0 ? power_dbfs((double)sum_sq_ / samples_) : FLOOR_DBFS;
+        s.peak_dbfs = peak_ > 0 ? 20.0f * log10f(peak_ / 32768.0f) : FLOOR_DBFS;
+        s.clip_ratio = raw_samples_ > 0 ? (float)clipped_ / raw_samples_ : 0.0f;
+        s.snr_valid = speech_samples_ > 0 && noise_samples_ > 0 && noise_sq_ > 0;
+        s.snr_db = 0.0f;
+        if (s.snr_valid) {
+            double noise = (double)noise_sq_ / noise_samples_;
+            double speech = (double)speech_sq_ / speech_samples_ - noise;
+            // 说话帧不比静音帧响时信噪比按 0dB 以下的下限报
+            s.snr_db = speech > noise * 1e-3 ? (float)(10.0 * log10(speech / noise)) : -30.0f;
+        }
+        s.frames = frames_;
+        s.speech_frames = speech_frames_;
+        s.lost_frames = lost_frames_;
+        return s;
+    }
+
+private:
+    static float power_dbfs(double mean_sq) {
+        if (mean_sq <= 0) {
+            return FLOOR_DBFS;
+        }
+        float db = (float)(10.0 * log10(mean_sq / (32768.0 * 32768.0)));
+        return db < FLOOR_DBFS ? FLOOR_DBFS : db;
+    }
+
+    uint64_t sum_sq_;
+    uint64_t samples_;
+    int32_t peak_;
+    uint64_t raw_samples_;
+    uint64_t clipped_;
+    uint64_t speech_sq_;
+    uint64_t speech_samples_;
+    uint64_t noise_sq_;
+    uint64_t noise_samples_;
+    uint32_t frames_;
+    uint32_t speech_frames_;
+    uint32_t lost_frames_;
+};
+
+#endif // UPLINK_QUALITY_H
@@ -6,7 +6,9 @@
  */
 
  #include "websocket_client.h"
+ #include "ws_frame.h"
  #include "esp_log.h"
+ #include "esp_timer.h"
  #include <cstring>
  
  static const char *TAG = "WebSocketClient";
@@ -15,7 +17,11 @@
                                 int reconnect_interval_ms)
      : uri_(uri), auto_reconnect_(auto_reconnect),
        reconnect_interval_ms_(reconnect_interval_ms),
-       client_(nullptr), connected_(false), should_stop_(false), reconnect_task_handle_(nullptr) {
+       transport_(Transport::STOCK), client_(nullptr), lean_(nullptr), connected_(false), disconnect_reported_(false), should_stop_(false), reconnect_task_handle_(nullptr),
+       heartbeat_task_handle_(nullptr), heartbeat_interval_ms_(DEFAULT_HEARTBEAT_INTERVAL_MS),
+       last_alive_us_(0), ping_seq_(0), binary_copy_bytes_(0), max_send_frame_(0), reconnect_failures_(0) {
+     memset(&rtt_stats_, 0, sizeof(rtt_stats_));
+     portMUX_INITIALIZE(&stats_lock_);
  }
  
  WebSocketClient::~WebSocketClient() {
@@ -40,19 +46,28 @@
      switch (event_id) {
          case WEBSOCKET_EVENT_CONNECTED:
              ESP_LOGI(TAG, "WebSocket已连接");
+             ws_client->last_alive_us_ = esp_timer_get_time();
+             ws_client->reconnect_failures_ = 0;
              ws_client->connected_ = true;
+             ws_client->disconnect_reported_ = false;
              event.type = EventType::CONNECTED;
              break;
              
          case WEBSOCKET_EVENT_DISCONNECTED:
-             ESP_LOGI(TAG, "WebSocket已断开");
              ws_client->connected_ = false;
+             // 心跳判定断开时已经上报过，重连任务随后停止客户端又会收到一次
+             if (ws_client->disconnect_reported_.exchange(true)) {
+                 return;
+             }
+             ESP_LOGI(TAG, "WebSocket已断开");
              event.type = EventType::DISCONNECTED;
              break;
              
          case WEBSOCKET_EVENT_DATA:
              ESP_LOGD(TAG, "收到WebSocket数据，长度: %d 字节, op_code: 0x%02x", 
                      data->data_len, data->op_code);
+             // 收到任何帧都说明链路还活着（下行音频很密时服务器的pong可能排在后面）
+             ws_client->last_alive_us_ = esp_timer_get_time();
              event.data = (const uint8_t*)data->data_ptr;
              event.data_len = data->data_len;
              event.op_code = data->op_code;
@@ -66,6 +81,7 @@
                  event.type = EventType::PING;
              } else if (data->op_code == 0x0A) { // Pong帧（心跳回应）
                  event.type = EventType::PONG;
+                 ws_client->handlePong(event.data, event.data_len);
              } else {
                  event.type = EventType::DATA_BINARY; // 其他都当作二进制
              }
@@ -93,34 +109,216 @@
      // 重连任务主循环
      while (!ws_client->should_stop_) {
          // 检查是否需要重连
-         if (!ws_client->connected_ && ws_client->client_ != nullptr && ws_client->auto_reconnect_) {
+         if (!ws_client->connected_ && ws_client->hasTransport() && ws_client->auto_reconnect_) {
              ESP_LOGI(TAG, "尝试重新连接WebSocket...");
 
              // 先停止现有连接
-             esp_websocket_client_stop(ws_client->client_);
+             if (ws_client->client_ != nullptr) {
+                 esp_websocket_client_stop(ws_client->client_);
+             } else {
+                 ws_client->lean_->close();
+             }
              vTaskDelay(pdMS_TO_TICKS(100));
 
+             // 当前服务器多次失败时切换到备用服务器
+             ws_client->reconnect_failures_++;
+             if (ws_client->failover_handler_) {
+                 std::string next = ws_client->failover_handler_(ws_client->reconnect_failures_);
+                 if (!next.empty() && next != ws_client->uri_) {
+                     ESP_LOGW(TAG, "切换服务器: %s -> %s", ws_client->uri_.c_str(), next.c_str());
+                     ws_client->uri_ = next;
+                     if (ws_client->client_ != nullptr) {
+                         esp_websocket_client_set_uri(ws_client->client_, ws_client->uri_.c_str());
+                     }
+                 }
+             }
+
              // 重新启动连接
-             esp_websocket_client_start(ws_client->client_);
+             if (ws_client->client_ != nullptr) {
+                 esp_websocket_client_start(ws_client->client_);
+             } else {
+                 ws_client->openLean();
+             }
          }
 
-         // 休眠一段时间后再检查
-         vTaskDelay(pdMS_TO_TICKS(ws_client->reconnect_interval_ms_));
+         // 休眠一段时间后再检查（心跳判定断开时会提前唤醒）
+         ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(ws_client->reconnect_interval_ms_));
      }
 
      // 任务优雅退出
      ws_client->reconnect_task_handle_ = nullptr;
      vTaskDelete(NULL);
  }
- 
- esp_err_t WebSocketClient::connect() {
-     if (client_ != nullptr) {
-         ESP_LOGW(TAG, "WebSocket客户端已存在");
-         return ESP_OK;
+
+ void WebSocketClient::heartbeat_task(void* arg) {
+     WebSocketClient* ws_client = static_cast<WebSocketClient*>(arg);
+
+     while (!ws_client->should_stop_) {
+         // 间隔被修改时会提前唤醒，新间隔立即生效
+         ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(ws_client->heartbeat_interval_ms_));
+         if (ws_client->should_stop_) {
+             break;
+         }
+         if (!ws_client->connected_ || !ws_client->hasTransport()) {
+             continue;
+         }
+
+         // 超过 HEARTBEAT_MISS_LIMIT 个间隔没有收到任何帧，说明链路已经半开
+         int64_t silent_ms = (esp_timer_get_time() - ws_client->last_alive_us_) / 1000;
+         if (silent_ms > (int64_t)ws_client->heartbeat_interval_ms_ * HEARTBEAT_MISS_LIMIT) {
+             ws_client->declareLinkDead(silent_ms);
+             continue;
+         }
+
+         ws_client->sendPing();
      }
-     
-     ESP_LOGI(TAG, "正在连接WebSocket服务器: %s", uri_.c_str());
-     
+
+     ws_client->heartbeat_task_handle_ = nullptr;
+     vTaskDelete(NULL);
+ }
+
+ void WebSocketClient::handlePong(const uint8_t* data, size_t len) {
+     int64_t now_us = esp_timer_get_time();
+
+     // 只统计自己发出的心跳（8字节：序号 + 发送时间戳）
+     if (data == nullptr || len != 2 * sizeof(uint32_t)) {
+         return;
+     }
+     uint32_t sent_us;
+     memcpy(&sent_us, data + sizeof(uint32_t), sizeof(sent_us));
+     uint32_t rtt_ms = ((uint32_t)now_us - sent_us) / 1000;
+
+     portENTER_CRITICAL(&stats_lock_);
+     RttStats& st = rtt_stats_;
+     if (st.samples == 0) {
+         st.srtt_ms = rtt_ms;
+         st.jitter_ms = rtt_ms / 2;
+         st.min_ms = rtt_ms;
+         st.max_ms = rtt_ms;
+     } else {
+         uint32_t delta = (rtt_ms > st.srtt_ms) ? rtt_ms - st.srtt_ms : st.srtt_ms - rtt_ms;
+         st.jitter_ms = (3 * st.jitter_ms + delta) / 4;
+         st.srtt_ms = (7 * st.srtt_ms + rtt_ms) / 8;
+         if (rtt_ms < st.min_ms) st.min_ms = rtt_ms;
+         if (rtt_ms > st.max_ms) st.max_ms = rtt_ms;
+     }
+     st.last_ms = rtt_ms;
+     st.samples++;
+     uint32_t srtt_ms = st.srtt_ms;
+     uint32_t jitter_ms = st.jitter_ms;
+     portEXIT_CRITICAL(&stats_lock_);
+
+     ESP_LOGD(TAG, "心跳RTT: %lu ms (平滑 %lu ms, 抖动 %lu ms)",
+              (unsigned long)rtt_ms, (unsigned long)srtt_ms, (unsigned long)jitter_ms);
+ }
+
+ void WebSocketClient::declareLinkDead(int64_t silent_ms) {
+     ESP_LOGW(TAG, "已 %lld ms 未收到心跳回应，判定连接已断开", (long long)silent_ms);
+
+     portENTER_CRITICAL(&stats_lock_);
+     rtt_stats_.dead_links++;
+     portEXIT_CRITICAL(&stats_lock_);
+
+     connected_ = false;
+
+     // 立即唤醒重连任务，不必等满一个重连间隔
+     if (reconnect_task_handle_ != nullptr) {
+         xTaskNotifyGive(reconnect_task_handle_);
+     }
+
+     reportDisconnected();
+ }
+
+ void WebSocketClient::reportDisconnected() {
+     if (!disconnect_reported_.exchange(true)) {
+         dispatchEvent(EventType::DISCONNECTED, nullptr, 0, 0);
+     }
+ }
+
+ void WebSocketClient::dispatchEvent(EventType type, const uint8_t* data, size_t len, int op_code) {
+     if (event_callback_) {
+         EventData event;
+         event.type = type;
+         event.data = data;
+         event.data_len = len;
+         event.op_code = op_code;
+         event_callback_(event);
+     }
+ }
+
+ void WebSocketClient::onConnected() {
+     ESP_LOGI(TAG, "WebSocket已连接");
+     last_alive_us_ = esp_timer_get_time();
+     reconnect_failures_ = 0;
+     connected_ = true;
+     disconnect_reported_ = false;
+     dispatchEvent(EventType::CONNECTED, nullptr, 0, 0);
+ }
+
+ bool WebSocketClient::openLean() {
+     std::string connect_ip = address_lookup_ ? address_lookup_(uri_) : std::string();
+     if (lean_->open(uri_, NETWORK_TIMEOUT_MS, connect_ip) != ESP_OK) {
+         return false;
+     }
+     onConnected();
+     return true;
+ }
+
+ void WebSocketClient::onLeanFrame(uint8_t opcode, const uint8_t* data, size_t len) {
+     // 收到任何帧都说明链路还活着（包括直接收进播放缓冲区的音频）
+     last_alive_us_ = esp_timer_get_time();
+
+     // 与esp_websocket_client的事件保持一致，上层不用区分传输实现
+     switch (opcode) {
+         case ws_frame::OP_TEXT:
+             dispatchEvent(EventType::DATA_TEXT, data, len, opcode);
+             break;
+         case ws_frame::OP_BINARY:
+             dispatchEvent(EventType::DATA_BINARY, data, len, opcode);
+             break;
+         case ws_frame::OP_PING:
+             dispatchEvent(EventType::PING, data, len, opcode);
+             break;
+         case ws_frame::OP_PONG:
+             handlePong(data, len);
+             dispatchEvent(EventType::PONG, data, len, opcode);
+             break;
+         default:
+             break;              // close帧：随后由 onLeanClosed() 上报断开
+     }
+ }
+
+ void WebSocketClient::onLeanClosed() {
+     if (!connected_) {
+         return;
+     }
+     ESP_LOGI(TAG, "WebSocket已断开");
+     connected_ = false;
+     reportDisconnected();
+     if (reconnect_task_handle_ != nullptr) {
+         xTaskNotifyGive(reconnect_task_handle_);
+     }
+ }
+
+ void WebSocketClient::setHeartbeatInterval(int interval_ms) {
+     if (interval_ms <= 0 || interval_ms == heartbeat_interval_ms_) {
+         return;
+     }
+     ESP_LOGD(TAG, "心跳间隔调整为 %d ms", interval_ms);
+     heartbeat_interval_ms_ = interval_ms;
+     if (heartbeat_task_handle_ != nullptr) {
+         xTaskNotifyGive(heartbeat_task_handle_);
+     }
+ }
+
+ WebSocketClient::RttStats WebSocketClient::getRttStats() const {
+     portENTER_CRITICAL(&stats_lock_);
+     RttStats copy = rtt_stats_;
+     portEXIT_CRITICAL(&stats_lock_);
+     return copy;
+ }
+ 
+ esp_err_t WebSocketClient::startStock() {
      // 🔧 配置WebSocket参数
      esp_websocket_client_config_t ws_cfg = {};
      ws_cfg.uri = uri_.c_str();            // 服务器地址
@@ -151,13 +349,54 @@
          client_ = nullptr;
          return ret;
      }
+     return ESP_OK;
+ }
+
+ esp_err_t WebSocketClient::startLean() {
+     lean_ = new LeanWsTransport();
+     lean_->setFrameHandler([this](uint8_t opcode, const uint8_t* data, size_t len) {
+         onLeanFrame(opcode, data, len);
+     });
+     lean_->setCloseHandler([this]() { onLeanClosed(); });
+     if (binary_receiver_.acquire) {
+         lean_->setBinaryReceiver(binary_receiver_);
+     }
+     // 首次连接失败不算错误，与esp_websocket_client一样交给重连任务
+     if (!openLean()) {
+         ESP_LOGW(TAG, "首次连接失败，稍后重连");
+     }
+     return ESP_OK;
+ }
+
+ esp_err_t WebSocketClient::connect() {
+     if (hasTransport()) {
+         ESP_LOGW(TAG, "WebSocket客户端已存在");
+         return ESP_OK;
+     }
+     
+     ESP_LOGI(TAG, "正在连接WebSocket服务器: %s", uri_.c_str());
+
+     esp_err_t ret = (transport_ == Transport::LEAN) ? startLean() : startStock();
+     if (ret != ESP_OK) {
+         return ret;
+     }
      
+     // 之前disconnect()可能置位过停止标志
+     should_stop_ = false;
+
      // 创建自动重连任务
      if (auto_reconnect_ && reconnect_task_handle_ == nullptr) {
          xTaskCreate(reconnect_task, "ws_reconnect", RECONNECT_TASK_STACK_SIZE, 
                     this, 5, &reconnect_task_handle_);
          ESP_LOGI(TAG, "自动重连任务已启动");
      }
+
+     // 创建心跳任务
+     if (heartbeat_task_handle_ == nullptr) {
+         xTaskCreate(heartbeat_task, "ws_heartbeat", HEARTBEAT_TASK_STACK_SIZE,
+                    this, 5, &heartbeat_task_handle_);
+         ESP_LOGI(TAG, "心跳任务已启动，间隔 %d ms", heartbeat_interval_ms_);
+     }
      
      return ESP_OK;
  }
@@ -167,6 +406,7 @@
      if (reconnect_task_handle_ != nullptr) {
          ESP_LOGI(TAG, "请求停止自动重连任务...");
          should_stop_ = true;
+         xTaskNotifyGive(reconnect_task_handle_);
 
          // 等待任务优雅退出（最多等待2秒）
          TickType_t timeout = xTaskGetTickCount() + pdMS_TO_TICKS(2000);
@@ -184,6 +424,22 @@
          ESP_LOGI(TAG, "自动重连任务已停止");
      }
 
+     // 停止心跳任务
+     if (heartbeat_task_handle_ != nullptr) {
+         should_stop_ = true;
+         xTaskNotifyGive(heartbeat_task_handle_);
+
+         TickType_t timeout = xTaskGetTickCount() + pdMS_TO_TICKS(2000);
+         while (heartbeat_task_handle_ != nullptr && xTaskGetTickCount() < timeout) {
+             vTaskDelay(pdMS_TO_TICKS(50));
+         }
+         if (heartbeat_task_handle_ != nullptr) {
+             ESP_LOGW(TAG, "心跳任务未响应，强制删除");
+             vTaskDelete(heartbeat_task_handle_);
+             heartbeat_task_handle_ = nullptr;
+         }
+     }
+
      // 断开并清理WebSocket连接
      if (client_ != nullptr) {
          ESP_LOGI(TAG, "正在断开WebSocket连接...");
@@ -193,16 +449,31 @@
          connected_ = false;
          ESP_LOGI(TAG, "WebSocket已完全断开");
      }
+     if (lean_ != nullptr) {
+         ESP_LOGI(TAG, "正在断开WebSocket连接...");
+         lean_->close();
+         delete lean_;
+         lean_ = nullptr;
+         connected_ = false;
+         ESP_LOGI(TAG, "WebSocket已完全断开");
+     }
  }
  
  int WebSocketClient::sendText(const std::string& text, int timeout_ms) {
-     if (client_ == nullptr || !connected_) {
+     if (!hasTransport() || !connected_) {
          ESP_LOGW(TAG, "WebSocket未连接，无法发送文本");
          return -1;
      }
+     size_t limit = max_send_frame_;
+     if (limit > 0 && text.length() > limit) {
+         ESP_LOGE(TAG, "文本消息 %zu 字节，超过协商的单帧上限 %zu 字节", text.length(), limit);
+         return -1;
+     }
      
      // 调用ESP-IDF的WebSocket API发送文本数据
-     int len = esp_websocket_client_send_text(client_, text.c_str(), text.length(), 
+     int len = lean_ != nullptr ?
+               lean_->send(ws_frame::OP_TEXT, (const uint8_t*)text.c_str(), text.length(), timeout_ms) :
+               esp_websocket_client_send_text(client_, text.c_str(), text.length(), 
                                              timeout_ms / portTICK_PERIOD_MS);
      if (len < 0) {
          ESP_LOGE(TAG, "发送文本失败");
@@ -214,35 +485,74 @@
  }
  
  int WebSocketClient::sendBinary(const uint8_t* data, size_t len, int timeout_ms) {
-     if (client_ == nullptr || !connected_) {
+     if (!hasTransport() || !connected_) {
          ESP_LOGW(TAG, "WebSocket未连接，无法发送二进制数据");
          return -1;
      }
      
-     // 调用ESP-IDF的WebSocket API发送二进制数据（通常是音频）
-     int sent = esp_websocket_client_send_bin(client_, (const char*)data, len, 
-                                             timeout_ms / portTICK_PERIOD_MS);
+     // 调用ESP-IDF的WebSocket API发送二进制数据（通常是音频），超过单帧上限时分几帧发
+     size_t limit = max_send_frame_ > 0 ? max_send_frame_ : len;
+     size_t offset = 0;
+     int sent = 0;
+     do {
+         size_t n = len - offset < limit ? len - offset : limit;
+         sent = lean_ != nullptr ?
+                lean_->send(ws_frame::OP_BINARY, data + offset, n, timeout_ms) :
+                esp_websocket_client_send_bin(client_, (const char*)data + offset, n,
+                                              timeout_ms / portTICK_PERIOD_MS);
+         offset += n;
+     } while (sent >= 0 && offset < len);
      if (sent < 0) {
          ESP_LOGE(TAG, "发送二进制数据失败");
-     } else {
-         ESP_LOGD(TAG, "发送二进制数据成功: %d 字节", sent);
+         return -1;
+     }
+     binary_copy_bytes_ += len;
+     ESP_LOGD(TAG, "发送二进制数据成功: %zu 字节", len);
+     return (int)len;
+ }
+ 
+ int WebSocketClient::sendBinaryInPlace(uint8_t* data, size_t len, int timeout_ms) {
+     if (lean_ == nullptr || !connected_) {
+         return sendBinary(data, len, timeout_ms);
      }
      
-     return sent;
+     size_t limit = max_send_frame_ > 0 ? max_send_frame_ : len;
+     size_t offset = 0;
+     int sent = 0;
+     do {
+         size_t n = len - offset < limit ? len - offset : limit;
+         sent = lean_->sendInPlace(ws_frame::OP_BINARY, data + offset, n, timeout_ms);
+         offset += n;
+     } while (sent >= 0 && offset < len);
+     if (sent < 0) {
+         ESP_LOGE(TAG, "发送二进制数据失败");
+         return -1;
+     }
+     ESP_LOGD(TAG, "原地发送二进制数据成功: %zu 字节", len);
+     return (int)len;
  }
  
- esp_err_t WebSocketClient::sendPing() {
-     if (client_ == nullptr || !connected_) {
+ esp_err_t WebSocketClient::sendPing(int timeout_ms) {
+     if (!hasTransport() || !connected_) {
          ESP_LOGW(TAG, "WebSocket未连接，无法发送ping");
          return ESP_ERR_INVALID_STATE;
      }
      
-     // 发送 WebSocket ping 包保活
-     int ret = esp_websocket_client_send_with_opcode(client_, WS_TRANSPORT_OPCODES_PING, NULL, 0, portMAX_DELAY);
+     // 负载 = 序号 + 发送时间戳(us)，服务器在pong中原样返回
+     uint32_t payload[2];
+     payload[0] = ++ping_seq_;
+     payload[1] = (uint32_t)esp_timer_get_time();
+
+     // 发送 WebSocket ping 包保活（带超时，不会被大块音频发送无限阻塞）
+     int ret = lean_ != nullptr ?
+               lean_->send(ws_frame::OP_PING, (const uint8_t*)payload, sizeof(payload), timeout_ms) :
+               esp_websocket_client_send_with_opcode(client_, WS_TRANSPORT_OPCODES_PING,
+                                                     (const uint8_t*)payload, sizeof(payload),
+                                                     pdMS_TO_TICKS(timeout_ms));
      if (ret < 0) {
-         ESP_LOGW(TAG, "发送ping失败，标记连接为断开");
-         // ping失败时标记连接为断开，让重连任务可以工作
-         connected_ = false;
+         // 发送锁被大块音频占着也会超时，链路未必断了：只算丢了一次心跳，
+         // 由 heartbeat_task 按 HEARTBEAT_MISS_LIMIT 判定并走 declareLinkDead()
+         ESP_LOGW(TAG, "发送ping失败，记为一次心跳丢失");
          return ESP_FAIL;
      }
      ESP_LOGD(TAG, "发送ping成功");
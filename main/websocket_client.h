@@ -2,10 +2,13 @@
 #define WEBSOCKET_CLIENT_H
 
 #include "esp_websocket_client.h"
+#include "ws_lean_transport.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include <stdint.h>
 #include <string>
 #include <functional>
+#include <atomic>
 
 class WebSocketClient {
 public:
@@ -22,6 +25,14 @@ public:
         PONG,           // 收到pong（心跳回应）
         ERROR           // 发生错误
     };
+
+    /**
+     * @brief 底层传输实现
+     */
+    enum class Transport {
+        STOCK,          // esp_websocket_client（默认）
+        LEAN            // 精简传输：分散写、按字掩码、下行直接收进调用方缓冲区（见 ws_lean_transport.h）
+    };
     
     /**
      * @brief WebSocket事件数据结构
@@ -29,7 +40,7 @@ public:
      */
     struct EventData {
         EventType type;         // 事件类型
-        const uint8_t* data;    // 数据指针（可能为空）
+        const uint8_t* data;    // 数据指针（可能为空；DATA_BINARY为空表示已直接写入BinaryReceiver）
         size_t data_len;        // 数据长度
         int op_code;            // WebSocket操作码
     };
@@ -39,6 +50,35 @@ public:
      * 
      */
     using EventCallback = std::function<void(const EventData&)>;
+
+    /**
+     * @brief 故障切换回调
+     *
+     * 自动重连前调用，参数为自上次连接成功以来的重连次数。
+     * 返回新的服务器URI即切换服务器，返回空字符串表示继续重连当前服务器。
+     */
+    using FailoverHandler = std::function<std::string(int consecutive_failures)>;
+
+    /**
+     * @brief 连接地址查询：给出URI对应的IP（DNS缓存），返回空字符串表示按主机名解析
+     */
+    using AddressLookup = std::function<std::string(const std::string& uri)>;
+
+    /**
+     * @brief 应用层心跳的RTT统计
+     *
+     * 心跳ping携带序号和发送时间戳，服务器原样回送pong，
+     * 据此计算往返时延。平滑算法与TCP的SRTT/RTTVAR相同。
+     */
+    struct RttStats {
+        uint32_t last_ms;       // 最近一次RTT
+        uint32_t srtt_ms;       // 平滑RTT（增益1/8）
+        uint32_t jitter_ms;     // RTT抖动（平均偏差，增益1/4）
+        uint32_t min_ms;        // 最小RTT
+        uint32_t max_ms;        // 最大RTT
+        uint32_t samples;       // 收到的有效pong数量
+        uint32_t dead_links;    // 心跳判定为半开连接的次数
+    };
     
     /**
      * @brief 创建WebSocket客户端
@@ -64,6 +104,19 @@ public:
      */
     void setEventCallback(EventCallback callback);
     
+    /**
+     * @brief 选择底层传输（需在 connect() 之前调用）
+     */
+    void setTransport(Transport transport) { transport_ = transport; }
+
+    /**
+     * @brief 设置下行二进制数据的直接接收目标（仅精简传输有效）
+     *
+     * 设置后二进制负载直接收进 receiver 提供的缓冲区，
+     * 随后的 DATA_BINARY 事件 data 为空、data_len 为写入的字节数。
+     */
+    void setBinaryReceiver(const LeanWsTransport::BinaryReceiver& receiver) { binary_receiver_ = receiver; }
+
     /**
      * @brief 连接到服务器
      * 
@@ -78,6 +131,14 @@ public:
      */
     void disconnect();
     
+    /**
+     * @brief 设置发送的单帧负载上限（hello协商出的 max_frame），0=不限制
+     *
+     * 二进制数据超过上限时按顺序拆成多个帧发出（音频是连续的PCM，服务器依次拼接）；
+     * 文本消息是完整的JSON事件，不能拆开，超过上限时拒绝发送。
+     */
+    void setMaxSendFrame(size_t max_frame) { max_send_frame_ = max_frame; }
+
     /**
      * @brief 发送文本消息
      * 
@@ -85,7 +146,7 @@ public:
      * 
      * @param text 要发送的文本内容
      * @param timeout_ms 超时时间（默认永不超时）
-     * @return 发送的字节数，-1=失败
+     * @return 发送的字节数，-1=失败（包括超过单帧上限）
      */
     int sendText(const std::string& text, int timeout_ms = portMAX_DELAY);
     
@@ -100,12 +161,35 @@ public:
      * @return 发送的字节数，-1=失败
      */
     int sendBinary(const uint8_t* data, size_t len, int timeout_ms = portMAX_DELAY);
+
+    /**
+     * @brief 发送二进制数据，允许破坏调用方缓冲区以省掉一次拷贝
+     *
+     * 精简传输下原地掩码后直接发出，返回后 data 的内容已被掩码破坏；
+     * esp_websocket_client 下与 sendBinary 相同（库内部总会拷贝）。
+     * 只在调用方是数据的最后一个使用者时调用。
+     *
+     * @return 发送的字节数，-1=失败
+     */
+    int sendBinaryInPlace(uint8_t* data, size_t len, int timeout_ms = portMAX_DELAY);
+
+    /**
+     * @brief 二进制负载在发送路径上被拷贝的累计字节数
+     *
+     * esp_websocket_client 每次发送都先拷进自己的缓冲区；
+     * 精简传输只有 sendBinary 经过暂存区，sendBinaryInPlace 不拷贝。
+     */
+    uint64_t getBinaryCopyBytes() const { return binary_copy_bytes_; }
     
     /**
-     * @brief 发送ping包
+     * @brief 发送带时间戳的心跳ping包
+     *
+     * 服务器回送的pong会被用来更新RTT统计。
+     *
+     * @param timeout_ms 发送超时时间（默认1秒，避免被大块音频发送卡住）
      * @return ESP_OK表示成功，其他值表示失败
      */
-    esp_err_t sendPing();
+    esp_err_t sendPing(int timeout_ms = PING_SEND_TIMEOUT_MS);
     
     /**
      * @brief 查询连接状态
@@ -126,6 +210,42 @@ public:
      */
     void setReconnectInterval(int interval_ms) { reconnect_interval_ms_ = interval_ms; }
 
+    /**
+     * @brief 设置故障切换回调
+     * @param handler 回调函数
+     */
+    void setFailoverHandler(FailoverHandler handler) { failover_handler_ = handler; }
+
+    /**
+     * @brief 设置连接地址查询（只对精简传输生效，esp_websocket_client 总是自己解析主机名）
+     */
+    void setAddressLookup(AddressLookup lookup) { address_lookup_ = lookup; }
+
+    /**
+     * @brief 当前使用的服务器地址
+     */
+    const std::string& getUri() const { return uri_; }
+
+    /**
+     * @brief 单次收到的数据最大长度（接收缓冲区大小），握手时告知服务器
+     */
+    static constexpr int getMaxFrameSize() { return BUFFER_SIZE; }
+
+    /**
+     * @brief 设置心跳间隔
+     *
+     * 连续 HEARTBEAT_MISS_LIMIT 个间隔收不到pong即判定连接已死，
+     * 因此间隔越短，半开连接被发现得越快。可随对话状态随时调整。
+     *
+     * @param interval_ms 心跳间隔（毫秒）
+     */
+    void setHeartbeatInterval(int interval_ms);
+
+    /**
+     * @brief 获取心跳RTT统计快照
+     */
+    RttStats getRttStats() const;
+
 private:
     // WebSocket事件处理器
     static void websocket_event_handler(void* handler_args, esp_event_base_t base, 
@@ -133,29 +253,79 @@ private:
     
     // 重连任务
     static void reconnect_task(void* arg);
+
+    // 心跳任务：定时发送ping并检测半开连接
+    static void heartbeat_task(void* arg);
+
+    // 处理pong回包，更新RTT统计
+    void handlePong(const uint8_t* data, size_t len);
+
+    // 心跳判定连接已死：标记断开并唤醒重连任务
+    void declareLinkDead(int64_t silent_ms);
+
+    // 按 transport_ 创建底层客户端
+    esp_err_t startStock();
+    esp_err_t startLean();
+
+    // 精简传输：建立连接、转发帧事件、处理断开
+    bool openLean();
+    void onLeanFrame(uint8_t opcode, const uint8_t* data, size_t len);
+    void onLeanClosed();
+
+    // 连接成功/断开的公共处理
+    void onConnected();
+    // 每次连接只上报一次 DISCONNECTED（心跳判定和传输层断开都会走到这里）
+    void reportDisconnected();
+    void dispatchEvent(EventType type, const uint8_t* data, size_t len, int op_code);
+
+    bool hasTransport() const { return client_ != nullptr || lean_ != nullptr; }
     
     // 配置参数
     std::string uri_;
     bool auto_reconnect_;
     int reconnect_interval_ms_;
     
-    // WebSocket客户端句柄
+    // WebSocket客户端句柄（二选一）
+    Transport transport_;
     esp_websocket_client_handle_t client_;
+    LeanWsTransport* lean_;
+    LeanWsTransport::BinaryReceiver binary_receiver_;
     
     // 状态变量
     bool connected_;
+    std::atomic<bool> disconnect_reported_;     // 本次连接的断开已经上报
     bool should_stop_;  // 用于优雅停止重连任务
 
     // 重连任务句柄
     TaskHandle_t reconnect_task_handle_;
+
+    // 心跳相关
+    TaskHandle_t heartbeat_task_handle_;
+    volatile int heartbeat_interval_ms_;
+    volatile int64_t last_alive_us_;    // 最近一次确认链路存活的时间（连接成功或收到任何帧）
+    uint32_t ping_seq_;
+    uint64_t binary_copy_bytes_;
+    volatile size_t max_send_frame_;    // 发送单帧负载上限，0=不限制
+    RttStats rtt_stats_;
+    mutable portMUX_TYPE stats_lock_;
     
     // 事件回调
     EventCallback event_callback_;
+
+    // 故障切换
+    FailoverHandler failover_handler_;
+    AddressLookup address_lookup_;
+    int reconnect_failures_;    // 自上次连接成功以来的重连次数
     
     // 内部配置常量
     static constexpr int BUFFER_SIZE = 8192;                // 数据缓冲区大小（8KB）
     static constexpr int TASK_STACK_SIZE = 8192;            // WebSocket任务栈大小
     static constexpr int RECONNECT_TASK_STACK_SIZE = 4096;  // 重连任务栈大小
+    static constexpr int HEARTBEAT_TASK_STACK_SIZE = 3072;  // 心跳任务栈大小
+    static constexpr int DEFAULT_HEARTBEAT_INTERVAL_MS = 2000; // 默认心跳间隔
+    static constexpr int HEARTBEAT_MISS_LIMIT = 3;          // 连续丢失几个心跳判定断开
+    static constexpr int PING_SEND_TIMEOUT_MS = 1000;       // ping发送超时
+    static constexpr int NETWORK_TIMEOUT_MS = 10000;        // 精简传输的连接/握手超时
 };
 
 #endif // WEBSOCKET_CLIENT_H
\ No newline at end of file
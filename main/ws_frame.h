@@ -0,0 +1,197 @@
+/**
+ * @file ws_frame.h
+ * @brief 🧱 WebSocket帧编解码与负载掩码
+ *
+ * RFC 6455 规定客户端发出的每个帧都要用4字节掩码逐字节异或。
+ * 这里把掩码做成按32位字处理（每次16字节展开），并提供“边拷贝边掩码”
+ * 和“原地掩码”两种形式，发送路径只需一次遍历数据。
+ *
+ * 纯头文件，不依赖ESP-IDF，主机端基准测试也可以直接编译。
+ */
+
+#ifndef WS_FRAME_H
+#define WS_FRAME_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+namespace ws_frame {
+
+enum Opcode : uint8_t {
+    OP_CONTINUATION = 0x0,
+    OP_TEXT         = 0x1,
+    OP_BINARY       = 0x2,
+    OP_CLOSE        = 0x8,
+    OP_PING         = 0x9,
+    OP_PONG         = 0xA,
+};
+
+constexpr size_t MAX_HEADER_SIZE = 14;      // 2 + 8字节长度 + 4字节掩码
+
+/**
+ * @brief 解析出的帧头
+ */
+struct FrameHeader {
+    bool fin;
+    uint8_t opcode;
+    bool masked;
+    uint64_t payload_len;
+    uint8_t mask[4];
+    size_t header_len;
+};
+
+/**
+ * @brief 生成客户端帧头（FIN=1，带掩码）
+ *
+ * @param out 至少 MAX_HEADER_SIZE 字节
+ * @param opcode 操作码
+ * @param len 负载长度
+ * @param mask_key 掩码（内存字节序，即 mask[0] 在最低地址）
+ * @return 帧头长度
+ */
+inline size_t build_client_header(uint8_t* out, uint8_t opcode, uint64_t len, uint32_t mask_key) {
+    size_t pos = 0;
+    out[pos++] = 0x80 | (opcode & 0x0F);
+    if (len < 126) {
+        out[pos++] = 0x80 | (uint8_t)len;
+    } else if (len <= 0xFFFF) {
+        out[pos++] = 0x80 | 126;
+        out[pos++] = (uint8_t)(len >> 8);
+        out[pos++] = (uint8_t)len;
+    } else {
+        out[pos++] = 0x80 | 127;
+        for (int i = 7; i >= 0; i--) {
+            out[pos++] = (uint8_t)(len >> (8 * i));
+        }
+    }
+    memcpy(out + pos, &mask_key, 4);
+    return pos + 4;
+}
+
+/**
+ * @brief 解析帧头
+ *
+ * @param buf 已收到的数据
+ * @param avail 已收到的字节数
+ * @param out 解析结果
+ * @return >0=帧头长度，0=数据不够（至少需要 out->header_len 字节），-1=格式错误
+ */
+inline int parse_header(const uint8_t* buf, size_t avail, FrameHeader* out) {
+    if (avail < 2) {
+        out->header_len = 2;
+        return 0;
+    }
+    out->fin = (buf[0] & 0x80) != 0;
+    out->opcode = buf[0] & 0x0F;
+    out->masked = (buf[1] & 0x80) != 0;
+    if (buf[0] & 0x70) {
+        return -1;                          // 没有协商扩展，RSV位必须为0
+    }
+
+    uint8_t len7 = buf[1] & 0x7F;
+    size_t need = 2 + (len7 == 126 ? 2 : len7 == 127 ? 8 : 0) + (out->masked ? 4 : 0);
+    out->header_len = need;
+    if (avail < need) {
+        return 0;
+    }
+
+    size_t pos = 2;
+    if (len7 == 126) {
+        out->payload_len = ((uint64_t)buf[2] << 8) | buf[3];
+        pos += 2;
+    } else if (len7 == 127) {
+        out->payload_len = 0;
+        for (int i = 0; i < 8; i++) {
+            out->payload_len = (out->payload_len << 8) | buf[pos++];
+        }
+    } else {
+        out->payload_len = len7;
+    }
+    if (out->masked) {
+        memcpy(out->mask, buf + pos, 4);
+    }
+    // 控制帧不能分片，负载不超过125字节
+    if ((out->opcode & 0x08) && (!out->fin || out->payload_len > 125)) {
+        return -1;
+    }
+    return (int)need;
+}
+
+/**
+ * @brief 逐字节掩码（参考实现，基准测试对照用）
+ *
+ * @param key_pos 本段数据在整个负载中的偏移 % 4
+ * @return 处理后的 key_pos
+ */
+inline size_t mask_bytes(uint8_t* dst, const uint8_t* src, size_t len, uint32_t mask_key, size_t key_pos) {
+    uint8_t key[4];
+    memcpy(key, &mask_key, 4);
+    for (size_t i = 0; i < len; i++) {
+        dst[i] = src[i] ^ key[(key_pos + i) & 3];
+    }
+    return (key_pos + len) & 3;
+}
+
+/**
+ * @brief 按32位字掩码，可以边拷贝边掩码（dst != src），也可以原地掩码（dst == src）
+ *
+ * 先逐字节处理到 dst 4字节对齐，再把掩码旋转到对应相位，按字异或。
+ * 字的读写都用 memcpy，src 未对齐时编译器也会生成合适的加载指令。
+ *
+ * @param key_pos 本段数据在整个负载中的偏移 % 4（分段发送时接着上一段）
+ * @return 处理后的 key_pos
+ */
+inline size_t mask_words(uint8_t* dst, const uint8_t* src, size_t len, uint32_t mask_key, size_t key_pos) {
+    uint8_t key[4];
+    memcpy(key, &mask_key, 4);
+
+    // 1. 逐字节处理到目标地址对齐
+    while (len > 0 && ((uintptr_t)dst & 3) != 0) {
+        *dst++ = *src++ ^ key[key_pos];
+        key_pos = (key_pos + 1) & 3;
+        len--;
+    }
+
+    // 2. 掩码按当前相位旋转：字中第i个字节对应 key[(key_pos + i) & 3]
+    uint32_t word_key = (uint32_t)key[key_pos] |
+                        ((uint32_t)key[(key_pos + 1) & 3] << 8) |
+                        ((uint32_t)key[(key_pos + 2) & 3] << 16) |
+                        ((uint32_t)key[(key_pos + 3) & 3] << 24);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    word_key = __builtin_bswap32(word_key);
+#endif
+
+    // 字的读写都走 memcpy：不违反严格别名规则，对齐时编译器生成单条32位加载/存储
+    while (len >= 16) {
+        uint32_t w[4];
+        memcpy(w, src, 16);
+        w[0] ^= word_key;
+        w[1] ^= word_key;
+        w[2] ^= word_key;
+        w[3] ^= word_key;
+        memcpy(dst, w, 16);
+        dst += 16;
+        src += 16;
+        len -= 16;
+    }
+    while (len >= 4) {
+        uint32_t w;
+        memcpy(&w, src, 4);
+        w ^= word_key;
+        memcpy(dst, &w, 4);
+        dst += 4;
+        src += 4;
+        len -= 4;
+    }
+
+    // 3. 剩余不足一个字的尾巴（整字处理不改变相位）
+    for (size_t i = 0; i < len; i++) {
+        dst[i] = src[i] ^ key[(key_pos + i) & 3];
+    }
+    return (key_pos + len) & 3;
+}
+
+} // namespace ws_frame
+
+#endif // WS_FRAME_H
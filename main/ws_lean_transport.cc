@@ -0,0 +1,486 @@
+/**
+ * @file ws_lean_transport.cc
+ * @brief ⚡ 精简WebSocket传输实现
+ */
+
+#include "ws_lean_transport.h"
+#include "ws_frame.h"
+#include "net_connect.h"
+#include "esp_log.h"
+#include "esp_random.h"
+#include "esp_heap_caps.h"
+#include "lwip/sockets.h"
+#include "lwip/netdb.h"
+#include "mbedtls/sha1.h"
+#include "mbedtls/base64.h"
+#include <cstring>
+#include <cctype>
+
+static const char *TAG = "LeanWs";
+
+static const char* WS_GUID = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+static constexpr size_t HANDSHAKE_MAX = 1024;
+
+LeanWsTransport::LeanWsTransport()
+    : sock_(-1), closing_(false), rx_task_handle_(nullptr), tx_lock_(xSemaphoreCreateMutex()),
+      rx_buffer_(nullptr), tx_staging_(nullptr), rx_data_opcode_(ws_frame::OP_BINARY),
+      current_send_timeout_ms_(-1) {
+    memset(&stats_, 0, sizeof(stats_));
+}
+
+LeanWsTransport::~LeanWsTransport() {
+    close();
+    vSemaphoreDelete(tx_lock_);
+    heap_caps_free(rx_buffer_);
+    heap_caps_free(tx_staging_);
+}
+
+esp_err_t LeanWsTransport::open(const std::string& uri, int timeout_ms, const std::string& connect_ip) {
+    if (sock_ >= 0) {
+        close();
+    }
+
+    // 解析 ws://host:port/path
+    if (uri.compare(0, 5, "ws://") != 0) {
+        ESP_LOGE(TAG, "只支持 ws:// 地址: %s", uri.c_str());
+        return ESP_ERR_INVALID_ARG;
+    }
+    size_t host_start = 5;
+    size_t path_start = uri.find('/', host_start);
+    std::string authority = uri.substr(host_start, path_start == std::string::npos ?
+                                       std::string::npos : path_start - host_start);
+    std::string path = path_start == std::string::npos ? "/" : uri.substr(path_start);
+    std::string host = authority;
+    uint16_t port = 80;
+    size_t colon = authority.find(':');
+    if (colon != std::string::npos) {
+        host = authority.substr(0, colon);
+        port = (uint16_t)atoi(authority.c_str() + colon + 1);
+    }
+
+    // 缓冲区放内部RAM：接收任务和掩码循环频繁访问
+    if (rx_buffer_ == nullptr) {
+        rx_buffer_ = (uint8_t*)heap_caps_malloc(RX_BUFFER_SIZE, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    }
+    if (tx_staging_ == nullptr) {
+        tx_staging_ = (uint8_t*)heap_caps_malloc(TX_STAGING_SIZE, MALLOC_CAP_INTERNAL | MALLOC_CAP_32BIT);
+    }
+    if (rx_buffer_ == nullptr || tx_staging_ == nullptr) {
+        ESP_LOGE(TAG, "缓冲区分配失败");
+        return ESP_ERR_NO_MEM;
+    }
+
+    struct addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo* res = nullptr;
+    char port_str[8];
+    snprintf(port_str, sizeof(port_str), "%u", port);
+    // 有缓存的IP就直接连，握手里的 Host 仍然用URI中的主机名
+    const std::string& target = connect_ip.empty() ? host : connect_ip;
+    if (getaddrinfo(target.c_str(), port_str, &hints, &res) != 0 || res == nullptr) {
+        ESP_LOGE(TAG, "解析地址失败: %s", target.c_str());
+        return ESP_FAIL;
+    }
+
+    int sock = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
+    if (sock < 0) {
+        freeaddrinfo(res);
+        return ESP_FAIL;
+    }
+
+    struct timeval tv;
+    tv.tv_sec = timeout_ms / 1000;
+    tv.tv_usec = (timeout_ms % 1000) * 1000;
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(sock, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+    int ret = net_connect_timeout(sock, res->ai_addr, res->ai_addrlen, timeout_ms);
+    freeaddrinfo(res);
+    if (ret != 0) {
+        ESP_LOGW(TAG, "TCP连接失败: %s:%u errno %d", target.c_str(), port, errno);
+        ::close(sock);
+        return ESP_FAIL;
+    }
+
+    // 与esp_websocket_client相同的保活参数；音频小包不等Nagle合并
+    int one = 1;
+    int keep_idle = 30, keep_interval = 10, keep_count = 3;
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    setsockopt(sock, SOL_SOCKET, SO_KEEPALIVE, &one, sizeof(one));
+    setsockopt(sock, IPPROTO_TCP, TCP_KEEPIDLE, &keep_idle, sizeof(keep_idle));
+    setsockopt(sock, IPPROTO_TCP, TCP_KEEPINTVL, &keep_interval, sizeof(keep_interval));
+    setsockopt(sock, IPPROTO_TCP, TCP_KEEPCNT, &keep_count, sizeof(keep_count));
+
+    // 发送方在 tx_lock_ 里检查 isOpen()：握手完成之前它们拿不到这个socket
+    xSemaphoreTake(tx_lock_, portMAX_DELAY);
+    sock_ = sock;
+    closing_ = false;
+    current_send_timeout_ms_ = timeout_ms;
+    bool ok = handshake(authority, port, path);
+    if (!ok) {
+        ::close(sock_);
+        sock_ = -1;
+    }
+    xSemaphoreGive(tx_lock_);
+    if (!ok) {
+        return ESP_FAIL;
+    }
+
+    // 接收任务用1秒超时轮询，以便及时发现 close() 请求
+    tv.tv_sec = 1;
+    tv.tv_usec = 0;
+    setsockopt(sock_, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    rx_data_opcode_ = ws_frame::OP_BINARY;
+    xTaskCreate(rx_task, "ws_lean_rx", RX_TASK_STACK_SIZE, this, 5, &rx_task_handle_);
+    ESP_LOGI(TAG, "已连接: %s", uri.c_str());
+    return ESP_OK;
+}
+
+bool LeanWsTransport::handshake(const std::string& host, uint16_t port, const std::string& path) {
+    uint8_t nonce[16];
+    esp_fill_random(nonce, sizeof(nonce));
+    unsigned char key[32];
+    size_t key_len = 0;
+    mbedtls_base64_encode(key, sizeof(key), &key_len, nonce, sizeof(nonce));
+    key[key_len] = '\0';
+
+    char* req = (char*)rx_buffer_;
+    int req_len = snprintf(req, HANDSHAKE_MAX,
+                           "GET %s HTTP/1.1\r\n"
+                           "Host: %s\r\n"
+                           "Upgrade: websocket\r\n"
+                           "Connection: Upgrade\r\n"
+                           "Sec-WebSocket-Key: %s\r\n"
+                           "Sec-WebSocket-Version: 13\r\n\r\n",
+                           path.c_str(), host.c_str(), (const char*)key);
+    if (!writeAll(nullptr, 0, (const uint8_t*)req, req_len)) {
+        ESP_LOGW(TAG, "发送握手请求失败");
+        return false;
+    }
+
+    // 逐字节读到空行为止，握手之后的字节属于第一个帧，不能多读
+    size_t len = 0;
+    while (len < HANDSHAKE_MAX - 1) {
+        if (recv(sock_, rx_buffer_ + len, 1, 0) != 1) {
+            ESP_LOGW(TAG, "读取握手应答失败");
+            return false;
+        }
+        len++;
+        if (len >= 4 && memcmp(rx_buffer_ + len - 4, "\r\n\r\n", 4) == 0) {
+            break;
+        }
+    }
+    rx_buffer_[len] = '\0';
+    char* resp = (char*)rx_buffer_;
+    if (strncmp(resp, "HTTP/1.1 101", 12) != 0) {
+        ESP_LOGW(TAG, "服务器拒绝升级: %.*s", 32, resp);
+        return false;
+    }
+
+    // 期望的 Accept = base64(SHA1(key + GUID))
+    char concat[sizeof(key) + 40];
+    snprintf(concat, sizeof(concat), "%s%s", (const char*)key, WS_GUID);
+    unsigned char digest[20];
+    mbedtls_sha1((const unsigned char*)concat, strlen(concat), digest);
+    unsigned char expected[32];
+    size_t expected_len = 0;
+    mbedtls_base64_encode(expected, sizeof(expected), &expected_len, digest, sizeof(digest));
+    expected[expected_len] = '\0';
+
+    for (char* p = resp; *p; p++) {
+        *p = (char)tolower((unsigned char)*p);
+    }
+    const char* accept = strstr(resp, "sec-websocket-accept:");
+    if (accept == nullptr) {
+        ESP_LOGW(TAG, "握手应答缺少 Sec-WebSocket-Accept");
+        return false;
+    }
+    accept += strlen("sec-websocket-accept:");
+    while (*accept == ' ') {
+        accept++;
+    }
+    // 应答已转成小写，base64比较也按不区分大小写进行
+    for (size_t i = 0; i < expected_len; i++) {
+        if (accept[i] != (char)tolower(expected[i])) {
+            ESP_LOGW(TAG, "Sec-WebSocket-Accept 不匹配");
+            return false;
+        }
+    }
+    return true;
+}
+
+void LeanWsTransport::close() {
+    if (sock_ < 0) {
+        return;
+    }
+    closing_ = true;
+    shutdown(sock_, SHUT_RDWR);
+
+    if (rx_task_handle_ != nullptr && rx_task_handle_ != xTaskGetCurrentTaskHandle()) {
+        TickType_t timeout = xTaskGetTickCount() + pdMS_TO_TICKS(2000);
+        while (rx_task_handle_ != nullptr && xTaskGetTickCount() < timeout) {
+            vTaskDelay(pdMS_TO_TICKS(20));
+        }
+        if (rx_task_handle_ != nullptr) {
+            ESP_LOGW(TAG, "接收任务未响应，强制删除");
+            vTaskDelete(rx_task_handle_);
+            rx_task_handle_ = nullptr;
+        }
+    }
+
+    // shutdown 已让阻塞中的发送返回；等它放开锁再释放socket，发送方不会写到已关闭（或被复用）的描述符
+    xSemaphoreTake(tx_lock_, portMAX_DELAY);
+    ::close(sock_);
+    sock_ = -1;
+    xSemaphoreGive(tx_lock_);
+}
+
+void LeanWsTransport::setSendTimeout(int timeout_ms) {
+    if (timeout_ms <= 0) {
+        timeout_ms = 0;                     // portMAX_DELAY：不超时
+    }
+    if (timeout_ms == current_send_timeout_ms_) {
+        return;
+    }
+    struct timeval tv;
+    tv.tv_sec = timeout_ms / 1000;
+    tv.tv_usec = (timeout_ms % 1000) * 1000;
+    setsockopt(sock_, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    current_send_timeout_ms_ = timeout_ms;
+}
+
+bool LeanWsTransport::writeAll(const uint8_t* header, size_t header_len, const uint8_t* payload, size_t len) {
+    struct iovec iov[2];
+    int iovcnt = 0;
+    if (header_len > 0) {
+        iov[iovcnt].iov_base = (void*)header;
+        iov[iovcnt].iov_len = header_len;
+        iovcnt++;
+    }
+    if (len > 0) {
+        iov[iovcnt].iov_base = (void*)payload;
+        iov[iovcnt].iov_len = len;
+        iovcnt++;
+    }
+
+    struct msghdr msg = {};
+    msg.msg_iov = iov;
+    msg.msg_iovlen = iovcnt;
+    while (msg.msg_iovlen > 0) {
+        ssize_t n = sendmsg(sock_, &msg, 0);
+        if (n <= 0) {
+            return false;
+        }
+        // 部分写出：跳过已发送的部分继续
+        while (n > 0 && msg.msg_iovlen > 0) {
+            if ((size_t)n >= msg.msg_iov[0].iov_len) {
+                n -= msg.msg_iov[0].iov_len;
+                msg.msg_iov++;
+                msg.msg_iovlen--;
+            } else {
+                msg.msg_iov[0].iov_base = (uint8_t*)msg.msg_iov[0].iov_base + n;
+                msg.msg_iov[0].iov_len -= n;
+                n = 0;
+            }
+        }
+    }
+    return true;
+}
+
+int LeanWsTransport::send(uint8_t opcode, const uint8_t* data, size_t len, int timeout_ms) {
+    return sendFrame(opcode, data, len, timeout_ms, false);
+}
+
+int LeanWsTransport::sendInPlace(uint8_t opcode, uint8_t* data, size_t len, int timeout_ms) {
+    return sendFrame(opcode, data, len, timeout_ms, true);
+}
+
+int LeanWsTransport::sendFrame(uint8_t opcode, const uint8_t* data, size_t len, int timeout_ms, bool in_place) {
+    TickType_t wait = timeout_ms <= 0 ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
+    if (xSemaphoreTake(tx_lock_, wait) != pdTRUE) {
+        return -1;
+    }
+    // 重连会在锁里替换socket，所以在锁里检查
+    if (!isOpen()) {
+        xSemaphoreGive(tx_lock_);
+        return -1;
+    }
+    setSendTimeout(timeout_ms);
+
+    uint32_t mask_key = esp_random();
+    uint8_t header[ws_frame::MAX_HEADER_SIZE];
+    size_t header_len = ws_frame::build_client_header(header, opcode, len, mask_key);
+
+    bool ok;
+    if (in_place) {
+        // 零拷贝：原地掩码，帧头和负载一次分散写出
+        ws_frame::mask_words((uint8_t*)data, data, len, mask_key, 0);
+        ok = writeAll(header, header_len, data, len);
+    } else {
+        // 边拷贝边掩码进暂存区，分段写出；暂存区大小是4的倍数，段间掩码相位不变
+        size_t offset = 0;
+        ok = true;
+        do {
+            size_t n = len - offset < TX_STAGING_SIZE ? len - offset : TX_STAGING_SIZE;
+            ws_frame::mask_words(tx_staging_, data + offset, n, mask_key, 0);
+            ok = offset == 0 ? writeAll(header, header_len, tx_staging_, n)
+                             : writeAll(nullptr, 0, tx_staging_, n);
+            offset += n;
+        } while (ok && offset < len);
+    }
+
+    if (ok) {
+        stats_.tx_bytes += len;
+        stats_.tx_frames++;
+    } else {
+        // 帧写了一半，流已经无法继续使用；关闭读端让接收任务退出并上报断开
+        ESP_LOGW(TAG, "发送失败: errno %d", errno);
+        shutdown(sock_, SHUT_RDWR);
+    }
+    xSemaphoreGive(tx_lock_);
+    return ok ? (int)len : -1;
+}
+
+bool LeanWsTransport::recvAll(uint8_t* buf, size_t len) {
+    while (len > 0) {
+        ssize_t n = recv(sock_, buf, len, 0);
+        if (n > 0) {
+            buf += n;
+            len -= n;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) && !closing_) {
+            continue;                       // 接收超时，只是用来检查 closing_
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool LeanWsTransport::readPayload(uint8_t opcode, uint64_t len, const uint8_t* mask, size_t mask_pos) {
+    uint32_t mask_key = 0;
+    if (mask != nullptr) {
+        memcpy(&mask_key, mask, 4);
+    }
+
+    // 二进制负载优先直接收进调用方缓冲区
+    size_t direct = 0;
+    while (len > 0 && opcode == ws_frame::OP_BINARY && receiver_.acquire) {
+        size_t granted = 0;
+        uint8_t* dst = receiver_.acquire((size_t)len, &granted);
+        if (dst == nullptr || granted == 0) {
+            break;
+        }
+        size_t n = granted < len ? granted : (size_t)len;
+        if (!recvAll(dst, n)) {
+            receiver_.commit(0);
+            return false;
+        }
+        if (mask != nullptr) {
+            mask_pos = ws_frame::mask_words(dst, dst, n, mask_key, mask_pos);
+        }
+        receiver_.commit(n);
+        direct += n;
+        len -= n;
+    }
+    if (direct > 0) {
+        stats_.rx_bytes += direct;
+        stats_.rx_direct_bytes += direct;
+        if (frame_handler_) {
+            frame_handler_(opcode, nullptr, direct);
+        }
+    }
+
+    // 其余情况收进内部缓冲区交给上层；超过缓冲区的帧分段交付（与esp_websocket_client一致）
+    while (len > 0) {
+        size_t n = len < RX_BUFFER_SIZE ? (size_t)len : RX_BUFFER_SIZE;
+        if (!recvAll(rx_buffer_, n)) {
+            return false;
+        }
+        if (mask != nullptr) {
+            mask_pos = ws_frame::mask_words(rx_buffer_, rx_buffer_, n, mask_key, mask_pos);
+        }
+        stats_.rx_bytes += n;
+        len -= n;
+        if (frame_handler_) {
+            frame_handler_(opcode, rx_buffer_, n);
+        }
+    }
+    return true;
+}
+
+void LeanWsTransport::rxLoop() {
+    uint8_t head[ws_frame::MAX_HEADER_SIZE];
+    while (!closing_) {
+        ws_frame::FrameHeader fh = {};
+        if (!recvAll(head, 2)) {
+            break;
+        }
+        int ret = ws_frame::parse_header(head, 2, &fh);
+        if (ret == 0) {
+            // 扩展长度和掩码还没收到
+            if (!recvAll(head + 2, fh.header_len - 2)) {
+                break;
+            }
+            ret = ws_frame::parse_header(head, fh.header_len, &fh);
+        }
+        if (ret < 0) {
+            ESP_LOGW(TAG, "收到非法帧头 %02x %02x", head[0], head[1]);
+            break;
+        }
+        stats_.rx_frames++;
+
+        if (fh.opcode & 0x08) {
+            // 控制帧：负载不超过125字节，整体读入后处理
+            uint8_t payload[125];
+            size_t len = (size_t)fh.payload_len;
+            if (!recvAll(payload, len)) {
+                break;
+            }
+            if (fh.masked) {
+                uint32_t key;
+                memcpy(&key, fh.mask, 4);
+                ws_frame::mask_bytes(payload, payload, len, key, 0);
+            }
+            if (fh.opcode == ws_frame::OP_PING) {
+                send(ws_frame::OP_PONG, payload, len, 1000);
+            } else if (fh.opcode == ws_frame::OP_CLOSE) {
+                ESP_LOGI(TAG, "服务器关闭连接");
+                send(ws_frame::OP_CLOSE, payload, len >= 2 ? 2 : 0, 1000);
+                break;
+            }
+            if (frame_handler_) {
+                frame_handler_(fh.opcode, payload, len);
+            }
+            continue;
+        }
+
+        // 数据帧：续帧沿用分片消息第一帧的类型
+        uint8_t opcode = fh.opcode;
+        if (opcode == ws_frame::OP_CONTINUATION) {
+            opcode = rx_data_opcode_;
+        } else {
+            rx_data_opcode_ = opcode;
+        }
+        if (!readPayload(opcode, fh.payload_len, fh.masked ? fh.mask : nullptr, 0)) {
+            break;
+        }
+    }
+}
+
+void LeanWsTransport::rx_task(void* arg) {
+    LeanWsTransport* self = static_cast<LeanWsTransport*>(arg);
+    self->rxLoop();
+
+    bool by_peer = !self->closing_;
+    self->closing_ = true;
+    self->rx_task_handle_ = nullptr;
+    if (by_peer) {
+        ESP_LOGW(TAG, "连接已断开");
+        if (self->close_handler_) {
+            self->close_handler_();
+        }
+    }
+    vTaskDelete(NULL);
+}
@@ -0,0 +1,142 @@
+/**
+ * @file ws_lean_transport.h
+ * @brief ⚡ 精简WebSocket传输 - 直接基于lwIP socket的客户端实现
+ *
+ * esp_websocket_client 每次发送都先把负载拷进自己的缓冲区，再逐字节掩码；
+ * 接收时也要先收进内部缓冲区，再通过事件交给上层拷贝一次。
+ * 音频上下行是数据量最大的路径，这里去掉这些多余的拷贝：
+ *
+ * - 发送：帧头和负载用 sendmsg 分散写出；负载边拷贝边按32位字掩码进一个小暂存区，
+ *   只遍历一次数据；调用方可以放弃缓冲区内容时用 sendInPlace() 原地掩码，完全不拷贝
+ * - 接收：二进制帧的负载通过 BinaryReceiver 直接收进调用方的缓冲区
+ *   （例如 AudioManager 的播放环形缓冲区），不经过中间缓冲
+ *
+ * 只实现客户端需要的部分：ws://（无TLS）、无扩展、自动回复ping和close。
+ */
+
+#ifndef WS_LEAN_TRANSPORT_H
+#define WS_LEAN_TRANSPORT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <functional>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+class LeanWsTransport {
+public:
+    /**
+     * @brief 收到一个完整的帧（或超长帧的一段）
+     *
+     * data 为空表示二进制负载已经直接写入了 BinaryReceiver 提供的缓冲区。
+     */
+    using FrameHandler = std::function<void(uint8_t opcode, const uint8_t* data, size_t len)>;
+
+    /**
+     * @brief 连接断开（对端关闭、网络错误）
+     */
+    using CloseHandler = std::function<void()>;
+
+    /**
+     * @brief 二进制负载的直接接收目标
+     *
+     * acquire 返回一段可写的连续空间（*granted 为其大小，可以小于 want），
+     * 返回空表示当前不接收，负载改为通过 FrameHandler 交付。
+     * commit 在数据写入后调用，n 为实际写入的字节数；接收失败时以 n=0 调用，
+     * 每次非空的 acquire 都对应一次 commit。
+     */
+    struct BinaryReceiver {
+        std::function<uint8_t*(size_t want, size_t* granted)> acquire;
+        std::function<void(size_t n)> commit;
+    };
+
+    /**
+     * @brief 传输统计
+     */
+    struct Stats {
+        uint64_t tx_bytes;          // 发送的负载字节数
+        uint64_t rx_bytes;          // 收到的负载字节数
+        uint64_t rx_direct_bytes;   // 直接收进调用方缓冲区的字节数
+        uint32_t tx_frames;
+        uint32_t rx_frames;
+    };
+
+    LeanWsTransport();
+    ~LeanWsTransport();
+
+    void setFrameHandler(FrameHandler handler) { frame_handler_ = handler; }
+    void setCloseHandler(CloseHandler handler) { close_handler_ = handler; }
+    void setBinaryReceiver(const BinaryReceiver& receiver) { receiver_ = receiver; }
+
+    /**
+     * @brief 建立TCP连接并完成WebSocket握手，成功后启动接收任务
+     *
+     * @param uri ws://host:port/path
+     * @param timeout_ms 连接和握手超时
+     * @param connect_ip 连接用的IP（DNS缓存），空=解析URI中的主机名
+     * @return ESP_OK=成功，ESP_ERR_INVALID_ARG=URI不支持，ESP_FAIL=连接或握手失败
+     */
+    esp_err_t open(const std::string& uri, int timeout_ms, const std::string& connect_ip = std::string());
+
+    /**
+     * @brief 关闭连接并等待接收任务退出（不触发 CloseHandler）
+     */
+    void close();
+
+    /**
+     * @brief 连接是否可用（只作提示，发送时会在发送锁里重新检查）
+     */
+    bool isOpen() const { return sock_ >= 0 && !closing_; }
+
+    /**
+     * @brief 发送一个帧（负载边拷贝边掩码，调用方缓冲区不被修改）
+     *
+     * @param timeout_ms 超时时间（portMAX_DELAY=永不超时）
+     * @return 发送的负载字节数，-1=失败（连接会被关闭）
+     */
+    int send(uint8_t opcode, const uint8_t* data, size_t len, int timeout_ms);
+
+    /**
+     * @brief 原地掩码后发送（零拷贝），返回后 data 的内容已被掩码破坏
+     */
+    int sendInPlace(uint8_t opcode, uint8_t* data, size_t len, int timeout_ms);
+
+    /**
+     * @brief 获取统计快照
+     */
+    Stats getStats() const { return stats_; }
+
+    static constexpr size_t RX_BUFFER_SIZE = 8192;      // 非直接接收时的缓冲区（与esp_websocket_client一致）
+    static constexpr size_t TX_STAGING_SIZE = 2048;     // 发送掩码暂存区
+
+private:
+    static void rx_task(void* arg);
+    void rxLoop();
+    bool recvAll(uint8_t* buf, size_t len);
+    bool readPayload(uint8_t opcode, uint64_t len, const uint8_t* mask, size_t mask_pos);
+    bool writeAll(const uint8_t* header, size_t header_len, const uint8_t* payload, size_t len);
+    int sendFrame(uint8_t opcode, const uint8_t* data, size_t len, int timeout_ms, bool in_place);
+    bool handshake(const std::string& host, uint16_t port, const std::string& path);
+    void setSendTimeout(int timeout_ms);
+
+    int sock_;
+    volatile bool closing_;
+    TaskHandle_t rx_task_handle_;
+    SemaphoreHandle_t tx_lock_;     // 串行化发送，也保护 sock_ 的建立和释放
+    uint8_t* rx_buffer_;
+    uint8_t* tx_staging_;
+    uint8_t rx_data_opcode_;        // 分片消息的数据类型（续帧沿用）
+    int current_send_timeout_ms_;
+
+    FrameHandler frame_handler_;
+    CloseHandler close_handler_;
+    BinaryReceiver receiver_;
+    Stats stats_;
+
+    static constexpr int RX_TASK_STACK_SIZE = 6144;
+};
+
+#endif // WS_LEAN_TRANSPORT_H
@@ -0,0 +1,143 @@
+/**
+ * @file ws_transport_bench.cc
+ * @brief 📊 WebSocket传输基准测试实现
+ */
+
+#include "ws_transport_bench.h"
+#include "websocket_client.h"
+#include "ws_frame.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <cstring>
+#include <cstdlib>
+
+static const char *TAG = "WsBench";
+
+static constexpr size_t BENCH_TOTAL_BYTES = 1024 * 1024;    // 每种传输上传1MB
+static constexpr size_t BENCH_FRAME_BYTES = 2000;           // 与预录音补发的分块相同（1000样本）
+static constexpr size_t MASK_BUFFER_BYTES = 32 * 1024;
+static constexpr int MASK_ROUNDS = 32;
+
+/**
+ * @brief 掩码内核吞吐（MB/s）
+ */
+static void bench_mask_kernels(void)
+{
+    uint8_t* src = (uint8_t*)heap_caps_malloc(MASK_BUFFER_BYTES, MALLOC_CAP_INTERNAL | MALLOC_CAP_32BIT);
+    uint8_t* dst = (uint8_t*)heap_caps_malloc(MASK_BUFFER_BYTES, MALLOC_CAP_INTERNAL | MALLOC_CAP_32BIT);
+    if (src == nullptr || dst == nullptr) {
+        ESP_LOGW(TAG, "掩码测试缓冲区分配失败");
+        heap_caps_free(src);
+        heap_caps_free(dst);
+        return;
+    }
+    for (size_t i = 0; i < MASK_BUFFER_BYTES; i++) {
+        src[i] = (uint8_t)i;
+    }
+    const uint32_t key = 0x5A3C96E1;
+
+    int64_t start = esp_timer_get_time();
+    for (int r = 0; r < MASK_ROUNDS; r++) {
+        ws_frame::mask_bytes(dst, src, MASK_BUFFER_BYTES, key, 0);
+    }
+    int64_t bytes_us = esp_timer_get_time() - start;
+
+    start = esp_timer_get_time();
+    for (int r = 0; r < MASK_ROUNDS; r++) {
+        ws_frame::mask_words(dst, src, MASK_BUFFER_BYTES, key, 0);
+    }
+    int64_t words_us = esp_timer_get_time() - start;
+
+    // 最后一次是 mask_words 的结果，与逐字节结果对照
+    uint8_t check[64];
+    ws_frame::mask_bytes(check, src, sizeof(check), key, 0);
+    bool match = memcmp(check, dst, sizeof(check)) == 0;
+
+    double total_mb = (double)MASK_BUFFER_BYTES * MASK_ROUNDS / (1024.0 * 1024.0);
+    ESP_LOGI(TAG, "掩码内核: 逐字节 %.1f MB/s, 按字 %.1f MB/s (%.1fx)%s",
+             total_mb / (bytes_us / 1e6), total_mb / (words_us / 1e6),
+             (double)bytes_us / (double)words_us, match ? "" : " [结果不一致!]");
+
+    heap_caps_free(src);
+    heap_caps_free(dst);
+}
+
+/**
+ * @brief 用指定传输上传 BENCH_TOTAL_BYTES，等待服务器确认
+ */
+static void bench_transport(const std::string& uri, WebSocketClient::Transport transport, const char* name)
+{
+    SemaphoreHandle_t connected = xSemaphoreCreateBinary();
+    SemaphoreHandle_t done = xSemaphoreCreateBinary();
+    volatile long server_bytes = -1;
+
+    size_t internal_before = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    WebSocketClient* client = new WebSocketClient(uri, false, 1000);
+    client->setTransport(transport);
+    client->setEventCallback([&](const WebSocketClient::EventData& event) {
+        if (event.type == WebSocketClient::EventType::CONNECTED) {
+            xSemaphoreGive(connected);
+        } else if (event.type == WebSocketClient::EventType::DATA_TEXT && event.data != nullptr) {
+            std::string text((const char*)event.data, event.data_len);
+            size_t pos = text.find("\"bytes\":");
+            if (pos != std::string::npos) {
+                server_bytes = atol(text.c_str() + pos + strlen("\"bytes\":"));
+                xSemaphoreGive(done);
+            }
+        }
+    });
+
+    uint8_t* frame = (uint8_t*)heap_caps_malloc(BENCH_FRAME_BYTES, MALLOC_CAP_INTERNAL);
+    if (frame != nullptr && client->connect() == ESP_OK &&
+        xSemaphoreTake(connected, pdMS_TO_TICKS(5000)) == pdTRUE) {
+        size_t internal_connected = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+        for (size_t i = 0; i < BENCH_FRAME_BYTES; i++) {
+            frame[i] = (uint8_t)i;
+        }
+
+        size_t sent = 0;
+        int64_t start = esp_timer_get_time();
+        while (sent < BENCH_TOTAL_BYTES) {
+            if (client->sendBinary(frame, BENCH_FRAME_BYTES, 5000) < 0) {
+                break;
+            }
+            sent += BENCH_FRAME_BYTES;
+        }
+        int64_t send_us = esp_timer_get_time() - start;
+        client->sendText("{\"event\":\"bench_done\"}", 1000);
+        bool confirmed = xSemaphoreTake(done, pdMS_TO_TICKS(10000)) == pdTRUE;
+        int64_t total_us = esp_timer_get_time() - start;
+
+        ESP_LOGI(TAG, "%s: 发送 %zu 字节用时 %lld ms (%.1f KB/s)，服务器确认 %ld 字节，端到端 %.1f KB/s，"
+                 "连接占用内部RAM %zu 字节",
+                 name, sent, (long long)(send_us / 1000), sent / 1024.0 / (send_us / 1e6),
+                 confirmed ? (long)server_bytes : -1L, sent / 1024.0 / (total_us / 1e6),
+                 internal_before > internal_connected ? internal_before - internal_connected : 0);
+    } else {
+        ESP_LOGW(TAG, "%s: 无法连接 %s（服务器需运行 loopback_server.py）", name, uri.c_str());
+    }
+
+    client->disconnect();
+    delete client;
+    heap_caps_free(frame);
+    vSemaphoreDelete(connected);
+    vSemaphoreDelete(done);
+}
+
+void ws_transport_bench_run(const std::string& ws_uri)
+{
+    // 同一台服务器的 /ws/bench 端点
+    size_t host_start = ws_uri.find("://");
+    host_start = (host_start == std::string::npos) ? 0 : host_start + 3;
+    size_t path_start = ws_uri.find('/', host_start);
+    std::string uri = ws_uri.substr(0, path_start) + "/ws/bench";
+
+    ESP_LOGI(TAG, "========== WebSocket传输基准测试 ==========");
+    bench_mask_kernels();
+    bench_transport(uri, WebSocketClient::Transport::STOCK, "esp_websocket_client");
+    bench_transport(uri, WebSocketClient::Transport::LEAN, "精简传输");
+    ESP_LOGI(TAG, "==========================================");
+}
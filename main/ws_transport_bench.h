@@ -0,0 +1,23 @@
+/**
+ * @file ws_transport_bench.h
+ * @brief 📊 WebSocket传输基准测试 - 对比 esp_websocket_client 与精简传输
+ *
+ * 配合 loopback_server.py 的 /ws/bench 端点使用（CONFIG_WS_TRANSPORT_BENCH）：
+ * - 掩码内核：逐字节 vs 按32位字，纯CPU吞吐
+ * - 端到端：两种传输各上传 BENCH_TOTAL_BYTES，帧大小与实时上行相同，
+ *   服务器确认收到的字节数和耗时
+ */
+
+#ifndef WS_TRANSPORT_BENCH_H
+#define WS_TRANSPORT_BENCH_H
+
+#include <string>
+
+/**
+ * @brief 运行基准测试并打印结果（阻塞，约数秒）
+ *
+ * @param ws_uri 当前选中的服务器地址，路径会被替换为 /ws/bench
+ */
+void ws_transport_bench_run(const std::string& ws_uri);
+
+#endif // WS_TRANSPORT_BENCH_H
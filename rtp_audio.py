@@ -0,0 +1,214 @@
+"""
+RTP风格的UDP音频包 - 服务器端公共模块
+功能：打包/解包音频数据报，按序号重排并标记丢包
+
+包格式（12字节头，网络字节序，与设备端 udp_audio.h 保持一致）：
+  byte 0    : 0x80 (版本2)
+  byte 1    : bit7=marker(本段回复的最后一包) | bit0-6=payload type
+  byte 2-3  : 序号 seq (uint16，回绕)
+  byte 4-7  : 时间戳 (uint32，以样本为单位)
+  byte 8-11 : SSRC (uint32，会话标识)
+  其后      : PCM s16le 16kHz 单声道
+"""
+
+import asyncio
+import struct
+import time
+
+import hello_protocol
+
+RTP_HEADER = struct.Struct("!BBHII")
+RTP_VERSION = 0x80
+PT_PCM_S16LE_16K = 96
+SAMPLE_RATE = 16000
+FRAME_MS = 20
+FRAME_BYTES = SAMPLE_RATE * FRAME_MS // 1000 * 2  # 640字节
+
+
+def pack(seq: int, timestamp: int, ssrc: int, payload: bytes, marker: bool = False) -> bytes:
+    """打包一个音频数据报"""
+    pt = PT_PCM_S16LE_16K | (0x80 if marker else 0)
+    return RTP_HEADER.pack(RTP_VERSION, pt, seq & 0xFFFF, timestamp & 0xFFFFFFFF, ssrc) + payload
+
+
+def unpack(datagram: bytes):
+    """解包，返回 (seq, timestamp, ssrc, marker, payload)，格式不对返回None"""
+    if len(datagram) < RTP_HEADER.size:
+        return None
+    version, pt, seq, timestamp, ssrc = RTP_HEADER.unpack_from(datagram)
+    if version != RTP_VERSION:
+        return None
+    return seq, timestamp, ssrc, bool(pt & 0x80), datagram[RTP_HEADER.size:]
+
+
+def seq_diff(a: int, b: int) -> int:
+    """a - b，考虑16位回绕"""
+    return ((a - b + 0x8000) & 0xFFFF) - 0x8000
+
+
+class ReorderBuffer:
+    """
+    按序号重排数据报。
+
+    乱序到达的包先暂存；当缓存超过 depth 个包仍等不到期望的序号时，
+    判定该包丢失，用等长静音补齐（服务器端ASR对静音不敏感），继续向后输出。
+    """
+
+    def __init__(self, depth: int = 4):
+        self.depth = depth
+        self.expected = None
+        self.pending = {}
+        self.received = 0
+        self.lost = 0
+        self.reordered = 0
+        self.duplicates = 0
+        self.last_len = FRAME_BYTES
+
+    def push(self, seq: int, payload: bytes):
+        """放入一个包，返回可以按序输出的负载列表"""
+        self.received += 1
+        if self.expected is None:
+            self.expected = seq
+        d = seq_diff(seq, self.expected)
+        if d < 0 or seq in self.pending:
+            self.duplicates += 1  # 迟到太久或重复的包
+            return []
+        if d > 0:
+            self.reordered += 1
+        self.pending[seq] = payload
+        return self._drain(force=False)
+
+    def skip(self):
+        """缺失的包等待超时：按丢失处理（补静音），输出后面已到的包"""
+        if not self.pending:
+            return []
+        self.lost += 1
+        out = [b"\x00" * self.last_len]
+        self.expected = (self.expected + 1) & 0xFFFF
+        return out + self._drain(force=False)
+
+    def flush(self):
+        """会话结束时输出剩余的包，中间缺失的用静音补齐"""
+        return self._drain(force=True)
+
+    def _drain(self, force: bool):
+        out = []
+        while self.pending:
+            if self.expected in self.pending:
+                payload = self.pending.pop(self.expected)
+                self.last_len = len(payload)
+                out.append(payload)
+            elif force or len(self.pending) > self.depth:
+                self.lost += 1
+                out.append(b"\x00" * self.last_len)
+            else:
+                break
+            self.expected = (self.expected + 1) & 0xFFFF
+        return out
+
+    def stats(self) -> dict:
+        return {
+            "received": self.received,
+            "lost": self.lost,
+            "reordered": self.reordered,
+            "duplicates": self.duplicates,
+        }
+
+
+class UdpAudioSession:
+    """一个设备的UDP音频会话（由 udp_offer 建立）"""
+
+    def __init__(self, server, ssrc: int, addr, on_audio):
+        self.server = server
+        self.ssrc = ssrc
+        self.addr = addr
+        self.on_audio = on_audio
+        self.reorder = ReorderBuffer()
+        self.send_seq = 0
+        self.send_ts = 0
+
+    def push(self, seq: int, payload: bytes):
+        for chunk in self.reorder.push(seq, payload):
+            self.on_audio(chunk)
+
+    def flush_uplink(self):
+        """录音结束时调用，输出重排缓冲中剩余的音频"""
+        for chunk in self.reorder.flush():
+            self.on_audio(chunk)
+        return self.reorder.stats()
+
+    async def send_stream(self, audio: bytes, config: dict, pace: float = 4.0):
+        """
+        下行：按20ms一帧发送，最后一包带marker。
+        pace 为相对实时的发送倍速，可以快于实时；但和WebSocket通道一样，
+        积压不超过握手时上报的播放缓冲区容量（config["ring_bytes"]）的3/4。
+        """
+        frames = [audio[i:i + FRAME_BYTES] for i in range(0, len(audio), FRAME_BYTES)]
+        interval = FRAME_MS / 1000.0 / pace
+        send_start = time.monotonic()
+        sent = 0
+        for index, frame in enumerate(frames):
+            delay = hello_protocol.ring_headroom_delay(config, sent, time.monotonic() - send_start)
+            if delay > 0:
+                await asyncio.sleep(delay)
+            marker = index == len(frames) - 1
+            self.server.sendto(pack(self.send_seq, self.send_ts, self.ssrc, frame, marker), self.addr)
+            sent += len(frame)
+            self.send_seq = (self.send_seq + 1) & 0xFFFF
+            self.send_ts += len(frame) // 2
+            await asyncio.sleep(interval)
+
+
+class UdpAudioServer:
+    """
+    UDP音频服务端：所有设备共用一个端口，按SSRC区分会话。
+
+    用法：
+        udp_server = UdpAudioServer()
+        await udp_server.start(port)
+        session = udp_server.open_session(ssrc, (device_ip, device_port), on_audio)
+    """
+
+    def __init__(self):
+        self.transport = None
+        self.port = None
+        self.sessions = {}
+
+    async def start(self, port: int):
+        loop = asyncio.get_running_loop()
+        server = self
+
+        class _Protocol(asyncio.DatagramProtocol):
+            def datagram_received(self, data, addr):
+                server._on_datagram(data, addr)
+
+        self.transport, _ = await loop.create_datagram_endpoint(_Protocol, local_addr=("0.0.0.0", port))
+        self.port = port
+        print(f"UDP音频端口: {port}")
+
+    def open_session(self, ssrc: int, addr, on_audio) -> UdpAudioSession:
+        session = UdpAudioSession(self, ssrc, addr, on_audio)
+        self.sessions[ssrc] = session
+        return session
+
+    def close_session(self, session):
+        if session is not None:
+            self.sessions.pop(session.ssrc, None)
+
+    def sendto(self, datagram: bytes, addr):
+        if self.transport is not None:
+            self.transport.sendto(datagram, addr)
+
+    def _on_datagram(self, data: bytes, addr):
+        parsed = unpack(data)
+        if parsed is None:
+            return
+        seq, _timestamp, ssrc, _marker, payload = parsed
+        session = self.sessions.get(ssrc)
+        if session is not None:
+            session.push(seq, payload)
+
+    def answer(self, offer: dict, client_ip: str, on_audio):
+        """处理设备的 udp_offer，返回 (会话, 应答消息)"""
+        session = self.open_session(int(offer["ssrc"]), (client_ip, int(offer["port"])), on_audio)
+        return session, {"event": "udp_answer", "port": self.port}
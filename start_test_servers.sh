@@ -0,0 +1,29 @@
+#!/bin/bash
+# 在本机启动多个回环服务器，用于测试设备的多节点测速与故障切换
+#
+# 用法: ./start_test_servers.sh [主机IP]
+#   启动后把打印出的节点列表填入 menuconfig → Voice Server Configuration，
+#   然后用 kill 停掉当前被选中的节点，观察设备是否切换到下一个最快节点。
+
+HOST_IP=${1:-$(hostname -I | awk '{print $1}')}
+
+# 端口:注入延迟(ms)
+SERVERS="8001:0 8002:80 8003:250"
+
+PIDS=""
+ENDPOINTS=""
+for entry in $SERVERS; do
+    port=${entry%%:*}
+    latency=${entry##*:}
+    python3 loopback_server.py --port "$port" --latency-ms "$latency" > "server_$port.log" 2>&1 &
+    PIDS="$PIDS $!"
+    echo "已启动节点 :$port (注入延迟 ${latency}ms, PID $!, 日志 server_$port.log)"
+    ENDPOINTS="${ENDPOINTS:+$ENDPOINTS,}$HOST_IP:$port/ws/esp32"
+done
+
+echo ""
+echo "CONFIG_WS_SERVER_ENDPOINTS=\"$ENDPOINTS\""
+echo ""
+echo "按 Ctrl+C 停止全部节点"
+trap "kill $PIDS 2>/dev/null; exit 0" INT TERM
+wait
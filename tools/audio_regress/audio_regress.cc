@@ -0,0 +1,568 @@
+/**
+ * @file audio_regress.cc
+ * @brief 🎧 音频回归测试 - 用语料WAV跑采集链和播放链，与提交进仓库的基准结果逐位对比
+ *
+ * corpus/ 下的每个WAV按主程序的方式逐帧（512样本）处理：
+ *
+ *   采集：CaptureChain（去直流）→ VAD → AudioManager 录音历史 + Endpointer 端点检测
+ *   播放：按播放任务的3200字节分块经过 AudioManager::processPlayback（音量150%，软限幅生效）
+ *
+ * 结果写成文本（输出PCM的FNV-1a哈希、逐帧VAD判决、端点事件时间线、每轮上报的上行音频质量），
+ * 与同名 .golden 文件比较；任何一位不同都算失败，并打印差异行。
+ * 同时统计每一级每帧耗时的P99，超过该级实时周期的预算比例也算失败。
+ *
+ * 用法：
+ *   cmake -S tools/audio_regress -B build_audio_regress && cmake --build build_audio_regress
+ *   ./build_audio_regress/audio_regress                   # 检查
+ *   ./build_audio_regress/audio_regress --update          # 有意改变处理结果后，重新生成基准
+ *   ./build_audio_regress/audio_regress --write-outputs=/tmp/out   # 输出处理后的WAV试听
+ *
+ * 主机上没有 esp-sr：噪音抑制不参与（恒等），VAD 用能量门限代替。
+ * 因此这里锁定的是固件自己的代码（处理链、录音历史、端点检测），不是 esp-sr 模型的行为。
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <dirent.h>
+#include "audio_frame_pool.h"
+#include "audio_manager.h"
+#include "capture_chain.h"
+#include "endpointer.h"
+#include "uplink_quality.h"
+
+#ifndef AUDIO_REGRESS_CORPUS_DIR
+#define AUDIO_REGRESS_CORPUS_DIR "corpus"
+#endif
+
+static constexpr uint32_t SAMPLE_RATE = 16000;
+static constexpr size_t FRAME_SAMPLES = 512;            // 与唤醒词的采集块相同（32ms）
+static constexpr size_t PLAYBACK_CHUNK = 3200;          // 播放任务每次写I2S的字节数（100ms）
+static constexpr int PLAYBACK_VOLUME = 150;             // 超过100%，软限幅才会真正处理数据
+static constexpr double FRAME_PERIOD_NS = 1e9 * FRAME_SAMPLES / SAMPLE_RATE;
+static constexpr double CHUNK_PERIOD_NS = 1e9 * PLAYBACK_CHUNK / sizeof(int16_t) / SAMPLE_RATE;
+
+// ========== WAV ==========
+
+static bool read_wav(const std::string& path, std::vector<int16_t>* samples, std::string* err)
+{
+    std::ifstream in(path, std::ios::binary);
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (data.size() < 12 || memcmp(data.data(), "RIFF", 4) != 0 || memcmp(data.data() + 8, "WAVE", 4) != 0) {
+        *err = "不是RIFF/WAVE文件";
+        return false;
+    }
+
+    bool format_ok = false;
+    size_t pos = 12;
+    while (pos + 8 <= data.size()) {
+        uint32_t size;
+        memcpy(&size, data.data() + pos + 4, 4);
+        const uint8_t* body = data.data() + pos + 8;
+        if (pos + 8 + size > data.size()) {
+            size = (uint32_t)(data.size() - pos - 8);
+        }
+        if (memcmp(data.data() + pos, "fmt ", 4) == 0 && size >= 16) {
+            uint16_t format, channels, bits;
+            uint32_t rate;
+            memcpy(&format, body, 2);
+            memcpy(&channels, body + 2, 2);
+            memcpy(&rate, body + 4, 4);
+            memcpy(&bits, body + 14, 2);
+            if (format != 1 || channels != 1 || bits != 16 || rate != SAMPLE_RATE) {
+                *err = "只支持16kHz、16位、单声道PCM";
+                return false;
+            }
+            format_ok = true;
+        } else if (memcmp(data.data() + pos, "data", 4) == 0) {
+            if (!format_ok) {
+                *err = "data块在fmt块之前";
+                return false;
+            }
+            samples->resize(size / sizeof(int16_t));
+            memcpy(samples->data(), body, samples->size() * sizeof(int16_t));
+            return true;
+        }
+        pos += 8 + size + (size & 1);
+    }
+    *err = "没有data块";
+    return false;
+}
+
+static void write_wav(const std::string& path, const std::vector<int16_t>& samples)
+{
+    uint32_t data_bytes = (uint32_t)(samples.size() * sizeof(int16_t));
+    uint32_t riff_size = 36 + data_bytes;
+    uint32_t fmt_size = 16, rate = SAMPLE_RATE, byte_rate = SAMPLE_RATE * 2;
+    uint16_t format = 1, channels = 1, align = 2, bits = 16;
+
+    std::ofstream out(path, std::ios::binary);
+    out.write("RIFF", 4);
+    out.write((const char*)&riff_size, 4);
+    out.write("WAVEfmt ", 8);
+    out.write((const char*)&fmt_size, 4);
+    out.write((const char*)&format, 2);
+    out.write((const char*)&channels, 2);
+    out.write((const char*)&rate, 4);
+    out.write((const char*)&byte_rate, 4);
+    out.write((const char*)&align, 2);
+    out.write((const char*)&bits, 2);
+    out.write("data", 4);
+    out.write((const char*)&data_bytes, 4);
+    out.write((const char*)samples.data(), data_bytes);
+}
+
+// ========== 主机上的替代VAD ==========
+
+/**
+ * @brief 能量门限VAD（esp-sr 的 vad_process 只有ESP32的库）
+ */
+class HostVad {
+public:
+    static constexpr double THRESHOLD_DBFS = -40.0;
+
+    bool process(const int16_t* samples, size_t n) {
+        double sum = 0;
+        for (size_t i = 0; i < n; i++) {
+            sum += (double)samples[i] * samples[i];
+        }
+        double rms = sqrt(sum / n) / 32768.0;
+        return rms > 0 && 20.0 * log10(rms) > THRESHOLD_DBFS;
+    }
+};
+
+// ========== 每级耗时与预算 ==========
+
+struct Stage {
+    const char* name;
+    double period_ns;           // 这一级的实时周期
+    double budget_pct;          // P99 耗时不能超过周期的这个比例
+    std::vector<double> ns;
+
+    double percentile(double p) const {
+        if (ns.empty()) return 0;
+        std::vector<double> sorted = ns;
+        std::sort(sorted.begin(), sorted.end());
+        return sorted[std::min(sorted.size() - 1, (size_t)(p / 100.0 * (sorted.size() - 1) + 0.5))];
+    }
+};
+
+// 预算是ESP32-S3上允许的比例；主机快得多，正常情况下远低于预算，超出说明算法级退化（多余的遍历、逐样本浮点）
+static Stage stages[] = {
+    { "condition", FRAME_PERIOD_NS, 0.5, {} },
+    { "vad",       FRAME_PERIOD_NS, 1.0, {} },
+    { "endpoint",  FRAME_PERIOD_NS, 0.2, {} },
+    { "playback",  CHUNK_PERIOD_NS, 0.5, {} },
+};
+enum { STAGE_CONDITION, STAGE_VAD, STAGE_ENDPOINT, STAGE_PLAYBACK };
+
+class ScopedStage {
+public:
+    explicit ScopedStage(int stage) : stage_(stage), start_(std::chrono::steady_clock::now()) {}
+    ~ScopedStage() {
+        auto end = std::chrono::steady_clock::now();
+        stages[stage_].ns.push_back(std::chrono::duration<double, std::nano>(end - start_).count());
+    }
+
+private:
+    int stage_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+// ========== 处理一个文件 ==========
+
+static void fnv1a(uint64_t* hash, const void* data, size_t len)
+{
+    const uint8_t* p = (const uint8_t*)data;
+    for (size_t i = 0; i < len; i++) {
+        *hash = (*hash ^ p[i]) * 0x100000001b3ull;
+    }
+}
+
+static const char* event_name(Endpointer::Event ev)
+{
+    switch (ev) {
+    case Endpointer::Event::END_OF_TURN: return "end_of_turn";
+    case Endpointer::Event::TOO_SHORT: return "too_short";
+    default: return "";
+    }
+}
+
+/**
+ * @brief 跑一遍采集链和播放链，返回基准结果文本
+ */
+static std::string process(const std::string& name, const std::vector<int16_t>& input,
+                           AudioManager& audio, AudioFramePool& pool,
+                           std::vector<int16_t>* capture_out, std::vector<int16_t>* playback_out)
+{
+    CaptureChain capture_chain;
+    HostVad vad;
+    Endpointer endpointer(Endpointer::SILENCE_FRAMES_REQUIRED, SAMPLE_RATE * Endpointer::MIN_TURN_MS / 1000);
+    UplinkQuality quality;
+
+    uint64_t capture_hash = 0xcbf29ce484222325ull;
+    std::string vad_track;
+    std::ostringstream events;
+    bool in_turn = false;
+
+    audio.clearRecordingBuffer();
+    audio.startRecording();
+    size_t frames = input.size() / FRAME_SAMPLES;
+    for (size_t i = 0; i < frames; i++) {
+        AudioFrame* frame = pool.acquire();
+        memcpy(frame->data, input.data() + i * FRAME_SAMPLES, FRAME_SAMPLES * sizeof(int16_t));
+        frame->length = FRAME_SAMPLES * sizeof(int16_t);
+
+        quality.addRaw(frame->samples(), frame->sampleCount());
+        {
+            ScopedStage t(STAGE_CONDITION);
+            capture_chain.process(frame->samples(), frame->sampleCount());
+        }
+        fnv1a(&capture_hash, frame->data, frame->length);
+        capture_out->insert(capture_out->end(), frame->samples(), frame->samples() + frame->sampleCount());
+
+        bool speech;
+        {
+            ScopedStage t(STAGE_VAD);
+            speech = vad.process(frame->samples(), frame->sampleCount());
+        }
+        vad_track += speech ? '1' : '0';
+        quality.addFrame(frame->samples(), frame->sampleCount(), speech);
+
+        // 与主程序录音状态相同：先记录帧，再交给端点检测
+        Endpointer::Event ev = Endpointer::Event::WAITING;
+        bool full = audio.isRecordingBufferFull();
+        if (!full) {
+            ScopedStage t(STAGE_ENDPOINT);
+            audio.addRecordingFrame(frame, true);
+            ev = endpointer.update(speech, audio.getRecordingLength());
+        }
+        frame->release();
+
+        if (ev == Endpointer::Event::SPEECH && !in_turn) {
+            events << "event " << i << " speech_start\n";
+            in_turn = true;
+        }
+        if (full || ev == Endpointer::Event::END_OF_TURN || ev == Endpointer::Event::TOO_SHORT) {
+            events << "event " << i << " " << (full ? "buffer_full" : event_name(ev)) << "\n";
+            if (ev != Endpointer::Event::TOO_SHORT) {
+                // 与 recording_ended 上报的字段相同
+                UplinkQuality::Summary q = quality.summary();
+                char snr[16] = "null";
+                if (q.snr_valid) {
+                    snprintf(snr, sizeof(snr), "%.1f", q.snr_db);
+                }
+                char line[128];
+                snprintf(line, sizeof(line), "quality rms=%.1f peak=%.1f clip=%.5f snr=%s frames=%u/%u\n",
+                         q.rms_dbfs, q.peak_dbfs, q.clip_ratio, snr,
+                         (unsigned)q.speech_frames, (unsigned)q.frames);
+                events << line;
+            }
+            // 连续对话：马上开始下一段录音
+            audio.stopRecording();
+            audio.clearRecordingBuffer();
+            audio.startRecording();
+            endpointer.reset();
+            quality.reset();
+            in_turn = false;
+        }
+    }
+    audio.stopRecording();
+    audio.clearRecordingBuffer();
+
+    // 播放：与播放任务相同的分块
+    uint64_t playback_hash = 0xcbf29ce484222325ull;
+    std::vector<uint8_t> chunk(PLAYBACK_CHUNK);
+    const uint8_t* bytes = (const uint8_t*)input.data();
+    size_t total = input.size() * sizeof(int16_t);
+    for (size_t pos = 0; pos < total; pos += PLAYBACK_CHUNK) {
+        size_t len = std::min(PLAYBACK_CHUNK, total - pos);
+        memcpy(chunk.data(), bytes + pos, len);
+        {
+            ScopedStage t(STAGE_PLAYBACK);
+            audio.processPlayback(chunk.data(), len);
+        }
+        fnv1a(&playback_hash, chunk.data(), len);
+        const int16_t* s = (const int16_t*)chunk.data();
+        playback_out->insert(playback_out->end(), s, s + len / sizeof(int16_t));
+    }
+
+    char line[96];
+    std::ostringstream out;
+    out << "# audio_regress golden v1（audio_regress --update 生成，勿手改）\n";
+    out << "input " << name << "\n";
+    out << "config dc_block=" << CONFIG_AUDIO_CAPTURE_DC_BLOCK << " agc=" << CONFIG_AUDIO_CAPTURE_AGC
+        << " volume=" << PLAYBACK_VOLUME
+        << " vad=energy" << (int)HostVad::THRESHOLD_DBFS << "dBFS\n";
+    out << "frames " << frames << "\n";
+    snprintf(line, sizeof(line), "capture_fnv1a %016llx\n", (unsigned long long)capture_hash);
+    out << line;
+    snprintf(line, sizeof(line), "playback_fnv1a %016llx\n", (unsigned long long)playback_hash);
+    out << line;
+    out << "vad " << vad_track << "\n";
+    out << events.str();
+    return out.str();
+}
+
+// ========== 电平一致性 ==========
+
+// 整体缩放输入，模拟说话人从约3米（-24dB）到30厘米（+6dB）
+static const int LEVEL_GAINS_DB[] = { -24, -12, 0, 6 };
+static constexpr double LEVEL_SPREAD_LIMIT_DB = 6.0;    // 输出说话电平的最大差距
+static constexpr double SILENCE_BOOST_LIMIT_DB = 1.0;   // 开头静音最多放大多少
+static constexpr size_t ONSET_FRAMES = 2;               // VAD判为说话之前已经开始起音的帧
+static constexpr size_t MIN_SPEECH_FRAMES = 16;         // 说话不到0.5秒的录音不检查：增益来不及收敛
+
+struct LevelResult {
+    double speech_dbfs;         // 说话帧的输出RMS
+    double silence_boost_db;    // 第一次说话之前的静音（不含紧挨着的 ONSET_FRAMES 帧）：输出比输入高多少，没有时为 NAN
+};
+
+static double rms_dbfs(double sum_sq, size_t n)
+{
+    return n > 0 && sum_sq > 0 ? 10.0 * log10(sum_sq / n / (32768.0 * 32768.0)) : -INFINITY;
+}
+
+/**
+ * @brief 输入缩放 gain_db 后跑一遍采集链，测说话帧的输出电平和开头静音的放大量
+ *
+ * 哪些帧是说话由原始输入的VAD决定，各个增益用同一组帧。
+ */
+static LevelResult measure_level(const std::vector<int16_t>& input, const std::vector<bool>& speech, int gain_db)
+{
+    CaptureChain chain;
+    const double scale = pow(10.0, gain_db / 20.0);
+    double speech_sq = 0, silence_in_sq = 0, silence_out_sq = 0;
+    size_t speech_n = 0, silence_n = 0;
+    size_t first_speech = std::find(speech.begin(), speech.end(), true) - speech.begin();
+    size_t silence_end = first_speech > ONSET_FRAMES ? first_speech - ONSET_FRAMES : 0;
+    int16_t frame[FRAME_SAMPLES];
+    for (size_t f = 0; f < speech.size(); f++) {
+        for (size_t i = 0; i < FRAME_SAMPLES; i++) {
+            double v = round(input[f * FRAME_SAMPLES + i] * scale);
+            frame[i] = (int16_t)std::max(-32768.0, std::min(32767.0, v));
+        }
+        double in_sq = 0;
+        for (int16_t v : frame) {
+            in_sq += (double)v * v;
+        }
+        chain.process(frame, FRAME_SAMPLES);
+        double out_sq = 0;
+        for (int16_t v : frame) {
+            out_sq += (double)v * v;
+        }
+        if (speech[f]) {
+            speech_sq += out_sq;
+            speech_n += FRAME_SAMPLES;
+        } else if (f < silence_end) {
+            silence_in_sq += in_sq;
+            silence_out_sq += out_sq;
+            silence_n += FRAME_SAMPLES;
+        }
+    }
+    LevelResult r;
+    r.speech_dbfs = rms_dbfs(speech_sq, speech_n);
+    r.silence_boost_db = silence_n > 0 && silence_in_sq > 0 ? 10.0 * log10(silence_out_sq / silence_in_sq) : NAN;
+    return r;
+}
+
+/**
+ * @brief 电平一致性：不同距离的同一段录音，经过自动增益后说话电平应该接近，开头的静音不应被放大
+ *
+ * @return 失败项数
+ */
+static int check_levels(const std::string& wav, const std::vector<int16_t>& input)
+{
+    HostVad vad;
+    std::vector<bool> speech(input.size() / FRAME_SAMPLES);
+    for (size_t f = 0; f < speech.size(); f++) {
+        speech[f] = vad.process(input.data() + f * FRAME_SAMPLES, FRAME_SAMPLES);
+    }
+    size_t speech_frames = std::count(speech.begin(), speech.end(), true);
+    if (speech_frames < MIN_SPEECH_FRAMES) {
+        printf("- %s: 说话只有 %zu 帧，跳过\n", wav.c_str(), speech_frames);
+        return 0;
+    }
+
+    std::string levels;
+    double lo = INFINITY, hi = -INFINITY, boost = -INFINITY;
+    char item[48];
+    for (int gain : LEVEL_GAINS_DB) {
+        LevelResult r = measure_level(input, speech, gain);
+        lo = std::min(lo, r.speech_dbfs);
+        hi = std::max(hi, r.speech_dbfs);
+        if (!std::isnan(r.silence_boost_db)) {
+            boost = std::max(boost, r.silence_boost_db);
+        }
+        snprintf(item, sizeof(item), " %+ddB→%.1f", gain, r.speech_dbfs);
+        levels += item;
+    }
+    double spread = hi - lo;
+    bool ok = spread <= LEVEL_SPREAD_LIMIT_DB && boost <= SILENCE_BOOST_LIMIT_DB;
+    printf("%s %s: 说话电平(dBFS)%s, 差距 %.1f dB（输入 %d dB）, 开头静音放大 ",
+           ok ? "✓" : "✗", wav.c_str(), levels.c_str(), spread,
+           LEVEL_GAINS_DB[std::size(LEVEL_GAINS_DB) - 1] - LEVEL_GAINS_DB[0]);
+    if (std::isinf(boost)) {
+        printf("—\n");
+    } else {
+        printf("%.1f dB\n", boost);
+    }
+    return ok ? 0 : 1;
+}
+
+// ========== 对比 ==========
+
+static std::vector<std::string> split_lines(const std::string& text)
+{
+    std::vector<std::string> lines;
+    std::istringstream in(text);
+    std::string line;
+    while (std::getline(in, line)) {
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+static void print_diff(const std::string& expected, const std::string& actual)
+{
+    std::vector<std::string> a = split_lines(expected);
+    std::vector<std::string> b = split_lines(actual);
+    for (size_t i = 0; i < std::max(a.size(), b.size()); i++) {
+        const std::string& x = i < a.size() ? a[i] : std::string("<无>");
+        const std::string& y = i < b.size() ? b[i] : std::string("<无>");
+        if (x != y) {
+            printf("    - %s\n    + %s\n", x.c_str(), y.c_str());
+        }
+    }
+}
+
+static std::vector<std::string> list_wavs(const std::string& dir)
+{
+    std::vector<std::string> names;
+    DIR* d = opendir(dir.c_str());
+    if (d == nullptr) {
+        return names;
+    }
+    while (struct dirent* e = readdir(d)) {
+        std::string n = e->d_name;
+        if (n.size() > 4 && n.compare(n.size() - 4, 4, ".wav") == 0) {
+            names.push_back(n);
+        }
+    }
+    closedir(d);
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+int main(int argc, char** argv)
+{
+    std::string corpus = AUDIO_REGRESS_CORPUS_DIR;
+    std::string outputs;
+    bool update = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--update") == 0) {
+            update = true;
+        } else if (strncmp(argv[i], "--write-outputs=", 16) == 0) {
+            outputs = argv[i] + 16;
+        } else if (argv[i][0] != '-') {
+            corpus = argv[i];
+        } else {
+            fprintf(stderr, "用法: %s [--update] [--write-outputs=<目录>] [语料目录]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    AudioManager audio(SAMPLE_RATE, 10, 32);        // 与主程序相同的录音/回复时长
+    AudioFramePool pool("regress", FRAME_SAMPLES * sizeof(int16_t), AudioManager::RECORDING_HISTORY_FRAMES + 4, 0);
+    if (audio.init() != ESP_OK || pool.init() != ESP_OK) {
+        fprintf(stderr, "初始化失败\n");
+        return 1;
+    }
+    audio.setPlaybackVolume(PLAYBACK_VOLUME);
+
+    std::vector<std::string> wavs = list_wavs(corpus);
+    if (wavs.empty()) {
+        fprintf(stderr, "%s 里没有WAV文件\n", corpus.c_str());
+        return 1;
+    }
+
+    int failures = 0;
+    for (const std::string& wav : wavs) {
+        std::vector<int16_t> input;
+        std::string err;
+        if (!read_wav(corpus + "/" + wav, &input, &err)) {
+            printf("✗ %s: %s\n", wav.c_str(), err.c_str());
+            failures++;
+            continue;
+        }
+
+        std::vector<int16_t> capture_out, playback_out;
+        std::string actual = process(wav, input, audio, pool, &capture_out, &playback_out);
+        std::string stem = wav.substr(0, wav.size() - 4);
+        if (!outputs.empty()) {
+            write_wav(outputs + "/" + stem + ".capture.wav", capture_out);
+            write_wav(outputs + "/" + stem + ".playback.wav", playback_out);
+        }
+
+        std::string golden_path = corpus + "/" + stem + ".golden";
+        if (update) {
+            std::ofstream(golden_path) << actual;
+            printf("↻ %s: 已更新基准\n", wav.c_str());
+            continue;
+        }
+        std::ifstream in(golden_path);
+        if (!in) {
+            printf("✗ %s: 没有基准文件 %s（先运行 --update）\n", wav.c_str(), golden_path.c_str());
+            failures++;
+            continue;
+        }
+        std::string expected((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        if (expected != actual) {
+            printf("✗ %s: 与基准不同\n", wav.c_str());
+            print_diff(expected, actual);
+            failures++;
+        } else {
+            printf("✓ %s\n", wav.c_str());
+        }
+    }
+
+#if CONFIG_AUDIO_CAPTURE_AGC
+    printf("\n电平一致性（自动增益，差距不超过 %.0f dB，静音放大不超过 %.0f dB）:\n",
+           LEVEL_SPREAD_LIMIT_DB, SILENCE_BOOST_LIMIT_DB);
+    for (const std::string& wav : wavs) {
+        std::vector<int16_t> input;
+        std::string err;
+        if (read_wav(corpus + "/" + wav, &input, &err)) {
+            failures += check_levels(wav, input);
+        }
+    }
+#endif
+
+    printf("\n%-10s %8s %10s %10s %8s %8s\n", "阶段", "帧数", "P99(ns)", "最大(ns)", "占周期", "预算");
+    for (const Stage& s : stages) {
+        double p99 = s.percentile(99);
+        double pct = p99 / s.period_ns * 100.0;
+        bool over = pct > s.budget_pct;
+        printf("%-10s %8zu %10.0f %10.0f %7.3f%% %7.2f%%%s\n", s.name, s.ns.size(), p99, s.percentile(100),
+               pct, s.budget_pct, over ? "  ✗ 超预算" : "");
+        if (over) {
+            failures++;
+        }
+    }
+
+    audio.deinit();
+    if (failures > 0) {
+        printf("\n%d 项失败\n", failures);
+        return 1;
+    }
+    printf("\n全部通过\n");
+    return 0;
+}
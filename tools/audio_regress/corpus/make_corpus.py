@@ -0,0 +1,74 @@
+"""
+生成回归测试的合成语料（16kHz、16位单声道WAV）
+
+合成语音用带音节包络的谐波（基频抖动 + 共振峰式的谐波衰减）加底噪，
+覆盖端点检测和处理链需要的几种情况。随机数种子固定，重复运行生成的文件完全相同。
+真机录音可以直接放进这个目录，再运行 audio_regress --update 生成基准结果。
+
+用法：
+    python tools/audio_regress/corpus/make_corpus.py
+"""
+
+import math
+import os
+import random
+import struct
+import wave
+
+SAMPLE_RATE = 16000
+HERE = os.path.dirname(os.path.abspath(__file__))
+
+
+def noise(rng, seconds, level):
+    return [rng.gauss(0.0, level) for _ in range(int(seconds * SAMPLE_RATE))]
+
+
+def speech(rng, seconds, level, f0=140.0):
+    """音节约每200ms一个，包络是升余弦；基频缓慢抖动"""
+    out = []
+    phase = 0.0
+    n = int(seconds * SAMPLE_RATE)
+    syllable = int(0.2 * SAMPLE_RATE)
+    for i in range(n):
+        pos = (i % syllable) / syllable
+        env = 0.5 - 0.5 * math.cos(2 * math.pi * pos)
+        f = f0 * (1.0 + 0.08 * math.sin(2 * math.pi * 3.0 * i / SAMPLE_RATE))
+        phase += 2 * math.pi * f / SAMPLE_RATE
+        s = sum(math.sin(k * phase) / k for k in range(1, 12))
+        out.append(level * env * s + rng.gauss(0.0, level * 0.02))
+    return out
+
+
+def write(name, samples, dc=0.0):
+    path = os.path.join(HERE, name)
+    frames = b"".join(struct.pack("<h", max(-32768, min(32767, int(round(s + dc))))) for s in samples)
+    with wave.open(path, "wb") as w:
+        w.setnchannels(1)
+        w.setsampwidth(2)
+        w.setframerate(SAMPLE_RATE)
+        w.writeframes(frames)
+    print(f"{name}: {len(samples) / SAMPLE_RATE:.2f} 秒")
+
+
+def main():
+    rng = random.Random(20240601)
+    floor = 40.0
+
+    # 两段说话，中间的停顿短于结束阈值：应该只有一次 end_of_turn
+    write("two_phrases.wav",
+          noise(rng, 0.4, floor) + speech(rng, 1.2, 6000) + noise(rng, 0.35, floor)
+          + speech(rng, 0.8, 5000, f0=180.0) + noise(rng, 1.0, floor))
+
+    # 很短的一下（咳嗽、碰撞），随后静音。录音长度包含结尾的静音帧，
+    # 所以目前仍判为 end_of_turn（250ms下限实际不起作用），改端点检测时这里会变
+    write("short_blip.wav",
+          noise(rng, 0.3, floor) + speech(rng, 0.12, 8000) + noise(rng, 1.0, floor))
+
+    # 大直流偏置 + 接近满幅：检查去直流和播放软限幅
+    write("loud_dc_offset.wav",
+          noise(rng, 0.3, floor) + speech(rng, 1.0, 14000, f0=220.0) + noise(rng, 0.9, floor),
+          dc=2500.0)
+
+
+if __name__ == "__main__":
+    main()
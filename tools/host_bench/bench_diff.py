@@ -0,0 +1,88 @@
+"""
+基准测试结果对比 - host_bench / target_bench 的输出前后对照
+
+输入可以是 host_bench 的JSON输出，也可以是 target_bench 的串口日志
+（取 BENCH_JSON_BEGIN 和 BENCH_JSON_END 之间的部分）。
+按 (name, memory) 配对，目标板结果优先比较 cycles_per_op，否则比较 ns_per_op。
+
+用法：
+    ./build_host_bench/host_bench > before.json
+    （修改代码）
+    ./build_host_bench/host_bench > after.json
+    python tools/host_bench/bench_diff.py before.json after.json --threshold 10
+
+变慢超过阈值（百分比）的用例会标出来，并以退出码1结束，方便放进脚本。
+"""
+
+import argparse
+import json
+import sys
+
+BEGIN_MARK = "BENCH_JSON_BEGIN"
+END_MARK = "BENCH_JSON_END"
+
+
+def load(path):
+    with open(path, encoding="utf-8", errors="replace") as f:
+        text = f.read()
+    begin = text.find(BEGIN_MARK)
+    if begin >= 0:
+        end = text.find(END_MARK, begin)
+        if end < 0:
+            raise ValueError(f"{path}: 找到 {BEGIN_MARK} 但没有 {END_MARK}，日志不完整")
+        text = text[begin + len(BEGIN_MARK):end]
+    data = json.loads(text)
+    results = {}
+    for item in data["benchmarks"]:
+        results[(item["name"], item.get("memory", "default"))] = item
+    return data.get("suite", "?"), results
+
+
+def metric(before, after):
+    """两边都有周期数时用周期数（不受频率影响），否则用纳秒"""
+    if "cycles_per_op" in before and "cycles_per_op" in after:
+        return "cycles", before["cycles_per_op"], after["cycles_per_op"]
+    return "ns", before["ns_per_op"], after["ns_per_op"]
+
+
+def main():
+    parser = argparse.ArgumentParser(description="对比两次基准测试结果")
+    parser.add_argument("before")
+    parser.add_argument("after")
+    parser.add_argument("--threshold", type=float, default=10.0,
+                        help="变慢超过该百分比视为退步（默认10）")
+    args = parser.parse_args()
+
+    suite_a, before = load(args.before)
+    suite_b, after = load(args.after)
+    if suite_a != suite_b:
+        print(f"注意：比较的是不同平台的结果（{suite_a} vs {suite_b}），只适合看相对量级")
+
+    regressions = 0
+    print(f"{'用例':44s} {'内存':8s} {'单位':6s} {'之前':>12s} {'之后':>12s} {'变化':>8s}")
+    for key in sorted(set(before) | set(after)):
+        name, memory = key
+        if key not in before:
+            print(f"{name:44s} {memory:8s} {'':6s} {'-':>12s} {'新增':>12s}")
+            continue
+        if key not in after:
+            print(f"{name:44s} {memory:8s} {'':6s} {'删除':>12s} {'-':>12s}")
+            continue
+        unit, a, b = metric(before[key], after[key])
+        change = (b - a) / a * 100.0 if a > 0 else 0.0
+        flag = ""
+        if change > args.threshold:
+            flag = "  ⚠ 变慢"
+            regressions += 1
+        elif change < -args.threshold:
+            flag = "  ✓ 变快"
+        print(f"{name:44s} {memory:8s} {unit:6s} {a:12.2f} {b:12.2f} {change:+7.1f}%{flag}")
+
+    if regressions:
+        print(f"\n{regressions} 个用例变慢超过 {args.threshold:.0f}%")
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
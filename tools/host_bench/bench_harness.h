@@ -0,0 +1,240 @@
+/**
+ * @file bench_harness.h
+ * @brief ⏱️ 主机基准测试框架 - 自动标定次数、取中位数、输出稳定的JSON
+ *
+ * 每个用例是一个 op（被测操作）加一个可选的 setup（每批开始前调用，不计时）。
+ * 先把批大小翻倍到一批至少1ms，再重复 REPEATS 次取每次操作耗时的中位数，
+ * 噪声比单次平均小得多，不同提交之间的结果可以直接比较。
+ *
+ * 主机和ESP32-S3共用：在ESP-IDF下（ESP_PLATFORM）用CPU周期计数器计时，
+ * 同时输出每次操作的周期数；批与批之间让出CPU一次，不触发任务看门狗。
+ */
+
+#ifndef BENCH_HARNESS_H
+#define BENCH_HARNESS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifdef ESP_PLATFORM
+#include "sdkconfig.h"
+#include "esp_cpu.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#endif
+
+namespace bench {
+
+/**
+ * @brief 阻止编译器把结果当成无用计算删掉
+ */
+template <typename T>
+inline void keep(T const& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+inline void clobber() {
+    asm volatile("" : : : "memory");
+}
+
+#ifdef ESP_PLATFORM
+using Ticks = uint32_t;     // 240MHz下约17秒回绕，一批只有几十毫秒
+
+inline Ticks now() { return (Ticks)esp_cpu_get_cycle_count(); }
+inline double ticks_to_ns(double t) { return t * 1000.0 / CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ; }
+inline double ticks_to_cycles(double t) { return t; }
+inline void yield() { vTaskDelay(1); }
+#else
+using Ticks = uint64_t;
+
+inline Ticks now() {
+    return (Ticks)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+inline double ticks_to_ns(double t) { return t; }
+inline double ticks_to_cycles(double) { return 0; }    // 主机上不报告周期数
+inline void yield() {}
+#endif
+
+struct Result {
+    std::string name;
+    std::string memory;         // 缓冲区所在内存（host / sram / psram / default）
+    size_t bytes_per_op;
+    double ns_per_op;           // 中位数
+    double ns_min;              // 最好的一次
+    double cycles_per_op;       // 中位数，仅目标板
+    uint64_t iterations;        // 计时的总操作数
+};
+
+class Case {
+public:
+    Case(const char* name, const char* memory, size_t bytes_per_op, size_t max_batch)
+        : name_(name), memory_(memory), bytes_per_op_(bytes_per_op), max_batch_(max_batch) {}
+    virtual ~Case() = default;
+
+    const char* name() const { return name_; }
+    const char* memory() const { return memory_; }
+    size_t bytesPerOp() const { return bytes_per_op_; }
+    size_t maxBatch() const { return max_batch_; }
+
+    /**
+     * @brief 先 setup，再计时执行 n 次 op（n 不超过 maxBatch），返回计时刻度
+     */
+    virtual Ticks runBatch(size_t n) = 0;
+
+private:
+    const char* name_;
+    const char* memory_;
+    size_t bytes_per_op_;
+    size_t max_batch_;          // 0 = 不限
+};
+
+template <typename Setup, typename Op>
+class CaseImpl : public Case {
+public:
+    CaseImpl(const char* name, const char* memory, size_t bytes_per_op, size_t max_batch, Setup setup, Op op)
+        : Case(name, memory, bytes_per_op, max_batch), setup_(setup), op_(op) {}
+
+    Ticks runBatch(size_t n) override {
+        setup_();
+        Ticks start = now();
+        for (size_t i = 0; i < n; i++) {
+            op_();
+        }
+        return now() - start;
+    }
+
+private:
+    Setup setup_;
+    Op op_;
+};
+
+class Registry {
+public:
+    static constexpr int REPEATS = 7;
+
+    /**
+     * @brief 之后登记的用例都标记为这块内存（默认 "default"）
+     */
+    void setMemory(const char* memory) { memory_ = memory; }
+
+    template <typename Op>
+    void add(const char* name, size_t bytes_per_op, Op op) {
+        add(name, bytes_per_op, 0, [] {}, op);
+    }
+
+    template <typename Setup, typename Op>
+    void add(const char* name, size_t bytes_per_op, size_t max_batch, Setup setup, Op op) {
+        cases_.emplace_back(new CaseImpl<Setup, Op>(name, memory_, bytes_per_op, max_batch, setup, op));
+    }
+
+    /**
+     * @brief 登记一个本树里没有对应代码的类别，输出里注明原因
+     */
+    void skip(const char* name, const char* reason) {
+        skipped_.push_back({ name, reason });
+    }
+
+    std::vector<Result> run(const char* filter, double min_time_ms) {
+        std::vector<Case*> selected;
+        for (auto& c : cases_) {
+            if (filter == nullptr || strstr(c->name(), filter) != nullptr ||
+                strcmp(c->memory(), filter) == 0) {
+                selected.push_back(c.get());
+            }
+        }
+        std::sort(selected.begin(), selected.end(), [](Case* a, Case* b) {
+            int by_name = strcmp(a->name(), b->name());
+            return by_name != 0 ? by_name < 0 : strcmp(a->memory(), b->memory()) < 0;
+        });
+
+        std::vector<Result> results;
+        for (Case* c : selected) {
+            results.push_back(measure(*c, min_time_ms));
+        }
+        return results;
+    }
+
+    void list() const {
+        for (auto& c : cases_) {
+            printf("%s [%s]\n", c->name(), c->memory());
+        }
+    }
+
+    /**
+     * @brief 输出JSON：字段顺序、数字格式固定，只含可比较的量（没有时间戳）
+     */
+    void printJson(const std::vector<Result>& results, const char* suite) const {
+        printf("{\n  \"schema\": 1,\n  \"suite\": \"%s\",\n  \"benchmarks\": [\n", suite);
+        for (size_t i = 0; i < results.size(); i++) {
+            const Result& r = results[i];
+            double bytes_per_sec = r.bytes_per_op ? r.bytes_per_op * 1e9 / r.ns_per_op : 0;
+            printf("    {\"name\": \"%s\", \"memory\": \"%s\", \"ns_per_op\": %.2f, \"ns_min\": %.2f, ",
+                   r.name.c_str(), r.memory.c_str(), r.ns_per_op, r.ns_min);
+            if (r.cycles_per_op > 0) {
+                printf("\"cycles_per_op\": %.1f, ", r.cycles_per_op);
+            }
+            printf("\"bytes_per_op\": %zu, \"bytes_per_sec\": %.0f, \"iterations\": %llu}%s\n",
+                   r.bytes_per_op, bytes_per_sec, (unsigned long long)r.iterations,
+                   i + 1 < results.size() ? "," : "");
+        }
+        printf("  ],\n  \"skipped\": [\n");
+        for (size_t i = 0; i < skipped_.size(); i++) {
+            printf("    {\"name\": \"%s\", \"reason\": \"%s\"}%s\n", skipped_[i].first.c_str(),
+                   skipped_[i].second.c_str(), i + 1 < skipped_.size() ? "," : "");
+        }
+        printf("  ]\n}\n");
+    }
+
+private:
+    // 执行 total 次操作，批大小受 maxBatch 限制，返回计时刻度
+    static double runOps(Case& c, uint64_t total) {
+        double ticks = 0;
+        while (total > 0) {
+            size_t n = (size_t)total;
+            if (c.maxBatch() != 0 && n > c.maxBatch()) {
+                n = c.maxBatch();
+            }
+            ticks += c.runBatch(n);
+            total -= n;
+        }
+        yield();
+        return ticks;
+    }
+
+    static Result measure(Case& c, double min_time_ms) {
+        // 标定：一轮至少 min_time / REPEATS
+        const double target_ns = min_time_ms * 1e6 / REPEATS;
+        uint64_t ops = 1;
+        double ns = ticks_to_ns(runOps(c, ops));
+        while (ns < target_ns && ops < (1ull << 40)) {
+            uint64_t next = ns > 0 ? (uint64_t)(ops * target_ns / ns * 1.2) : ops * 10;
+            ops = std::max(ops * 2, std::min(next, ops * 100));
+            ns = ticks_to_ns(runOps(c, ops));
+        }
+
+        std::vector<double> per_op;     // 刻度/操作
+        for (int r = 0; r < REPEATS; r++) {
+            per_op.push_back(runOps(c, ops) / ops);
+        }
+        std::sort(per_op.begin(), per_op.end());
+        double median = per_op[REPEATS / 2];
+        return { c.name(), c.memory(), c.bytesPerOp(), ticks_to_ns(1) * median, ticks_to_ns(1) * per_op[0],
+                 ticks_to_cycles(1) * median, ops * REPEATS };
+    }
+
+    const char* memory_ = "default";
+    std::vector<std::unique_ptr<Case>> cases_;
+    std::vector<std::pair<std::string, std::string>> skipped_;
+};
+
+} // namespace bench
+
+#endif // BENCH_HARNESS_H
@@ -0,0 +1,38 @@
+/**
+ * @file bsp_stub.cc
+ * @brief 🧩 基准测试用的板级音频接口替身
+ *
+ * 目标板基准测试只测内核，不碰I2S：采集返回静音，播放直接返回成功，
+ * 播放任务即使取到数据也不会驱动功放。主机端直接编译 bsp_board.cc，I2S由 shim/driver.cc 代替。
+ */
+
+#include <string.h>
+#include "bsp_board.h"
+
+esp_err_t bsp_board_init(uint32_t, int, int) { return ESP_OK; }
+esp_err_t bsp_audio_init(uint32_t, int, int) { return ESP_OK; }
+
+esp_err_t bsp_get_feed_data(bool, int16_t *buffer, int buffer_len)
+{
+    memset(buffer, 0, buffer_len);
+    return ESP_OK;
+}
+
+esp_err_t bsp_play_audio(const uint8_t *, size_t) { return ESP_OK; }
+esp_err_t bsp_play_audio_stream(const uint8_t *, size_t) { return ESP_OK; }
+esp_err_t bsp_audio_stop(void) { return ESP_OK; }
+
+esp_err_t bsp_i2s_set_dma_geometry(const bsp_i2s_dma_geometry_t *, const bsp_i2s_dma_geometry_t *) { return ESP_OK; }
+
+void bsp_i2s_get_stats(bsp_i2s_stats_t *stats, bool)
+{
+    memset(stats, 0, sizeof(*stats));
+}
+
+esp_err_t bsp_i2s_check_iram_safety(void) { return ESP_OK; }
+
+esp_err_t bsp_mic_get_beam_stats(bsp_mic_beam_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    return ESP_ERR_NOT_SUPPORTED;
+}
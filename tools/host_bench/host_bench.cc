@@ -0,0 +1,89 @@
+/**
+ * @file host_bench.cc
+ * @brief 📊 主机端微基准测试 - 直接编译固件源文件，测量音频和协议内核
+ *
+ * 在开发机上几秒钟跑完，结果是固定格式的JSON，可以提交前后各跑一次直接对比：
+ *
+ *   cmake -S tools/host_bench -B build_host_bench
+ *   cmake --build build_host_bench
+ *   ./build_host_bench/host_bench > after.json
+ *   python tools/host_bench/bench_diff.py before.json after.json
+ *
+ * 参数：
+ *   --filter=<子串>     只跑名称包含该子串的用例
+ *   --min-time-ms=<n>  每个用例的最少计时时间（默认 300）
+ *   --list             列出用例名称
+ *
+ * 被测代码与固件是同一份源文件（audio_manager.cc、bsp_board.cc、websocket_client.cc、
+ * ws_lean_transport.cc、hello_handshake.cc 以及纯头文件内核），ESP-IDF/FreeRTOS 接口
+ * 由 shim/ 目录里的替身提供（I2S是内存里的DMA缓冲区，WebSocket走本机回环）。
+ * 用例在 kernel_cases.cc 里，与目标板基准测试（tools/target_bench）共用；
+ * 板级音频和WebSocket发送的用例在 io_cases.cc 里，只在主机上跑。
+ * 主机上的绝对数字与ESP32-S3不同，用来比较同一机器上的改动前后。
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "bench_harness.h"
+#include "kernel_cases.h"
+#include "audio_frame_pool.h"
+#include "audio_manager.h"
+
+static constexpr size_t FRAME_SAMPLES = 512;
+
+static void usage(const char* prog)
+{
+    fprintf(stderr, "用法: %s [--filter=<子串>] [--min-time-ms=<n>] [--list]\n", prog);
+}
+
+int main(int argc, char** argv)
+{
+    const char* filter = nullptr;
+    double min_time_ms = 300;
+    bool list = false;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--filter=", 9) == 0) {
+            filter = argv[i] + 9;
+        } else if (strncmp(argv[i], "--min-time-ms=", 14) == 0) {
+            min_time_ms = atof(argv[i] + 14);
+        } else if (strcmp(argv[i], "--list") == 0) {
+            list = true;
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    AudioManager audio;
+    if (audio.init() != ESP_OK) {
+        fprintf(stderr, "AudioManager 初始化失败\n");
+        return 1;
+    }
+    AudioFramePool pool("bench", FRAME_SAMPLES * sizeof(int16_t), 32, 0);
+    if (pool.init() != ESP_OK) {
+        fprintf(stderr, "帧池初始化失败\n");
+        return 1;
+    }
+
+    bench::Registry reg;
+    if (!bench::register_buffer_cases(reg, { "host", 0 })) {
+        fprintf(stderr, "测试缓冲区分配失败\n");
+        return 1;
+    }
+    bench::register_system_cases(reg, audio, pool);
+    bench::register_io_cases(reg);
+    bench::register_skipped(reg);
+
+    if (list) {
+        reg.list();
+        return 0;
+    }
+    std::vector<bench::Result> results = reg.run(filter, min_time_ms);
+    reg.printJson(results, "host_bench");
+
+    audio.deinit();
+    return 0;
+}
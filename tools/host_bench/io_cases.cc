@@ -0,0 +1,165 @@
+/**
+ * @file io_cases.cc
+ * @brief 📋 板级音频和WebSocket发送路径的基准用例（只在主机上登记）
+ *
+ * 直接调用固件的 bsp_board.cc 和 websocket_client.cc / ws_lean_transport.cc：
+ *
+ * - I2S通道由 shim/driver.cc 的内存替身提供，读写只是与DMA缓冲区之间的拷贝，
+ *   测到的是采集格式转换、播放写入和DMA队列记账
+ * - WebSocketClient 用精简传输连到本进程里的回环服务器（127.0.0.1），
+ *   测到的是加锁、帧头、掩码和 sendmsg 的整条发送路径；服务器线程只负责把数据读走
+ *
+ * 目标板上I2S读写按采样率阻塞、基准固件也不联网，这些用例不在 target_bench 里登记。
+ */
+
+#include "kernel_cases.h"
+#include <string.h>
+#include <string>
+#include <thread>
+#include "bsp_board.h"
+#include "websocket_client.h"
+#include "lwip/sockets.h"
+#include "mbedtls/base64.h"
+#include "mbedtls/sha1.h"
+
+namespace bench {
+
+static constexpr size_t FRAME_SAMPLES = 512;        // 与主程序的采集帧相同（32ms）
+static constexpr size_t CHUNK_BYTES = 3200;         // 服务器下行分块（100ms）
+static constexpr uint32_t SAMPLE_RATE = 16000;
+
+// ========== 板级音频 ==========
+
+static bool register_bsp(Registry& reg)
+{
+    if (bsp_board_init(SAMPLE_RATE, 1, 16) != ESP_OK || bsp_audio_init(SAMPLE_RATE, 1, 16) != ESP_OK) {
+        return false;
+    }
+
+    static int16_t frame[FRAME_SAMPLES];
+    reg.add("bsp/feed_data_512", sizeof(frame), [] {
+        keep(bsp_get_feed_data(false, frame, sizeof(frame)));
+        clobber();
+    });
+
+    static uint8_t chunk[CHUNK_BYTES];
+    memset(chunk, 0x11, sizeof(chunk));
+    reg.add("bsp/play_stream_3200", CHUNK_BYTES, [] {
+        keep(bsp_play_audio_stream(chunk, CHUNK_BYTES));
+    });
+    return true;
+}
+
+// ========== WebSocket 发送 ==========
+
+// 读完握手请求，按其中的 Sec-WebSocket-Key 回101应答，之后收到的数据全部丢掉
+static void loopback_serve(int listen_fd)
+{
+    int fd = accept(listen_fd, nullptr, nullptr);
+    ::close(listen_fd);
+    if (fd < 0) {
+        return;
+    }
+
+    char req[1024];
+    size_t len = 0;
+    while (len < sizeof(req) - 1 && recv(fd, req + len, 1, 0) == 1) {
+        len++;
+        if (len >= 4 && memcmp(req + len - 4, "\r\n\r\n", 4) == 0) {
+            break;
+        }
+    }
+    req[len] = '\0';
+
+    const char* key = strstr(req, "Sec-WebSocket-Key:");
+    if (key == nullptr) {
+        ::close(fd);
+        return;
+    }
+    key += strlen("Sec-WebSocket-Key:");
+    while (*key == ' ') {
+        key++;
+    }
+    std::string concat(key, strcspn(key, "\r\n"));
+    concat += "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+    unsigned char digest[20];
+    mbedtls_sha1((const unsigned char*)concat.data(), concat.size(), digest);
+    unsigned char accept_key[32];
+    size_t accept_len = 0;
+    mbedtls_base64_encode(accept_key, sizeof(accept_key), &accept_len, digest, sizeof(digest));
+
+    char resp[256];
+    int resp_len = snprintf(resp, sizeof(resp),
+                            "HTTP/1.1 101 Switching Protocols\r\n"
+                            "Upgrade: websocket\r\n"
+                            "Connection: Upgrade\r\n"
+                            "Sec-WebSocket-Accept: %s\r\n\r\n", (const char*)accept_key);
+    if (send(fd, resp, resp_len, 0) != resp_len) {
+        ::close(fd);
+        return;
+    }
+
+    static uint8_t sink[65536];
+    while (recv(fd, sink, sizeof(sink), 0) > 0) {
+    }
+    ::close(fd);
+}
+
+// 在 127.0.0.1 的随机端口上启动回环服务器，返回端口，0=失败
+static uint16_t start_loopback_server()
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return 0;
+    }
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    socklen_t addr_len = sizeof(addr);
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, 1) != 0 ||
+        getsockname(fd, (struct sockaddr*)&addr, &addr_len) != 0) {
+        ::close(fd);
+        return 0;
+    }
+    std::thread(loopback_serve, fd).detach();
+    return ntohs(addr.sin_port);
+}
+
+static bool register_ws_client(Registry& reg)
+{
+    uint16_t port = start_loopback_server();
+    if (port == 0) {
+        return false;
+    }
+
+    // 与主程序相同的用法：精简传输、不自动重连（主机上任务不启动）；进程结束前不释放
+    auto* client = new WebSocketClient("ws://127.0.0.1:" + std::to_string(port) + "/bench", false);
+    client->setTransport(WebSocketClient::Transport::LEAN);
+    if (client->connect() != ESP_OK || !client->isConnected()) {
+        return false;
+    }
+
+    // 采集任务每帧发一次：sendBinary 边拷贝边掩码，sendBinaryInPlace 原地掩码
+    static uint8_t frame[FRAME_SAMPLES * sizeof(int16_t)];
+    memset(frame, 0x22, sizeof(frame));
+    reg.add("ws/client_send_binary_1024", sizeof(frame), [client] {
+        keep(client->sendBinary(frame, sizeof(frame)));
+    });
+    reg.add("ws/client_send_inplace_1024", sizeof(frame), [client] {
+        keep(client->sendBinaryInPlace(frame, sizeof(frame)));
+    });
+    return true;
+}
+
+void register_io_cases(Registry& reg)
+{
+    if (!register_bsp(reg)) {
+        reg.skip("bsp", "I2S替身初始化失败");
+    }
+    if (!register_ws_client(reg)) {
+        reg.skip("ws/client", "无法在127.0.0.1上建立回环连接");
+    }
+}
+
+} // namespace bench
@@ -0,0 +1,303 @@
+/**
+ * @file kernel_cases.cc
+ * @brief 📋 内核基准用例实现
+ */
+
+#include "kernel_cases.h"
+#include <string.h>
+#include "esp_heap_caps.h"
+#include "audio_frame_pool.h"
+#include "audio_manager.h"
+#include "beamformer.h"
+#include "dsp_pipeline.h"
+#include "hello_handshake.h"
+#include "sample_format.h"
+#include "server_event.h"
+#include "ws_frame.h"
+
+namespace bench {
+
+static constexpr size_t FRAME_SAMPLES = 512;        // 与主程序的采集帧相同（32ms）
+static constexpr size_t CHUNK_BYTES = 3200;         // 服务器下行分块（100ms）
+static constexpr size_t RING_BATCH = 60;            // 200KB环形缓冲区装得下的3200字节块数
+static constexpr size_t ALIGN = 64;
+
+// 确定的伪随机数据（LCG），每次运行、每个平台输入完全相同
+static void fill_noise(void* buf, size_t len, uint32_t seed)
+{
+    uint8_t* p = (uint8_t*)buf;
+    for (size_t i = 0; i < len; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        p[i] = (uint8_t)(seed >> 24);
+    }
+}
+
+static void* alloc_filled(size_t size, uint32_t caps, uint32_t seed)
+{
+    void* p = heap_caps_aligned_alloc(ALIGN, size, caps);
+    if (p != nullptr) {
+        fill_noise(p, size, seed);
+    }
+    return p;
+}
+
+// ========== 采集 / 播放处理 ==========
+
+static void register_dsp(Registry& reg, int16_t* frame, int16_t* block, const int16_t* source)
+{
+    auto* dc_block = new dsp::Pipeline<dsp::DcBlock<>>();
+    reg.add("capture/dc_block_512", FRAME_SAMPLES * sizeof(int16_t), [dc_block, frame] {
+        dc_block->process(frame, FRAME_SAMPLES);
+        clobber();
+    });
+
+    // 与 capture_chain.h 默认配置相同的组合；每次从同一段输入开始，自动增益每片都走完整的包络/限幅路径
+    auto* capture = new dsp::Pipeline<dsp::DcBlock<>, dsp::Agc<>>();
+    reg.add("capture/dc_block_agc_512", FRAME_SAMPLES * sizeof(int16_t), [capture, frame, source] {
+        memcpy(frame, source, FRAME_SAMPLES * sizeof(int16_t));
+        capture->process(frame, FRAME_SAMPLES);
+        clobber();
+    });
+
+    // 与 AudioManager::PlaybackChain 相同的组合，150% 音量让软限幅真正起作用
+    auto* chain = new dsp::Pipeline<dsp::Gain, dsp::SoftClip<>>();
+    chain->stage<0>().q8 = 384;
+    reg.add("playback/volume_softclip_3200", CHUNK_BYTES, [chain, block, source] {
+        memcpy(block, source, CHUNK_BYTES);
+        chain->process(block, CHUNK_BYTES / sizeof(int16_t));
+        clobber();
+    });
+}
+
+// ========== 双麦克风波束形成 ==========
+
+static void register_beamform(Registry& reg, int16_t* mic_a, int16_t* mic_b, int16_t* pcm)
+{
+    // 只有相加：S3上是PIE SIMD，与标量版对比
+    reg.add("beamform/average_scalar_512", FRAME_SAMPLES * 4, [mic_a, mic_b, pcm] {
+        dsp::beam::average_scalar(mic_a, mic_b, pcm, FRAME_SAMPLES);
+        clobber();
+    });
+    reg.add("beamform/average_512", FRAME_SAMPLES * 4, [mic_a, mic_b, pcm] {
+        dsp::beam::average(mic_a, mic_b, pcm, FRAME_SAMPLES);
+        clobber();
+    });
+
+    // 完整的一帧：固定延迟2（B要拷进对齐的缓冲区）；自适应（噪声输入每片都算互相关）
+    auto* fixed = new dsp::Beamformer(dsp::Beamformer::Mode::FIXED, 2, 3);
+    reg.add("beamform/fixed_delay2_512", FRAME_SAMPLES * 4, [fixed, mic_a, mic_b, pcm] {
+        fixed->process(mic_a, mic_b, pcm, FRAME_SAMPLES);
+        clobber();
+    });
+    // 先喂一片静音把底噪压到最低，之后噪声输入每片都判为有声、都算互相关，测的是最坏情况
+    static int16_t silence[dsp::Beamformer::BLOCK];
+    auto* adaptive = new dsp::Beamformer(dsp::Beamformer::Mode::ADAPTIVE, 0, 3);
+    adaptive->process(silence, silence, silence, dsp::Beamformer::BLOCK);
+    reg.add("beamform/adaptive_512", FRAME_SAMPLES * 4, [adaptive, mic_a, mic_b, pcm] {
+        adaptive->process(mic_a, mic_b, pcm, FRAME_SAMPLES);
+        clobber();
+    });
+}
+
+// ========== I2S 格式转换 ==========
+
+static void register_format(Registry& reg, uint8_t* raw, int16_t* pcm)
+{
+    using namespace sample_format;
+
+    reg.add("format/s24in32_to_pcm16_512", FRAME_SAMPLES * 4, [raw, pcm] {
+        to_pcm16<S24In32Mono>(raw, pcm, FRAME_SAMPLES);
+        clobber();
+    });
+    reg.add("format/s24in32_shift4_to_pcm16_512", FRAME_SAMPLES * 4, [raw, pcm] {
+        to_pcm16<S24In32Mono, 0, 4>(raw, pcm, FRAME_SAMPLES);
+        clobber();
+    });
+    reg.add("format/s16stereo_mix_to_pcm16_512", FRAME_SAMPLES * 4, [raw, pcm] {
+        to_pcm16<S16Stereo, MIX_ALL>(raw, pcm, FRAME_SAMPLES);
+        clobber();
+    });
+    reg.add("format/pcm16_to_s16stereo_512", FRAME_SAMPLES * 2, [raw, pcm] {
+        from_pcm16<S16Stereo>(pcm, raw, FRAME_SAMPLES);
+        clobber();
+    });
+    reg.add("format/pcm16_to_s32stereo_512", FRAME_SAMPLES * 2, [raw, pcm] {
+        from_pcm16<S32Stereo>(pcm, raw, FRAME_SAMPLES);
+        clobber();
+    });
+}
+
+// ========== WebSocket 掩码 ==========
+
+static void register_mask(Registry& reg, uint8_t* src, uint8_t* dst)
+{
+    static const uint32_t KEY = 0x5A3C96E1;
+
+    reg.add("ws/mask_bytes_3200", CHUNK_BYTES, [src, dst] {
+        keep(ws_frame::mask_bytes(dst, src, CHUNK_BYTES, KEY, 0));
+        clobber();
+    });
+    reg.add("ws/mask_words_copy_3200", CHUNK_BYTES, [src, dst] {
+        keep(ws_frame::mask_words(dst, src, CHUNK_BYTES, KEY, 0));
+        clobber();
+    });
+    reg.add("ws/mask_words_inplace_3200", CHUNK_BYTES, [dst] {
+        keep(ws_frame::mask_words(dst, dst, CHUNK_BYTES, KEY, 0));
+        clobber();
+    });
+    // 源地址不对齐（帧头后面紧跟负载的常见情况）
+    reg.add("ws/mask_words_unaligned_3200", CHUNK_BYTES, [src, dst] {
+        keep(ws_frame::mask_words(dst, src + 2, CHUNK_BYTES, KEY, 0));
+        clobber();
+    });
+}
+
+bool register_buffer_cases(Registry& reg, const Memory& mem)
+{
+    int16_t* frame = (int16_t*)alloc_filled(FRAME_SAMPLES * sizeof(int16_t), mem.caps, 2);
+    uint8_t* raw = (uint8_t*)alloc_filled(FRAME_SAMPLES * 8, mem.caps, 3);
+    int16_t* pcm = (int16_t*)alloc_filled(FRAME_SAMPLES * sizeof(int16_t), mem.caps, 4);
+    int16_t* source = (int16_t*)alloc_filled(CHUNK_BYTES, mem.caps, 5);
+    int16_t* block = (int16_t*)alloc_filled(CHUNK_BYTES, mem.caps, 0);
+    uint8_t* src = (uint8_t*)alloc_filled(CHUNK_BYTES + ALIGN, mem.caps, 6);
+    uint8_t* dst = (uint8_t*)alloc_filled(CHUNK_BYTES + ALIGN, mem.caps, 0);
+    if (!frame || !raw || !pcm || !source || !block || !src || !dst) {
+        heap_caps_free(frame);
+        heap_caps_free(raw);
+        heap_caps_free(pcm);
+        heap_caps_free(source);
+        heap_caps_free(block);
+        heap_caps_free(src);
+        heap_caps_free(dst);
+        return false;
+    }
+
+    reg.setMemory(mem.name);
+    register_dsp(reg, frame, block, source);
+    register_format(reg, raw, pcm);
+    register_beamform(reg, frame, (int16_t*)raw, pcm);
+    register_mask(reg, src, dst);
+    reg.setMemory("default");
+    return true;
+}
+
+// ========== 固件对象 ==========
+
+static void register_ring(Registry& reg, AudioManager& audio)
+{
+    static uint8_t chunk[CHUNK_BYTES];
+    fill_noise(chunk, sizeof(chunk), 1);
+
+    // 网络回调的路径：拷贝进环形缓冲区。每批开始前清空（不计时）
+    reg.add("ring/add_chunk_3200", CHUNK_BYTES, RING_BATCH,
+            [&audio] { audio.startStreamingPlayback(); },
+            [&audio] { keep(audio.addStreamingAudioChunk(chunk, CHUNK_BYTES)); });
+
+    // 零拷贝路径：直接写进环形缓冲区的连续空间
+    reg.add("ring/acquire_commit_3200", CHUNK_BYTES, RING_BATCH,
+            [&audio] { audio.startStreamingPlayback(); },
+            [&audio] {
+                size_t granted = 0;
+                uint8_t* dst = audio.acquireStreamingWrite(CHUNK_BYTES, &granted);
+                if (dst != nullptr) {
+                    memcpy(dst, chunk, granted);
+                    audio.commitStreamingWrite(granted);
+                }
+                keep(granted);
+            });
+}
+
+static void register_capture(Registry& reg, AudioManager& audio, AudioFramePool& pool)
+{
+    reg.add("capture/frame_acquire_release", 0, [&pool] {
+        AudioFrame* f = pool.acquire();
+        keep(f);
+        f->release();
+    });
+
+    // 录音状态下每帧都进历史（只记引用），历史满了释放最旧的一帧
+    const size_t record_batch = audio.getRecordingBufferSize() / FRAME_SAMPLES - 1;
+    reg.add("capture/record_frame_history", 0, record_batch,
+            [&audio] { audio.startRecording(); },
+            [&audio, &pool] {
+                AudioFrame* f = pool.acquire();
+                f->length = FRAME_SAMPLES * sizeof(int16_t);
+                keep(audio.addRecordingFrame(f, true));
+                f->release();
+            });
+}
+
+static void register_json(Registry& reg)
+{
+    static const char* FINISHED = "{\"event\":\"response_finished\",\"turn\":12}";
+    static const char* SET_SERVERS =
+        "{\"event\":\"set_servers\",\"servers\":\"ws://10.0.0.2:8888,ws://10.0.0.3:8888\"}";
+    static const char* WEATHER =
+        "{\"event\":\"play_weather\",\"triggered_by\":\"wake_word\",\"city\":\"beijing\"}";
+    static const char* HELLO_ACK =
+        "{\"event\":\"hello_ack\",\"version\":1,\"sample_rate_up\":16000,\"sample_rate_down\":16000,"
+        "\"encoding\":\"pcm_s16le\",\"max_frame\":4096,\"features\":[\"udp_audio\",\"heartbeat_rtt\"]}";
+
+    reg.add("json/classify_first", 0, [] {
+        const char* p = FINISHED;
+        keep(p);
+        keep(classify_server_event(p));
+    });
+    // 判断链的最后一项：每条规则都要扫一遍
+    reg.add("json/classify_last", 0, [] {
+        const char* p = SET_SERVERS;
+        keep(p);
+        keep(classify_server_event(p));
+    });
+    reg.add("json/string_field", 0, [] {
+        const char* p = WEATHER;
+        keep(p);
+        size_t len = 0;
+        keep(json_string_field(p, "triggered_by", &len));
+        keep(len);
+    });
+
+    static HelloHandshake handshake({ 16000, 204800, 4096,
+                                      HelloHandshake::FEATURE_UDP_AUDIO | HelloHandshake::FEATURE_HEARTBEAT_RTT });
+    reg.add("json/hello_ack", 0, [] {
+        const char* p = HELLO_ACK;
+        keep(p);
+        keep(handshake.handleAck(p));
+    });
+}
+
+static void register_ws_header(Registry& reg)
+{
+    static const uint32_t KEY = 0x5A3C96E1;
+    static uint8_t header[ws_frame::MAX_HEADER_SIZE];
+    ws_frame::build_client_header(header, ws_frame::OP_BINARY, CHUNK_BYTES, KEY);
+
+    reg.add("ws/build_header", 0, [] {
+        uint64_t len = CHUNK_BYTES;
+        keep(len);
+        keep(ws_frame::build_client_header(header, ws_frame::OP_BINARY, len, KEY));
+        clobber();
+    });
+    reg.add("ws/parse_header", 0, [] {
+        ws_frame::FrameHeader h = {};
+        keep(ws_frame::parse_header(header, sizeof(header), &h));
+        keep(h.payload_len);
+    });
+}
+
+void register_system_cases(Registry& reg, AudioManager& audio, AudioFramePool& pool)
+{
+    register_ring(reg, audio);
+    register_capture(reg, audio, pool);
+    register_json(reg);
+    register_ws_header(reg);
+}
+
+void register_skipped(Registry& reg)
+{
+    // 固件里还没有这两类内核：全链路固定 16kHz、下行只支持 pcm_s16le
+    reg.skip("resample", "固件没有重采样：上下行都固定16kHz（hello握手拒绝其他采样率）");
+    reg.skip("codec", "固件没有编解码器：音频只以 pcm_s16le 传输");
+}
+
+} // namespace bench
@@ -0,0 +1,59 @@
+/**
+ * @file kernel_cases.h
+ * @brief 📋 音频和协议内核的基准用例 - 主机和ESP32-S3共用同一份
+ *
+ * 主机端（host_bench）和目标板（tools/target_bench）都从这里登记用例，
+ * 被测内核、输入数据和用例名称完全相同，两边的结果可以用 bench_diff.py 对比。
+ */
+
+#ifndef KERNEL_CASES_H
+#define KERNEL_CASES_H
+
+#include <stdint.h>
+#include "bench_harness.h"
+
+class AudioManager;
+class AudioFramePool;
+
+namespace bench {
+
+/**
+ * @brief 用例缓冲区所在的内存
+ */
+struct Memory {
+    const char* name;           // 结果里的 memory 字段
+    uint32_t caps;              // heap_caps_* 能力标志
+};
+
+/**
+ * @brief 登记只依赖输入缓冲区的内核（格式转换、DSP、掩码）
+ *
+ * 缓冲区按 mem.caps 分配、cache行对齐，进程结束前不释放。
+ * 同一组用例可以对不同内存各登记一次。
+ *
+ * @return false=缓冲区分配失败，未登记
+ */
+bool register_buffer_cases(Registry& reg, const Memory& mem);
+
+/**
+ * @brief 登记使用固件对象的用例（环形缓冲区、帧池、录音历史、JSON事件、帧头）
+ *
+ * 这些对象自己决定内存位置，只登记一次（memory 为 "default"）。
+ */
+void register_system_cases(Registry& reg, AudioManager& audio, AudioFramePool& pool);
+
+/**
+ * @brief 登记直接调用 bsp_board.cc 和 WebSocketClient 的用例（只在主机上，见 io_cases.cc）
+ *
+ * I2S是内存替身，WebSocket连到本进程里的回环服务器；初始化失败的部分记为跳过。
+ */
+void register_io_cases(Registry& reg);
+
+/**
+ * @brief 登记固件中不存在、因而跳过的类别
+ */
+void register_skipped(Registry& reg);
+
+} // namespace bench
+
+#endif // KERNEL_CASES_H
@@ -0,0 +1,142 @@
+/**
+ * @file driver.cc
+ * @brief 🧩 主机基准测试的I2S/GPIO替身
+ *
+ * I2S通道是内存里的一块"DMA缓冲区"：读是从里面拷出（内容是固定的伪随机噪声），
+ * 写是拷进去，与 ESP-IDF 的 i2s_channel_read/write 在DMA缓冲区和调用方之间拷贝一样，
+ * 只是不按采样率等待。每次读写都按实际字节数触发一次收满/发完回调，
+ * 固件里的DMA队列记账照常运行。
+ */
+
+#include <string.h>
+#include <vector>
+#include "driver/gpio.h"
+#include "driver/i2s_std.h"
+
+struct i2s_channel_obj_t {
+    bool enabled;
+    i2s_event_callbacks_t callbacks;
+    void *user_data;
+    std::vector<uint8_t> dma;       // 所有描述符连在一起
+    size_t pos;                     // 下一次读写的位置
+};
+
+static i2s_channel_obj_t *new_channel(const i2s_chan_config_t *cfg)
+{
+    // 按最宽的槽（32位立体声）估算描述符大小
+    size_t dma_bytes = (size_t)cfg->dma_desc_num * cfg->dma_frame_num * 8;
+    i2s_channel_obj_t *ch = new i2s_channel_obj_t{ false, {}, nullptr, std::vector<uint8_t>(dma_bytes), 0 };
+    uint32_t seed = 0x1F2E3D4C;
+    for (uint8_t &b : ch->dma) {
+        seed = seed * 1664525u + 1013904223u;
+        b = (uint8_t)(seed >> 24);
+    }
+    return ch;
+}
+
+// 在DMA缓冲区里环形地拷贝，to_dma=true 为写入
+static void dma_copy(i2s_channel_obj_t *ch, uint8_t *user, size_t size, bool to_dma)
+{
+    while (size > 0) {
+        size_t n = ch->dma.size() - ch->pos < size ? ch->dma.size() - ch->pos : size;
+        if (to_dma) {
+            memcpy(ch->dma.data() + ch->pos, user, n);
+        } else {
+            memcpy(user, ch->dma.data() + ch->pos, n);
+        }
+        ch->pos = (ch->pos + n) % ch->dma.size();
+        user += n;
+        size -= n;
+    }
+}
+
+extern "C" {
+
+esp_err_t gpio_config(const gpio_config_t *) { return ESP_OK; }
+esp_err_t gpio_set_level(gpio_num_t, uint32_t) { return ESP_OK; }
+
+esp_err_t i2s_new_channel(const i2s_chan_config_t *cfg, i2s_chan_handle_t *tx, i2s_chan_handle_t *rx)
+{
+    if (cfg == nullptr || cfg->dma_desc_num == 0 || cfg->dma_frame_num == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (tx != nullptr) {
+        *tx = new_channel(cfg);
+    }
+    if (rx != nullptr) {
+        *rx = new_channel(cfg);
+    }
+    return ESP_OK;
+}
+
+esp_err_t i2s_del_channel(i2s_chan_handle_t handle)
+{
+    if (handle == nullptr || handle->enabled) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    delete handle;
+    return ESP_OK;
+}
+
+esp_err_t i2s_channel_init_std_mode(i2s_chan_handle_t handle, const i2s_std_config_t *cfg)
+{
+    return handle != nullptr && cfg != nullptr ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t i2s_channel_register_event_callback(i2s_chan_handle_t handle, const i2s_event_callbacks_t *cbs, void *user_data)
+{
+    if (handle == nullptr || handle->enabled) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    handle->callbacks = *cbs;
+    handle->user_data = user_data;
+    return ESP_OK;
+}
+
+esp_err_t i2s_channel_enable(i2s_chan_handle_t handle)
+{
+    if (handle == nullptr || handle->enabled) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    handle->enabled = true;
+    return ESP_OK;
+}
+
+esp_err_t i2s_channel_disable(i2s_chan_handle_t handle)
+{
+    if (handle == nullptr || !handle->enabled) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    handle->enabled = false;
+    return ESP_OK;
+}
+
+esp_err_t i2s_channel_read(i2s_chan_handle_t handle, void *dest, size_t size, size_t *bytes_read, uint32_t)
+{
+    if (handle == nullptr || !handle->enabled) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (handle->callbacks.on_recv != nullptr) {
+        i2s_event_data_t event = { handle->dma.data(), size, handle->dma.data() };
+        handle->callbacks.on_recv(handle, &event, handle->user_data);
+    }
+    dma_copy(handle, (uint8_t *)dest, size, false);
+    *bytes_read = size;
+    return ESP_OK;
+}
+
+esp_err_t i2s_channel_write(i2s_chan_handle_t handle, const void *src, size_t size, size_t *bytes_written, uint32_t)
+{
+    if (handle == nullptr || !handle->enabled) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    dma_copy(handle, (uint8_t *)src, size, true);
+    *bytes_written = size;
+    if (handle->callbacks.on_sent != nullptr) {
+        i2s_event_data_t event = { handle->dma.data(), size, handle->dma.data() };
+        handle->callbacks.on_sent(handle, &event, handle->user_data);
+    }
+    return ESP_OK;
+}
+
+} // extern "C"
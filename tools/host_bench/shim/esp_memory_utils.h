@@ -0,0 +1,8 @@
+#pragma once
+#include <stdbool.h>
+
+// 主机上没有外部RAM，也没有DMA
+static inline bool esp_ptr_external_ram(const void *p) { (void)p; return false; }
+static inline bool esp_ptr_internal(const void *p) { (void)p; return true; }
+static inline bool esp_ptr_in_iram(const void *p) { (void)p; return true; }
+static inline bool esp_ptr_dma_capable(const void *p) { (void)p; return false; }
@@ -0,0 +1,11 @@
+#pragma once
+// lwIP 的 BSD socket 接口与主机相同，直接用系统的
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
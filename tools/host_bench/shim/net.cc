@@ -0,0 +1,151 @@
+/**
+ * @file net.cc
+ * @brief 🧩 主机基准测试的网络相关替身
+ *
+ * - esp_random：确定的伪随机数，每次运行的掩码相同
+ * - mbedtls_sha1 / mbedtls_base64_encode：完整实现，WebSocket握手的 Accept 校验照常进行
+ * - esp_websocket_client：主机上没有这个库，init 返回空，只能测精简传输
+ */
+
+#include <string.h>
+#include "esp_random.h"
+#include "esp_websocket_client.h"
+#include "mbedtls/base64.h"
+#include "mbedtls/sha1.h"
+
+static uint32_t random_state = 0x9E3779B9;
+
+static inline uint32_t rol(uint32_t x, int n) { return (x << n) | (x >> (32 - n)); }
+
+static void sha1_block(uint32_t h[5], const unsigned char *p)
+{
+    uint32_t w[80];
+    for (int i = 0; i < 16; i++) {
+        w[i] = (uint32_t)p[4 * i] << 24 | (uint32_t)p[4 * i + 1] << 16 | (uint32_t)p[4 * i + 2] << 8 | p[4 * i + 3];
+    }
+    for (int i = 16; i < 80; i++) {
+        w[i] = rol(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    }
+    uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+    for (int i = 0; i < 80; i++) {
+        uint32_t f, k;
+        if (i < 20) {
+            f = (b & c) | (~b & d);
+            k = 0x5A827999;
+        } else if (i < 40) {
+            f = b ^ c ^ d;
+            k = 0x6ED9EBA1;
+        } else if (i < 60) {
+            f = (b & c) | (b & d) | (c & d);
+            k = 0x8F1BBCDC;
+        } else {
+            f = b ^ c ^ d;
+            k = 0xCA62C1D6;
+        }
+        uint32_t t = rol(a, 5) + f + e + k + w[i];
+        e = d;
+        d = c;
+        c = rol(b, 30);
+        b = a;
+        a = t;
+    }
+    h[0] += a;
+    h[1] += b;
+    h[2] += c;
+    h[3] += d;
+    h[4] += e;
+}
+
+extern "C" {
+
+uint32_t esp_random(void)
+{
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return random_state;
+}
+
+void esp_fill_random(void *buf, size_t len)
+{
+    uint8_t *p = (uint8_t *)buf;
+    for (size_t i = 0; i < len; i++) {
+        p[i] = (uint8_t)esp_random();
+    }
+}
+
+int mbedtls_sha1(const unsigned char *input, size_t ilen, unsigned char output[20])
+{
+    uint32_t h[5] = { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+    size_t full = ilen / 64 * 64;
+    for (size_t i = 0; i < full; i += 64) {
+        sha1_block(h, input + i);
+    }
+    // 最后一块：剩余字节 + 0x80 + 填充 + 64位长度（大端位数）
+    unsigned char tail[128] = {};
+    size_t rest = ilen - full;
+    memcpy(tail, input + full, rest);
+    tail[rest] = 0x80;
+    size_t tail_len = rest + 9 <= 64 ? 64 : 128;
+    uint64_t bits = (uint64_t)ilen * 8;
+    for (int i = 0; i < 8; i++) {
+        tail[tail_len - 1 - i] = (unsigned char)(bits >> (8 * i));
+    }
+    for (size_t i = 0; i < tail_len; i += 64) {
+        sha1_block(h, tail + i);
+    }
+    for (int i = 0; i < 5; i++) {
+        output[4 * i] = (unsigned char)(h[i] >> 24);
+        output[4 * i + 1] = (unsigned char)(h[i] >> 16);
+        output[4 * i + 2] = (unsigned char)(h[i] >> 8);
+        output[4 * i + 3] = (unsigned char)h[i];
+    }
+    return 0;
+}
+
+int mbedtls_base64_encode(unsigned char *dst, size_t dlen, size_t *olen, const unsigned char *src, size_t slen)
+{
+    static const char ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    size_t need = (slen + 2) / 3 * 4;
+    // 与 mbedtls 一致：输出带结尾的'\0'，缓冲区不够时 olen 给出需要的大小
+    if (dst == nullptr || dlen < need + 1) {
+        *olen = need + 1;
+        return MBEDTLS_ERR_BASE64_BUFFER_TOO_SMALL;
+    }
+    size_t n = 0;
+    for (size_t i = 0; i < slen; i += 3) {
+        uint32_t v = (uint32_t)src[i] << 16;
+        if (i + 1 < slen) v |= (uint32_t)src[i + 1] << 8;
+        if (i + 2 < slen) v |= src[i + 2];
+        dst[n++] = ALPHABET[(v >> 18) & 63];
+        dst[n++] = ALPHABET[(v >> 12) & 63];
+        dst[n++] = i + 1 < slen ? ALPHABET[(v >> 6) & 63] : '=';
+        dst[n++] = i + 2 < slen ? ALPHABET[v & 63] : '=';
+    }
+    dst[n] = '\0';
+    *olen = n;
+    return 0;
+}
+
+esp_websocket_client_handle_t esp_websocket_client_init(const esp_websocket_client_config_t *) { return nullptr; }
+
+esp_err_t esp_websocket_register_events(esp_websocket_client_handle_t, esp_websocket_event_id_t,
+                                        esp_event_handler_t, void *)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t esp_websocket_client_start(esp_websocket_client_handle_t) { return ESP_ERR_NOT_SUPPORTED; }
+esp_err_t esp_websocket_client_stop(esp_websocket_client_handle_t) { return ESP_ERR_NOT_SUPPORTED; }
+esp_err_t esp_websocket_client_destroy(esp_websocket_client_handle_t) { return ESP_ERR_NOT_SUPPORTED; }
+esp_err_t esp_websocket_client_set_uri(esp_websocket_client_handle_t, const char *) { return ESP_ERR_NOT_SUPPORTED; }
+int esp_websocket_client_send_text(esp_websocket_client_handle_t, const char *, int, TickType_t) { return -1; }
+int esp_websocket_client_send_bin(esp_websocket_client_handle_t, const char *, int, TickType_t) { return -1; }
+
+int esp_websocket_client_send_with_opcode(esp_websocket_client_handle_t, ws_transport_opcodes_t,
+                                          const uint8_t *, int, TickType_t)
+{
+    return -1;
+}
+
+} // extern "C"
@@ -0,0 +1,22 @@
+/**
+ * @file sdkconfig.h
+ * @brief 主机基准测试用的配置：没有GDMA、PSRAM，其余与默认 menuconfig 相同
+ */
+#pragma once
+
+#define CONFIG_AUDIO_ASYNC_COPY 0
+#define CONFIG_AUDIO_CAPTURE_DC_BLOCK 1
+#define CONFIG_AUDIO_CAPTURE_AGC 1
+#define CONFIG_AUDIO_AGC_TARGET_DBFS -20
+#define CONFIG_AUDIO_AGC_MAX_GAIN_DB 24
+#define CONFIG_AUDIO_AGC_GATE_DBFS -55
+#define CONFIG_AUDIO_PLAYBACK_VOLUME 100
+#define CONFIG_BSP_MIC_FORMAT_S16 1
+#define CONFIG_BSP_MIC_SHIFT 0
+#define CONFIG_BSP_MIC_BEAM_ADAPTIVE 1
+#define CONFIG_BSP_MIC_BEAM_DELAY 0
+#define CONFIG_BSP_MIC_SPACING_MM 60
+#define CONFIG_BSP_SPEAKER_FORMAT_S16_MONO 1
+#define CONFIG_I2S_ISR_IRAM_SAFE 1
+#define CONFIG_ESP_TIMER_IN_IRAM 1
+#define CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ 240
@@ -0,0 +1,151 @@
+/**
+ * @file shim.cc
+ * @brief 🧩 主机基准测试的ESP-IDF/FreeRTOS替身
+ *
+ * 只实现被测固件源文件用到的接口。基准测试是单线程的：
+ * 任务不启动，信号量/队列只计数。I2S/GPIO 见 driver.cc，网络相关见 net.cc。
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <thread>
+#include <deque>
+#include <vector>
+#include "esp_err.h"
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+
+struct QueueDefinition {
+    size_t item_size;           // 0 表示信号量
+    size_t length;
+    size_t count;
+    std::deque<std::vector<uint8_t>> items;
+};
+
+extern "C" {
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    switch (code) {
+    case ESP_OK: return "ESP_OK";
+    case ESP_FAIL: return "ESP_FAIL";
+    case ESP_ERR_NO_MEM: return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG: return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_NOT_SUPPORTED: return "ESP_ERR_NOT_SUPPORTED";
+    case ESP_ERR_TIMEOUT: return "ESP_ERR_TIMEOUT";
+    default: return "ESP_ERR_UNKNOWN";
+    }
+}
+
+void *heap_caps_malloc(size_t size, uint32_t) { return malloc(size); }
+void *heap_caps_calloc(size_t n, size_t size, uint32_t) { return calloc(n, size); }
+void heap_caps_free(void *ptr) { free(ptr); }
+
+void *heap_caps_aligned_alloc(size_t alignment, size_t size, uint32_t)
+{
+    return aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+}
+
+int64_t esp_timer_get_time(void)
+{
+    using namespace std::chrono;
+    return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+BaseType_t xTaskCreate(TaskFunction_t, const char *, uint32_t, void *, UBaseType_t, TaskHandle_t *handle)
+{
+    if (handle != nullptr) {
+        *handle = nullptr;
+    }
+    return pdPASS;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack, void *arg,
+                                   UBaseType_t prio, TaskHandle_t *handle, BaseType_t)
+{
+    return xTaskCreate(fn, name, stack, arg, prio, handle);
+}
+
+void vTaskDelete(TaskHandle_t) {}
+
+void vTaskDelay(TickType_t ticks)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)(esp_timer_get_time() / 1000);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) { return nullptr; }
+
+BaseType_t xTaskNotifyGive(TaskHandle_t) { return pdPASS; }
+
+uint32_t ulTaskNotifyTake(BaseType_t, TickType_t) { return 0; }
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size)
+{
+    return new QueueDefinition{ item_size, length, 0, {} };
+}
+
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t)
+{
+    if (q->items.size() >= q->length) {
+        return pdFALSE;
+    }
+    const uint8_t *p = (const uint8_t *)item;
+    q->items.emplace_back(p, p + q->item_size);
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t)
+{
+    if (q->items.empty()) {
+        return pdFALSE;
+    }
+    memcpy(item, q->items.front().data(), q->item_size);
+    q->items.pop_front();
+    return pdTRUE;
+}
+
+void vQueueDelete(QueueHandle_t q) { delete q; }
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max, UBaseType_t initial)
+{
+    return new QueueDefinition{ 0, max, initial, {} };
+}
+
+// 主机上单线程运行，互斥量就是初值为1的二值信号量
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    return new QueueDefinition{ 0, 1, 1, {} };
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t s, TickType_t)
+{
+    if (s->count == 0) {
+        return pdFALSE;
+    }
+    s->count--;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t s)
+{
+    if (s->count >= s->length) {
+        return pdFALSE;
+    }
+    s->count++;
+    return pdTRUE;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t s) { delete s; }
+
+} // extern "C"
@@ -0,0 +1,199 @@
+/**
+ * @file latency_sim.cc
+ * @brief 📏 回环延迟估计的主机仿真 - 模拟板子按给定延迟把激励送回麦克风，检查估计误差
+ *
+ * 模拟的板子和真实自检走同一套接口：固件的 LatencyProbe（main/latency_probe.h，同一份代码）给出激励，
+ * 播放时刻打参考时间戳，采集按 512 样本一次读取，每次读取带返回时刻。模拟的部分：
+ *
+ *   延迟       参考时刻到声音到达麦克风的时间（小数样本，加窗sinc插值）
+ *   扬声器     小喇叭的低频衰减（一阶高通 300Hz）、整体衰减、可选反相
+ *   房间       一次早期反射（+2.5ms，-8dB）
+ *   噪声       麦克风处的白噪声，按相对激励的SNR给出
+ *   调度       每次读取晚返回 0~几毫秒（指数分布），采集时间轴由估计器自己对齐
+ *
+ * 每个场景按固件的方式测 RUNS 次取中位数（LatencyProbe::combine），误差超过 2 个样本（125us）即失败；
+ * 另有一个没有回声（扬声器没接）的场景，必须判为无效。
+ *
+ * 用法：
+ *   cmake -S tools/latency_sim -B build_latency_sim && cmake --build build_latency_sim
+ *   ./build_latency_sim/latency_sim                               # 跑全部场景
+ *   ./build_latency_sim/latency_sim --delay-ms=37.4 --snr-db=5    # 只跑给定的延迟和信噪比
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+#include "latency_probe.h"
+
+static constexpr double SAMPLE_RATE = LatencyProbe::SAMPLE_RATE;
+static constexpr size_t READ_SAMPLES = 512;             // 与主程序的采集帧相同
+static constexpr double PREROLL_MS = 200;               // 与自检相同：先播静音把发送DMA填满
+static constexpr int RUNS = 3;                          // 与自检相同
+static constexpr int SINC_HALF = 16;
+static constexpr double ERROR_LIMIT_US = 125;
+static constexpr double PI = 3.14159265358979323846;
+
+// 确定的伪随机数（LCG + Box-Muller），每次运行结果相同
+struct Rng {
+    uint32_t state;
+    explicit Rng(uint32_t seed) : state(seed) {}
+    double uniform() {
+        state = state * 1664525u + 1013904223u;
+        return ((state >> 8) + 0.5) / 16777216.0;
+    }
+    double gauss() { return sqrt(-2.0 * log(uniform())) * cos(2 * PI * uniform()); }
+};
+
+struct Scenario {
+    const char* name;
+    double delay_ms;
+    double snr_db;
+    double gain_db;         // 扬声器到麦克风的整体衰减
+    bool inverted;
+    bool echo;              // false=扬声器没接，只有噪声
+};
+
+// 加窗sinc取 x 在小数位置 t 的值
+static double interpolate(const std::vector<double>& x, double t)
+{
+    long c = (long)floor(t);
+    double acc = 0;
+    for (long k = c - SINC_HALF + 1; k <= c + SINC_HALF; k++) {
+        if (k < 0 || k >= (long)x.size()) {
+            continue;
+        }
+        double d = t - k;
+        double sinc = fabs(d) < 1e-9 ? 1.0 : sin(PI * d) / (PI * d);
+        double w = 0.5 + 0.5 * cos(PI * d / SINC_HALF);
+        acc += x[k] * sinc * w;
+    }
+    return acc;
+}
+
+/**
+ * @brief 模拟一次测量：返回这一次的估计结果
+ */
+static LatencyProbe::Result run_once(const LatencyProbe& proto, const Scenario& sc, Rng& rng)
+{
+    LatencyProbe probe = proto;
+    const size_t capture_samples = (size_t)(SAMPLE_RATE * PREROLL_MS / 1000) + LatencyProbe::MLS_LENGTH
+                                   + LatencyProbe::MAX_DELAY_SAMPLES + 2 * READ_SAMPLES;
+    std::vector<int16_t> buffer(capture_samples);
+    probe.begin(buffer.data(), buffer.size());
+
+    // 采集时间轴的真实零点（对估计器未知）和参考时刻
+    const double sample_us = 1e6 / SAMPLE_RATE;
+    const double t0_us = 1e6 + rng.uniform() * 1e6;
+    const double ref_us = t0_us + PREROLL_MS * 1000 + rng.uniform() * sample_us * 7;
+    probe.markReference((int64_t)llround(ref_us));
+
+    std::vector<int16_t> stim16(LatencyProbe::MLS_LENGTH);
+    probe.stimulus(0, stim16.data(), stim16.size());
+    std::vector<double> stim(stim16.begin(), stim16.end());
+
+    const double gain = pow(10.0, sc.gain_db / 20) * (sc.inverted ? -1 : 1);
+    const double reflection = pow(10.0, -8.0 / 20);
+    const double noise_rms = LatencyProbe::AMPLITUDE * fabs(gain) / pow(10.0, sc.snr_db / 20);
+    const double hp = exp(-2 * PI * 300 / SAMPLE_RATE);
+    double hp_x = 0;
+    double hp_y = 0;
+
+    std::vector<int16_t> read(READ_SAMPLES);
+    size_t total = 0;
+    while (!probe.complete() && total < capture_samples + READ_SAMPLES) {
+        for (size_t i = 0; i < READ_SAMPLES; i++) {
+            double t_us = t0_us + (total + i) * sample_us;
+            double pos = (t_us - ref_us - sc.delay_ms * 1000) / sample_us;
+            double s = 0;
+            if (sc.echo) {
+                s = interpolate(stim, pos) + reflection * interpolate(stim, pos - 2.5e-3 * SAMPLE_RATE);
+            }
+            // 一阶高通：y = a*(y + x - x1)
+            double y = hp * (hp_y + s - hp_x);
+            hp_x = s;
+            hp_y = y;
+            double v = gain * y + noise_rms * rng.gauss();
+            read[i] = (int16_t)std::max(-32768.0, std::min(32767.0, lround(v) * 1.0));
+        }
+        total += READ_SAMPLES;
+        double late_us = -log(rng.uniform()) * 300;       // 平均晚 0.3ms
+        probe.addCapture(read.data(), READ_SAMPLES, (int64_t)llround(t0_us + total * sample_us + late_us));
+    }
+    return probe.estimate();
+}
+
+static bool run_scenario(const LatencyProbe& proto, const Scenario& sc, uint32_t seed)
+{
+    Rng rng(seed);
+    LatencyProbe::Result runs[RUNS];
+    for (int i = 0; i < RUNS; i++) {
+        runs[i] = run_once(proto, sc, rng);
+    }
+    LatencyProbe::Result r = LatencyProbe::combine(runs, RUNS);
+
+    bool ok;
+    double err_us = r.delay_us - sc.delay_ms * 1000;
+    if (sc.echo) {
+        ok = r.valid && fabs(err_us) <= ERROR_LIMIT_US && r.inverted == sc.inverted;
+    } else {
+        ok = !r.valid;
+    }
+    printf("%s %-14s 延迟 %7.2f ms  SNR %5.1f dB  衰减 %5.1f dB  → ", ok ? "✓" : "✗",
+           sc.name, sc.delay_ms, sc.snr_db, sc.gain_db);
+    if (r.valid) {
+        printf("%7.2f ms（误差 %+5.0f us，置信 %4.1f dB%s）\n", r.delay_us / 1000.0,
+               sc.echo ? err_us : 0.0, r.confidence_db, r.inverted ? "，反相" : "");
+    } else {
+        printf("无效（置信 %4.1f dB）\n", runs[0].confidence_db);
+    }
+    return ok;
+}
+
+int main(int argc, char** argv)
+{
+    double delay_ms = -1;
+    double snr_db = 20;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--delay-ms=", 11) == 0) {
+            delay_ms = atof(argv[i] + 11);
+        } else if (strncmp(argv[i], "--snr-db=", 9) == 0) {
+            snr_db = atof(argv[i] + 9);
+        } else {
+            fprintf(stderr, "用法: %s [--delay-ms=毫秒] [--snr-db=分贝]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (delay_ms >= LatencyProbe::MAX_DELAY_MS) {
+        fprintf(stderr, "延迟必须小于 %lu ms\n", (unsigned long)LatencyProbe::MAX_DELAY_MS);
+        return 2;
+    }
+
+    const LatencyProbe proto;
+    int failures = 0;
+    printf("回环延迟估计仿真（每个场景测 %d 次取中位数，误差上限 %.0f us）\n", RUNS, ERROR_LIMIT_US);
+    if (delay_ms >= 0) {
+        Scenario sc = { "指定", delay_ms, snr_db, -20, false, true };
+        failures += !run_scenario(proto, sc, 1);
+    } else {
+        static const Scenario SCENARIOS[] = {
+            { "近距离",        3.00,  30, -10, false, true },
+            { "典型",         24.70,  20, -20, false, true },
+            { "DMA排队深",    93.31,  20, -20, false, true },
+            { "接近上限",    243.00,  20, -20, false, true },
+            { "吵",           37.40,   0, -20, false, true },
+            { "很吵",         37.40, -10, -20, false, true },
+            { "很小声",       52.13,  10, -40, false, true },
+            { "反相",         24.70,  20, -20, true,  true },
+            { "没接扬声器",    0.00,  20, -20, false, false },
+        };
+        uint32_t seed = 1;
+        for (const Scenario& sc : SCENARIOS) {
+            failures += !run_scenario(proto, sc, seed++);
+        }
+    }
+    printf("\n%s\n", failures == 0 ? "全部通过" : "有场景失败");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,169 @@
+"""
+模型仓库打包工具 - 把若干文件打成设备可以直接映射使用的镜像（main/model_store.h）
+
+镜像布局（全部小端）：
+
+    文件头  64 字节   magic "MSTR", 版本, 项数, 数据区偏移, 镜像大小,
+                      数据区CRC32, 索引表CRC32, 对齐
+    索引表  48 字节/项 名字(32字节，0结尾), 偏移, 大小, CRC32, 标志
+    数据区  每块按 --align 对齐（默认64字节，cache行），空隙填0xFF（flash擦除值）
+
+输入是 名字=路径：
+- .wav 取出 data 块（只接受16位单声道PCM）
+- .h  从C数组头文件里取出所有 0xNN 字节（main/mock_voices 的格式）
+- 其他文件原样放入
+
+用法：
+    python tools/model_pack/pack_models.py -o build/assets.bin \\
+        hi=main/mock_voices/hi.h bye=main/mock_voices/bye.h
+    python tools/model_pack/pack_models.py --list build/assets.bin
+    parttool.py write_partition --partition-name assets --input build/assets.bin
+"""
+
+import argparse
+import re
+import struct
+import sys
+import zlib
+
+MAGIC = 0x5254534D  # "MSTR"
+VERSION = 1
+NAME_LEN = 32
+HEADER_FMT = "<IHHIIIII36s"
+ENTRY_FMT = "<32sIIII"
+HEADER_SIZE = struct.calcsize(HEADER_FMT)
+ENTRY_SIZE = struct.calcsize(ENTRY_FMT)
+assert HEADER_SIZE == 64 and ENTRY_SIZE == 48
+
+C_BYTE_RE = re.compile(r"0x([0-9a-fA-F]{2})\b")
+
+
+def crc32(data):
+    # 和设备上的 esp_rom_crc32_le(0, ...) 一致
+    return zlib.crc32(data) & 0xFFFFFFFF
+
+
+def read_wav(path, data):
+    if data[:4] != b"RIFF" or data[8:12] != b"WAVE":
+        raise ValueError(f"{path}: 不是WAV文件")
+    pos = 12
+    fmt = None
+    while pos + 8 <= len(data):
+        chunk_id, size = struct.unpack_from("<4sI", data, pos)
+        body = data[pos + 8:pos + 8 + size]
+        if chunk_id == b"fmt ":
+            fmt = struct.unpack_from("<HHIIHH", body)
+        elif chunk_id == b"data":
+            if fmt is None or fmt[0] != 1 or fmt[1] != 1 or fmt[5] != 16:
+                raise ValueError(f"{path}: 只接受16位单声道PCM")
+            return bytes(body)
+        pos += 8 + size + (size & 1)
+    raise ValueError(f"{path}: 没有data块")
+
+
+def read_input(path):
+    if path.endswith(".h"):
+        with open(path, encoding="utf-8", errors="replace") as f:
+            text = f.read()
+        # 只取数组初始化部分，长度常量等不是0x开头的不会被匹配
+        return bytes(int(b, 16) for b in C_BYTE_RE.findall(text))
+    with open(path, "rb") as f:
+        data = f.read()
+    if path.lower().endswith(".wav"):
+        return read_wav(path, data)
+    return data
+
+
+def align_up(value, align):
+    return (value + align - 1) // align * align
+
+
+def pack(items, align):
+    names = set()
+    for name, _ in items:
+        if len(name.encode()) >= NAME_LEN:
+            raise ValueError(f"名字太长（最多 {NAME_LEN - 1} 字节）: {name}")
+        if name in names:
+            raise ValueError(f"名字重复: {name}")
+        names.add(name)
+
+    data_offset = align_up(HEADER_SIZE + ENTRY_SIZE * len(items), align)
+    entries = []
+    payload = bytearray()
+    for name, data in items:
+        offset = data_offset + len(payload)
+        entries.append(struct.pack(ENTRY_FMT, name.encode(), offset, len(data), crc32(data), 0))
+        payload += data
+        payload += b"\xff" * (align_up(len(payload), align) - len(payload))
+
+    index = b"".join(entries)
+    image_size = data_offset + len(payload)
+    header = struct.pack(HEADER_FMT, MAGIC, VERSION, len(items), data_offset, image_size,
+                         crc32(bytes(payload)), crc32(index), align, b"\x00" * 36)
+    gap = b"\xff" * (data_offset - HEADER_SIZE - len(index))
+    return header + index + gap + bytes(payload)
+
+
+def unpack(image):
+    """检查镜像并返回 [(名字, 偏移, 大小, CRC是否正确)]，和设备上的 open() 做同样的检查"""
+    (magic, version, count, data_offset, image_size,
+     data_crc, index_crc, align, _) = struct.unpack_from(HEADER_FMT, image)
+    if magic != MAGIC or version != VERSION:
+        raise ValueError("不是模型仓库镜像或版本不对")
+    if image_size > len(image):
+        raise ValueError(f"镜像被截断: {len(image)} < {image_size}")
+    index = image[HEADER_SIZE:HEADER_SIZE + ENTRY_SIZE * count]
+    if crc32(index) != index_crc:
+        raise ValueError("索引表CRC错误")
+    if crc32(image[data_offset:image_size]) != data_crc:
+        raise ValueError("数据区CRC错误")
+    result = []
+    for i in range(count):
+        raw_name, offset, size, crc, _ = struct.unpack_from(ENTRY_FMT, index, i * ENTRY_SIZE)
+        name = raw_name.split(b"\x00", 1)[0].decode()
+        ok = offset % align == 0 and crc32(image[offset:offset + size]) == crc
+        result.append((name, offset, size, ok))
+    return result
+
+
+def parse_item(arg):
+    name, sep, path = arg.partition("=")
+    if not sep or not name or not path:
+        raise argparse.ArgumentTypeError(f"应为 名字=路径: {arg}")
+    return name, path
+
+
+def main():
+    parser = argparse.ArgumentParser(description="打包/检查模型仓库镜像")
+    parser.add_argument("items", nargs="*", type=parse_item, help="名字=路径")
+    parser.add_argument("-o", "--output", help="输出镜像")
+    parser.add_argument("--align", type=int, default=64, help="数据块对齐（字节，2的幂）")
+    parser.add_argument("--max-size", type=lambda v: int(v, 0), help="分区大小，超出时报错")
+    parser.add_argument("--list", metavar="IMAGE", help="检查并列出已有镜像")
+    args = parser.parse_args()
+
+    if args.list:
+        with open(args.list, "rb") as f:
+            entries = unpack(f.read())
+        for name, offset, size, ok in entries:
+            print(f"{name:<32} 偏移 0x{offset:06x}  {size:>8} 字节  {'OK' if ok else 'CRC错误'}")
+        return 0 if all(ok for *_, ok in entries) else 1
+
+    if not args.output or not args.items:
+        parser.error("打包需要 -o 和至少一个 名字=路径")
+    if args.align <= 0 or args.align & (args.align - 1):
+        parser.error("--align 必须是2的幂")
+
+    image = pack([(name, read_input(path)) for name, path in args.items], args.align)
+    if args.max_size is not None and len(image) > args.max_size:
+        print(f"镜像 {len(image)} 字节超过分区大小 {args.max_size}", file=sys.stderr)
+        return 1
+    with open(args.output, "wb") as f:
+        f.write(image)
+    unpack(image)
+    print(f"{args.output}: {len(args.items)} 项, {len(image)} 字节")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
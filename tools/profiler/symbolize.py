@@ -0,0 +1,139 @@
+"""
+采样分析器结果符号化 - 把串口输出的 (核, 任务, PC) 计数变成火焰图输入
+
+固件开启 CONFIG_AUDIO_PROFILER 后，服务器发送
+{"event":"profile","action":"dump"}，设备在串口输出：
+
+    PROFILE_BEGIN hz=997 samples=15951 dropped=0 duration_ms=8002
+    P 0 main 0x42012abc 37
+    P 1 IDLE1 0x40378f20 6012
+    ...
+    PROFILE_END
+
+本脚本用 addr2line 把PC换成函数名，输出：
+- 折叠栈（每行 "core<N>;<任务>;<函数> <次数>"），可直接交给
+  flamegraph.pl 或拖进 speedscope
+- 按函数汇总的占比排行
+
+采样时没有回溯调用栈，火焰图只有 核 → 任务 → 函数 三层；
+PC为0的采样是打断了另一个中断，记为 [isr]。
+
+用法：
+    idf.py monitor | tee profile.log
+    python tools/profiler/symbolize.py profile.log -e build/audio_test.elf -o profile.folded
+    flamegraph.pl profile.folded > profile.svg
+"""
+
+import argparse
+import collections
+import re
+import subprocess
+import sys
+
+BEGIN_MARK = "PROFILE_BEGIN"
+END_MARK = "PROFILE_END"
+SAMPLE_RE = re.compile(r"^P (\d+) (\S+) 0x([0-9a-fA-F]+) (\d+)\s*$")
+HEADER_RE = re.compile(r"(\w+)=(\d+)")
+
+
+def parse_log(path):
+    """取最后一段 PROFILE_BEGIN/PROFILE_END 之间的采样"""
+    with open(path, encoding="utf-8", errors="replace") as f:
+        lines = f.read().splitlines()
+
+    begin = None
+    for i, line in enumerate(lines):
+        if BEGIN_MARK in line:
+            begin = i
+    if begin is None:
+        raise ValueError(f"{path}: 没有找到 {BEGIN_MARK}")
+
+    header = {k: int(v) for k, v in HEADER_RE.findall(lines[begin])}
+    samples = []
+    for line in lines[begin + 1:]:
+        if END_MARK in line:
+            return header, samples
+        m = SAMPLE_RE.match(line.strip())
+        if m:
+            samples.append((int(m.group(1)), m.group(2), int(m.group(3), 16), int(m.group(4))))
+    raise ValueError(f"{path}: 找到 {BEGIN_MARK} 但没有 {END_MARK}，日志不完整")
+
+
+def symbolize(addr2line, elf, pcs):
+    """一次调用 addr2line 符号化所有地址，返回 {pc: 函数名}"""
+    pcs = sorted(pc for pc in pcs if pc != 0)
+    names = {0: "[isr]"}
+    if not pcs:
+        return names
+    if elf is None:
+        for pc in pcs:
+            names[pc] = f"0x{pc:08x}"
+        return names
+
+    # -a 在每个地址的结果前输出地址本身，用来分段；-f 输出函数名，
+    # -C 反修饰C++名字，-i 展开内联（每段多对 函数/文件:行，第一对是最内层）
+    cmd = [addr2line, "-a", "-f", "-i", "-C", "-e", elf]
+    stdin = "".join(f"0x{pc:08x}\n" for pc in pcs)
+    try:
+        out = subprocess.run(cmd, input=stdin, capture_output=True, text=True, check=True).stdout
+    except FileNotFoundError:
+        raise SystemExit(f"找不到 {addr2line}，先运行 ESP-IDF 的 export.sh 或用 --addr2line 指定路径")
+
+    current = None
+    for line in out.splitlines():
+        if re.fullmatch(r"0x[0-9a-fA-F]+", line):
+            current = int(line, 16)
+        elif current is not None:
+            names[current] = line if line != "??" else f"0x{current:08x}"
+            current = None
+    for pc in pcs:
+        names.setdefault(pc, f"0x{pc:08x}")
+    return names
+
+
+def main():
+    parser = argparse.ArgumentParser(description="符号化采样分析器输出")
+    parser.add_argument("log", help="包含 PROFILE_BEGIN/PROFILE_END 的串口日志")
+    parser.add_argument("-e", "--elf", help="固件ELF（不给则只输出地址）")
+    parser.add_argument("-o", "--output", help="折叠栈输出文件（默认不写）")
+    parser.add_argument("--addr2line", default="xtensa-esp32s3-elf-addr2line",
+                        help="addr2line 可执行文件（默认 xtensa-esp32s3-elf-addr2line）")
+    parser.add_argument("--top", type=int, default=30, help="排行显示多少个函数（默认30）")
+    args = parser.parse_args()
+
+    header, samples = parse_log(args.log)
+    names = symbolize(args.addr2line, args.elf, {pc for _, _, pc, _ in samples})
+
+    folded = collections.Counter()
+    by_func = collections.Counter()
+    by_task = collections.Counter()
+    total = 0
+    for core, task, pc, count in samples:
+        func = names[pc]
+        folded[f"core{core};{task};{func}"] += count
+        by_func[func] += count
+        by_task[f"core{core} {task}"] += count
+        total += count
+
+    if args.output:
+        with open(args.output, "w", encoding="utf-8") as f:
+            for stack, count in sorted(folded.items()):
+                f.write(f"{stack} {count}\n")
+
+    print(f"采样频率 {header.get('hz', 0)} Hz，{total} 个采样，"
+          f"持续 {header.get('duration_ms', 0)} ms，丢弃 {header.get('dropped', 0)}")
+    if total == 0:
+        return 0
+
+    print(f"\n{'任务':24s} {'采样':>8s} {'占比':>7s}")
+    for task, count in by_task.most_common():
+        print(f"{task:24s} {count:8d} {count * 100.0 / total:6.1f}%")
+
+    print(f"\n{'函数':60s} {'采样':>8s} {'占比':>7s}")
+    for func, count in by_func.most_common(args.top):
+        print(f"{func[:60]:60s} {count:8d} {count * 100.0 / total:6.1f}%")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
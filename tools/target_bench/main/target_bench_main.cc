@@ -0,0 +1,71 @@
+/**
+ * @file target_bench_main.cc
+ * @brief 📊 目标板基准测试 - 在ESP32-S3上跑与主机相同的内核用例
+ *
+ * 主机上测不出PSRAM延迟、cache行为和Xtensa上的代码生成。这个固件上电后：
+ *
+ * 1. 同一组缓冲区用例分别在内部SRAM和PSRAM上各跑一遍
+ * 2. 环形缓冲区、帧池、JSON等用例使用固件对象自己的内存，跑一遍
+ * 3. 用CPU周期计数器计时，结果（含 cycles_per_op）以JSON从串口输出，
+ *    前后用 BENCH_JSON_BEGIN / BENCH_JSON_END 标记，bench_diff.py 可以直接读串口日志
+ *
+ * 测试任务固定在核1、优先级高于播放任务，一批计时过程中播放任务不会取走环形缓冲区的数据。
+ */
+
+#include <stdio.h>
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "bench_harness.h"
+#include "kernel_cases.h"
+#include "audio_frame_pool.h"
+#include "audio_manager.h"
+
+static const char *TAG = "TargetBench";
+
+static constexpr double MIN_TIME_MS = 300;
+static constexpr size_t FRAME_BYTES = 512 * sizeof(int16_t);
+
+static void bench_task(void *arg)
+{
+    static AudioManager audio;
+    static AudioFramePool pool("bench", FRAME_BYTES, 32, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (audio.init() != ESP_OK || pool.init() != ESP_OK) {
+        ESP_LOGE(TAG, "初始化失败");
+        vTaskDelete(NULL);
+        return;
+    }
+
+    bench::Registry reg;
+    const bench::Memory memories[] = {
+        { "sram", MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT },
+        { "psram", MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT },
+    };
+    for (const auto& mem : memories) {
+        if (!bench::register_buffer_cases(reg, mem)) {
+            ESP_LOGW(TAG, "%s 缓冲区分配失败，跳过", mem.name);
+        }
+    }
+    bench::register_system_cases(reg, audio, pool);
+    bench::register_skipped(reg);
+
+    ESP_LOGI(TAG, "开始测试 (CPU %d MHz, 每个用例至少 %.0f ms)", CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ, MIN_TIME_MS);
+    std::vector<bench::Result> results = reg.run(nullptr, MIN_TIME_MS);
+
+    // 日志和JSON之间不能交错，先等日志刷完
+    fflush(stdout);
+    printf("BENCH_JSON_BEGIN\n");
+    reg.printJson(results, "target_bench");
+    printf("BENCH_JSON_END\n");
+    fflush(stdout);
+
+    ESP_LOGI(TAG, "✓ 完成 %u 个用例", (unsigned)results.size());
+    vTaskDelete(NULL);
+}
+
+extern "C" void app_main(void)
+{
+    // 播放任务在核1、优先级5（见 AudioManager::init）
+    xTaskCreatePinnedToCore(bench_task, "bench", 8192, NULL, 10, NULL, 1);
+}
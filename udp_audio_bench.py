@@ -0,0 +1,153 @@
+"""
+UDP与TCP音频传输对比测试 - 本机回环 + netem 模拟弱网
+
+按实时节奏发送20ms音频帧，分别走TCP（与WebSocket相同的可靠有序传输）
+和UDP（rtp_audio 包格式 + ReorderBuffer 重排），统计每帧从发送到
+按序交付给上层的延迟，以及UDP的丢包补偿帧数。
+
+用法：
+    # 模拟2%丢包 + 20ms延迟（需要root，测完记得删除）
+    sudo tc qdisc add dev lo root netem loss 2% delay 20ms
+    python udp_audio_bench.py --seconds 30
+    sudo tc qdisc del dev lo root
+"""
+
+import argparse
+import socket
+import struct
+import threading
+import time
+
+from rtp_audio import FRAME_BYTES, FRAME_MS, ReorderBuffer, pack, unpack
+
+TCP_PORT = 47001
+UDP_PORT = 47002
+REORDER_WAIT_S = 0.04  # 与设备端 REORDER_WAIT_MS 一致
+
+
+def percentile(values, p):
+    if not values:
+        return 0.0
+    ordered = sorted(values)
+    index = min(len(ordered) - 1, int(round(p / 100.0 * (len(ordered) - 1))))
+    return ordered[index]
+
+
+def summarize(name, latencies_ms, frames, extra=""):
+    print(f"{name:4s} 交付 {len(latencies_ms)}/{frames} 帧  "
+          f"p50={percentile(latencies_ms, 50):6.1f}ms  "
+          f"p95={percentile(latencies_ms, 95):6.1f}ms  "
+          f"p99={percentile(latencies_ms, 99):6.1f}ms  "
+          f"max={max(latencies_ms, default=0):6.1f}ms  {extra}")
+
+
+def make_frame(index):
+    # 负载前8字节放发送时间，其余填充
+    return struct.pack("!d", time.monotonic()) + bytes(FRAME_BYTES - 8)
+
+
+def pace(start, index):
+    delay = start + index * FRAME_MS / 1000.0 - time.monotonic()
+    if delay > 0:
+        time.sleep(delay)
+
+
+def bench_tcp(frames):
+    latencies = []
+    server = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    server.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    server.bind(("127.0.0.1", TCP_PORT))
+    server.listen(1)
+
+    def receiver():
+        conn, _ = server.accept()
+        conn.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        buf = b""
+        while len(latencies) < frames:
+            data = conn.recv(65536)
+            if not data:
+                break
+            buf += data
+            while len(buf) >= FRAME_BYTES:
+                frame, buf = buf[:FRAME_BYTES], buf[FRAME_BYTES:]
+                sent = struct.unpack_from("!d", frame)[0]
+                latencies.append((time.monotonic() - sent) * 1000.0)
+        conn.close()
+
+    thread = threading.Thread(target=receiver)
+    thread.start()
+    client = socket.create_connection(("127.0.0.1", TCP_PORT))
+    client.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+    start = time.monotonic()
+    for i in range(frames):
+        pace(start, i)
+        client.sendall(make_frame(i))
+    thread.join(timeout=10)
+    client.close()
+    server.close()
+    summarize("TCP", latencies, frames)
+
+
+def bench_udp(frames):
+    latencies = []
+    reorder = ReorderBuffer(depth=8)
+    rx = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    rx.bind(("127.0.0.1", UDP_PORT))
+    rx.settimeout(0.01)
+    done = threading.Event()
+
+    def deliver(chunks, now):
+        for chunk in chunks:
+            sent = struct.unpack_from("!d", chunk)[0]
+            if sent > 0:  # 静音补偿帧没有时间戳
+                latencies.append((now - sent) * 1000.0)
+
+    def receiver():
+        gap_since = None
+        while not done.is_set():
+            try:
+                data, _ = rx.recvfrom(2048)
+            except socket.timeout:
+                data = None
+            now = time.monotonic()
+            if data:
+                parsed = unpack(data)
+                if parsed:
+                    deliver(reorder.push(parsed[0], parsed[4]), now)
+            # 与设备端相同：缺包等待超过 REORDER_WAIT_S 即补偿跳过
+            if reorder.pending:
+                gap_since = gap_since or now
+                if now - gap_since >= REORDER_WAIT_S:
+                    deliver(reorder.skip(), now)
+                    gap_since = None
+            else:
+                gap_since = None
+        deliver(reorder.flush(), time.monotonic())
+
+    thread = threading.Thread(target=receiver)
+    thread.start()
+    tx = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    start = time.monotonic()
+    for i in range(frames):
+        pace(start, i)
+        tx.sendto(pack(i, i * FRAME_BYTES // 2, 0x1234, make_frame(i), i == frames - 1),
+                  ("127.0.0.1", UDP_PORT))
+    time.sleep(0.5)
+    done.set()
+    thread.join()
+    tx.close()
+    rx.close()
+    stats = reorder.stats()
+    summarize("UDP", latencies, frames,
+              f"补偿={stats['lost']} 乱序={stats['reordered']} 迟到/重复={stats['duplicates']}")
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="UDP/TCP 音频传输延迟对比")
+    parser.add_argument("--seconds", type=int, default=20, help="每种传输的测试时长")
+    args = parser.parse_args()
+
+    frames = args.seconds * 1000 // FRAME_MS
+    print(f"每种传输发送 {frames} 帧（{FRAME_MS}ms/帧，{FRAME_BYTES}字节）")
+    bench_tcp(frames)
+    bench_udp(frames)